@@ -0,0 +1,42 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Offline detection + tracking over recorded footage (no GL)
+ *  - Input: a directory of PNG/JPG/QOI frames (sorted by name), a raw
+ *    8-bit YUV4MPEG2 stream (.y4m, luma plane used, mmap'd) or a lossless
+ *    fcodec recording (.fcv, mmap'd, decoded by the workers)
+ *  - Worker pool: decode -> gray -> letterbox tensor -> detect, one frame
+ *    per worker; ORT sessions are shared (Run is thread-safe), the
+ *    sky-blob fallback gets one detector per worker
+ *  - Results are re-ordered and fed to the IoU tracker on the calling
+ *    thread, then written as CSV in source pixel coordinates
+ */
+
+#define BATCH_DET_SIZE 448
+
+typedef struct {
+    const char* input;         /* directory, .y4m or .fcv file */
+    const char* out_path;      /* CSV; NULL = stdout */
+    const char* model_path;    /* NULL / unreadable: sky-blob fallback */
+    const char* detlog_path;   /* columnar log next to the CSV (NULL = off) */
+    int   det_w, det_h;        /* model input size; 0 = the model's (BATCH_DET_SIZE if dynamic) */
+    int   threads;             /* workers; 0 = online CPUs */
+    float score_thresh;
+    float nms_iou;
+} BatchConfig;
+
+BatchConfig batch_default_config(void);
+
+/* Returns a process exit code (0 on success) */
+int batch_run(const BatchConfig* cfg);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* BATCH_H */
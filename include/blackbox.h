@@ -0,0 +1,55 @@
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "onnx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * In-memory black-box recorder
+ *  - Every frame appends flight state (all planes, speed, autopilot, crash
+ *    flag), the frame time and the detections to a fixed ring; slots are
+ *    seqlocked, so the render thread never waits on a reader
+ *  - Detection frames are copied into a small single-producer staging ring
+ *    and fcodec-compressed by a background thread into a byte arena (the
+ *    frame is skipped if the encoder falls behind, the state never is)
+ *  - When isCrashed flips or a frame takes longer than the spike threshold,
+ *    a dump thread writes the last N seconds to <dir>/NNN_<reason>_f<frame>/:
+ *    state.csv, detections.csv, frames.fcv (replayable with --batch), info.txt
+ */
+
+#define BLACKBOX_MAX_FPS        240     /* ring sized for seconds x this */
+#define BLACKBOX_MAX_DETS       32      /* per frame; extra detections are dropped */
+#define BLACKBOX_ARENA_MB       64      /* compressed frames */
+#define BLACKBOX_WARMUP_FRAMES  30      /* no spike triggers before this */
+
+/* seconds: history kept; spike_ms: 0 = crash trigger only */
+bool blackbox_open(const char* dir, double seconds, double spike_ms);
+bool blackbox_active(void);
+
+/* Detection readback of the current frame (bottom-up RGBA, copied) */
+void blackbox_capture(const uint8_t* rgba, int w, int h);
+/* Readbacks waiting for the encoder; *dropped: skipped on a full ring (may be NULL) */
+int  blackbox_queue_depth(long* dropped);
+/* Detections of the current frame (detector pixels) */
+void blackbox_detections(const OnnxDet* dets, int count);
+
+/* Closes the current frame: snapshots the flight state, publishes the slot
+ * and checks the triggers. frame_ms: wall time of the whole loop iteration. */
+void blackbox_frame_end(long frame, double sim_time, double frame_ms);
+
+/* Manual dump (reason: short tag used in the directory name) */
+void blackbox_dump(const char* reason);
+
+/* Waits for a running dump, stops the encoder, frees everything */
+void blackbox_close(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* BLACKBOX_H */
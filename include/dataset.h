@@ -0,0 +1,64 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cglm/cglm.h"
+#include "onnx.h"
+#include "idpass.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Synthetic training data export (YOLO layout)
+ *  - Ground truth comes from the simulator itself: tight, occlusion-aware
+ *    boxes from the instance-ID pass, or (fallback) every plane's mesh AABB
+ *    projected with its modelMatrix and the detection view/proj
+ *  - Each detection frame is queued as <dir>/images/%08ld.{jpg,png,qoi} plus
+ *    <dir>/labels/%08ld.txt ("cls cx cy w h", normalized) and written by a
+ *    pool of writer threads (stb_image_write, or fcodec for lossless .qoi);
+ *    the render thread only copies
+ *  - <dir>/manifest.txt lists every written image (relative paths) and
+ *    data.yaml points at it, so shards can be merged by concatenation
+ *  - Classes match the detector: 0 own plane, 1 near enemy, 2 far enemy
+ */
+
+#define DATASET_NEAR_DISTANCE 1500.0f   /* camera distance splitting classes 1/2 */
+#define DATASET_MIN_BOX_PX    2.0f      /* smaller (clipped) boxes are dropped */
+#define DATASET_MIN_VISIBLE_PX 8        /* ID pass: fewer visible pixels = no label */
+
+/* Projects every plane into an img_w x img_h image whose scene occupies the
+ * GL viewport (vp_x, vp_y, vp_w, vp_h). Boxes are top-down pixels, score 1.
+ * Planes crossing the near plane or beyond the far plane are skipped.
+ * Returns the number of boxes written to out (at most max_out); plane_out
+ * (optional) receives each box's index in planes[]. */
+int  dataset_ground_truth(mat4 view, mat4 proj, int vp_x, int vp_y, int vp_w, int vp_h,
+                          int img_w, int img_h, OnnxDet* out, int* plane_out, int max_out);
+
+/* Labels from an idpass_run() result (same image geometry) */
+int  dataset_ground_truth_id(mat4 view, const IdPassBox ids[MAX_PLANES], OnnxDet* out,
+                             int* plane_out, int max_out);
+
+/* format: "jpg" (default, quality 95), "png" or "qoi" (lossless, ~20x faster
+ * than png); writers 0 = online CPUs - 1 */
+bool dataset_open(const char* dir, const char* format, int writers);
+bool dataset_active(void);
+
+/* Queues one bottom-up RGBA8 frame (copied) and all of its boxes; waits
+ * when all slots are in flight so no frame is lost. A frame whose copy
+ * cannot be allocated is skipped whole (counted), never written unlabeled. */
+void dataset_submit(const uint8_t* rgba, int w, int h, const OnnxDet* boxes, int count);
+
+/* Frames queued or being written (never dropped: submit waits) */
+int  dataset_queue_depth(void);
+
+/* Drains the queue, joins the writers and prints images/s */
+void dataset_close(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* DATASET_H */
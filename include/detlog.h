@@ -0,0 +1,85 @@
+#ifndef DETLOG_H
+#define DETLOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "onnx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Columnar detection log (append-only, mmap-friendly)
+ *  - File: 32-byte header, then self-contained blocks appended whole
+ *  - Block: header with zone maps (frame / score / track range, class
+ *    mask) so readers can skip it, then one contiguous column per field:
+ *      frames:     frame, sim_time, stage timings, first detection row
+ *      detections: frame, track, cls, score, x1, y1, x2, y2
+ *  - Columns are 8-byte aligned; a reader can use them in place
+ *  - A block cut short by a killed writer is ignored (payload size check)
+ *  - tools/detlog_query.c filters by frame range, class, track and score
+ */
+
+#define DETLOG_BLOCK_FRAMES 1024     /* flush after this many frames ... */
+#define DETLOG_BLOCK_ROWS   16384    /* ... or detections */
+
+enum { DETLOG_RENDER, DETLOG_READ, DETLOG_CONVERT, DETLOG_INFER, DETLOG_DRAW, DETLOG_TOTAL,
+       DETLOG_STAGES };
+extern const char* const detlog_stage_names[DETLOG_STAGES];
+
+/* ---- Writer (one per process, render or batch thread) ---- */
+bool detlog_open(const char* path);
+bool detlog_active(void);
+
+/* One frame: stage times in ms (DETLOG_STAGES entries, NULL = zeros),
+ * detections in detector pixels, tracks (NULL = all -1) */
+void detlog_frame(long frame, double sim_time, const float* stage_ms,
+                  const OnnxDet* dets, const int* tracks, int count);
+
+/* Flushes the open block and closes the file */
+void detlog_close(void);
+
+/* ---- Reader ---- */
+typedef struct {
+    int64_t  frame_min, frame_max;
+    int32_t  track_min, track_max;
+    float    score_min, score_max;
+    uint32_t cls_mask;          /* bit (cls + 1) set if present (cls -1 = bit 0) */
+    uint32_t nframes, nrows;
+
+    /* frames */
+    const int64_t*  frame;
+    const double*   sim_time;
+    const float*    stage_ms[DETLOG_STAGES];
+    const uint32_t* first_row;  /* detections of frame i: [first_row[i], first_row[i+1]) */
+    /* detections */
+    const int64_t*  det_frame;
+    const int32_t*  track;
+    const int16_t*  cls;
+    const float*    score;
+    const float*    x1;
+    const float*    y1;
+    const float*    x2;
+    const float*    y2;
+} DetlogBlock;
+
+typedef struct {
+    int            fd;
+    const uint8_t* map;
+    size_t         size;
+    long           nblocks;
+    DetlogBlock*   blocks;
+    long           frames, rows;
+    size_t         end;        /* bytes covered by complete blocks */
+} DetlogReader;
+
+bool detlog_reader_open(DetlogReader* r, const char* path);
+void detlog_reader_close(DetlogReader* r);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* DETLOG_H */
@@ -0,0 +1,57 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include <stdbool.h>
+#include "onnx.h"
+#include "detlog.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Detector evaluation against simulator ground truth (--eval FILE.json)
+ *  - Ground truth is what --dataset would label (ID pass, or projected mesh
+ *    bounds) plus each plane's camera distance for the range buckets
+ *  - Detections are matched greedily by score at IoU >= EVAL_IOU, per
+ *    detector class and class-agnostic (the sky-blob fallback has no class)
+ *  - Precision / recall at the score threshold and AP@0.5 (all-point
+ *    interpolation) per class, overall and per range bucket; an unmatched
+ *    detection is put in the bucket its box size implies (box size x range
+ *    is calibrated on the ground truth of the same run)
+ *  - p50/p95/p99/max of every stage time, after a short warm-up
+ *  - "summary" is the pair to compare runs by: accuracy (mAP@0.5, or the
+ *    class-agnostic AP@0.5 when the detector has no classes) and total p95,
+ *    plus the detection cost per simulated frame (frames that hold the last
+ *    output under --detect-every count as zero) for autotune
+ */
+
+#define EVAL_IOU             0.5f
+#define EVAL_CLASSES         3         /* 0 own plane, 1 near enemy, 2 far enemy */
+#define EVAL_RANGE_BUCKETS   4         /* edges below */
+#define EVAL_RANGE_EDGES     { 500.0f, 1500.0f, 3000.0f }
+#define EVAL_WARMUP_FRAMES   10        /* not counted in the latency figures */
+#define EVAL_LATENCY_SAMPLES (1 << 18) /* latest frames kept per stage */
+#define EVAL_SCORE_FLOOR     0.001f    /* detector threshold under --eval: AP needs the whole PR curve */
+
+/* detector: name written to the report; input / detect_every: settings
+ * written next to it; score_thresh: operating point for precision / recall
+ * (AP uses every detection, so pass the list cut at EVAL_SCORE_FLOOR) */
+bool eval_open(const char* path, const char* detector, int input_w, int input_h, int detect_every,
+               float score_thresh);
+bool eval_active(void);
+
+/* One detection frame: ground truth boxes with their camera distance, the
+ * detector output (same pixels) and the stage times; stage_ms NULL: the
+ * detector did not run and dets is the held output of an earlier frame */
+void eval_frame(const OnnxDet* gt, const float* gt_range, int ngt,
+                const OnnxDet* dets, int ndet, const float stage_ms[DETLOG_STAGES]);
+
+/* Writes the JSON report, prints the summary line and frees everything */
+bool eval_close(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* EVAL_H */
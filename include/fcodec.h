@@ -0,0 +1,76 @@
+#ifndef FCODEC_H
+#define FCODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fast lossless frame codec (QOI class)
+ *  - RGBA: the QOI op set (index / diff / luma / run / raw)
+ *  - Gray: same idea on one channel (7-bit diff, run, raw)
+ *  - Frames are cut into horizontal stripes that are encoded and decoded
+ *    independently, one thread per stripe
+ *  - .fcv streams: header + length-prefixed frames, read through mmap
+ *  - Plain .qoi files (single stream, spec-compatible) for dataset images
+ *
+ * Frame ("FCF1"): magic, w, h, channels, stripe count, stripe sizes, payloads.
+ * Decoded pixels are always top-down and tightly packed.
+ */
+
+#define FCODEC_MAX_STRIPES 64
+
+typedef struct {
+    int w, h;
+    int ch;         /* 1 or 4 */
+    int stripes;
+} FcodecInfo;
+
+/* Worst-case encoded size of one frame */
+size_t fcodec_bound(int w, int h, int ch, int stripes);
+
+/* px: ch = 1 (gray) or 4 (RGBA), stride in bytes (0 = tight), bottom_up for
+ * glReadPixels buffers. Returns the encoded size, 0 on error. */
+size_t fcodec_encode(const uint8_t* px, int w, int h, int ch, int stride, bool bottom_up,
+                     int stripes, uint8_t* out, size_t cap);
+
+bool   fcodec_info(const uint8_t* data, size_t size, FcodecInfo* info);
+
+/* out: w * h * ch bytes. threads <= 1 decodes on the calling thread. */
+bool   fcodec_decode(const uint8_t* data, size_t size, uint8_t* out, int threads);
+
+/* ---- Standard QOI files ---- */
+bool     fcodec_write_qoi(const char* path, const uint8_t* rgba, int w, int h, bool bottom_up);
+uint8_t* fcodec_read_qoi(const char* path, int* w, int* h);   /* RGBA, free() */
+
+/* ---- .fcv frame streams ---- */
+typedef struct {
+    int            fd;
+    const uint8_t* map;
+    size_t         size;
+    int            w, h, ch;
+    double         fps;
+    long           count;
+    size_t*        offsets;    /* payload offset of each frame */
+    uint32_t*      sizes;
+} FcodecStream;
+
+/* Writer side: plain stdio, frames appended in order */
+bool fcodec_stream_write_header(FILE* f, int w, int h, int ch, double fps);
+bool fcodec_stream_write_frame(FILE* f, const uint8_t* data, size_t size);
+
+/* Reader side: mmap + index; a truncated last frame is ignored */
+bool           fcodec_stream_open(FcodecStream* s, const char* path);
+const uint8_t* fcodec_stream_frame(const FcodecStream* s, long i, size_t* size);
+void           fcodec_stream_close(FcodecStream* s);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* FCODEC_H */
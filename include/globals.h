@@ -19,7 +19,7 @@
 // === World & Terrain Constants ===
 // =========================================
 #define EDGE_SIZE_OF_EACH_CHUNK 5120
-#define MAX_PLANES              6
+#define MAX_PLANES              6       /* stock scenario (minimap icons, ID pass, snapshots) */
 
 // =========================================
 // === Plane Data Structures ===
@@ -49,7 +49,8 @@ typedef struct {
 // =========================================
 // === Global Variables (defined in .c) ===
 // =========================================
-extern Plane planes[MAX_PLANES];
+extern Plane *planes;          /* planes[0] is the player; --scenario may resize */
+extern int    plane_count;
 
 extern const int SCR_WIDTH;
 extern const int SCR_HEIGHT;
@@ -93,4 +94,13 @@ extern float offset_right;
 GLuint compileShader(const char *source, GLenum type);
 GLuint createShaderProgram(const char *vsSource, const char *fsSource);
 
+// Engine setup / teardown (shaders, terrain, plane mesh, OSD, minimap)
+void INIT_SYSTEM(void);
+void CLEANUP_SYSTEM(void);
+
+// 2D box overlay in screen pixels (detections, tracks)
+void init_box_drawing(void);
+void drawBoundingBoxColored(int L, int T, int R, int B, float thickness_px,
+                            float r, float g, float b, float a);
+
 #endif // GLOBALS_H
@@ -0,0 +1,39 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <GLES2/gl2.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Window-less GLES2 context through EGL
+ *  - Default display + pbuffer surface when available
+ *  - Otherwise EGL_MESA_platform_surfaceless + KHR_surfaceless_context,
+ *    rendering into an offscreen FBO that stands in for the window
+ * Mesa llvmpipe works, so no GPU or X server is needed.
+ */
+
+bool   headless_init(int width, int height);
+
+/* Framebuffer the app should treat as "the screen" (0 with a pbuffer) */
+GLuint headless_default_fbo(void);
+
+/* Finish the frame (eglSwapBuffers on pbuffer, glFlush otherwise) */
+void   headless_swap(void);
+
+/* Extension entry point (eglGetProcAddress), NULL if unknown */
+void*  headless_get_proc(const char* name);
+
+/* Renderer string for logs */
+const char* headless_renderer(void);
+
+void   headless_shutdown(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* HEADLESS_H */
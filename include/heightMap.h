@@ -19,6 +19,18 @@ void init_heightmap_texture(void);
 void init_chunks(void);
 void update_chunks(void);
 void draw_chunks(mat4 view, mat4 proj);
+// Chunk meshes generated since start (streaming and snapshot restores)
+long chunk_generations(void);
+
+// Chunk pool residency (which tile each slot holds) for snapshots.
+// Restoring regenerates only the slots whose tile changed.
+typedef struct {
+    int32_t gridX, gridZ;
+    int32_t isActive;
+} ChunkResidency;
+
+void get_chunk_residency(ChunkResidency out[TOTAL_CHUNKS]);
+void set_chunk_residency(const ChunkResidency in[TOTAL_CHUNKS]);
 
 // Sample terrain height in world units
 float get_terrain_height(float x, float z);
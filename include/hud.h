@@ -0,0 +1,44 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Performance HUD (--hud, H toggles it in a window)
+ *  - Rolling p50/p95/p99 over the last HUD_WINDOW samples of the frame
+ *    time and every detection stage (log-bucketed, see stats.h)
+ *  - Queue depths of the video, dataset, black-box and shadow workers,
+ *    what they dropped, and frames over budget (1.5x the frame period)
+ *  - Drawn with the OSD text renderer; one line is rebuilt per frame so
+ *    the cost stays flat. The last line shows that cost: the rebuild plus
+ *    the CPU side of drawing the lines. Text slots are taken on first show.
+ */
+
+#define HUD_WINDOW 600
+
+/* After init_osd. budget_ms: frame period to check against (0 = none) */
+bool hud_init(bool visible, double budget_ms);
+void hud_toggle(void);
+bool hud_visible(void);
+
+/* Samples are taken while hidden too, so the HUD opens with history */
+void hud_frame(double frame_ms);
+/* DETLOG_STAGES stage times; track_ms < 0 when the tracker did not run */
+void hud_detection(const float* stage_ms, double track_ms);
+
+/* Once per frame, before the texts are drawn */
+void hud_update(void);
+/* After draw_texts: the HUD lines are drawn (and timed) here, not there */
+void hud_draw(void);
+
+void hud_free(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* HUD_H */
@@ -0,0 +1,42 @@
+#ifndef IDPASS_H
+#define IDPASS_H
+
+#include <stdbool.h>
+#include "globals.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Instance-ID pass: exact, occlusion-aware plane boxes
+ *  - Planes are drawn with depth testing into a small offscreen target in
+ *    flat colors (R = plane index + 1), so hidden parts never show up
+ *  - A reduction shader collapses the ID image into per-ID column and row
+ *    pixel counts (one output row per ID and axis)
+ *  - Only that (max(w,h) x 2*MAX_PLANES) strip is read back; the CPU turns
+ *    it into tight boxes and visible pixel counts
+ */
+
+typedef struct {
+    int   visible_px;          /* 0: not visible (box undefined) */
+    float x1, y1, x2, y2;      /* top-down pixels, x2/y2 exclusive */
+} IdPassBox;
+
+/* w, h: size of the image the boxes refer to (the detection target) */
+bool idpass_init(int w, int h);
+bool idpass_ready(void);
+
+/* Draws planes[] with view/proj into viewport (vp_x, vp_y, vp_w, vp_h)
+ * (GL, bottom-up, same as the color pass) and fills out[i] for planes[i].
+ * Restores the bound framebuffer, viewport and depth test. */
+bool idpass_run(mat4 view, mat4 proj, int vp_x, int vp_y, int vp_w, int vp_h,
+                IdPassBox out[MAX_PLANES]);
+
+void idpass_destroy(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* IDPASS_H */
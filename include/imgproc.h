@@ -0,0 +1,87 @@
+#ifndef IMGPROC_H
+#define IMGPROC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "onnx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Frame -> model tensor kernels (SSE2 with scalar fallbacks)
+ *  - RGB8 / RGBA8 / GRAY8 -> gray conversion, optional bottom-up flip
+ *  - Bilinear and area (box) resize of gray frames
+ *  - Letterbox into the 3-channel normalized CHW tensor the detector expects
+ *  - Inverse box transform back to source pixel coordinates
+ */
+
+typedef enum {
+    PIX_GRAY8 = 1,
+    PIX_RGB8  = 3,
+    PIX_RGBA8 = 4
+} PixFormat;
+
+typedef enum {
+    RESIZE_BILINEAR = 0,
+    RESIZE_AREA     = 1   /* box filter; falls back to bilinear when upscaling */
+} ResizeMode;
+
+/* tensor = source * scale + offset (per axis) */
+typedef struct {
+    float scale_x, scale_y;
+    float off_x, off_y;
+    int   content_x, content_y;   /* letterboxed content rect in the tensor */
+    int   content_w, content_h;
+    int   src_w, src_h;
+} BoxTransform;
+
+/* Reusable intermediate buffers (grown on demand) */
+typedef struct {
+    uint8_t*  gray;      size_t gray_cap;
+    uint8_t*  resized;   size_t resized_cap;
+    uint16_t* row16;     size_t row16_cap;
+    float*    rowf;      size_t rowf_cap;
+    int32_t*  xtab;      size_t xtab_cap;
+    float*    wtab;      size_t wtab_cap;
+} ImgScratch;
+
+/* Aspect-preserving fit of src into dst, content centred */
+BoxTransform imgproc_letterbox_fit(int src_w, int src_h, int dst_w, int dst_h);
+
+/* Map a tensor-space box back to source pixels (clamped to the source) */
+void imgproc_unmap_box(const BoxTransform* tf, OnnxDet* det);
+
+/* Row kernels */
+void imgproc_rgba_to_gray(const uint8_t* src, uint8_t* dst, int n);
+void imgproc_rgb_to_gray(const uint8_t* src, uint8_t* dst, int n);
+
+/* Whole frame to gray (stride in bytes, 0 = tight) */
+void imgproc_to_gray(const uint8_t* src, PixFormat fmt, int w, int h, int stride,
+                     int bottom_up, uint8_t* dst);
+
+/* Gray resize; dst_stride 0 = tight */
+int imgproc_resize_gray(ImgScratch* s, const uint8_t* src, int sw, int sh,
+                        uint8_t* dst, int dw, int dh, int dst_stride, ResizeMode mode);
+
+/* Gray rows -> three identical normalized planes (x / 255) */
+void imgproc_gray_to_chw3(const uint8_t* gray, int n, float* c0, float* c1, float* c2);
+
+/* Any frame -> letterboxed [3, dst_h, dst_w] tensor; pad_value in 0..1.
+ * out_tf (optional) receives the transform for imgproc_unmap_box. */
+int imgproc_frame_to_tensor(ImgScratch* s,
+                            const uint8_t* src, PixFormat fmt, int w, int h, int stride, int bottom_up,
+                            float* dst_chw, int dst_w, int dst_h,
+                            ResizeMode mode, float pad_value, BoxTransform* out_tf);
+
+/* Detection readback path: bottom-up RGBA8 W x H -> gray3 CHW / 255 */
+void rgba_flip_gray3_chw_norm(const unsigned char* src, float* dst, int W, int H);
+
+void imgproc_scratch_free(ImgScratch* s);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* IMGPROC_H */
@@ -0,0 +1,60 @@
+#ifndef INFER_CACHE_H
+#define INFER_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Inference memoization for deterministic replays
+ *  - Key: 64-bit hash of the input tensor bytes
+ *  - Value: raw detector output rows (before post-processing)
+ *  - Backing store: one memory-mapped file, open addressing slot table
+ *    followed by an append-only float arena
+ *
+ * A file created for another model (different tag) is reset on open.
+ * The file is locked (flock) while open; a second instance sharing the
+ * path gets -1 from infer_cache_open and runs uncached.
+ */
+
+typedef struct InferCache {
+    int      fd;
+    uint8_t* base;          /* mmap base */
+    size_t   size;          /* mapped bytes */
+    void*    header;        /* CacheHeader*, internal */
+    void*    slots;         /* CacheSlot*,   internal */
+    float*   arena;
+    uint64_t hits, misses;
+    int      full_warned;
+} InferCache;
+
+/* Open or create `path`. slot_count is rounded up to a power of two;
+ * arena_floats bounds the stored outputs. Returns 0 on success. */
+int infer_cache_open(InferCache* c, const char* path, uint64_t model_tag,
+                     uint32_t slot_count, uint64_t arena_floats);
+
+/* Fast 64-bit hash (xxh64-style, 4 lanes) */
+uint64_t infer_cache_hash(const void* data, size_t len);
+
+/* Model tag from the file's contents and size (0 if unreadable), so a
+ * retrained model at the same path does not hit old entries */
+uint64_t infer_cache_file_tag(const char* path);
+
+/* 1 on hit: *out points into the mapping (rows * cols floats) */
+int infer_cache_lookup(InferCache* c, uint64_t key,
+                       const float** out, int* rows, int* cols);
+
+/* 0 on success, -1 when the table or arena is full */
+int infer_cache_store(InferCache* c, uint64_t key,
+                      const float* data, int rows, int cols);
+
+void infer_cache_close(InferCache* c);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* INFER_CACHE_H */
@@ -0,0 +1,43 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Metrics exporter (--metrics PATH | unix:/path)
+ *  - Counters (frames, late frames, chunk generations, worker drops) and
+ *    log-bucketed histograms (stats.h) of the frame time, every detection
+ *    stage, the tracker and the worker queue depths, all since start
+ *  - Every --metrics-interval seconds one JSON line is written with plain
+ *    write(2): appended to a file, or sent to a listening SOCK_STREAM Unix
+ *    socket (non-blocking; reconnects on the next flush, a line that does
+ *    not fit is dropped and counted rather than waiting for the reader)
+ *  - Histograms carry count/sum/max, p50/p95/p99 and the non-empty buckets
+ *    as [lower bound, count] pairs
+ *  - Recording is a few adds per frame; formatting happens only on flush.
+ * Render thread only.
+ */
+
+#define METRICS_INTERVAL_S 1.0
+
+/* budget_ms: frame period for the late-frame counter (0 = none) */
+bool metrics_open(const char* target, double interval_s, double budget_ms);
+bool metrics_active(void);
+
+/* Once per frame; also samples queue depths and flushes when due */
+void metrics_frame(double frame_ms);
+/* DETLOG_STAGES stage times; track_ms < 0 when the tracker did not run */
+void metrics_detection(const float* stage_ms, double track_ms);
+
+/* Writes a last line and closes the target */
+void metrics_close(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* METRICS_H */
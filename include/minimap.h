@@ -3,6 +3,8 @@
 
 #include "globals.h"
 
+#define MINIMAP_TEXTURE_SIZE 256
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -22,6 +24,9 @@ void reset_minimap_for_restart(void);
 // Release resources
 void cleanup_minimap(void);
 
+// Rasterize one plane icon (CPU) into a MINIMAP_TEXTURE_SIZE^2 RGBA buffer
+void draw_starfighter_icon(float angle_rad, StarfighterColors *colors, unsigned char *targetPixelData);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,45 @@
+#ifndef MOT_H
+#define MOT_H
+
+#include <stdbool.h>
+#include "onnx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Multi-object tracking evaluation (--mot FILE.json)
+ *  - Ground truth identity is the plane's index in planes[], boxes are the
+ *    --eval / --dataset ground truth; hypotheses are the confirmed tracks
+ *  - Frames are kept compactly (ids + IoU matrix) and scored at close:
+ *      CLEAR MOT: MOTA, MOTP, ID switches (per-frame Hungarian, previous
+ *                 correspondences kept while IoU >= MOT_IOU)
+ *      Identity:  IDF1, IDP, IDR (one global ID assignment)
+ *      HOTA:      DetA, AssA, LocA averaged over alpha = 0.05 .. 0.95
+ *  - Tracker CPU time per frame (thread CPU clock) next to the scores, so a
+ *    cheaper tracking cadence can be weighed against its identity cost
+ */
+
+#define MOT_IOU        0.5f     /* CLEAR / identity match threshold */
+#define MOT_MAX_BOXES  256      /* per frame and side; the rest is ignored */
+#define MOT_CPU_SAMPLES (1 << 18)
+
+/* track_every: tracker cadence, written to the report */
+bool mot_open(const char* path, int track_every);
+bool mot_active(void);
+
+/* One frame. Hypotheses with id < 0 (unconfirmed) are ignored.
+ * tracker_ms < 0: the tracker did not run this frame; hyp / nhyp are ignored
+ * and its previous output is held, as a consumer would see it. */
+void mot_frame(const OnnxDet* gt, const int* gt_ids, int ngt,
+               const OnnxDet* hyp, const int* hyp_ids, int nhyp, double tracker_ms);
+
+/* Scores the run, writes the JSON report, prints the summary and frees */
+bool mot_close(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* MOT_H */
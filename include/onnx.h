@@ -12,7 +12,11 @@ extern "C" {
  * Minimal ONNX Runtime C wrapper API
  *  - Model load/unload
  *  - Inference with RGB8 (HWC) input sized w x h
+ *  - Inference with raw RGBA8 readback when the model has the
+ *    preprocessing fused in (tools/fuse_preprocess.py)
  *  - Post-processing returns pixel-space boxes & scores
+ *  - Optional memoization of raw outputs by input hash (infer_cache.h)
+ *  - Optional ORT per-operator profiling (trace.h merges it)
  */
 
 /* Forward-declare ONNX Runtime types so this header
@@ -38,9 +42,10 @@ typedef struct {
 typedef struct {
     int   intra_threads;     /* intra-op threads */
     int   inter_threads;     /* inter-op threads */
-    float score_thresh;      /* pre-NMS score threshold */
+    float score_thresh;      /* output rows below are dropped (NMS is in the model) */
     float nms_iou_thresh;    /* NMS IoU threshold */
     int   verbose;           /* 0/1 logging */
+    const char* profile_prefix; /* ORT profiling file prefix (NULL = off) */
 } OnnxConfig;
 
 /* Status codes */
@@ -65,8 +70,11 @@ typedef struct {
     char* output_name;             /* owned by ORT allocator */
 
     int64_t in_n, in_c, in_h, in_w; /* expected input NCHW */
+    int     in_u8;                  /* 1: fused model, uint8 [1,H,W,4] RGBA input */
 
     OnnxConfig cfg;                /* runtime config */
+
+    struct InferCache* cache;      /* optional memoization (infer_cache.h), not owned */
 } OnnxDetector;
 
 /* Defaults */
@@ -75,11 +83,16 @@ OnnxConfig onnx_default_config(void);
 /* Load model from path */
 int onnx_load_model(OnnxDetector* detector, const char* model_path, const OnnxConfig* cfg);
 
-/* Inference on RGB8 HWC image of size w x h */
+/* Inference on the preprocessed float CHW tensor, or (in_u8 models)
+ * directly on the bottom-up RGBA8 glReadPixels buffer of size w x h */
 int onnx_predict(const OnnxDetector* detector,
                  const uint8_t* img_rgb, int w, int h,
                  OnnxDet** out_dets, int* out_count);
 
+/* Stops ORT profiling: *out_path (malloc'd) is the profile JSON and
+ * *start_ns its time origin in ns on the system clock */
+int onnx_end_profiling(OnnxDetector* detector, char** out_path, uint64_t* start_ns);
+
 /* Cleanup */
 void onnx_destroy(OnnxDetector* detector);
 void onnx_free_detections(OnnxDet* dets);
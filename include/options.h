@@ -0,0 +1,107 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Build-time defaults (overridable from the command line)
+#define USE_VSYNC  1
+#define TARGET_FPS 0.0
+
+// Machine profile written by autotune, loaded at startup when present
+#define TUNE_PROFILE_DEFAULT "tune.profile"
+
+// ===============================
+// Command-line options (main.c)
+// ===============================
+typedef struct {
+    // Context / loop
+    bool        headless;        // EGL offscreen, no window, uncapped
+    long        max_frames;      // stop after N frames (0 = run until closed)
+    bool        vsync;           // windowed only
+    double      target_fps;      // windowed, vsync off; 0 = uncapped
+
+    // Simulation clock
+    double      fixed_hz;        // fixed-step rate; 0 = variable dt (legacy)
+    double      time_warp;       // simulated seconds per real second
+    unsigned long long seed;     // randomized start (0 = stock scenario)
+
+    // Scenario (aircraft, trajectories, camera script)
+    const char *scenario_path;   // scenario file (NULL = stock six planes)
+    int         aircraft;        // total aircraft, overrides the file (0 = as defined)
+
+    // Session record / replay
+    const char *record_path;     // write inputs of every frame (NULL = off)
+    const char *replay_path;     // drive the sim from a recording (NULL = off)
+    long        replay_from;     // ... simulating, not drawing, the frames before this
+
+    // Snapshots
+    const char *snapshot_load;   // warm-start from this state (NULL = off)
+    const char *snapshot_save;   // write the state here ...
+    long        snapshot_at;     // ... after this frame (0 = at exit)
+
+    // Annotated video output
+    const char *video_path;      // .y4m, .fcv or raw rgb24 (NULL = off)
+    int         video_downscale; // 1 = full size, N = 1/N per side (box-filtered by the writer)
+
+    // Black-box recorder
+    const char *blackbox_dir;    // crash / spike dumps (NULL = off)
+    double      blackbox_seconds;  // history kept in memory
+    double      blackbox_spike_ms; // frame time that triggers a dump (0 = crash only)
+
+    // Frame trace (CPU spans, GPU timer queries, ORT operators)
+    const char *trace_path;      // Chrome trace-event JSON (NULL = off)
+    bool        hud;             // performance HUD shown at start (H toggles)
+    const char *metrics_target;  // JSONL metrics: file or "unix:/path" (NULL = off)
+    double      metrics_interval;// seconds between metric lines (0 = METRICS_INTERVAL_S)
+
+    // Machine profile (flags file, below scenario args and the command line)
+    const char *profile_path;    // NULL = TUNE_PROFILE_DEFAULT if present, "none" = off
+
+    // Detection
+    const char *model_path;      // NULL = ./models default, "none" = sky-blob fallback
+    int         det_size;        // detector input side (0 = model's / DET_W)
+    int         intra_threads;   // ONNX Runtime intra-op threads (0 = onnx default)
+    int         inter_threads;   // ONNX Runtime inter-op threads (0 = onnx default)
+    int         detect_every;    // detection cadence in frames (1 = every frame)
+    const char *infer_cache;     // memoization file (NULL = off)
+    const char *detlog_path;     // columnar detection/track log (NULL = off)
+    const char *eval_path;       // ground-truth evaluation report, JSON (NULL = off)
+    const char *mot_path;        // tracking evaluation report, JSON (NULL = off)
+    int         track_every;     // tracker cadence in frames (1 = every frame)
+    const char *shadow_model;    // candidate model for shadow mode (NULL = off)
+    int         shadow_sample;   // offer every Nth frame to the candidate
+
+    // Offline batch mode (no GL, no window)
+    const char *batch_input;     // image directory, .y4m or .fcv (NULL = off)
+    const char *batch_out;       // CSV path (NULL = stdout)
+    int         threads;         // batch workers / dataset writers (0 = auto)
+
+    // Synthetic training data
+    const char *dataset_dir;     // YOLO images + labels (NULL = off)
+    const char *dataset_format;  // "jpg" | "png" | "qoi"
+} AppOptions;
+
+extern AppOptions g_opts;
+
+// Defaults (build-time #defines, then environment variables)
+void default_options(AppOptions *o);
+
+// Returns false when the program should exit (bad flag or --help);
+// *exit_code receives the status to return.
+bool parse_options(int argc, char **argv, AppOptions *o, int *exit_code);
+
+// Flags file ('#' comments, whitespace separated) through parse_options.
+// A "# host NAME" line warns when the profile was tuned on another machine.
+bool load_profile(const char *path, AppOptions *o, int *exit_code);
+
+void print_usage(const char *argv0);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif // OPTIONS_H
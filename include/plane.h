@@ -19,15 +19,55 @@ void init_flight_model(Plane plane);
 // Simple AI tick for non-player planes.
 void update_enemy_plane(Plane *enemy);
 
+// Rebuild an enemy's model matrix from its position / front (no movement).
+void update_enemy_model_matrix(Plane *enemy);
+
 // Draw a single plane.
 void draw_plane(Plane *plane, mat4 view, mat4 proj);
 
+// Same mesh in a flat color with R = id / 255 (instance-ID pass).
+void draw_plane_id(Plane *plane, mat4 view, mat4 proj, int id);
+
+// Model-space AABB of the plane mesh (valid after init_plane).
+void plane_mesh_bounds(vec3 out_min, vec3 out_max);
+
 // ===============================
 // Player controls / autopilot
 // ===============================
+typedef enum {
+    FLY_STRAIGHT,
+    TURN_LEFT,
+    TURN_RIGHT,
+    AUTO_PITCH_UP,
+    AUTO_PITCH_DOWN,
+    SET_SPEED,
+    TOGGLE_SPEED_LOCK,
+    SET_CAMERA,
+    HOLD_ZOOM,
+    TOGGLE_GRID_VIEW
+} AutopilotAction;
+
+typedef struct {
+    AutopilotAction action;
+    float duration;
+    float value;
+} AutopilotCommand;
+
 void autoPilotMode(void);
 void reset_autopilot_state(void);
 
+// Scripted flight plan position (record / replay divergence checks)
+int   autopilot_command_index(void);
+float autopilot_command_timer(void);
+void  autopilot_set_state(int command_index, float command_timer);
+int   autopilot_command_count(void);
+
+// Replace the built-in flight plan (NULL = restore it); commands must outlive it
+void  autopilot_set_plan(const AutopilotCommand *commands, int count);
+
+// Camera offsets of preset 1..8 (keys 1-8, SET_CAMERA); false if unknown
+bool  autopilot_camera_preset(int preset);
+
 void applyUpPitch(float rotation_speed);
 void applyDownPitch(float rotation_speed);
 void applyLeftTurn(float rotation_speed, float roll_speed);
@@ -0,0 +1,72 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "globals.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Flight session record / replay
+ *  - One record per rendered frame: frame dt, processInput key mask,
+ *    autopilot command index + timer (after the frame's sim steps)
+ *  - Records are delta-compressed (XOR + varint) against the previous
+ *    frame; a footer with the frame count closes the file
+ *  - Replay memory-maps the file; the recorded dt and keys drive the
+ *    same simulation code, and the autopilot values detect divergence
+ *  - The header carries --seed too, so a seeded run replays with the same
+ *    randomized start. The sim cannot jump to a frame, so --replay-from
+ *    fast-forwards: the skipped frames are stepped but not drawn
+ */
+
+/* Session-wide settings the replay must match */
+typedef struct {
+    bool   keyboard;       /* processInput drove the plane (else autopilot) */
+    double fixed_hz;       /* 0 = variable dt */
+    double time_warp;
+    uint64_t seed;         /* --seed, re-applied on replay (0 = none) */
+} ReplayInfo;
+
+typedef struct {
+    double   dt;           /* clamped frame dt fed to the sim clock */
+    uint32_t keys;         /* tracked key mask, see input_key_down */
+    int32_t  cmd_index;    /* autopilot state after the frame */
+    float    cmd_timer;
+} ReplayFrame;
+
+/* ---- Input abstraction (processInput reads keys through this) ---- */
+
+/* Snapshot the tracked keys of a live window into a mask */
+uint32_t input_poll_keys(GLFWwindow* win);
+
+/* Keys seen by the current frame (live poll or replayed mask) */
+void     input_set_keys(uint32_t mask);
+uint32_t input_keys(void);
+bool     input_key_down(int glfw_key);
+
+/* ---- Recording ---- */
+bool replay_record_start(const char* path, const ReplayInfo* info);
+void replay_record_frame(const ReplayFrame* f);
+bool replay_recording(void);
+void replay_record_stop(void);   /* writes the footer */
+
+/* ---- Replay (mmap) ---- */
+bool     replay_open(const char* path, ReplayInfo* out_info);
+bool     replay_active(void);
+bool     replay_next(ReplayFrame* out);        /* false at end of file */
+uint64_t replay_frame_count(void);
+uint64_t replay_position(void);                /* frames returned so far */
+
+/* Compare the live autopilot state with the frame just replayed;
+ * warns once on the first mismatch. Returns false when diverged. */
+bool     replay_check(const ReplayFrame* expected, int cmd_index, float cmd_timer);
+void     replay_close(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* REPLAY_H */
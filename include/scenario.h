@@ -0,0 +1,55 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Scenario files (--scenario FILE)
+ *  - Plain text, one directive per line, '#' comments, key=value fields:
+ *      aircraft N                         total incl. the player (fills up)
+ *      player   pos=X,Y,Z heading=DEG
+ *      spawn    count=N pattern=point|line|grid|ring|random ... path=...
+ *      plan     ACTION DURATION [VALUE]   replaces the built-in flight plan
+ *      camera   t=SEC preset=N | offset=BEHIND,ABOVE,RIGHT [fov=DEG]
+ *      args     --flag value ...          command-line flags (the real
+ *                                         command line wins)
+ *  - Trajectories per spawn group: follow (stock: mirror the player's
+ *    heading), straight, orbit (around the ring centre) and waypoints
+ *  - planes[] is reallocated to the scenario size before INIT_SYSTEM;
+ *    minimap icons and the ID pass cover the first MAX_PLANES aircraft
+ *  - Everything is a function of the file and the sim clock, so recordings
+ *    replay as long as they are given the same scenario
+ */
+
+#define SCENARIO_MAX_PLANES    100000
+#define SCENARIO_MAX_ARGS      64
+#define SCENARIO_MAX_PLAN      256
+#define SCENARIO_MAX_CAMERA    256
+#define SCENARIO_MAX_SPAWNS    256
+#define SCENARIO_MAX_WAYPOINTS 64      /* per spawn group */
+
+/* Parses the file (no GL, before option parsing). Errors name the line. */
+bool scenario_load(const char* path);
+bool scenario_active(void);
+
+/* "args" lines as an argv (argv[0] = file name) for parse_options */
+int  scenario_args(char*** argv);
+
+/* Builds planes[] and installs the flight plan. aircraft > 0 overrides the
+ * file's count (also without a file: the stock six plus a grid). */
+bool scenario_apply(int aircraft);
+
+/* One sim step: enemy trajectories and the camera script */
+void scenario_step(double sim_time, float dt);
+
+void scenario_free(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* SCENARIO_H */
@@ -0,0 +1,54 @@
+#ifndef SHADOW_H
+#define SHADOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "onnx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shadow-mode evaluation of a candidate model
+ *  - Candidate runs on its own low-priority thread (SCHED_IDLE / nice 19);
+ *    its session is created there, so ORT's intra-op threads inherit that
+ *  - Render thread hands over sampled RGBA readbacks + production boxes
+ *    through a single-slot mailbox; busy worker => frame skipped, never waits
+ *  - Reports box agreement (IoU matching) and p50/p95/p99 latency of both
+ */
+
+typedef struct {
+    int   sample_every;    /* offer every Nth detection frame */
+    float iou_match;       /* IoU needed to count two boxes as agreeing */
+    float score_thresh;    /* boxes below are ignored on both sides */
+    int   intra_threads;   /* candidate ORT intra-op threads */
+    int   report_every;    /* print a report every N compared frames (0: only at stop) */
+    int   frame_w, frame_h; /* size of the offered frames; a fixed-input candidate must match */
+} ShadowConfig;
+
+ShadowConfig shadow_default_config(void);
+
+/* Load the candidate and start the worker. 0 on success; fails if the
+ * candidate has a fixed input size other than frame_w x frame_h. */
+int  shadow_start(const char* model_path, const ShadowConfig* cfg);
+
+/* Offer a frame (bottom-up RGBA8, w x h) with the production result.
+ * Cheap when not sampled; one memcpy when handed over. */
+void shadow_offer(const uint8_t* rgba, int w, int h,
+                  const OnnxDet* prod, int prod_count, double prod_ms);
+
+int  shadow_active(void);
+/* 1 while the candidate holds a frame; *dropped: sampled frames it was busy for (may be NULL) */
+int  shadow_queue_depth(long* dropped);
+void shadow_report(FILE* out);
+
+/* Stop the worker, print the final report, release the candidate */
+void shadow_stop(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* SHADOW_H */
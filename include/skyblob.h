@@ -0,0 +1,74 @@
+#ifndef SKYBLOB_H
+#define SKYBLOB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "onnx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Classical sky-blob proposal detector
+ *  - RGBA8 readback -> gray (SIMD)
+ *  - Coarse background grid (SKYBLOB_CELL px cells, median, bilinear)
+ *  - |gray - background| > thresh -> run-length connected components
+ *  - Emits pixel-space boxes in the same OnnxDet format as the model
+ *
+ * Used as a fallback when no model is loaded.
+ */
+
+#define SKYBLOB_CELL  16   /* background grid cell size (px) */
+#define SKYBLOB_CLASS (-1) /* class id reported for proposals */
+
+typedef struct {
+    int   thresh;         /* |gray - bg| threshold (0..255) */
+    int   min_area;       /* drop blobs with fewer pixels */
+    int   merge_gap;      /* merge boxes closer than this (px) */
+    int   max_blobs;      /* output cap */
+} SkyBlobConfig;
+
+typedef struct {
+    int w, h;             /* frame size the buffers are sized for */
+    SkyBlobConfig cfg;
+
+    uint8_t*  gray;       /* roi_w * roi_h */
+    uint8_t*  bg_row;     /* one background row */
+    uint8_t*  diff_row;   /* one |gray - bg| row */
+    uint32_t* cell_sum;   /* background grid sums */
+    uint16_t* cell_cnt;
+    uint8_t*  cell_mean;
+
+    void* runs;           /* Run[], internal */
+    void* blobs;          /* Blob[], internal */
+    int   run_capacity;
+} SkyBlobDetector;
+
+/* Defaults */
+SkyBlobConfig skyblob_default_config(void);
+
+/* Allocate buffers for frames up to w x h */
+int skyblob_init(SkyBlobDetector* d, int w, int h, const SkyBlobConfig* cfg);
+
+/* Detect blobs inside roi (top-left origin) of an RGBA8 frame.
+ * bottom_up != 0 for glReadPixels order. Free with onnx_free_detections. */
+int skyblob_detect_rgba(SkyBlobDetector* d,
+                        const uint8_t* rgba, int bottom_up,
+                        int roi_x, int roi_y, int roi_w, int roi_h,
+                        OnnxDet** out_dets, int* out_count);
+
+/* Same on a top-down GRAY8 frame of any size; the ROI must fit the
+ * init size (roi_w <= w, roi_h <= h). stride 0 = tight */
+int skyblob_detect_gray(SkyBlobDetector* d,
+                        const uint8_t* gray, int w, int h, int stride,
+                        int roi_x, int roi_y, int roi_w, int roi_h,
+                        OnnxDet** out_dets, int* out_count);
+
+void skyblob_destroy(SkyBlobDetector* d);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* SKYBLOB_H */
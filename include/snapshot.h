@@ -0,0 +1,57 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "globals.h"
+#include "heightMap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Simulation state snapshots (warm start / fan-out)
+ *  - Fixed-size POD record: a few KB, one read + checksum to load
+ *  - Tied to the build layout (sizeof check); snapshots are meant for
+ *    the jobs of one build, not for long-term storage
+ * main.c fills / applies SimState; this module only owns the file format.
+ */
+
+typedef struct {
+    Plane   planes[MAX_PLANES];
+
+    /* camera */
+    float   offset_behind, offset_above, offset_right;
+    vec3    cameraPos, cameraFront, cameraUp, cameraRight;
+    float   fov;
+
+    /* flight / autopilot */
+    int32_t cmd_index;
+    float   cmd_timer;
+    float   currentMovementSpeed, fixedValue, gravitySpeed;
+    float   verticalSpeed, lastAltitude;
+    uint8_t isAutopilotOn, startingAutoPilotMode, isSpeedFixed, automaticCameraMovement;
+
+    /* crash */
+    uint8_t isCrashed, hasSetCrashView, pad_[2];
+    vec3    crashPosition;
+
+    /* clock */
+    double  sim_time, sim_accum;
+    int64_t frame;
+
+    /* terrain chunk pool */
+    ChunkResidency chunks[TOTAL_CHUNKS];
+} SimState;
+
+bool snapshot_save(const char* path, const SimState* st);
+
+/* false on missing file, other build layout or checksum mismatch */
+bool snapshot_load(const char* path, SimState* out);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* SNAPSHOT_H */
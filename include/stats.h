@@ -0,0 +1,74 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Latency sample window
+ *  - Fixed-capacity ring of the most recent samples (ms)
+ *  - Percentiles computed on demand from a sorted copy
+ */
+typedef struct {
+    double* v;        /* ring storage */
+    double* scratch;  /* sort buffer */
+    int     cap;
+    int     count;    /* valid samples (<= cap) */
+    int     head;     /* next write index */
+    long    total;    /* samples ever pushed */
+} LatencyWindow;
+
+int    latwin_init(LatencyWindow* w, int capacity);
+void   latwin_push(LatencyWindow* w, double ms);
+void   latwin_reset(LatencyWindow* w);
+void   latwin_free(LatencyWindow* w);
+
+/* Fills out[i] with the ps[i] percentile (0..100); returns sample count */
+int    latwin_percentiles(LatencyWindow* w, const double* ps, double* out, int n);
+
+/* Percentile of an already sorted array (linear interpolation) */
+double stats_percentile_sorted(const double* sorted, int n, double p);
+
+/*
+ * Log-bucketed histogram (ms)
+ *  - LOGHIST_SUB buckets per octave from LOGHIST_MIN_MS up (6-12 % wide),
+ *    bucket 0 holds everything below; the last one everything above
+ *  - Adding is O(1), a percentile is one scan over the buckets
+ *  - RollingHist: the same over the last N samples (one byte per sample)
+ */
+#define LOGHIST_MIN_MS   0.001
+#define LOGHIST_SUB      8
+#define LOGHIST_OCTAVES  24        /* up to ~16.7 s */
+#define LOGHIST_BUCKETS  (1 + LOGHIST_OCTAVES * LOGHIST_SUB)
+
+typedef struct {
+    uint32_t n[LOGHIST_BUCKETS];
+    uint64_t count;
+    double   sum, max;     /* add only (RollingHist leaves them alone) */
+} LogHist;
+
+int    loghist_bucket(double ms);
+double loghist_bucket_lower(int b);          /* ms; upper = lower(b + 1) */
+void   loghist_add(LogHist* h, double ms);
+void   loghist_reset(LogHist* h);
+double loghist_percentile(const LogHist* h, double p);   /* p in 0..100 */
+
+typedef struct {
+    LogHist  h;
+    uint8_t* ring;         /* bucket of each sample in the window */
+    int      cap, count, head;
+} RollingHist;
+
+int    rollhist_init(RollingHist* r, int capacity);
+void   rollhist_push(RollingHist* r, double ms);
+void   rollhist_free(RollingHist* r);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* STATS_H */
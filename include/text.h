@@ -76,7 +76,27 @@ bool update_text(int id, const char *str);
 bool change_text_colour(int id, float r, float g, float b, float a);
 
 //
-// draw all the texts to screen
+// hidden texts are skipped by draw_texts (draw_text_range still draws them)
+void set_text_visible(int id, bool visible);
+
+//
+// draw all the visible texts to screen
 void draw_texts();
 
+//
+// draw texts first..first+count-1 only, so a caller can own (and time) a group
+void draw_text_range(int first, int count);
+
+//
+// build the glyph quads of str and upload them into the two VBOs
+// (br_x, br_y: bottom-right corner of the text area, clip space)
+void text_to_vbo(
+    const char *str,
+    float scale_px,
+    GLuint *points_vbo,
+    GLuint *texcoords_vbo,
+    int *point_count,
+    float *br_x,
+    float *br_y);
+
 #endif
@@ -0,0 +1,56 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Frame trace in Chrome trace-event JSON (--trace FILE.json)
+ *  - CPU spans: trace_begin / trace_end pairs on the render thread, kept
+ *    in a fixed event buffer and written out between frames
+ *  - GPU spans: trace_gpu_begin / trace_gpu_end also wrap the pass in an
+ *    EXT_disjoint_timer_query time-elapsed query. Results are collected a
+ *    few frames later without stalling and laid out in submit order on a
+ *    "GPU" track; disjoint intervals are dropped
+ *  - ONNX Runtime: the session's own per-operator profile is merged in on
+ *    close, shifted onto the same clock
+ *  - Opens in ui.perfetto.dev or chrome://tracing
+ *  - Off: every call is a single branch
+ * Names must be string literals (the pointer is kept). Not thread-safe.
+ */
+
+#define TRACE_MAX_DEPTH    32
+#define TRACE_GPU_QUERIES  64        /* time-elapsed queries in flight */
+
+typedef void* (*TraceGetProc)(const char* name);
+
+bool trace_open(const char* path);
+bool trace_active(void);
+
+/* Loads the timer-query entry points (needs a current context) */
+void trace_gpu_init(TraceGetProc get_proc);
+
+void trace_begin(const char* name);
+void trace_end(void);
+
+/* CPU span plus GPU time; GPU queries do not nest (inner ones are CPU only) */
+void trace_gpu_begin(const char* name);
+void trace_gpu_end(void);
+
+/* Frame boundary: collects finished GPU queries, writes buffered events */
+void trace_frame_end(long frame);
+
+/* ORT profile (onnx_end_profiling) to merge on close; start_ns on CLOCK_REALTIME */
+void trace_ort_profile(const char* path, uint64_t start_ns);
+
+void trace_close(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* TRACE_H */
@@ -0,0 +1,64 @@
+#ifndef TRACKER_H
+#define TRACKER_H
+
+#include "onnx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Greedy IoU multi-object tracker
+ *  - Tracks predicted with a constant-velocity box shift
+ *  - Detection <-> track pairs taken in descending IoU order
+ *  - Class is not part of the match: near/far classes flip with range
+ *  - Unmatched detections open tracks; tracks die after max_misses frames
+ */
+
+typedef struct {
+    float iou_match;     /* minimum IoU to continue a track */
+    int   max_misses;    /* frames a track may go unmatched */
+    int   min_hits;      /* matches before a track is reported */
+} TrackerConfig;
+
+typedef struct {
+    int   id;
+    int   cls;
+    float score;
+    float x1, y1, x2, y2;     /* last matched (or predicted) box */
+    float vx, vy;             /* centre velocity, px/frame */
+    int   hits, misses, age;
+} Track;
+
+typedef struct {
+    TrackerConfig cfg;
+    Track* tracks;
+    int    count, cap;
+    int    next_id;
+
+    /* scratch for matching */
+    void*  pairs;
+    int    pair_cap;
+    int*   det_track;
+    int    det_cap;
+} Tracker;
+
+TrackerConfig tracker_default_config(void);
+
+void tracker_init(Tracker* t, const TrackerConfig* cfg);
+
+/* Advance one frame. out_ids (optional, n entries) receives the track id
+ * of each detection, or -1 while its track is not yet confirmed. */
+int  tracker_update(Tracker* t, const OnnxDet* dets, int n, int* out_ids);
+
+/* Confirmed tracks matched in the last update */
+int  tracker_is_reported(const Tracker* t, const Track* tr);
+
+void tracker_reset(Tracker* t);
+void tracker_free(Tracker* t);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* TRACKER_H */
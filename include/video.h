@@ -0,0 +1,44 @@
+#ifndef VIDEO_H
+#define VIDEO_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Annotated video output
+ *  - video_capture() reads the finished frame (scene, boxes, OSD, minimap)
+ *    of the bound framebuffer into a ring of CPU buffers
+ *  - A writer thread flips/converts and writes it: "*.y4m" becomes
+ *    YUV4MPEG2 4:2:0 (BT.601 full range), "*.fcv" a lossless fcodec stream
+ *    (striped parallel encode, replayable through --batch), anything else
+ *    raw top-down rgb24
+ *  - Windowed runs drop frames when the ring is full so the frame rate
+ *    holds; headless runs wait instead, so the file has every frame
+ *  - downscale N > 1: the writer box-filters the readback by N first, so
+ *    conversion, encode and file shrink by N^2 (the readback stays full)
+ */
+
+#define VIDEO_RING_SLOTS    4
+#define VIDEO_MAX_DOWNSCALE 4
+
+/* width x height: framebuffer size; the file is (width/downscale) x (height/downscale) */
+bool video_open(const char* path, int width, int height, double fps, bool block_when_full, int downscale);
+bool video_active(void);
+
+/* Call after the last draw of the frame, before the swap */
+void video_capture(void);
+
+/* Frames waiting in the ring; *dropped: frames lost to a full ring or after a write error (may be NULL) */
+int  video_queue_depth(long* dropped);
+
+/* Drains the ring, joins the writer and prints the [VIDEO] summary */
+void video_close(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* VIDEO_H */
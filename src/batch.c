@@ -0,0 +1,558 @@
+#define _GNU_SOURCE
+#include "batch.h"
+#include "onnx.h"
+#include "imgproc.h"
+#include "skyblob.h"
+#include "tracker.h"
+#include "stats.h"
+#include "fcodec.h"
+#include "detlog.h"
+#include "stb_image.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define BATCH_SLOTS_PER_WORKER 2
+#define BATCH_LAT_WINDOW       8192
+
+static double now_ms(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec * 1000.0 + (double)t.tv_nsec / 1e6;
+}
+
+BatchConfig batch_default_config(void) {
+    BatchConfig c;
+    memset(&c, 0, sizeof(c));
+    c.score_thresh = 0.6f;
+    c.nms_iou = 0.45f;
+    return c;
+}
+
+/* ---------------- Frame sources ---------------- */
+
+typedef struct {
+    /* directory of images */
+    char**  files;
+    long    count;
+    /* y4m */
+    int            fd;
+    const uint8_t* map;
+    size_t         map_size;
+    int            w, h;
+    size_t*        offsets;     /* luma plane offset of each frame */
+    /* fcv (lossless recording) */
+    int            is_fcv;
+    FcodecStream   fcv;
+} FrameSource;
+
+static int has_image_ext(const char* name) {
+    const char* dot = strrchr(name, '.');
+    return dot && (!strcasecmp(dot, ".png") || !strcasecmp(dot, ".jpg") || !strcasecmp(dot, ".jpeg") ||
+                   !strcasecmp(dot, ".qoi"));
+}
+
+static int cmp_str(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static int open_dir_source(FrameSource* s, const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir) { perror("[BATCH] opendir"); return -1; }
+    long cap = 0;
+    struct dirent* e;
+    while ((e = readdir(dir)) != NULL) {
+        if (!has_image_ext(e->d_name)) continue;
+        if (s->count == cap) {
+            cap = cap ? cap * 2 : 256;
+            s->files = realloc(s->files, sizeof(char*) * (size_t)cap);
+        }
+        size_t n = strlen(path) + strlen(e->d_name) + 2;
+        s->files[s->count] = malloc(n);
+        snprintf(s->files[s->count], n, "%s/%s", path, e->d_name);
+        s->count++;
+    }
+    closedir(dir);
+    if (s->count) qsort(s->files, (size_t)s->count, sizeof(char*), cmp_str);
+    return 0;
+}
+
+/* YUV4MPEG2: header line, then "FRAME[ params]\n" + planes per frame */
+static int open_y4m_source(FrameSource* s, const char* path) {
+    s->fd = open(path, O_RDONLY);
+    if (s->fd < 0) { perror("[BATCH] open"); return -1; }
+    struct stat st;
+    if (fstat(s->fd, &st) != 0 || st.st_size < 10) { fprintf(stderr, "[BATCH] %s: empty\n", path); return -1; }
+    s->map_size = (size_t)st.st_size;
+    void* m = mmap(NULL, s->map_size, PROT_READ, MAP_PRIVATE, s->fd, 0);
+    if (m == MAP_FAILED) { perror("[BATCH] mmap"); return -1; }
+    s->map = (const uint8_t*)m;
+    madvise(m, s->map_size, MADV_SEQUENTIAL);
+
+    const uint8_t* end = s->map + s->map_size;
+    const uint8_t* nl = memchr(s->map, '\n', s->map_size);
+    if (!nl || memcmp(s->map, "YUV4MPEG2 ", 10) != 0) {
+        fprintf(stderr, "[BATCH] %s: not a YUV4MPEG2 stream\n", path);
+        return -1;
+    }
+
+    char hdr[512];
+    size_t hl = (size_t)(nl - s->map) < sizeof(hdr) - 1 ? (size_t)(nl - s->map) : sizeof(hdr) - 1;
+    memcpy(hdr, s->map, hl);
+    hdr[hl] = '\0';
+
+    const char* chroma = "420";
+    char cbuf[32] = "";
+    for (char* tok = strtok(hdr + 10, " "); tok; tok = strtok(NULL, " ")) {
+        if (tok[0] == 'W') s->w = atoi(tok + 1);
+        else if (tok[0] == 'H') s->h = atoi(tok + 1);
+        else if (tok[0] == 'C') { snprintf(cbuf, sizeof(cbuf), "%s", tok + 1); chroma = cbuf; }
+    }
+    if (s->w <= 0 || s->h <= 0) { fprintf(stderr, "[BATCH] %s: missing W/H\n", path); return -1; }
+
+    size_t luma = (size_t)s->w * s->h;
+    size_t cw = (size_t)(s->w + 1) / 2, ch = (size_t)(s->h + 1) / 2;
+    size_t chroma_bytes;
+    if (strstr(chroma, "p1") || strstr(chroma, "p9")) {   /* C420p10, C444p12, ... */
+        fprintf(stderr, "[BATCH] %s: only 8-bit Y4M is supported (C%s)\n", path, chroma);
+        return -1;
+    }
+    if (!strncmp(chroma, "mono", 4))           chroma_bytes = 0;
+    else if (!strncmp(chroma, "444alpha", 8))  chroma_bytes = luma * 3;
+    else if (!strncmp(chroma, "444", 3))       chroma_bytes = luma * 2;
+    else if (!strncmp(chroma, "422", 3))       chroma_bytes = cw * (size_t)s->h * 2;
+    else                                       chroma_bytes = cw * ch * 2;   /* 420jpeg/420mpeg2/420paldv */
+    size_t frame_bytes = luma + chroma_bytes;
+
+    long cap = 0;
+    const uint8_t* p = nl + 1;
+    while (p + 5 <= end && !memcmp(p, "FRAME", 5)) {
+        const uint8_t* fnl = memchr(p, '\n', (size_t)(end - p));
+        if (!fnl || (size_t)(end - (fnl + 1)) < frame_bytes) break;   /* truncated tail */
+        if (s->count == cap) {
+            cap = cap ? cap * 2 : 1024;
+            s->offsets = realloc(s->offsets, sizeof(size_t) * (size_t)cap);
+        }
+        s->offsets[s->count++] = (size_t)(fnl + 1 - s->map);
+        p = fnl + 1 + frame_bytes;
+    }
+    return 0;
+}
+
+/* fcodec stream (--video *.fcv): frames are decoded by the workers */
+static int open_fcv_source(FrameSource* s, const char* path) {
+    if (!fcodec_stream_open(&s->fcv, path)) {
+        fprintf(stderr, "[BATCH] %s: not a readable fcv stream\n", path);
+        return -1;
+    }
+    s->is_fcv = 1;
+    s->w = s->fcv.w;
+    s->h = s->fcv.h;
+    s->count = s->fcv.count;
+    return 0;
+}
+
+static int open_source(FrameSource* s, const char* path) {
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+    struct stat st;
+    if (stat(path, &st) != 0) { perror("[BATCH] stat"); return -1; }
+    if (S_ISDIR(st.st_mode)) return open_dir_source(s, path);
+    const char* dot = strrchr(path, '.');
+    if (dot && !strcasecmp(dot, ".fcv")) return open_fcv_source(s, path);
+    return open_y4m_source(s, path);
+}
+
+static void close_source(FrameSource* s) {
+    for (long i = 0; s->files && i < s->count; ++i) free(s->files[i]);
+    free(s->files);
+    free(s->offsets);
+    if (s->map) munmap((void*)s->map, s->map_size);
+    if (s->fd >= 0) close(s->fd);
+    if (s->is_fcv) fcodec_stream_close(&s->fcv);
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+}
+
+/* ---------------- Pipeline ---------------- */
+
+enum { SLOT_FREE = 0, SLOT_BUSY, SLOT_READY };
+
+typedef struct {
+    long     frame;
+    long     next;      /* frame allowed to claim the slot next (f % nslots order) */
+    int      state;
+    OnnxDet* dets;
+    int      count;
+    int      ok;
+    int      w, h;
+    double   decode_ms, detect_ms;
+} Slot;
+
+typedef struct {
+    const BatchConfig* cfg;
+    FrameSource  src;
+    OnnxDetector det;
+    int          use_model;
+    int          det_w, det_h;  /* tensor size the model is fed */
+
+    Slot*  slots;
+    int    nslots;
+    long   next_frame;
+    pthread_mutex_t lock;
+    pthread_cond_t  slot_free;
+    pthread_cond_t  slot_ready;
+} Batch;
+
+typedef struct {
+    Batch*          b;
+    pthread_t       thread;
+    ImgScratch      scratch;
+    float*          tensor;
+    uint8_t*        rgba;       /* fused-preprocessing models only */
+    SkyBlobDetector blob;
+    int             blob_ready;
+    uint8_t*        pix;        /* decoded fcv/qoi frame */
+    size_t          pix_cap;
+    uint8_t*        gray;       /* its gray conversion */
+    size_t          gray_cap;
+} Worker;
+
+static uint8_t* grow(uint8_t** buf, size_t* cap, size_t n) {
+    if (*cap < n) {
+        uint8_t* p = realloc(*buf, n);
+        if (!p) return NULL;
+        *buf = p;
+        *cap = n;
+    }
+    return *buf;
+}
+
+/* Lossless inputs: fcv frame f or a .qoi file -> wk->gray. NULL on error. */
+static const uint8_t* decode_fcodec(Worker* wk, long f, int* w, int* h) {
+    const FrameSource* src = &wk->b->src;
+    const uint8_t* pix = NULL;
+    int ch = 4;
+    uint8_t* qoi = NULL;
+    if (src->is_fcv) {
+        size_t n = 0;
+        const uint8_t* data = fcodec_stream_frame(&src->fcv, f, &n);
+        FcodecInfo info;
+        if (!data || !fcodec_info(data, n, &info)) return NULL;
+        if (!grow(&wk->pix, &wk->pix_cap, (size_t)info.w * info.h * info.ch)) return NULL;
+        if (!fcodec_decode(data, n, wk->pix, 1)) return NULL;
+        *w = info.w;
+        *h = info.h;
+        ch = info.ch;
+        pix = wk->pix;
+    } else {
+        qoi = fcodec_read_qoi(src->files[f], w, h);
+        if (!qoi) return NULL;
+        pix = qoi;
+    }
+    if (ch == 1) return pix;   /* fcv gray frame; qoi is always RGBA */
+
+    const uint8_t* gray = grow(&wk->gray, &wk->gray_cap, (size_t)*w * *h);
+    if (!gray) {
+        free(qoi);
+        return NULL;
+    }
+    imgproc_to_gray(pix, PIX_RGBA8, *w, *h, 0, 0, wk->gray);
+    free(qoi);
+    return gray;
+}
+
+/* gray3 CHW tensor -> bottom-up RGBA8, the layout fused models expect */
+static void tensor_to_rgba_bottom_up(const float* chw, uint8_t* rgba, int w, int h) {
+    for (int y = 0; y < h; ++y) {
+        const float* g = chw + (size_t)(h - 1 - y) * w;
+        uint8_t* d = rgba + (size_t)y * w * 4;
+        for (int x = 0; x < w; ++x) {
+            uint8_t v = (uint8_t)(g[x] * 255.0f + 0.5f);
+            d[4 * x + 0] = d[4 * x + 1] = d[4 * x + 2] = v;
+            d[4 * x + 3] = 255;
+        }
+    }
+}
+
+static void process_frame(Worker* wk, long f, Slot* s) {
+    Batch* b = wk->b;
+    const BatchConfig* cfg = b->cfg;
+    s->dets = NULL;
+    s->count = 0;
+    s->ok = 0;
+
+    double t0 = now_ms();
+    uint8_t* owned = NULL;
+    const uint8_t* gray;
+    int w, h, comp;
+    const char* dot = b->src.files ? strrchr(b->src.files[f], '.') : NULL;
+    if (b->src.is_fcv || (dot && !strcasecmp(dot, ".qoi"))) {
+        gray = decode_fcodec(wk, f, &w, &h);
+        if (!gray) {
+            fprintf(stderr, "[BATCH] frame %ld: lossless decode failed\n", f);
+            return;
+        }
+    } else if (b->src.files) {
+        owned = stbi_load(b->src.files[f], &w, &h, &comp, 1);
+        if (!owned) {
+            fprintf(stderr, "[BATCH] %s: %s\n", b->src.files[f], stbi_failure_reason());
+            return;
+        }
+        gray = owned;
+    } else {
+        gray = b->src.map + b->src.offsets[f];
+        w = b->src.w;
+        h = b->src.h;
+    }
+    s->w = w;
+    s->h = h;
+
+    int rc;
+    double t1;
+    if (b->use_model) {
+        BoxTransform tf;
+        rc = imgproc_frame_to_tensor(&wk->scratch, gray, PIX_GRAY8, w, h, 0, 0,
+                                     wk->tensor, b->det_w, b->det_h, RESIZE_AREA, 0.0f, &tf);
+        const uint8_t* input = (const uint8_t*)wk->tensor;
+        if (rc == ONNX_OK && b->det.in_u8) {
+            tensor_to_rgba_bottom_up(wk->tensor, wk->rgba, b->det_w, b->det_h);
+            input = wk->rgba;
+        }
+        t1 = now_ms();
+        if (rc == ONNX_OK)
+            rc = onnx_predict(&b->det, input, b->det_w, b->det_h, &s->dets, &s->count);
+        for (int i = 0; rc == ONNX_OK && i < s->count; ++i)
+            imgproc_unmap_box(&tf, &s->dets[i]);
+    } else {
+        /* blob detector works on the source resolution; grow per worker */
+        if (!wk->blob_ready || wk->blob.w < w || wk->blob.h < h) {
+            if (wk->blob_ready) skyblob_destroy(&wk->blob);
+            wk->blob_ready = skyblob_init(&wk->blob, w, h, NULL) == ONNX_OK;
+        }
+        t1 = now_ms();
+        rc = wk->blob_ready ? skyblob_detect_gray(&wk->blob, gray, w, h, 0, 0, 0, w, h, &s->dets, &s->count)
+                            : ONNX_ERR_MEMORY;
+    }
+    double t2 = now_ms();
+
+    if (owned) stbi_image_free(owned);
+    s->decode_ms = t1 - t0;
+    s->detect_ms = t2 - t1;
+    s->ok = rc == ONNX_OK;
+    if (!s->ok) {
+        onnx_free_detections(s->dets);
+        s->dets = NULL;
+        s->count = 0;
+        fprintf(stderr, "[BATCH] frame %ld: detection failed (%d)\n", f, rc);
+    }
+}
+
+static void* worker_main(void* arg) {
+    Worker* wk = (Worker*)arg;
+    Batch* b = wk->b;
+    for (;;) {
+        pthread_mutex_lock(&b->lock);
+        long f = b->next_frame < b->src.count ? b->next_frame++ : -1;
+        Slot* s = f >= 0 ? &b->slots[f % b->nslots] : NULL;
+        while (s && (s->state != SLOT_FREE || s->next != f)) pthread_cond_wait(&b->slot_free, &b->lock);
+        if (s) { s->frame = f; s->state = SLOT_BUSY; }
+        pthread_mutex_unlock(&b->lock);
+        if (!s) break;
+
+        process_frame(wk, f, s);
+
+        pthread_mutex_lock(&b->lock);
+        s->state = SLOT_READY;
+        pthread_cond_broadcast(&b->slot_ready);
+        pthread_mutex_unlock(&b->lock);
+    }
+    return NULL;
+}
+
+static const char* frame_name(const FrameSource* s, long f, char* buf, size_t n) {
+    if (s->files) {
+        const char* slash = strrchr(s->files[f], '/');
+        return slash ? slash + 1 : s->files[f];
+    }
+    snprintf(buf, n, "%ld", f);
+    return buf;
+}
+
+int batch_run(const BatchConfig* cfg) {
+    Batch b;
+    memset(&b, 0, sizeof(b));
+    b.cfg = cfg;
+
+    if (open_source(&b.src, cfg->input) != 0) { close_source(&b.src); return 1; }
+    if (b.src.count == 0) {
+        fprintf(stderr, "[BATCH] %s: no frames\n", cfg->input);
+        close_source(&b.src);
+        return 1;
+    }
+
+    int nworkers = cfg->threads > 0 ? cfg->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nworkers < 1) nworkers = 1;
+    if (nworkers > b.src.count) nworkers = (int)b.src.count;
+
+    /* One shared session; each worker's Run uses one intra-op thread */
+    if (cfg->model_path && access(cfg->model_path, R_OK) == 0) {
+        OnnxConfig oc = onnx_default_config();
+        oc.score_thresh = cfg->score_thresh;
+        oc.nms_iou_thresh = cfg->nms_iou;
+        if (nworkers > 1) oc.intra_threads = 1;
+        b.use_model = onnx_load_model(&b.det, cfg->model_path, &oc) == ONNX_OK;
+        if (!b.use_model) fprintf(stderr, "[BATCH] model load failed: %s\n", cfg->model_path);
+    }
+    /* Fixed-input models set the tensor size; an explicit one must agree */
+    b.det_w = cfg->det_w > 0 ? cfg->det_w : BATCH_DET_SIZE;
+    b.det_h = cfg->det_h > 0 ? cfg->det_h : BATCH_DET_SIZE;
+    if (b.use_model && b.det.in_w > 0 && b.det.in_h > 0) {
+        if ((cfg->det_w > 0 && cfg->det_w != b.det.in_w) || (cfg->det_h > 0 && cfg->det_h != b.det.in_h)) {
+            fprintf(stderr, "[BATCH] %s takes %lldx%lld input, --det-size %dx%d does not fit\n", cfg->model_path,
+                    (long long)b.det.in_w, (long long)b.det.in_h, cfg->det_w, cfg->det_h);
+            onnx_destroy(&b.det);
+            close_source(&b.src);
+            return 2;
+        }
+        b.det_w = (int)b.det.in_w;
+        b.det_h = (int)b.det.in_h;
+    }
+    stbi_set_flip_vertically_on_load(0);
+
+    FILE* out = cfg->out_path ? fopen(cfg->out_path, "w") : stdout;
+    if (!out) {
+        perror("[BATCH] output");
+        if (b.use_model) onnx_destroy(&b.det);
+        close_source(&b.src);
+        return 1;
+    }
+    fprintf(out, "frame,source,track,cls,score,x1,y1,x2,y2\n");
+    if (cfg->detlog_path && !detlog_open(cfg->detlog_path)) {
+        if (out != stdout) fclose(out);
+        if (b.use_model) onnx_destroy(&b.det);
+        close_source(&b.src);
+        return 1;
+    }
+
+    fprintf(stderr, "[BATCH] %s: %ld frames (%s), %d workers, %s\n", cfg->input, b.src.count,
+            b.src.files ? "images" : b.src.is_fcv ? "fcv" : "y4m", nworkers, b.use_model ? cfg->model_path : "sky-blob detector");
+
+    b.nslots = nworkers * BATCH_SLOTS_PER_WORKER;
+    b.slots = calloc((size_t)b.nslots, sizeof(Slot));
+    for (int i = 0; i < b.nslots; ++i) b.slots[i].next = i;
+    pthread_mutex_init(&b.lock, NULL);
+    pthread_cond_init(&b.slot_free, NULL);
+    pthread_cond_init(&b.slot_ready, NULL);
+
+    Worker* workers = calloc((size_t)nworkers, sizeof(Worker));
+    size_t tensor_floats = (size_t)3 * b.det_w * b.det_h;
+    int started = 0;
+    for (int i = 0; i < nworkers; ++i) {
+        workers[i].b = &b;
+        if (b.use_model) {
+            workers[i].tensor = malloc(sizeof(float) * tensor_floats);
+            if (b.det.in_u8) workers[i].rgba = malloc((size_t)4 * b.det_w * b.det_h);
+        }
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) break;
+        started++;
+    }
+
+    Tracker tracker;
+    tracker_init(&tracker, NULL);
+    LatencyWindow lat_decode, lat_detect;
+    latwin_init(&lat_decode, BATCH_LAT_WINDOW);
+    latwin_init(&lat_detect, BATCH_LAT_WINDOW);
+
+    int* ids = NULL;
+    int ids_cap = 0;
+    long failed = 0, rows = 0;
+    double t_start = now_ms();
+
+    /* In-order consumer: tracking needs frames in sequence */
+    for (long f = 0; f < b.src.count && started > 0; ++f) {
+        Slot* s = &b.slots[f % b.nslots];
+        pthread_mutex_lock(&b.lock);
+        while (!(s->state == SLOT_READY && s->frame == f)) pthread_cond_wait(&b.slot_ready, &b.lock);
+        pthread_mutex_unlock(&b.lock);
+
+        if (!s->ok) failed++;
+        latwin_push(&lat_decode, s->decode_ms);
+        latwin_push(&lat_detect, s->detect_ms);
+
+        if (s->count > ids_cap) {
+            ids_cap = s->count * 2;
+            ids = realloc(ids, sizeof(int) * (size_t)ids_cap);
+        }
+        tracker_update(&tracker, s->dets, s->count, ids);
+
+        char nb[32];
+        const char* name = frame_name(&b.src, f, nb, sizeof(nb));
+        for (int i = 0; i < s->count; ++i) {
+            const OnnxDet* d = &s->dets[i];
+            fprintf(out, "%ld,%s,%d,%d,%.4f,%.1f,%.1f,%.1f,%.1f\n",
+                    f, name, ids[i], d->cls, d->score, d->x1, d->y1, d->x2, d->y2);
+        }
+        rows += s->count;
+        if (detlog_active()) {
+            float stage_ms[DETLOG_STAGES] = { 0 };
+            stage_ms[DETLOG_CONVERT] = (float)s->decode_ms;
+            stage_ms[DETLOG_INFER] = (float)s->detect_ms;
+            stage_ms[DETLOG_TOTAL] = (float)(s->decode_ms + s->detect_ms);
+            detlog_frame(f, 0.0, stage_ms, s->dets, ids, s->count);
+        }
+        onnx_free_detections(s->dets);
+        s->dets = NULL;
+
+        pthread_mutex_lock(&b.lock);
+        s->state = SLOT_FREE;
+        s->next = f + b.nslots;
+        pthread_cond_broadcast(&b.slot_free);
+        pthread_mutex_unlock(&b.lock);
+    }
+
+    for (int i = 0; i < started; ++i) pthread_join(workers[i].thread, NULL);
+    double wall_s = (now_ms() - t_start) / 1000.0;
+
+    const double ps[3] = { 50.0, 95.0, 99.0 };
+    double pd[3] = {0}, pi[3] = {0};
+    latwin_percentiles(&lat_decode, ps, pd, 3);
+    latwin_percentiles(&lat_detect, ps, pi, 3);
+    fprintf(stderr, "[BATCH] %ld frames in %.2f s (%.1f FPS), %ld detections, %d tracks, %ld failed\n",
+            b.src.count, wall_s, wall_s > 0 ? b.src.count / wall_s : 0.0, rows, tracker.next_id - 1, failed);
+    fprintf(stderr, "[BATCH] decode+prep ms p50=%.2f p95=%.2f p99=%.2f | detect ms p50=%.2f p95=%.2f p99=%.2f\n",
+            pd[0], pd[1], pd[2], pi[0], pi[1], pi[2]);
+
+    if (out != stdout) fclose(out);
+    detlog_close();
+    free(ids);
+    tracker_free(&tracker);
+    latwin_free(&lat_decode);
+    latwin_free(&lat_detect);
+    for (int i = 0; i < nworkers; ++i) {
+        imgproc_scratch_free(&workers[i].scratch);
+        free(workers[i].tensor);
+        free(workers[i].rgba);
+        free(workers[i].pix);
+        free(workers[i].gray);
+        if (workers[i].blob_ready) skyblob_destroy(&workers[i].blob);
+    }
+    free(workers);
+    free(b.slots);
+    pthread_cond_destroy(&b.slot_ready);
+    pthread_cond_destroy(&b.slot_free);
+    pthread_mutex_destroy(&b.lock);
+    if (b.use_model) onnx_destroy(&b.det);
+    int rc = (started == 0 || failed == b.src.count) ? 1 : 0;
+    close_source(&b.src);
+    return rc;
+}
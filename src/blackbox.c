@@ -0,0 +1,478 @@
+#define _GNU_SOURCE
+#include "blackbox.h"
+#include "fcodec.h"
+#include "globals.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define BB_STAGING 4
+
+/* Ring slots start with a seqlock counter: odd while the single writer is
+ * inside, so a reader that sees the same even value before and after its
+ * copy got a consistent slot. */
+typedef struct {
+    uint32_t seq;
+    long     id;               /* internal frame counter (slot = id % n) */
+    long     frame;
+    double   wall_ms, sim_time, frame_ms;
+    uint8_t  crashed, autopilot;
+    float    speed, vspeed;
+    float    pos[MAX_PLANES][3], front[MAX_PLANES][3], up[MAX_PLANES][3];
+    float    plane_speed[MAX_PLANES];
+    int      ndet;
+    OnnxDet  dets[BLACKBOX_MAX_DETS];
+} BbEntry;
+
+typedef struct {
+    uint32_t seq;
+    long     id;
+    uint64_t pos;              /* absolute arena position (mod size = offset) */
+    uint32_t len;
+} BbImage;
+
+typedef struct {
+    long     id;
+    int      w, h;
+    uint8_t* rgba;
+    size_t   cap;
+} BbStage;
+
+typedef struct {
+    long     id;               /* last frame included */
+    double   wall_ms;
+    long     frame;
+    double   frame_ms;
+    long     stage_target;     /* staged frames the encoder should finish first */
+    int      index;            /* directory number */
+    char     reason[32];
+} BbDump;
+
+static struct {
+    int       running;
+    char      dir[512];
+    double    seconds, spike_ms;
+    double    t0;
+
+    /* State ring: written by the render thread only */
+    BbEntry*  entries;
+    long      nentries;
+    long      id;
+    BbEntry   pending;
+    int       was_crashed;
+
+    /* Staging ring (render thread -> encoder), single producer/consumer */
+    BbStage   stage[BB_STAGING];
+    long      stage_head, stage_tail;
+    long      stage_skipped;
+    sem_t     stage_sem;
+    int       stop;
+    pthread_t encoder;
+
+    /* Compressed frames: written by the encoder thread only */
+    uint8_t*  arena;
+    uint64_t  arena_size;
+    uint64_t  arena_write;
+    uint64_t  arena_head;      /* end of the newest record, stored before its bytes */
+    BbImage*  images;
+    long      nimages, image_count;
+    uint8_t*  enc;
+    size_t    enc_cap;
+
+    /* Dumps: at most one in flight */
+    pthread_t dumper;
+    int       dumper_started;
+    int       dump_busy;
+    BbDump    dump;
+    double    last_dump_ms;
+    int       dumps;
+} g_bb;
+
+static double now_ms(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec * 1000.0 + (double)t.tv_nsec / 1e6;
+}
+
+/* ---------------- Seqlock helpers ---------------- */
+
+static void seq_publish(void* slot, void* src, size_t size) {
+    uint32_t* seq = (uint32_t*)slot;
+    uint32_t s = *seq;
+    __atomic_store_n(seq, s + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    *(uint32_t*)src = s + 1;
+    memcpy(slot, src, size);
+    __atomic_store_n(seq, s + 2, __ATOMIC_RELEASE);
+}
+
+static bool seq_read(const void* slot, void* dst, size_t size) {
+    const uint32_t* seq = (const uint32_t*)slot;
+    uint32_t s1 = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+    if (s1 & 1) return false;
+    memcpy(dst, slot, size);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(seq, __ATOMIC_RELAXED) == s1;
+}
+
+/* ---------------- Encoder thread ---------------- */
+
+static void arena_append(long id, const uint8_t* data, uint32_t n) {
+    uint64_t pos = g_bb.arena_write;
+    if (pos % g_bb.arena_size + n > g_bb.arena_size) pos += g_bb.arena_size - pos % g_bb.arena_size;
+
+    /* Readers check arena_head after copying: announce the overwrite first */
+    __atomic_store_n(&g_bb.arena_head, pos + n, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    memcpy(g_bb.arena + pos % g_bb.arena_size, data, n);
+    g_bb.arena_write = pos + n;
+
+    BbImage im = { 0, id, pos, n };
+    seq_publish(&g_bb.images[g_bb.image_count % g_bb.nimages], &im, sizeof(im));
+    __atomic_store_n(&g_bb.image_count, g_bb.image_count + 1, __ATOMIC_RELEASE);
+}
+
+static void* encoder_main(void* arg) {
+    (void)arg;
+    for (;;) {
+        while (sem_wait(&g_bb.stage_sem) != 0 && errno == EINTR) {}
+        long tail = g_bb.stage_tail;
+        long head = __atomic_load_n(&g_bb.stage_head, __ATOMIC_ACQUIRE);
+        if (tail == head) {
+            if (__atomic_load_n(&g_bb.stop, __ATOMIC_ACQUIRE)) break;
+            continue;
+        }
+        BbStage* st = &g_bb.stage[tail % BB_STAGING];
+        size_t bound = fcodec_bound(st->w, st->h, 4, 1);
+        if (g_bb.enc_cap < bound) {
+            uint8_t* p = realloc(g_bb.enc, bound);
+            if (p) { g_bb.enc = p; g_bb.enc_cap = bound; }
+        }
+        size_t n = g_bb.enc_cap >= bound
+                 ? fcodec_encode(st->rgba, st->w, st->h, 4, 0, true, 1, g_bb.enc, g_bb.enc_cap) : 0;
+        if (n > 0 && n <= g_bb.arena_size) arena_append(st->id, g_bb.enc, (uint32_t)n);
+        __atomic_store_n(&g_bb.stage_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/* ---------------- Dump thread ---------------- */
+
+static void write_state_row(FILE* f, const BbEntry* e, double t_ms, long image) {
+    fprintf(f, "%ld,%.2f,%.4f,%.3f,%d,%d,%.3f,%.3f,%ld,%d", e->frame, t_ms, e->sim_time, e->frame_ms,
+            e->crashed, e->autopilot, e->speed, e->vspeed, image, e->ndet);
+    for (int p = 0; p < MAX_PLANES; ++p)
+        fprintf(f, ",%.3f,%.3f,%.3f,%.5f,%.5f,%.5f,%.5f,%.5f,%.5f,%.3f",
+                e->pos[p][0], e->pos[p][1], e->pos[p][2], e->front[p][0], e->front[p][1], e->front[p][2],
+                e->up[p][0], e->up[p][1], e->up[p][2], e->plane_speed[p]);
+    fputc('\n', f);
+}
+
+static FILE* open_in(const char* dir, const char* name, const char* mode) {
+    char path[700];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    return fopen(path, mode);
+}
+
+static void* dump_main(void* arg) {
+    const BbDump* d = (const BbDump*)arg;
+    double t_start = now_ms();
+
+    /* Let the encoder finish what was staged up to the trigger (bounded) */
+    while (__atomic_load_n(&g_bb.stage_tail, __ATOMIC_ACQUIRE) < d->stage_target && now_ms() - t_start < 250.0) {
+        struct timespec ts = { 0, 1000000 };
+        nanosleep(&ts, NULL);
+    }
+
+    /* 1) State: walk back from the trigger frame while it is inside the window */
+    BbEntry* rows = malloc(sizeof(BbEntry) * (size_t)g_bb.nentries);
+    long nrows = 0;
+    for (long id = d->id; rows && id >= 0 && id > d->id - g_bb.nentries; --id) {
+        BbEntry* e = &rows[g_bb.nentries - 1 - nrows];
+        if (!seq_read(&g_bb.entries[id % g_bb.nentries], e, sizeof(*e)) || e->id != id) break;
+        if (d->wall_ms - e->wall_ms > g_bb.seconds * 1000.0) break;
+        nrows++;
+    }
+    BbEntry* first = rows ? rows + (g_bb.nentries - nrows) : NULL;
+    long first_id = nrows ? first[0].id : d->id + 1;
+
+    /* 2) Compressed frames of those ids, oldest first */
+    long nimg = __atomic_load_n(&g_bb.image_count, __ATOMIC_ACQUIRE);
+    BbImage* refs = malloc(sizeof(BbImage) * (size_t)g_bb.nimages);
+    long nrefs = 0;
+    for (long k = nimg - 1; refs && k >= 0 && k > nimg - 1 - g_bb.nimages; --k) {
+        BbImage im;
+        if (!seq_read(&g_bb.images[k % g_bb.nimages], &im, sizeof(im))) break;
+        if (im.id > d->id) continue;
+        if (im.id < first_id) break;
+        refs[g_bb.nimages - 1 - nrefs++] = im;
+    }
+    BbImage* imgs = refs ? refs + (g_bb.nimages - nrefs) : NULL;
+
+    /* 3) Output directory: first free NNN_reason_fFRAME */
+    char dir[600];
+    int made = 0;
+    for (int tries = 0; tries < 1000 && !made; ++tries) {
+        snprintf(dir, sizeof(dir), "%s/%03d_%s_f%ld", g_bb.dir, d->index + tries, d->reason, d->frame);
+        made = mkdir(dir, 0755) == 0;
+        if (!made && errno != EEXIST) break;
+    }
+    if (!made) {
+        perror("[BLACKBOX] mkdir");
+        free(rows); free(refs);
+        __atomic_store_n(&g_bb.dump_busy, 0, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    long* image_of_row = calloc((size_t)(nrows ? nrows : 1), sizeof(long));
+    for (long r = 0; image_of_row && r < nrows; ++r) image_of_row[r] = -1;
+    long written = 0, lost = 0;
+    FILE* fcv = NULL;
+    uint8_t* buf = NULL;
+    size_t buf_cap = 0;
+    for (long k = 0; k < nrefs; ++k) {
+        const BbImage* im = &imgs[k];
+        if (buf_cap < im->len) {
+            uint8_t* p = realloc(buf, im->len);
+            if (!p) break;
+            buf = p;
+            buf_cap = im->len;
+        }
+        memcpy(buf, g_bb.arena + im->pos % g_bb.arena_size, im->len);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        FcodecInfo info;
+        if (__atomic_load_n(&g_bb.arena_head, __ATOMIC_RELAXED) > im->pos + g_bb.arena_size ||
+            !fcodec_info(buf, im->len, &info)) {
+            lost++;           /* overwritten while we were copying */
+            continue;
+        }
+        if (!fcv) {
+            double span = nrows > 1 ? first[nrows - 1].wall_ms - first[0].wall_ms : 0.0;
+            double fps = span > 0.0 ? (nrows - 1) * 1000.0 / span : 60.0;
+            fcv = open_in(dir, "frames.fcv", "wb");
+            if (!fcv || !fcodec_stream_write_header(fcv, info.w, info.h, info.ch, fps)) break;
+        }
+        if (!fcodec_stream_write_frame(fcv, buf, im->len)) break;
+        long r = im->id - first_id;
+        if (image_of_row && r >= 0 && r < nrows) image_of_row[r] = written;
+        written++;
+    }
+    if (fcv) fclose(fcv);
+    free(buf);
+
+    FILE* f = open_in(dir, "state.csv", "w");
+    if (f) {
+        fprintf(f, "frame,t_ms,sim_time,frame_ms,crashed,autopilot,speed,vspeed,image,ndet");
+        for (int p = 0; p < MAX_PLANES; ++p)
+            fprintf(f, ",p%d_x,p%d_y,p%d_z,p%d_fx,p%d_fy,p%d_fz,p%d_ux,p%d_uy,p%d_uz,p%d_speed",
+                    p, p, p, p, p, p, p, p, p, p);
+        fputc('\n', f);
+        for (long r = 0; r < nrows; ++r)
+            write_state_row(f, &first[r], first[r].wall_ms - d->wall_ms, image_of_row ? image_of_row[r] : -1);
+        fclose(f);
+    }
+    f = open_in(dir, "detections.csv", "w");
+    if (f) {
+        fprintf(f, "frame,cls,score,x1,y1,x2,y2\n");
+        for (long r = 0; r < nrows; ++r)
+            for (int i = 0; i < first[r].ndet; ++i) {
+                const OnnxDet* o = &first[r].dets[i];
+                fprintf(f, "%ld,%d,%.4f,%.1f,%.1f,%.1f,%.1f\n", first[r].frame, o->cls, o->score,
+                        o->x1, o->y1, o->x2, o->y2);
+            }
+        fclose(f);
+    }
+    f = open_in(dir, "info.txt", "w");
+    if (f) {
+        fprintf(f, "reason: %s\ntrigger_frame: %ld\ntrigger_frame_ms: %.3f\nframes: %ld\nimages: %ld\n"
+                   "images_lost: %ld\nstaging_skipped: %ld\nwindow_s: %.1f\n",
+                d->reason, d->frame, d->frame_ms, nrows, written, lost,
+                __atomic_load_n(&g_bb.stage_skipped, __ATOMIC_RELAXED), g_bb.seconds);
+        fclose(f);
+    }
+    printf("[BLACKBOX] %s: %ld frames, %ld images (%ld lost) in %.1f ms\n", dir, nrows, written, lost,
+           now_ms() - t_start);
+
+    free(image_of_row);
+    free(rows);
+    free(refs);
+    __atomic_store_n(&g_bb.dump_busy, 0, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void start_dump(const char* reason, long id, double wall_ms, long frame, double frame_ms) {
+    if (__atomic_load_n(&g_bb.dump_busy, __ATOMIC_ACQUIRE)) {
+        printf("[BLACKBOX] %s at frame %ld ignored, a dump is still running\n", reason, frame);
+        return;
+    }
+    if (g_bb.dumper_started) pthread_join(g_bb.dumper, NULL);
+    g_bb.dumper_started = 0;
+
+    g_bb.dump.id = id;
+    g_bb.dump.wall_ms = wall_ms;
+    g_bb.dump.frame = frame;
+    g_bb.dump.frame_ms = frame_ms;
+    g_bb.dump.stage_target = g_bb.stage_head;
+    g_bb.dump.index = g_bb.dumps;
+    snprintf(g_bb.dump.reason, sizeof(g_bb.dump.reason), "%s", reason);
+    g_bb.dump_busy = 1;
+    if (pthread_create(&g_bb.dumper, NULL, dump_main, &g_bb.dump) != 0) {
+        fprintf(stderr, "[BLACKBOX] dump thread failed\n");
+        g_bb.dump_busy = 0;
+        return;
+    }
+    g_bb.dumper_started = 1;
+    g_bb.dumps++;
+    g_bb.last_dump_ms = wall_ms;
+}
+
+/* ---------------- API ---------------- */
+
+bool blackbox_open(const char* dir, double seconds, double spike_ms) {
+    if (g_bb.running || !dir) return false;
+    memset(&g_bb, 0, sizeof(g_bb));
+    snprintf(g_bb.dir, sizeof(g_bb.dir), "%s", dir);
+    g_bb.seconds = seconds > 0.0 ? seconds : 10.0;
+    g_bb.spike_ms = spike_ms;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) { perror("[BLACKBOX] mkdir"); return false; }
+
+    g_bb.nentries = (long)(g_bb.seconds * BLACKBOX_MAX_FPS) + 1;
+    g_bb.nimages = g_bb.nentries;
+    g_bb.arena_size = (uint64_t)BLACKBOX_ARENA_MB << 20;
+    g_bb.entries = calloc((size_t)g_bb.nentries, sizeof(BbEntry));
+    g_bb.images = calloc((size_t)g_bb.nimages, sizeof(BbImage));
+    g_bb.arena = malloc((size_t)g_bb.arena_size);
+    if (!g_bb.entries || !g_bb.images || !g_bb.arena) {
+        fprintf(stderr, "[BLACKBOX] out of memory\n");
+        free(g_bb.entries); free(g_bb.images); free(g_bb.arena);
+        return false;
+    }
+    /* ids start at 0: mark every slot as "never written" */
+    for (long i = 0; i < g_bb.nentries; ++i) g_bb.entries[i].id = -1;
+    for (long i = 0; i < g_bb.nimages; ++i) g_bb.images[i].id = -1;
+
+    sem_init(&g_bb.stage_sem, 0, 0);
+    if (pthread_create(&g_bb.encoder, NULL, encoder_main, NULL) != 0) {
+        fprintf(stderr, "[BLACKBOX] encoder thread failed\n");
+        sem_destroy(&g_bb.stage_sem);
+        free(g_bb.entries); free(g_bb.images); free(g_bb.arena);
+        return false;
+    }
+    g_bb.t0 = now_ms();
+    g_bb.running = 1;
+
+    printf("[BLACKBOX] %s: last %.0f s (%ld-frame ring, %d MB frame arena), dump on crash%s",
+           dir, g_bb.seconds, g_bb.nentries, BLACKBOX_ARENA_MB, spike_ms > 0.0 ? "" : "\n");
+    if (spike_ms > 0.0) printf(" or frames > %.1f ms\n", spike_ms);
+    return true;
+}
+
+bool blackbox_active(void) {
+    return g_bb.running != 0;
+}
+
+int blackbox_queue_depth(long* dropped) {
+    if (dropped) *dropped = g_bb.running ? __atomic_load_n(&g_bb.stage_skipped, __ATOMIC_RELAXED) : 0;
+    if (!g_bb.running) return 0;
+    return (int)(g_bb.stage_head - __atomic_load_n(&g_bb.stage_tail, __ATOMIC_ACQUIRE));
+}
+
+void blackbox_capture(const uint8_t* rgba, int w, int h) {
+    if (!g_bb.running || !rgba) return;
+    long head = g_bb.stage_head;
+    if (head - __atomic_load_n(&g_bb.stage_tail, __ATOMIC_ACQUIRE) >= BB_STAGING) {
+        __atomic_add_fetch(&g_bb.stage_skipped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    /* Slot head belongs to this thread until the head index moves past it */
+    BbStage* st = &g_bb.stage[head % BB_STAGING];
+    size_t need = (size_t)w * h * 4;
+    if (st->cap < need) {
+        uint8_t* p = realloc(st->rgba, need);
+        if (!p) return;
+        st->rgba = p;
+        st->cap = need;
+    }
+    memcpy(st->rgba, rgba, need);
+    st->id = g_bb.id;
+    st->w = w;
+    st->h = h;
+    __atomic_store_n(&g_bb.stage_head, head + 1, __ATOMIC_RELEASE);
+    sem_post(&g_bb.stage_sem);
+}
+
+void blackbox_detections(const OnnxDet* dets, int count) {
+    if (!g_bb.running) return;
+    if (count > BLACKBOX_MAX_DETS) count = BLACKBOX_MAX_DETS;
+    if (count > 0) memcpy(g_bb.pending.dets, dets, sizeof(OnnxDet) * (size_t)count);
+    g_bb.pending.ndet = count > 0 ? count : 0;
+}
+
+void blackbox_frame_end(long frame, double sim_time, double frame_ms) {
+    if (!g_bb.running) return;
+    BbEntry* e = &g_bb.pending;
+    e->id = g_bb.id;
+    e->frame = frame;
+    e->wall_ms = now_ms();
+    e->sim_time = sim_time;
+    e->frame_ms = frame_ms;
+    e->crashed = isCrashed;
+    e->autopilot = isAutopilotOn;
+    e->speed = currentMovementSpeed;
+    e->vspeed = verticalSpeed;
+    for (int p = 0; p < MAX_PLANES; ++p) {     /* first MAX_PLANES of a scenario */
+        if (p >= plane_count) {
+            memset(e->pos[p], 0, sizeof(vec3)); memset(e->front[p], 0, sizeof(vec3));
+            memset(e->up[p], 0, sizeof(vec3));  e->plane_speed[p] = 0.0f;
+            continue;
+        }
+        memcpy(e->pos[p], planes[p].position, sizeof(vec3));
+        memcpy(e->front[p], planes[p].front, sizeof(vec3));
+        memcpy(e->up[p], planes[p].up, sizeof(vec3));
+        e->plane_speed[p] = planes[p].speed;
+    }
+    seq_publish(&g_bb.entries[g_bb.id % g_bb.nentries], e, sizeof(*e));
+
+    bool crashed_now = isCrashed && !g_bb.was_crashed;
+    g_bb.was_crashed = isCrashed;
+    bool spike = g_bb.spike_ms > 0.0 && frame_ms > g_bb.spike_ms && g_bb.id >= BLACKBOX_WARMUP_FRAMES &&
+                 (g_bb.dumps == 0 || e->wall_ms - g_bb.last_dump_ms > g_bb.seconds * 1000.0);
+    if (crashed_now)  start_dump("crash", g_bb.id, e->wall_ms, frame, frame_ms);
+    else if (spike)   start_dump("spike", g_bb.id, e->wall_ms, frame, frame_ms);
+
+    g_bb.id++;
+    e->ndet = 0;
+}
+
+void blackbox_dump(const char* reason) {
+    if (!g_bb.running || g_bb.id == 0) return;
+    const BbEntry* last = &g_bb.entries[(g_bb.id - 1) % g_bb.nentries];
+    start_dump(reason ? reason : "manual", g_bb.id - 1, last->wall_ms, last->frame, last->frame_ms);
+}
+
+void blackbox_close(void) {
+    if (!g_bb.running) return;
+    if (g_bb.dumper_started) pthread_join(g_bb.dumper, NULL);
+
+    __atomic_store_n(&g_bb.stop, 1, __ATOMIC_RELEASE);
+    sem_post(&g_bb.stage_sem);
+    pthread_join(g_bb.encoder, NULL);
+    sem_destroy(&g_bb.stage_sem);
+
+    printf("[BLACKBOX] %ld frames recorded, %ld compressed (%.1f MB), %ld staging skips, %d dumps\n",
+           g_bb.id, g_bb.image_count, g_bb.arena_write / 1048576.0, g_bb.stage_skipped, g_bb.dumps);
+
+    for (int i = 0; i < BB_STAGING; ++i) free(g_bb.stage[i].rgba);
+    free(g_bb.entries);
+    free(g_bb.images);
+    free(g_bb.arena);
+    free(g_bb.enc);
+    memset(&g_bb, 0, sizeof(g_bb));
+}
@@ -0,0 +1,320 @@
+#define _GNU_SOURCE
+#include "dataset.h"
+#include "fcodec.h"
+#include "globals.h"
+#include "plane.h"
+#include "stb_image_write.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define DATASET_JPG_QUALITY 95
+
+/* ---------------- Ground truth ---------------- */
+
+static int plane_class(int i, mat4 view) {
+    if (i == 0) return 0;
+    vec3 p;
+    glm_mat4_mulv3(view, planes[i].position, 1.0f, p);
+    return glm_vec3_norm(p) < DATASET_NEAR_DISTANCE ? 1 : 2;
+}
+
+int dataset_ground_truth(mat4 view, mat4 proj, int vp_x, int vp_y, int vp_w, int vp_h,
+                         int img_w, int img_h, OnnxDet* out, int* plane_out, int max_out) {
+    (void)img_w;   /* horizontal extent is the viewport; kept for symmetry */
+    vec3 bmin, bmax;
+    plane_mesh_bounds(bmin, bmax);
+
+    mat4 vp_mat;
+    glm_mat4_mul(proj, view, vp_mat);
+
+    int n = 0;
+    for (int i = 0; i < plane_count && n < max_out; ++i) {
+        mat4 mvp;
+        glm_mat4_mul(vp_mat, planes[i].modelMatrix, mvp);
+
+        float x0 = 1e30f, y0 = 1e30f, x1 = -1e30f, y1 = -1e30f;
+        int clipped = 0, beyond_far = 0;
+        for (int c = 0; c < 8; ++c) {
+            vec4 p = { (c & 1) ? bmax[0] : bmin[0], (c & 2) ? bmax[1] : bmin[1],
+                       (c & 4) ? bmax[2] : bmin[2], 1.0f };
+            vec4 q;
+            glm_mat4_mulv(mvp, p, q);
+            if (q[3] <= 1e-4f || q[2] < -q[3]) { clipped = 1; break; }
+            if (q[2] > q[3]) beyond_far++;
+            float nx = q[0] / q[3], ny = q[1] / q[3];
+            x0 = fminf(x0, nx); x1 = fmaxf(x1, nx);
+            y0 = fminf(y0, ny); y1 = fmaxf(y1, ny);
+        }
+        if (clipped || beyond_far == 8) continue;
+
+        /* NDC -> GL window (bottom-up) -> image (top-down), clipped to the scene */
+        float L = vp_x + (x0 * 0.5f + 0.5f) * vp_w;
+        float R = vp_x + (x1 * 0.5f + 0.5f) * vp_w;
+        float T = img_h - (vp_y + (y1 * 0.5f + 0.5f) * vp_h);
+        float B = img_h - (vp_y + (y0 * 0.5f + 0.5f) * vp_h);
+        float top = (float)(img_h - vp_y - vp_h), bottom = (float)(img_h - vp_y);
+        L = fmaxf(L, (float)vp_x);  R = fminf(R, (float)(vp_x + vp_w));
+        T = fmaxf(T, top);          B = fminf(B, bottom);
+        if (R - L < DATASET_MIN_BOX_PX || B - T < DATASET_MIN_BOX_PX) continue;
+
+        if (plane_out) plane_out[n] = i;
+        OnnxDet* d = &out[n++];
+        d->x1 = L; d->y1 = T; d->x2 = R; d->y2 = B;
+        d->score = 1.0f;
+        d->cls = plane_class(i, view);
+    }
+    return n;
+}
+
+int dataset_ground_truth_id(mat4 view, const IdPassBox ids[MAX_PLANES], OnnxDet* out,
+                            int* plane_out, int max_out) {
+    int n = 0;
+    for (int i = 0; i < plane_count && i < MAX_PLANES && n < max_out; ++i) {
+        if (ids[i].visible_px < DATASET_MIN_VISIBLE_PX) continue;
+        if (plane_out) plane_out[n] = i;
+        OnnxDet* d = &out[n++];
+        d->x1 = ids[i].x1; d->y1 = ids[i].y1; d->x2 = ids[i].x2; d->y2 = ids[i].y2;
+        d->score = 1.0f;
+        d->cls = plane_class(i, view);
+    }
+    return n;
+}
+
+/* ---------------- Writer pool ---------------- */
+
+enum { JOB_FREE = 0, JOB_QUEUED, JOB_BUSY };
+
+typedef struct {
+    int      state;
+    long     index;
+    uint8_t* rgba;
+    size_t   cap;
+    int      w, h;
+    OnnxDet* boxes;                /* grows with the visible count */
+    int      box_cap;
+    int      count;
+} DatasetJob;
+
+static struct {
+    int             running;
+    char            dir[512];
+    const char*     ext;           /* "jpg", "png" or "qoi" */
+    int             nwriters;
+    pthread_t*      threads;
+
+    DatasetJob*     jobs;
+    int             njobs;
+    int             head;          /* next slot the render thread fills */
+    int             tail;          /* next slot a writer takes */
+    int             stop;
+    pthread_mutex_t lock;
+    pthread_cond_t  have_job;
+    pthread_cond_t  job_done;
+
+    FILE*           manifest;      /* images written so far, one path per line */
+    long            submitted, written, failed, skipped, boxes;
+    double          t_start;
+} g_ds;
+
+static double now_s(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+static bool write_job(const DatasetJob* j) {
+    char path[640];
+    snprintf(path, sizeof(path), "%s/images/%08ld.%s", g_ds.dir, j->index, g_ds.ext);
+    int ok;
+    if (g_ds.ext[0] == 'q')      ok = fcodec_write_qoi(path, j->rgba, j->w, j->h, true);
+    else if (g_ds.ext[0] == 'p') ok = stbi_write_png(path, j->w, j->h, 4, j->rgba, j->w * 4);
+    else                         ok = stbi_write_jpg(path, j->w, j->h, 4, j->rgba, DATASET_JPG_QUALITY);
+    if (!ok) return false;
+
+    snprintf(path, sizeof(path), "%s/labels/%08ld.txt", g_ds.dir, j->index);
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    for (int i = 0; i < j->count; ++i) {
+        const OnnxDet* d = &j->boxes[i];
+        fprintf(f, "%d %.6f %.6f %.6f %.6f\n", d->cls,
+                0.5f * (d->x1 + d->x2) / j->w, 0.5f * (d->y1 + d->y2) / j->h,
+                (d->x2 - d->x1) / j->w, (d->y2 - d->y1) / j->h);
+    }
+    return fclose(f) == 0;
+}
+
+static void* dataset_writer(void* arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&g_ds.lock);
+        while (g_ds.jobs[g_ds.tail].state != JOB_QUEUED && !g_ds.stop)
+            pthread_cond_wait(&g_ds.have_job, &g_ds.lock);
+        if (g_ds.jobs[g_ds.tail].state != JOB_QUEUED) { pthread_mutex_unlock(&g_ds.lock); break; }
+        DatasetJob* j = &g_ds.jobs[g_ds.tail];
+        j->state = JOB_BUSY;
+        g_ds.tail = (g_ds.tail + 1) % g_ds.njobs;
+        pthread_mutex_unlock(&g_ds.lock);
+
+        bool ok = write_job(j);
+
+        pthread_mutex_lock(&g_ds.lock);
+        if (ok) {
+            g_ds.written++;
+            if (g_ds.manifest) fprintf(g_ds.manifest, "images/%08ld.%s\n", j->index, g_ds.ext);
+        } else if (g_ds.failed++ == 0) fprintf(stderr, "[DATASET] write failed for frame %ld\n", j->index);
+        j->state = JOB_FREE;
+        pthread_cond_broadcast(&g_ds.job_done);
+        pthread_mutex_unlock(&g_ds.lock);
+    }
+    return NULL;
+}
+
+static bool make_dir(const char* path) {
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+/* ---------------- API ---------------- */
+
+bool dataset_open(const char* dir, const char* format, int writers) {
+    if (g_ds.running || !dir) return false;
+    memset(&g_ds, 0, sizeof(g_ds));
+    snprintf(g_ds.dir, sizeof(g_ds.dir), "%s", dir);
+    if (!format || strcmp(format, "jpg") == 0) g_ds.ext = "jpg";
+    else if (strcmp(format, "png") == 0)       g_ds.ext = "png";
+    else if (strcmp(format, "qoi") == 0)       g_ds.ext = "qoi";
+    else {
+        fprintf(stderr, "[DATASET] unknown format '%s' (jpg|png|qoi)\n", format);
+        return false;
+    }
+
+    char sub[600];
+    bool ok = make_dir(dir);
+    snprintf(sub, sizeof(sub), "%s/images", dir); ok = ok && make_dir(sub);
+    snprintf(sub, sizeof(sub), "%s/labels", dir); ok = ok && make_dir(sub);
+    if (!ok) { perror("[DATASET] mkdir"); return false; }
+
+    /* Ultralytics-style dataset description next to the data */
+    snprintf(sub, sizeof(sub), "%s/data.yaml", dir);
+    FILE* y = fopen(sub, "w");
+    if (y) {
+        fprintf(y, "path: .\ntrain: manifest.txt\nval: manifest.txt\nnames:\n  0: own\n  1: enemy_near\n  2: enemy_far\n");
+        fclose(y);
+    }
+    snprintf(sub, sizeof(sub), "%s/manifest.txt", dir);
+    g_ds.manifest = fopen(sub, "w");
+
+    if (writers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        writers = cpus > 1 ? (int)cpus - 1 : 1;
+    }
+    g_ds.nwriters = writers;
+    g_ds.njobs = writers * 2 + 2;
+    g_ds.jobs = calloc((size_t)g_ds.njobs, sizeof(DatasetJob));
+    g_ds.threads = calloc((size_t)writers, sizeof(pthread_t));
+    if (!g_ds.jobs || !g_ds.threads) {
+        free(g_ds.jobs); free(g_ds.threads);
+        fprintf(stderr, "[DATASET] out of memory\n");
+        if (g_ds.manifest) fclose(g_ds.manifest);
+        return false;
+    }
+
+    stbi_flip_vertically_on_write(1);   /* frames arrive bottom-up from glReadPixels */
+    pthread_mutex_init(&g_ds.lock, NULL);
+    pthread_cond_init(&g_ds.have_job, NULL);
+    pthread_cond_init(&g_ds.job_done, NULL);
+    int started = 0;
+    for (int i = 0; i < writers; ++i)
+        if (pthread_create(&g_ds.threads[started], NULL, dataset_writer, NULL) == 0) started++;
+    g_ds.nwriters = started;
+    if (started == 0) {
+        fprintf(stderr, "[DATASET] no writer threads\n");
+        free(g_ds.jobs); free(g_ds.threads);
+        if (g_ds.manifest) fclose(g_ds.manifest);
+        return false;
+    }
+
+    g_ds.running = 1;
+    g_ds.t_start = now_s();
+    printf("[DATASET] %s: %s images + YOLO labels, %d writer threads\n", dir, g_ds.ext, started);
+    return true;
+}
+
+bool dataset_active(void) {
+    return g_ds.running != 0;
+}
+
+void dataset_submit(const uint8_t* rgba, int w, int h, const OnnxDet* boxes, int count) {
+    if (!g_ds.running || !rgba) return;
+
+    pthread_mutex_lock(&g_ds.lock);
+    DatasetJob* j = &g_ds.jobs[g_ds.head];
+    while (j->state != JOB_FREE)
+        pthread_cond_wait(&g_ds.job_done, &g_ds.lock);
+    pthread_mutex_unlock(&g_ds.lock);
+
+    /* A free slot at head belongs to the render thread until it is queued */
+    size_t need = (size_t)w * h * 4;
+    if (j->cap < need) {
+        uint8_t* p = realloc(j->rgba, need);
+        if (!p) { g_ds.skipped++; return; }
+        j->rgba = p;
+        j->cap = need;
+    }
+    if (j->box_cap < count) {
+        OnnxDet* b = realloc(j->boxes, sizeof(OnnxDet) * (size_t)count);
+        if (!b) { g_ds.skipped++; return; }
+        j->boxes = b;
+        j->box_cap = count;
+    }
+    memcpy(j->rgba, rgba, need);
+    if (count > 0) memcpy(j->boxes, boxes, sizeof(OnnxDet) * (size_t)count);
+    j->count = count;
+    j->w = w;
+    j->h = h;
+    j->index = g_ds.submitted++;
+    g_ds.boxes += count;
+
+    pthread_mutex_lock(&g_ds.lock);
+    j->state = JOB_QUEUED;
+    g_ds.head = (g_ds.head + 1) % g_ds.njobs;
+    pthread_cond_signal(&g_ds.have_job);
+    pthread_mutex_unlock(&g_ds.lock);
+}
+
+int dataset_queue_depth(void) {
+    if (!g_ds.running) return 0;
+    long done = __atomic_load_n(&g_ds.written, __ATOMIC_RELAXED) + __atomic_load_n(&g_ds.failed, __ATOMIC_RELAXED);
+    return (int)(g_ds.submitted - done);
+}
+
+void dataset_close(void) {
+    if (!g_ds.running) return;
+
+    pthread_mutex_lock(&g_ds.lock);
+    g_ds.stop = 1;
+    pthread_cond_broadcast(&g_ds.have_job);
+    pthread_mutex_unlock(&g_ds.lock);
+    for (int i = 0; i < g_ds.nwriters; ++i) pthread_join(g_ds.threads[i], NULL);
+
+    double secs = now_s() - g_ds.t_start;
+    printf("[DATASET] %ld images, %ld boxes in %.2f s (%.1f images/s), %ld failed, %ld skipped\n",
+           g_ds.written, g_ds.boxes, secs, secs > 0.0 ? g_ds.written / secs : 0.0, g_ds.failed, g_ds.skipped);
+
+    if (g_ds.manifest) fclose(g_ds.manifest);
+    for (int i = 0; i < g_ds.njobs; ++i) {
+        free(g_ds.jobs[i].rgba);
+        free(g_ds.jobs[i].boxes);
+    }
+    free(g_ds.jobs);
+    free(g_ds.threads);
+    pthread_cond_destroy(&g_ds.job_done);
+    pthread_cond_destroy(&g_ds.have_job);
+    pthread_mutex_destroy(&g_ds.lock);
+    g_ds.running = 0;
+}
@@ -0,0 +1,273 @@
+#define _GNU_SOURCE
+#include "detlog.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DETLOG_FILE_HEADER  32
+#define DETLOG_BLOCK_HEADER 64
+#define DETLOG_VERSION      1
+
+const char* const detlog_stage_names[DETLOG_STAGES] = {
+    "render", "read", "convert", "infer", "draw", "total"
+};
+
+static size_t pad8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+/* Column byte sizes of a block, in file order */
+static size_t payload_size(uint32_t nf, uint32_t nr) {
+    return pad8(8 * (size_t)nf) + pad8(8 * (size_t)nf) + DETLOG_STAGES * pad8(4 * (size_t)nf) +
+           pad8(4 * ((size_t)nf + 1)) +
+           pad8(8 * (size_t)nr) + pad8(4 * (size_t)nr) + pad8(2 * (size_t)nr) + 5 * pad8(4 * (size_t)nr);
+}
+
+/* ---------------- Writer ---------------- */
+
+static struct {
+    int       running;
+    FILE*     fp;
+    uint32_t  nframes, nrows;
+    int64_t   frame[DETLOG_BLOCK_FRAMES];
+    double    sim_time[DETLOG_BLOCK_FRAMES];
+    float     stage_ms[DETLOG_STAGES][DETLOG_BLOCK_FRAMES];
+    uint32_t  first_row[DETLOG_BLOCK_FRAMES + 1];
+    int64_t   det_frame[DETLOG_BLOCK_ROWS];
+    int32_t   track[DETLOG_BLOCK_ROWS];
+    int16_t   cls[DETLOG_BLOCK_ROWS];
+    float     score[DETLOG_BLOCK_ROWS];
+    float     box[4][DETLOG_BLOCK_ROWS];
+    long      blocks, frames, rows;
+    int       write_error;
+} g_dl;
+
+static int write_col(const void* p, size_t n) {
+    static const uint8_t zeros[8] = {0};
+    size_t pad = pad8(n) - n;
+    return (n == 0 || fwrite(p, 1, n, g_dl.fp) == n) && (pad == 0 || fwrite(zeros, 1, pad, g_dl.fp) == pad);
+}
+
+static void flush_block(void) {
+    const uint32_t nf = g_dl.nframes, nr = g_dl.nrows;
+    if (nf == 0) return;
+    g_dl.first_row[nf] = nr;
+
+    int64_t fmin = g_dl.frame[0], fmax = g_dl.frame[0];
+    for (uint32_t i = 1; i < nf; ++i) {
+        if (g_dl.frame[i] < fmin) fmin = g_dl.frame[i];
+        if (g_dl.frame[i] > fmax) fmax = g_dl.frame[i];
+    }
+    int32_t tmin = nr ? g_dl.track[0] : -1, tmax = tmin;
+    float smin = nr ? g_dl.score[0] : 0.0f, smax = smin;
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < nr; ++i) {
+        if (g_dl.track[i] < tmin) tmin = g_dl.track[i];
+        if (g_dl.track[i] > tmax) tmax = g_dl.track[i];
+        if (g_dl.score[i] < smin) smin = g_dl.score[i];
+        if (g_dl.score[i] > smax) smax = g_dl.score[i];
+        int bit = g_dl.cls[i] + 1;
+        if (bit >= 0 && bit < 32) mask |= 1u << bit;
+    }
+
+    uint8_t h[DETLOG_BLOCK_HEADER];
+    memset(h, 0, sizeof(h));
+    uint64_t payload = payload_size(nf, nr);
+    memcpy(h, "DLB1", 4);
+    memcpy(h + 4, &nf, 4);
+    memcpy(h + 8, &nr, 4);
+    memcpy(h + 12, &mask, 4);
+    memcpy(h + 16, &fmin, 8);
+    memcpy(h + 24, &fmax, 8);
+    memcpy(h + 32, &tmin, 4);
+    memcpy(h + 36, &tmax, 4);
+    memcpy(h + 40, &smin, 4);
+    memcpy(h + 44, &smax, 4);
+    memcpy(h + 48, &payload, 8);
+
+    int ok = fwrite(h, 1, sizeof(h), g_dl.fp) == sizeof(h);
+    ok = ok && write_col(g_dl.frame, 8 * (size_t)nf);
+    ok = ok && write_col(g_dl.sim_time, 8 * (size_t)nf);
+    for (int s = 0; s < DETLOG_STAGES; ++s) ok = ok && write_col(g_dl.stage_ms[s], 4 * (size_t)nf);
+    ok = ok && write_col(g_dl.first_row, 4 * ((size_t)nf + 1));
+    ok = ok && write_col(g_dl.det_frame, 8 * (size_t)nr);
+    ok = ok && write_col(g_dl.track, 4 * (size_t)nr);
+    ok = ok && write_col(g_dl.cls, 2 * (size_t)nr);
+    ok = ok && write_col(g_dl.score, 4 * (size_t)nr);
+    for (int k = 0; k < 4; ++k) ok = ok && write_col(g_dl.box[k], 4 * (size_t)nr);
+    ok = ok && fflush(g_dl.fp) == 0;   /* whole blocks only: readers may mmap a live log */
+    if (!ok && !g_dl.write_error) {
+        g_dl.write_error = 1;
+        fprintf(stderr, "[DETLOG] write failed\n");
+    }
+
+    g_dl.blocks++;
+    g_dl.nframes = 0;
+    g_dl.nrows = 0;
+}
+
+bool detlog_open(const char* path) {
+    if (g_dl.running || !path) return false;
+    memset(&g_dl, 0, sizeof(g_dl));
+
+    /* Reopening a log whose writer was killed: drop the partial block first */
+    struct stat st;
+    if (stat(path, &st) == 0 && st.st_size > 0) {
+        DetlogReader r;
+        if (!detlog_reader_open(&r, path)) {
+            fprintf(stderr, "[DETLOG] %s exists and is not a detection log\n", path);
+            return false;
+        }
+        size_t end = r.end;
+        detlog_reader_close(&r);
+        if ((size_t)st.st_size != end && truncate(path, (off_t)end) != 0) {
+            perror("[DETLOG] truncate");
+            return false;
+        }
+    }
+    g_dl.fp = fopen(path, "ab");
+    if (!g_dl.fp) { perror("[DETLOG] open"); return false; }
+
+    /* Append-only: a new file gets the header, an existing one keeps growing */
+    fseek(g_dl.fp, 0, SEEK_END);
+    if (ftell(g_dl.fp) == 0) {
+        uint8_t h[DETLOG_FILE_HEADER];
+        memset(h, 0, sizeof(h));
+        uint32_t version = DETLOG_VERSION, stages = DETLOG_STAGES;
+        memcpy(h, "DETLOG1", 8);
+        memcpy(h + 8, &version, 4);
+        memcpy(h + 12, &stages, 4);
+        if (fwrite(h, 1, sizeof(h), g_dl.fp) != sizeof(h)) {
+            perror("[DETLOG] write");
+            fclose(g_dl.fp);
+            return false;
+        }
+    }
+    g_dl.running = 1;
+    printf("[DETLOG] %s: columnar blocks of %d frames / %d detections\n", path,
+           DETLOG_BLOCK_FRAMES, DETLOG_BLOCK_ROWS);
+    return true;
+}
+
+bool detlog_active(void) {
+    return g_dl.running != 0;
+}
+
+void detlog_frame(long frame, double sim_time, const float* stage_ms,
+                  const OnnxDet* dets, const int* tracks, int count) {
+    if (!g_dl.running) return;
+    if (count < 0) count = 0;
+    if (count > DETLOG_BLOCK_ROWS) count = DETLOG_BLOCK_ROWS;
+    if (g_dl.nframes == DETLOG_BLOCK_FRAMES || g_dl.nrows + (uint32_t)count > DETLOG_BLOCK_ROWS)
+        flush_block();
+
+    const uint32_t f = g_dl.nframes++;
+    g_dl.frame[f] = frame;
+    g_dl.sim_time[f] = sim_time;
+    for (int s = 0; s < DETLOG_STAGES; ++s) g_dl.stage_ms[s][f] = stage_ms ? stage_ms[s] : 0.0f;
+    g_dl.first_row[f] = g_dl.nrows;
+
+    for (int i = 0; i < count; ++i) {
+        const uint32_t r = g_dl.nrows++;
+        g_dl.det_frame[r] = frame;
+        g_dl.track[r] = tracks ? tracks[i] : -1;
+        g_dl.cls[r] = (int16_t)dets[i].cls;
+        g_dl.score[r] = dets[i].score;
+        g_dl.box[0][r] = dets[i].x1;
+        g_dl.box[1][r] = dets[i].y1;
+        g_dl.box[2][r] = dets[i].x2;
+        g_dl.box[3][r] = dets[i].y2;
+    }
+    g_dl.frames++;
+    g_dl.rows += count;
+}
+
+void detlog_close(void) {
+    if (!g_dl.running) return;
+    flush_block();
+    if (fclose(g_dl.fp) != 0) perror("[DETLOG] close");
+    printf("[DETLOG] %ld frames, %ld detections in %ld blocks\n", g_dl.frames, g_dl.rows, g_dl.blocks);
+    g_dl.running = 0;
+}
+
+/* ---------------- Reader ---------------- */
+
+bool detlog_reader_open(DetlogReader* r, const char* path) {
+    memset(r, 0, sizeof(*r));
+    r->fd = open(path, O_RDONLY);
+    if (r->fd < 0) return false;
+    struct stat st;
+    if (fstat(r->fd, &st) != 0 || st.st_size < DETLOG_FILE_HEADER) goto fail;
+    r->size = (size_t)st.st_size;
+    void* m = mmap(NULL, r->size, PROT_READ, MAP_PRIVATE, r->fd, 0);
+    if (m == MAP_FAILED) goto fail;
+    r->map = m;
+    uint32_t stages;
+    memcpy(&stages, r->map + 12, 4);
+    if (memcmp(r->map, "DETLOG1", 8) != 0 || stages != DETLOG_STAGES) goto fail;
+
+    long cap = 0;
+    size_t p = DETLOG_FILE_HEADER;
+    r->end = p;
+    while (p + DETLOG_BLOCK_HEADER <= r->size && !memcmp(r->map + p, "DLB1", 4)) {
+        const uint8_t* h = r->map + p;
+        DetlogBlock b;
+        memset(&b, 0, sizeof(b));
+        uint64_t payload;
+        memcpy(&b.nframes, h + 4, 4);
+        memcpy(&b.nrows, h + 8, 4);
+        memcpy(&b.cls_mask, h + 12, 4);
+        memcpy(&b.frame_min, h + 16, 8);
+        memcpy(&b.frame_max, h + 24, 8);
+        memcpy(&b.track_min, h + 32, 4);
+        memcpy(&b.track_max, h + 36, 4);
+        memcpy(&b.score_min, h + 40, 4);
+        memcpy(&b.score_max, h + 44, 4);
+        memcpy(&payload, h + 48, 8);
+        if (payload != payload_size(b.nframes, b.nrows) ||
+            payload > r->size - p - DETLOG_BLOCK_HEADER) break;   /* truncated tail */
+
+        const uint8_t* c = h + DETLOG_BLOCK_HEADER;
+        const size_t nf = b.nframes, nr = b.nrows;
+        b.frame = (const int64_t*)c;     c += pad8(8 * nf);
+        b.sim_time = (const double*)c;   c += pad8(8 * nf);
+        for (int s = 0; s < DETLOG_STAGES; ++s) { b.stage_ms[s] = (const float*)c; c += pad8(4 * nf); }
+        b.first_row = (const uint32_t*)c; c += pad8(4 * (nf + 1));
+        b.det_frame = (const int64_t*)c; c += pad8(8 * nr);
+        b.track = (const int32_t*)c;     c += pad8(4 * nr);
+        b.cls = (const int16_t*)c;       c += pad8(2 * nr);
+        b.score = (const float*)c;       c += pad8(4 * nr);
+        b.x1 = (const float*)c;          c += pad8(4 * nr);
+        b.y1 = (const float*)c;          c += pad8(4 * nr);
+        b.x2 = (const float*)c;          c += pad8(4 * nr);
+        b.y2 = (const float*)c;
+
+        if (r->nblocks == cap) {
+            cap = cap ? cap * 2 : 64;
+            DetlogBlock* nb = realloc(r->blocks, sizeof(DetlogBlock) * (size_t)cap);
+            if (!nb) goto fail;
+            r->blocks = nb;
+        }
+        r->blocks[r->nblocks++] = b;
+        r->frames += b.nframes;
+        r->rows += b.nrows;
+        p += DETLOG_BLOCK_HEADER + payload;
+        r->end = p;
+    }
+    return true;
+
+fail:
+    detlog_reader_close(r);
+    return false;
+}
+
+void detlog_reader_close(DetlogReader* r) {
+    if (r->map) munmap((void*)r->map, r->size);
+    if (r->fd >= 0) close(r->fd);
+    free(r->blocks);
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+}
@@ -0,0 +1,340 @@
+#define _GNU_SOURCE
+#include "eval.h"
+#include "stats.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EVAL_MAX_FRAME_DETS 256   /* per frame; the rest is ignored (callers pass them by score) */
+#define EVAL_ROWS (1 + EVAL_CLASSES + EVAL_RANGE_BUCKETS)
+#define ROW_ALL   0
+#define ROW_CLS   1
+#define ROW_RANGE (1 + EVAL_CLASSES)
+
+typedef struct {
+    float   score;
+    uint8_t tp;
+} EvalRec;
+
+typedef struct {
+    long     gt;
+    EvalRec* recs;
+    long     n, cap;
+} EvalRow;
+
+/* Unmatched class-agnostic detection waiting for its range bucket */
+typedef struct {
+    float score;
+    float size;    /* sqrt(box area) */
+} EvalStray;
+
+static const float k_range_edges[EVAL_RANGE_BUCKETS - 1] = EVAL_RANGE_EDGES;
+
+static struct {
+    int           running;
+    char*         path;
+    char*         detector;
+    int           input_w, input_h, detect_every;
+    float         thresh;
+    long          frames;
+    long          classed_dets;   /* detections with a detector class */
+    EvalRow       rows[EVAL_ROWS];
+    EvalStray*    strays;
+    long          nstrays, strays_cap;
+    double        log_k_sum;      /* sum of log(range * sqrt(area)) over the ground truth */
+    long          log_k_n;
+    LatencyWindow lat[DETLOG_STAGES];
+    double        cost_ms;        /* detection total over the frames after warm-up */
+    long          cost_frames;
+} g_ev;
+
+static int grow(void** p, long* cap, long need, size_t elem) {
+    if (need <= *cap) return 1;
+    long nc = *cap ? *cap * 2 : 1024;
+    while (nc < need) nc *= 2;
+    void* np = realloc(*p, (size_t)nc * elem);
+    if (!np) return 0;
+    *p = np;
+    *cap = nc;
+    return 1;
+}
+
+static void row_add(EvalRow* r, float score, int tp) {
+    if (!grow((void**)&r->recs, &r->cap, r->n + 1, sizeof(EvalRec))) return;
+    r->recs[r->n].score = score;
+    r->recs[r->n].tp = (uint8_t)(tp != 0);
+    r->n++;
+}
+
+static int range_bucket(float range) {
+    int b = 0;
+    while (b < EVAL_RANGE_BUCKETS - 1 && range >= k_range_edges[b]) b++;
+    return b;
+}
+
+static float box_size(const OnnxDet* d) {
+    float w = d->x2 - d->x1, h = d->y2 - d->y1;
+    return (w > 0.0f && h > 0.0f) ? sqrtf(w * h) : 0.0f;
+}
+
+static float iou(const OnnxDet* a, const OnnxDet* b) {
+    float iw = fminf(a->x2, b->x2) - fmaxf(a->x1, b->x1);
+    float ih = fminf(a->y2, b->y2) - fmaxf(a->y1, b->y1);
+    if (iw <= 0.0f || ih <= 0.0f) return 0.0f;
+    float inter = iw * ih;
+    float uni = (a->x2 - a->x1) * (a->y2 - a->y1) + (b->x2 - b->x1) * (b->y2 - b->y1) - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+/* Greedy matching in score order: det_gt[i] = matched ground truth, -1 none,
+ * -2 not evaluated (by_class and the detection has no class) */
+static void match(const OnnxDet* gt, int ngt, const OnnxDet* dets, const int* order, int ndet,
+                  int by_class, int* det_gt) {
+    uint8_t used[EVAL_MAX_FRAME_DETS] = {0};
+    for (int k = 0; k < ndet; ++k) {
+        int i = order[k];
+        det_gt[i] = -1;
+        if (by_class && dets[i].cls < 0) { det_gt[i] = -2; continue; }
+        float best = EVAL_IOU;
+        for (int g = 0; g < ngt; ++g) {
+            if (used[g] || (by_class && gt[g].cls != dets[i].cls)) continue;
+            float v = iou(&dets[i], &gt[g]);
+            if (v >= best) { best = v; det_gt[i] = g; }
+        }
+        if (det_gt[i] >= 0) used[det_gt[i]] = 1;
+    }
+}
+
+bool eval_open(const char* path, const char* detector, int input_w, int input_h, int detect_every,
+               float score_thresh) {
+    if (g_ev.running) return true;
+    memset(&g_ev, 0, sizeof(g_ev));
+    FILE* fp = fopen(path, "w");   /* fail early, not after an hour-long run */
+    if (!fp) {
+        fprintf(stderr, "[EVAL] cannot write %s\n", path);
+        return false;
+    }
+    fclose(fp);
+    for (int s = 0; s < DETLOG_STAGES; ++s) {
+        if (latwin_init(&g_ev.lat[s], EVAL_LATENCY_SAMPLES) != 0) {
+            for (int j = 0; j < s; ++j) latwin_free(&g_ev.lat[j]);
+            return false;
+        }
+    }
+    g_ev.path = strdup(path);
+    g_ev.detector = strdup(detector ? detector : "none");
+    g_ev.input_w = input_w;
+    g_ev.input_h = input_h;
+    g_ev.detect_every = detect_every > 0 ? detect_every : 1;
+    g_ev.thresh = score_thresh;
+    g_ev.running = 1;
+    printf("[EVAL] %s vs simulator ground truth, IoU %.2f, report -> %s\n", g_ev.detector, EVAL_IOU, path);
+    return true;
+}
+
+bool eval_active(void) { return g_ev.running != 0; }
+
+void eval_frame(const OnnxDet* gt, const float* gt_range, int ngt,
+                const OnnxDet* dets, int ndet, const float stage_ms[DETLOG_STAGES]) {
+    if (!g_ev.running) return;
+    if (ngt > EVAL_MAX_FRAME_DETS) ngt = EVAL_MAX_FRAME_DETS;
+    if (ndet > EVAL_MAX_FRAME_DETS) ndet = EVAL_MAX_FRAME_DETS;
+
+    if (g_ev.frames >= EVAL_WARMUP_FRAMES) {
+        if (stage_ms)
+            for (int s = 0; s < DETLOG_STAGES; ++s) latwin_push(&g_ev.lat[s], stage_ms[s]);
+        g_ev.cost_ms += stage_ms ? stage_ms[DETLOG_TOTAL] : 0.0;
+        g_ev.cost_frames++;
+    }
+    g_ev.frames++;
+
+    for (int g = 0; g < ngt; ++g) {
+        g_ev.rows[ROW_ALL].gt++;
+        if (gt[g].cls >= 0 && gt[g].cls < EVAL_CLASSES) g_ev.rows[ROW_CLS + gt[g].cls].gt++;
+        g_ev.rows[ROW_RANGE + range_bucket(gt_range[g])].gt++;
+        float size = box_size(&gt[g]);
+        if (size > 0.0f && gt_range[g] > 0.0f) {
+            g_ev.log_k_sum += log((double)gt_range[g] * size);
+            g_ev.log_k_n++;
+        }
+    }
+
+    /* score order (insertion sort; a handful of boxes per frame) */
+    int order[EVAL_MAX_FRAME_DETS];
+    for (int i = 0; i < ndet; ++i) {
+        int j = i;
+        while (j > 0 && dets[order[j - 1]].score < dets[i].score) { order[j] = order[j - 1]; j--; }
+        order[j] = i;
+    }
+
+    int det_gt[EVAL_MAX_FRAME_DETS];
+    match(gt, ngt, dets, order, ndet, 1, det_gt);
+    for (int i = 0; i < ndet; ++i) {
+        if (det_gt[i] == -2 || dets[i].cls >= EVAL_CLASSES) continue;
+        g_ev.classed_dets++;
+        row_add(&g_ev.rows[ROW_CLS + dets[i].cls], dets[i].score, det_gt[i] >= 0);
+    }
+
+    match(gt, ngt, dets, order, ndet, 0, det_gt);
+    for (int i = 0; i < ndet; ++i) {
+        row_add(&g_ev.rows[ROW_ALL], dets[i].score, det_gt[i] >= 0);
+        if (det_gt[i] >= 0) {
+            row_add(&g_ev.rows[ROW_RANGE + range_bucket(gt_range[det_gt[i]])], dets[i].score, 1);
+        } else if (grow((void**)&g_ev.strays, &g_ev.strays_cap, g_ev.nstrays + 1, sizeof(EvalStray))) {
+            g_ev.strays[g_ev.nstrays].score = dets[i].score;
+            g_ev.strays[g_ev.nstrays].size = box_size(&dets[i]);
+            g_ev.nstrays++;
+        }
+    }
+}
+
+/* ---------------- Report ---------------- */
+
+typedef struct {
+    long   tp, fp;          /* at the score threshold */
+    double precision, recall, ap;
+} EvalScore;
+
+static void write_json_string(FILE* fp, const char* s) {
+    fputc('"', fp);
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(fp, "\\%c", c);
+        else if (c < 0x20) fprintf(fp, "\\u%04x", c);
+        else fputc(c, fp);
+    }
+    fputc('"', fp);
+}
+
+static int cmp_rec_desc(const void* a, const void* b) {
+    float x = ((const EvalRec*)a)->score, y = ((const EvalRec*)b)->score;
+    return (x < y) - (x > y);
+}
+
+static EvalScore row_score(EvalRow* r, float thresh) {
+    EvalScore s = {0};
+    for (long i = 0; i < r->n; ++i) {
+        if (r->recs[i].score < thresh) continue;
+        if (r->recs[i].tp) s.tp++; else s.fp++;
+    }
+    s.precision = (s.tp + s.fp) ? (double)s.tp / (double)(s.tp + s.fp) : 0.0;
+    s.recall    = r->gt ? (double)s.tp / (double)r->gt : 0.0;
+    if (r->gt == 0 || r->n == 0) return s;
+
+    /* all-point interpolated AP: area under the monotone precision envelope */
+    qsort(r->recs, (size_t)r->n, sizeof(EvalRec), cmp_rec_desc);
+    double* prec = malloc(sizeof(double) * (size_t)r->n);
+    double* rec  = malloc(sizeof(double) * (size_t)r->n);
+    if (!prec || !rec) { free(prec); free(rec); return s; }
+    long tp = 0;
+    for (long i = 0; i < r->n; ++i) {
+        tp += r->recs[i].tp;
+        prec[i] = (double)tp / (double)(i + 1);
+        rec[i]  = (double)tp / (double)r->gt;
+    }
+    for (long i = r->n - 2; i >= 0; --i)
+        if (prec[i] < prec[i + 1]) prec[i] = prec[i + 1];
+    double prev = 0.0;
+    for (long i = 0; i < r->n; ++i) {
+        s.ap += (rec[i] - prev) * prec[i];
+        prev = rec[i];
+    }
+    free(prec);
+    free(rec);
+    return s;
+}
+
+static void write_row(FILE* fp, EvalRow* r, float thresh) {
+    EvalScore s = row_score(r, thresh);
+    fprintf(fp, "\"gt\": %ld, \"detections\": %ld, \"tp\": %ld, \"fp\": %ld, \"fn\": %ld, "
+                "\"precision\": %.4f, \"recall\": %.4f, \"ap50\": %.4f",
+            r->gt, r->n, s.tp, s.fp, r->gt - s.tp, s.precision, s.recall, s.ap);
+}
+
+bool eval_close(void) {
+    if (!g_ev.running) return true;
+    g_ev.running = 0;
+
+    /* strays: range ~ k / box size, k from this run's ground truth */
+    if (g_ev.log_k_n > 0) {
+        double k = exp(g_ev.log_k_sum / (double)g_ev.log_k_n);
+        for (long i = 0; i < g_ev.nstrays; ++i) {
+            float range = g_ev.strays[i].size > 0.0f ? (float)(k / g_ev.strays[i].size) : 1e30f;
+            row_add(&g_ev.rows[ROW_RANGE + range_bucket(range)], g_ev.strays[i].score, 0);
+        }
+    }
+
+    double map = 0.0;
+    int map_n = 0;
+    for (int c = 0; c < EVAL_CLASSES; ++c) {
+        EvalRow* r = &g_ev.rows[ROW_CLS + c];
+        if (r->gt == 0) continue;
+        map += row_score(r, g_ev.thresh).ap;
+        map_n++;
+    }
+    map = map_n ? map / map_n : 0.0;
+    EvalScore all = row_score(&g_ev.rows[ROW_ALL], g_ev.thresh);
+    const int classed = g_ev.classed_dets > 0;
+    const double accuracy = classed ? map : all.ap;
+
+    static const double ps[4] = { 50.0, 95.0, 99.0, 100.0 };
+    double lat[DETLOG_STAGES][4];
+    for (int s = 0; s < DETLOG_STAGES; ++s) latwin_percentiles(&g_ev.lat[s], ps, lat[s], 4);
+
+    bool ok = false;
+    FILE* fp = fopen(g_ev.path, "w");
+    if (fp) {
+        fprintf(fp, "{\n  \"detector\": ");
+        write_json_string(fp, g_ev.detector);
+        fprintf(fp, ",\n  \"input\": [%d, %d],\n  \"detect_every\": %d,\n", g_ev.input_w, g_ev.input_h,
+                g_ev.detect_every);
+        fprintf(fp, "  \"frames\": %ld,\n  \"iou\": %.2f,\n  \"score_thresh\": %.3f,\n",
+                g_ev.frames, EVAL_IOU, g_ev.thresh);
+        fprintf(fp, "  \"summary\": { \"accuracy\": %.4f, \"accuracy_metric\": \"%s\", \"latency_ms_p95\": %.3f, "
+                    "\"cost_ms_per_frame\": %.3f },\n",
+                accuracy, classed ? "map50" : "ap50_class_agnostic", lat[DETLOG_TOTAL][1],
+                g_ev.cost_frames ? g_ev.cost_ms / g_ev.cost_frames : 0.0);
+        fprintf(fp, "  \"map50\": %.4f,\n  \"overall\": { ", map);
+        write_row(fp, &g_ev.rows[ROW_ALL], g_ev.thresh);
+        fprintf(fp, " },\n  \"classes\": [\n");
+        for (int c = 0; c < EVAL_CLASSES; ++c) {
+            fprintf(fp, "    { \"cls\": %d, ", c);
+            write_row(fp, &g_ev.rows[ROW_CLS + c], g_ev.thresh);
+            fprintf(fp, " }%s\n", c + 1 < EVAL_CLASSES ? "," : "");
+        }
+        fprintf(fp, "  ],\n  \"ranges\": [\n");
+        for (int b = 0; b < EVAL_RANGE_BUCKETS; ++b) {
+            float lo = b ? k_range_edges[b - 1] : 0.0f;
+            if (b + 1 < EVAL_RANGE_BUCKETS)
+                fprintf(fp, "    { \"min\": %.0f, \"max\": %.0f, ", lo, k_range_edges[b]);
+            else
+                fprintf(fp, "    { \"min\": %.0f, \"max\": null, ", lo);
+            write_row(fp, &g_ev.rows[ROW_RANGE + b], g_ev.thresh);
+            fprintf(fp, " }%s\n", b + 1 < EVAL_RANGE_BUCKETS ? "," : "");
+        }
+        fprintf(fp, "  ],\n  \"latency_ms\": {\n");
+        for (int s = 0; s < DETLOG_STAGES; ++s)
+            fprintf(fp, "    \"%s\": { \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f }%s\n",
+                    detlog_stage_names[s], lat[s][0], lat[s][1], lat[s][2], lat[s][3],
+                    s + 1 < DETLOG_STAGES ? "," : "");
+        fprintf(fp, "  }\n}\n");
+        ok = fclose(fp) == 0;
+    }
+    if (ok)
+        printf("[EVAL] %ld frames: accuracy %.4f (%s), total p95 %.2f ms, precision %.3f recall %.3f -> %s\n",
+               g_ev.frames, accuracy, classed ? "mAP@0.5" : "AP@0.5 class-agnostic", lat[DETLOG_TOTAL][1],
+               all.precision, all.recall, g_ev.path);
+    else
+        fprintf(stderr, "[EVAL] writing %s failed\n", g_ev.path);
+
+    for (int r = 0; r < EVAL_ROWS; ++r) free(g_ev.rows[r].recs);
+    for (int s = 0; s < DETLOG_STAGES; ++s) latwin_free(&g_ev.lat[s]);
+    free(g_ev.strays);
+    free(g_ev.path);
+    free(g_ev.detector);
+    memset(&g_ev, 0, sizeof(g_ev));
+    return ok;
+}
@@ -0,0 +1,473 @@
+#define _GNU_SOURCE
+#include "fcodec.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FCF_HEADER  16
+#define FCV_HEADER  24
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xc0
+#define QOI_OP_RGB   0xfe
+#define QOI_OP_RGBA  0xff
+#define QOI_MASK_2   0xc0
+#define QOI_HASH(r, g, b, a) (((r) * 3 + (g) * 5 + (b) * 7 + (a) * 11) & 63)
+
+/* Gray ops: 0ddddddd diff -64..63, 10rrrrrr run 1..64, 0xc0 + raw byte */
+#define GRAY_OP_RUN 0x80
+#define GRAY_OP_RAW 0xc0
+
+static const uint8_t kQoiEnd[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+/* ---------------- Byte helpers ---------------- */
+
+static inline void put_le32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+static inline uint32_t get_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+static inline void put_be32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16); p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v;
+}
+static inline uint32_t get_be32(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+/* ---------------- Stripe coders ----------------
+ * A stripe is `rows` rows of `w` pixels, row r at src + r * step (step may
+ * be negative for bottom-up input). State starts fresh in every stripe. */
+
+static size_t worst_case(int w, int rows, int ch) {
+    return (size_t)w * rows * (ch == 4 ? 5 : 2);
+}
+
+static size_t encode_rgba(const uint8_t* src, ptrdiff_t step, int w, int rows, uint8_t* o) {
+    uint8_t idx[64][4];
+    memset(idx, 0, sizeof(idx));
+    uint8_t pr = 0, pg = 0, pb = 0, pa = 255;
+    int run = 0;
+    size_t p = 0;
+
+    for (int y = 0; y < rows; ++y) {
+        const uint8_t* s = src + (ptrdiff_t)y * step;
+        for (int x = 0; x < w; ++x, s += 4) {
+            const uint8_t r = s[0], g = s[1], b = s[2], a = s[3];
+            if (r == pr && g == pg && b == pb && a == pa) {
+                if (++run == 62) { o[p++] = (uint8_t)(QOI_OP_RUN | (run - 1)); run = 0; }
+                continue;
+            }
+            if (run) { o[p++] = (uint8_t)(QOI_OP_RUN | (run - 1)); run = 0; }
+
+            const int h = QOI_HASH(r, g, b, a);
+            if (idx[h][0] == r && idx[h][1] == g && idx[h][2] == b && idx[h][3] == a) {
+                o[p++] = (uint8_t)(QOI_OP_INDEX | h);
+            } else {
+                idx[h][0] = r; idx[h][1] = g; idx[h][2] = b; idx[h][3] = a;
+                if (a == pa) {
+                    const int vr = (int8_t)(r - pr), vg = (int8_t)(g - pg), vb = (int8_t)(b - pb);
+                    const int vg_r = vr - vg, vg_b = vb - vg;
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                        o[p++] = (uint8_t)(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                    } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                        o[p++] = (uint8_t)(QOI_OP_LUMA | (vg + 32));
+                        o[p++] = (uint8_t)((vg_r + 8) << 4 | (vg_b + 8));
+                    } else {
+                        o[p++] = QOI_OP_RGB; o[p++] = r; o[p++] = g; o[p++] = b;
+                    }
+                } else {
+                    o[p++] = QOI_OP_RGBA; o[p++] = r; o[p++] = g; o[p++] = b; o[p++] = a;
+                }
+            }
+            pr = r; pg = g; pb = b; pa = a;
+        }
+    }
+    if (run) o[p++] = (uint8_t)(QOI_OP_RUN | (run - 1));
+    return p;
+}
+
+static bool decode_rgba(const uint8_t* in, size_t n, uint8_t* dst, ptrdiff_t step, int w, int rows) {
+    uint8_t idx[64][4];
+    memset(idx, 0, sizeof(idx));
+    uint8_t px[4] = { 0, 0, 0, 255 };
+    int run = 0;
+    size_t p = 0;
+
+    for (int y = 0; y < rows; ++y) {
+        uint8_t* d = dst + (ptrdiff_t)y * step;
+        for (int x = 0; x < w; ++x, d += 4) {
+            if (run > 0) {
+                run--;
+            } else {
+                if (p >= n) return false;
+                const int b1 = in[p++];
+                if (b1 == QOI_OP_RGB) {
+                    if (p + 3 > n) return false;
+                    px[0] = in[p]; px[1] = in[p + 1]; px[2] = in[p + 2]; p += 3;
+                } else if (b1 == QOI_OP_RGBA) {
+                    if (p + 4 > n) return false;
+                    memcpy(px, in + p, 4); p += 4;
+                } else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+                    memcpy(px, idx[b1], 4);
+                } else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+                    px[0] += ((b1 >> 4) & 3) - 2;
+                    px[1] += ((b1 >> 2) & 3) - 2;
+                    px[2] += (b1 & 3) - 2;
+                } else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+                    if (p >= n) return false;
+                    const int b2 = in[p++];
+                    const int vg = (b1 & 0x3f) - 32;
+                    px[0] += vg - 8 + ((b2 >> 4) & 0x0f);
+                    px[1] += vg;
+                    px[2] += vg - 8 + (b2 & 0x0f);
+                } else {
+                    run = b1 & 0x3f;
+                }
+                memcpy(idx[QOI_HASH(px[0], px[1], px[2], px[3])], px, 4);
+            }
+            memcpy(d, px, 4);
+        }
+    }
+    return true;
+}
+
+static size_t encode_gray(const uint8_t* src, ptrdiff_t step, int w, int rows, uint8_t* o) {
+    uint8_t prev = 0;
+    int run = 0;
+    size_t p = 0;
+    for (int y = 0; y < rows; ++y) {
+        const uint8_t* s = src + (ptrdiff_t)y * step;
+        for (int x = 0; x < w; ++x) {
+            const uint8_t v = s[x];
+            if (v == prev) {
+                if (++run == 64) { o[p++] = (uint8_t)(GRAY_OP_RUN | 63); run = 0; }
+                continue;
+            }
+            if (run) { o[p++] = (uint8_t)(GRAY_OP_RUN | (run - 1)); run = 0; }
+            const int d = (int8_t)(v - prev);
+            if (d >= -64 && d <= 63) {
+                o[p++] = (uint8_t)(d + 64);
+            } else {
+                o[p++] = GRAY_OP_RAW; o[p++] = v;
+            }
+            prev = v;
+        }
+    }
+    if (run) o[p++] = (uint8_t)(GRAY_OP_RUN | (run - 1));
+    return p;
+}
+
+static bool decode_gray(const uint8_t* in, size_t n, uint8_t* dst, ptrdiff_t step, int w, int rows) {
+    uint8_t v = 0;
+    int run = 0;
+    size_t p = 0;
+    for (int y = 0; y < rows; ++y) {
+        uint8_t* d = dst + (ptrdiff_t)y * step;
+        for (int x = 0; x < w; ++x) {
+            if (run > 0) {
+                run--;
+            } else {
+                if (p >= n) return false;
+                const int b = in[p++];
+                if (b < 0x80) {
+                    v = (uint8_t)(v + b - 64);
+                } else if (b == GRAY_OP_RAW) {
+                    if (p >= n) return false;
+                    v = in[p++];
+                } else if ((b & 0xc0) == GRAY_OP_RUN) {
+                    run = b & 0x3f;
+                } else {
+                    return false;
+                }
+            }
+            d[x] = v;
+        }
+    }
+    return true;
+}
+
+/* ---------------- Stripe jobs ---------------- */
+
+typedef struct {
+    const uint8_t* src;     /* encode: first row; decode: payload */
+    uint8_t*       dst;     /* encode: output;    decode: first row */
+    ptrdiff_t      step;
+    size_t         size;    /* encode: result;    decode: payload size */
+    int            w, rows, ch;
+    bool           ok;
+} StripeJob;
+
+typedef struct {
+    StripeJob* jobs;
+    int        n, first, stride;
+    bool       decode;
+} StripeSet;
+
+static void run_stripe(StripeJob* j, bool decode) {
+    if (decode) {
+        j->ok = j->ch == 4 ? decode_rgba(j->src, j->size, j->dst, j->step, j->w, j->rows)
+                           : decode_gray(j->src, j->size, j->dst, j->step, j->w, j->rows);
+    } else {
+        j->size = j->ch == 4 ? encode_rgba(j->src, j->step, j->w, j->rows, j->dst)
+                             : encode_gray(j->src, j->step, j->w, j->rows, j->dst);
+        j->ok = true;
+    }
+}
+
+static void* stripe_worker(void* arg) {
+    StripeSet* s = (StripeSet*)arg;
+    for (int i = s->first; i < s->n; i += s->stride) run_stripe(&s->jobs[i], s->decode);
+    return NULL;
+}
+
+/* Runs n jobs on up to `threads` threads (the caller is one of them) */
+static void run_stripes(StripeJob* jobs, int n, int threads, bool decode) {
+    if (threads > n) threads = n;
+    if (threads > FCODEC_MAX_STRIPES) threads = FCODEC_MAX_STRIPES;
+    if (threads <= 1) {
+        for (int i = 0; i < n; ++i) run_stripe(&jobs[i], decode);
+        return;
+    }
+    pthread_t tid[FCODEC_MAX_STRIPES];
+    StripeSet sets[FCODEC_MAX_STRIPES];
+    int started = 0;
+    for (int t = 0; t < threads; ++t) {
+        sets[t].jobs = jobs; sets[t].n = n; sets[t].first = t; sets[t].stride = threads; sets[t].decode = decode;
+    }
+    for (int t = 1; t < threads; ++t) {
+        if (pthread_create(&tid[t], NULL, stripe_worker, &sets[t]) != 0) break;
+        started = t;
+    }
+    /* Threads that failed to start: the caller picks their share up */
+    for (int t = started + 1; t < threads; ++t) stripe_worker(&sets[t]);
+    stripe_worker(&sets[0]);
+    for (int t = 1; t <= started; ++t) pthread_join(tid[t], NULL);
+}
+
+/* ---------------- Frames ---------------- */
+
+static int clamp_stripes(int stripes, int h) {
+    if (stripes < 1) stripes = 1;
+    if (stripes > FCODEC_MAX_STRIPES) stripes = FCODEC_MAX_STRIPES;
+    if (stripes > h) stripes = h > 0 ? h : 1;
+    return stripes;
+}
+
+size_t fcodec_bound(int w, int h, int ch, int stripes) {
+    stripes = clamp_stripes(stripes, h);
+    return FCF_HEADER + 4 * (size_t)stripes + worst_case(w, h, ch);
+}
+
+size_t fcodec_encode(const uint8_t* px, int w, int h, int ch, int stride, bool bottom_up,
+                     int stripes, uint8_t* out, size_t cap) {
+    if (!px || !out || w <= 0 || h <= 0 || (ch != 1 && ch != 4)) return 0;
+    stripes = clamp_stripes(stripes, h);
+    if (cap < fcodec_bound(w, h, ch, stripes)) return 0;
+    if (stride <= 0) stride = w * ch;
+
+    /* Every stripe is encoded at its worst-case offset, then compacted */
+    StripeJob jobs[FCODEC_MAX_STRIPES];
+    size_t off = FCF_HEADER + 4 * (size_t)stripes;
+    for (int s = 0; s < stripes; ++s) {
+        const int r0 = (int)((long)s * h / stripes), r1 = (int)((long)(s + 1) * h / stripes);
+        StripeJob* j = &jobs[s];
+        j->w = w; j->rows = r1 - r0; j->ch = ch;
+        j->step = bottom_up ? -(ptrdiff_t)stride : (ptrdiff_t)stride;
+        j->src = bottom_up ? px + (size_t)(h - 1 - r0) * stride : px + (size_t)r0 * stride;
+        j->dst = out + off;
+        off += worst_case(w, j->rows, ch);
+    }
+    run_stripes(jobs, stripes, stripes, false);
+
+    memcpy(out, "FCF1", 4);
+    put_le32(out + 4, (uint32_t)w);
+    put_le32(out + 8, (uint32_t)h);
+    out[12] = (uint8_t)ch;
+    out[13] = 0;
+    out[14] = (uint8_t)stripes;
+    out[15] = (uint8_t)(stripes >> 8);
+    size_t p = FCF_HEADER + 4 * (size_t)stripes;
+    for (int s = 0; s < stripes; ++s) {
+        put_le32(out + FCF_HEADER + 4 * s, (uint32_t)jobs[s].size);
+        if (jobs[s].dst != out + p) memmove(out + p, jobs[s].dst, jobs[s].size);
+        p += jobs[s].size;
+    }
+    return p;
+}
+
+bool fcodec_info(const uint8_t* data, size_t size, FcodecInfo* info) {
+    if (!data || size < FCF_HEADER || memcmp(data, "FCF1", 4) != 0) return false;
+    FcodecInfo i;
+    i.w = (int)get_le32(data + 4);
+    i.h = (int)get_le32(data + 8);
+    i.ch = data[12];
+    i.stripes = data[14] | data[15] << 8;
+    if (i.w <= 0 || i.h <= 0 || (i.ch != 1 && i.ch != 4)) return false;
+    if (i.stripes < 1 || i.stripes > FCODEC_MAX_STRIPES || i.stripes > i.h) return false;
+    if (size < FCF_HEADER + 4 * (size_t)i.stripes) return false;
+    if (info) *info = i;
+    return true;
+}
+
+bool fcodec_decode(const uint8_t* data, size_t size, uint8_t* out, int threads) {
+    FcodecInfo info;
+    if (!out || !fcodec_info(data, size, &info)) return false;
+
+    StripeJob jobs[FCODEC_MAX_STRIPES];
+    const size_t row = (size_t)info.w * info.ch;
+    size_t p = FCF_HEADER + 4 * (size_t)info.stripes;
+    for (int s = 0; s < info.stripes; ++s) {
+        const int r0 = (int)((long)s * info.h / info.stripes);
+        const int r1 = (int)((long)(s + 1) * info.h / info.stripes);
+        StripeJob* j = &jobs[s];
+        j->size = get_le32(data + FCF_HEADER + 4 * s);
+        if (j->size > size - p) return false;
+        j->src = data + p;
+        j->dst = out + (size_t)r0 * row;
+        j->step = (ptrdiff_t)row;
+        j->w = info.w; j->rows = r1 - r0; j->ch = info.ch;
+        j->ok = false;
+        p += j->size;
+    }
+    run_stripes(jobs, info.stripes, threads, true);
+    for (int s = 0; s < info.stripes; ++s)
+        if (!jobs[s].ok) return false;
+    return true;
+}
+
+/* ---------------- Standard QOI files ---------------- */
+
+bool fcodec_write_qoi(const char* path, const uint8_t* rgba, int w, int h, bool bottom_up) {
+    if (!rgba || w <= 0 || h <= 0) return false;
+    uint8_t* buf = malloc(14 + worst_case(w, h, 4) + sizeof(kQoiEnd));
+    if (!buf) return false;
+    memcpy(buf, "qoif", 4);
+    put_be32(buf + 4, (uint32_t)w);
+    put_be32(buf + 8, (uint32_t)h);
+    buf[12] = 4;    /* channels */
+    buf[13] = 0;    /* sRGB with linear alpha */
+    const ptrdiff_t stride = (ptrdiff_t)w * 4;
+    const uint8_t* first = bottom_up ? rgba + (size_t)(h - 1) * stride : rgba;
+    size_t n = 14 + encode_rgba(first, bottom_up ? -stride : stride, w, h, buf + 14);
+    memcpy(buf + n, kQoiEnd, sizeof(kQoiEnd));
+    n += sizeof(kQoiEnd);
+
+    FILE* f = fopen(path, "wb");
+    bool ok = f && fwrite(buf, 1, n, f) == n;
+    if (f && fclose(f) != 0) ok = false;
+    free(buf);
+    return ok;
+}
+
+uint8_t* fcodec_read_qoi(const char* path, int* w, int* h) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    uint8_t* px = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size >= 14 + (off_t)sizeof(kQoiEnd)) {
+        const size_t size = (size_t)st.st_size;
+        const uint8_t* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            const uint32_t qw = get_be32(map + 4), qh = get_be32(map + 8);
+            if (!memcmp(map, "qoif", 4) && qw && qh && qw <= 32768 && qh <= 32768 &&
+                (map[12] == 3 || map[12] == 4)) {
+                px = malloc((size_t)qw * qh * 4);
+                /* 3-channel files use the same op stream with alpha fixed at 255 */
+                if (px && !decode_rgba(map + 14, size - 14 - sizeof(kQoiEnd), px,
+                                       (ptrdiff_t)qw * 4, (int)qw, (int)qh)) {
+                    free(px);
+                    px = NULL;
+                }
+                if (px) { *w = (int)qw; *h = (int)qh; }
+            }
+            munmap((void*)map, size);
+        }
+    }
+    close(fd);
+    return px;
+}
+
+/* ---------------- .fcv streams ---------------- */
+
+bool fcodec_stream_write_header(FILE* f, int w, int h, int ch, double fps) {
+    uint8_t hdr[FCV_HEADER];
+    memset(hdr, 0, sizeof(hdr));
+    memcpy(hdr, "FCV1", 4);
+    put_le32(hdr + 4, (uint32_t)w);
+    put_le32(hdr + 8, (uint32_t)h);
+    put_le32(hdr + 12, (uint32_t)ch);
+    put_le32(hdr + 16, (uint32_t)(fps * 1000.0 + 0.5));
+    return fwrite(hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+}
+
+bool fcodec_stream_write_frame(FILE* f, const uint8_t* data, size_t size) {
+    uint8_t len[4];
+    put_le32(len, (uint32_t)size);
+    return fwrite(len, 1, 4, f) == 4 && fwrite(data, 1, size, f) == size;
+}
+
+bool fcodec_stream_open(FcodecStream* s, const char* path) {
+    memset(s, 0, sizeof(*s));
+    s->fd = open(path, O_RDONLY);
+    if (s->fd < 0) return false;
+    struct stat st;
+    if (fstat(s->fd, &st) != 0 || st.st_size < FCV_HEADER) goto fail;
+    s->size = (size_t)st.st_size;
+    void* map = mmap(NULL, s->size, PROT_READ, MAP_PRIVATE, s->fd, 0);
+    if (map == MAP_FAILED) goto fail;
+    s->map = map;
+    madvise(map, s->size, MADV_SEQUENTIAL);
+    if (memcmp(s->map, "FCV1", 4) != 0) goto fail;
+    s->w = (int)get_le32(s->map + 4);
+    s->h = (int)get_le32(s->map + 8);
+    s->ch = (int)get_le32(s->map + 12);
+    s->fps = get_le32(s->map + 16) / 1000.0;
+    if (s->w <= 0 || s->h <= 0 || (s->ch != 1 && s->ch != 4)) goto fail;
+
+    /* Index pass: only the length prefixes are touched */
+    long cap = 0;
+    size_t p = FCV_HEADER;
+    while (p + 4 <= s->size) {
+        const uint32_t n = get_le32(s->map + p);
+        if (n > s->size - p - 4) break;   /* truncated tail (writer killed) */
+        if (s->count == cap) {
+            cap = cap ? cap * 2 : 1024;
+            size_t* o = realloc(s->offsets, (size_t)cap * sizeof(size_t));
+            if (o) s->offsets = o;
+            uint32_t* z = realloc(s->sizes, (size_t)cap * sizeof(uint32_t));
+            if (z) s->sizes = z;
+            if (!o || !z) goto fail;
+        }
+        s->offsets[s->count] = p + 4;
+        s->sizes[s->count] = n;
+        s->count++;
+        p += 4 + (size_t)n;
+    }
+    return true;
+
+fail:
+    fcodec_stream_close(s);
+    return false;
+}
+
+const uint8_t* fcodec_stream_frame(const FcodecStream* s, long i, size_t* size) {
+    if (!s->map || i < 0 || i >= s->count) return NULL;
+    if (size) *size = s->sizes[i];
+    return s->map + s->offsets[i];
+}
+
+void fcodec_stream_close(FcodecStream* s) {
+    if (s->map) munmap((void*)s->map, s->size);
+    if (s->fd > 0) close(s->fd);
+    free(s->offsets);
+    free(s->sizes);
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+}
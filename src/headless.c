@@ -0,0 +1,156 @@
+#include "headless.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <string.h>
+
+static EGLDisplay g_dpy     = EGL_NO_DISPLAY;
+static EGLContext g_ctx     = EGL_NO_CONTEXT;
+static EGLSurface g_surface = EGL_NO_SURFACE;
+static GLuint g_fbo = 0, g_color_tex = 0, g_depth_rbo = 0;
+
+static bool has_ext(const char* list, const char* name) {
+    if (!list) return false;
+    size_t n = strlen(name);
+    for (const char* p = list; (p = strstr(p, name)) != NULL; p += n)
+        if ((p == list || p[-1] == ' ') && (p[n] == ' ' || p[n] == '\0')) return true;
+    return false;
+}
+
+static EGLDisplay open_display(void) {
+    /* Surfaceless first: works without X/Wayland and never blocks on a display server */
+    const char* client_ext = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (has_ext(client_ext, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display) {
+            EGLDisplay d = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+            if (d != EGL_NO_DISPLAY && eglInitialize(d, NULL, NULL)) return d;
+        }
+    }
+    EGLDisplay d = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (d != EGL_NO_DISPLAY && eglInitialize(d, NULL, NULL)) return d;
+    return EGL_NO_DISPLAY;
+}
+
+static bool choose_config(EGLint surface_bit, EGLConfig* out) {
+    const EGLint attrs[] = {
+        EGL_SURFACE_TYPE,    surface_bit,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 16,
+        EGL_NONE
+    };
+    EGLint n = 0;
+    return eglChooseConfig(g_dpy, attrs, out, 1, &n) && n > 0;
+}
+
+static bool create_offscreen_fbo(int width, int height) {
+    glGenFramebuffers(1, &g_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_fbo);
+
+    /* RGBA8 renderbuffers need OES_rgb8_rgba8; a texture is core GLES2 */
+    glGenTextures(1, &g_color_tex);
+    glBindTexture(GL_TEXTURE_2D, g_color_tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_color_tex, 0);
+
+    glGenRenderbuffers(1, &g_depth_rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, g_depth_rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, g_depth_rbo);
+
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+bool headless_init(int width, int height) {
+    g_dpy = open_display();
+    if (g_dpy == EGL_NO_DISPLAY) {
+        fprintf(stderr, "[HEADLESS] EGL display could not be opened\n");
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_ES_API)) {
+        fprintf(stderr, "[HEADLESS] eglBindAPI(GLES) failed\n");
+        headless_shutdown();
+        return false;
+    }
+
+    const EGLint ctx_attrs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    EGLConfig cfg;
+
+    if (choose_config(EGL_PBUFFER_BIT, &cfg)) {
+        const EGLint pb_attrs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+        g_surface = eglCreatePbufferSurface(g_dpy, cfg, pb_attrs);
+    }
+
+    if (g_surface != EGL_NO_SURFACE) {
+        g_ctx = eglCreateContext(g_dpy, cfg, EGL_NO_CONTEXT, ctx_attrs);
+        if (g_ctx == EGL_NO_CONTEXT || !eglMakeCurrent(g_dpy, g_surface, g_surface, g_ctx)) {
+            fprintf(stderr, "[HEADLESS] pbuffer context failed (0x%x)\n", eglGetError());
+            headless_shutdown();
+            return false;
+        }
+        eglSwapInterval(g_dpy, 0);
+    } else {
+        const char* ext = eglQueryString(g_dpy, EGL_EXTENSIONS);
+        if (!has_ext(ext, "EGL_KHR_surfaceless_context") || !choose_config(0, &cfg)) {
+            fprintf(stderr, "[HEADLESS] neither pbuffer nor surfaceless contexts are available\n");
+            headless_shutdown();
+            return false;
+        }
+        g_ctx = eglCreateContext(g_dpy, cfg, EGL_NO_CONTEXT, ctx_attrs);
+        if (g_ctx == EGL_NO_CONTEXT || !eglMakeCurrent(g_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, g_ctx)) {
+            fprintf(stderr, "[HEADLESS] surfaceless context failed (0x%x)\n", eglGetError());
+            headless_shutdown();
+            return false;
+        }
+        if (!create_offscreen_fbo(width, height)) {
+            fprintf(stderr, "[HEADLESS] offscreen framebuffer incomplete\n");
+            headless_shutdown();
+            return false;
+        }
+    }
+
+    glViewport(0, 0, width, height);
+    printf("[HEADLESS] %s, %s (%dx%d)\n", headless_renderer(),
+           g_surface != EGL_NO_SURFACE ? "pbuffer" : "surfaceless FBO", width, height);
+    return true;
+}
+
+GLuint headless_default_fbo(void) {
+    return g_fbo;
+}
+
+void headless_swap(void) {
+    if (g_surface != EGL_NO_SURFACE) eglSwapBuffers(g_dpy, g_surface);
+    else glFlush();
+}
+
+void* headless_get_proc(const char* name) {
+    return (void*)eglGetProcAddress(name);
+}
+
+const char* headless_renderer(void) {
+    const char* r = (const char*)glGetString(GL_RENDERER);
+    return r ? r : "(unknown renderer)";
+}
+
+void headless_shutdown(void) {
+    if (g_ctx != EGL_NO_CONTEXT) {
+        if (g_depth_rbo) glDeleteRenderbuffers(1, &g_depth_rbo);
+        if (g_color_tex) glDeleteTextures(1, &g_color_tex);
+        if (g_fbo)       glDeleteFramebuffers(1, &g_fbo);
+    }
+    g_fbo = g_color_tex = g_depth_rbo = 0;
+    if (g_dpy != EGL_NO_DISPLAY) {
+        eglMakeCurrent(g_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (g_surface != EGL_NO_SURFACE) eglDestroySurface(g_dpy, g_surface);
+        if (g_ctx != EGL_NO_CONTEXT)     eglDestroyContext(g_dpy, g_ctx);
+        eglTerminate(g_dpy);
+    }
+    g_dpy = EGL_NO_DISPLAY;
+    g_ctx = EGL_NO_CONTEXT;
+    g_surface = EGL_NO_SURFACE;
+}
@@ -25,6 +25,7 @@ const unsigned char* imageData = NULL; // owned by this module (g_heightData)
  *  Module-Local State
  * ========================== */
 static unsigned char* g_heightData = NULL; // owns imageData memory
+static long g_chunk_generations = 0;       // chunk meshes built so far
 static GLuint terrainShaderProgram = 0;
 static GLuint rockTextureID        = 0;
 static GLuint sharedChunkEBO       = 0; // shared index buffer for all chunks
@@ -213,6 +214,7 @@ static void generate_chunk_vertex_data(Chunk* chunk) {
         }
     }
 
+    ++g_chunk_generations;
     glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
     glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)vertexCount * 3 * sizeof(GLfloat), vertices);
     glBindBuffer(GL_ARRAY_BUFFER, chunk->tbo);
@@ -312,6 +314,27 @@ void update_chunks(void) {
     }
 }
 
+void get_chunk_residency(ChunkResidency out[TOTAL_CHUNKS]) {
+    for (int i = 0; i < TOTAL_CHUNKS; ++i) {
+        out[i].gridX    = chunks[i].gridX;
+        out[i].gridZ    = chunks[i].gridZ;
+        out[i].isActive = chunks[i].isActive ? 1 : 0;
+    }
+}
+
+void set_chunk_residency(const ChunkResidency in[TOTAL_CHUNKS]) {
+    for (int i = 0; i < TOTAL_CHUNKS; ++i) {
+        bool active = in[i].isActive != 0;
+        bool same_tile = chunks[i].isActive && chunks[i].gridX == in[i].gridX && chunks[i].gridZ == in[i].gridZ;
+        chunks[i].isActive = active;
+        chunks[i].gridX = in[i].gridX;
+        chunks[i].gridZ = in[i].gridZ;
+        if (active && !same_tile) generate_chunk_vertex_data(&chunks[i]);
+    }
+}
+
+long chunk_generations(void) { return g_chunk_generations; }
+
 void draw_chunks(mat4 view, mat4 proj) {
     glUseProgram(terrainShaderProgram);
 
@@ -0,0 +1,161 @@
+#define _GNU_SOURCE
+#include "hud.h"
+#include "blackbox.h"
+#include "dataset.h"
+#include "detlog.h"
+#include "shadow.h"
+#include "stats.h"
+#include "text.h"
+#include "video.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* Rows: frame time, the detection stages, tracker */
+enum { ROW_FRAME, ROW_STAGE0, ROW_TRACK = ROW_STAGE0 + DETLOG_STAGES, HUD_ROWS };
+/* Text lines: header, one per row, queues, drops, own cost */
+enum { LINE_HEADER, LINE_ROW0, LINE_QUEUES = LINE_ROW0 + HUD_ROWS, LINE_DROPS, LINE_COST, HUD_LINES };
+
+#define HUD_X       0.42f
+#define HUD_Y       0.95f
+#define HUD_STEP    0.04f
+#define HUD_SIZE_PX 20.0f
+
+static struct {
+    bool        ready;
+    bool        visible;
+    double      budget_ms;
+    RollingHist rows[HUD_ROWS];
+    RollingHist cost;              /* hud_update + hud_draw */
+    double      update_ms;         /* this frame's hud_update, added to the draw */
+    int         text_first;        /* HUD_LINES consecutive text ids, -1 until first shown */
+    int         next_line;
+    long        frames, late;
+} g_hud;
+
+static double now_ms(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec * 1000.0 + (double)t.tv_nsec / 1e6;
+}
+
+bool hud_init(bool visible, double budget_ms) {
+    memset(&g_hud, 0, sizeof(g_hud));
+    for (int r = 0; r < HUD_ROWS; ++r)
+        if (rollhist_init(&g_hud.rows[r], HUD_WINDOW) != 0) return false;
+    if (rollhist_init(&g_hud.cost, HUD_WINDOW) != 0) return false;
+    g_hud.text_first = -1;
+    g_hud.budget_ms = budget_ms;
+    g_hud.ready = true;
+    if (visible) hud_toggle();
+    return true;
+}
+
+bool hud_visible(void) { return g_hud.visible; }
+
+void hud_frame(double frame_ms) {
+    if (!g_hud.ready) return;
+    rollhist_push(&g_hud.rows[ROW_FRAME], frame_ms);
+    g_hud.frames++;
+    if (g_hud.budget_ms > 0.0 && frame_ms > 1.5 * g_hud.budget_ms) g_hud.late++;
+}
+
+void hud_detection(const float* stage_ms, double track_ms) {
+    if (!g_hud.ready || !stage_ms) return;
+    for (int s = 0; s < DETLOG_STAGES; ++s) rollhist_push(&g_hud.rows[ROW_STAGE0 + s], stage_ms[s]);
+    if (track_ms >= 0.0) rollhist_push(&g_hud.rows[ROW_TRACK], track_ms);
+}
+
+static void format_row(char* buf, size_t cap, const char* name, const RollingHist* r) {
+    if (r->h.count == 0) {
+        snprintf(buf, cap, "%-8s       -       -       -", name);
+        return;
+    }
+    snprintf(buf, cap, "%-8s %7.2f %7.2f %7.2f", name, loghist_percentile(&r->h, 50.0),
+             loghist_percentile(&r->h, 95.0), loghist_percentile(&r->h, 99.0));
+}
+
+static void format_line(int line, char* buf, size_t cap) {
+    if (line == LINE_HEADER) {
+        snprintf(buf, cap, "ms       %7s %7s %7s  (last %d)", "p50", "p95", "p99", HUD_WINDOW);
+    } else if (line < LINE_QUEUES) {
+        int row = line - LINE_ROW0;
+        const char* name = row == ROW_FRAME ? "frame" : row == ROW_TRACK ? "track"
+                         : detlog_stage_names[row - ROW_STAGE0];
+        format_row(buf, cap, name, &g_hud.rows[row]);
+    } else if (line == LINE_QUEUES) {
+        snprintf(buf, cap, "queues   video %d/%d  dataset %d  blackbox %d  shadow %d", video_queue_depth(NULL),
+                 VIDEO_RING_SLOTS, dataset_queue_depth(), blackbox_queue_depth(NULL), shadow_queue_depth(NULL));
+    } else if (line == LINE_DROPS) {
+        long vd, bd, sd;
+        video_queue_depth(&vd);
+        blackbox_queue_depth(&bd);
+        shadow_queue_depth(&sd);
+        if (g_hud.budget_ms > 0.0)
+            snprintf(buf, cap, "drops    late %ld (%.1f%%)  video %ld  blackbox %ld  shadow %ld", g_hud.late,
+                     g_hud.frames ? 100.0 * g_hud.late / g_hud.frames : 0.0, vd, bd, sd);
+        else
+            snprintf(buf, cap, "drops    late -  video %ld  blackbox %ld  shadow %ld", vd, bd, sd);
+    } else {
+        snprintf(buf, cap, "hud      %7.3f %7.3f %7.3f", loghist_percentile(&g_hud.cost.h, 50.0),
+                 loghist_percentile(&g_hud.cost.h, 95.0), loghist_percentile(&g_hud.cost.h, 99.0));
+    }
+}
+
+/* Text slots are taken on first show: a run that never opens the HUD
+ * spends no VBOs on it. add_text ids are consecutive, so one range draws them. */
+static bool alloc_lines(void) {
+    for (int i = 0; i < HUD_LINES; ++i) {
+        int id = add_text("", HUD_X, HUD_Y - HUD_STEP * i, HUD_SIZE_PX, 1.0f, 0.85f, 0.0f, 1.0f);
+        if (id < 0 || (i > 0 && id != g_hud.text_first + i)) return false;
+        if (i == 0) g_hud.text_first = id;
+        set_text_visible(id, false);   /* drawn by hud_draw, not draw_texts */
+    }
+    return true;
+}
+
+void hud_toggle(void) {
+    if (!g_hud.ready) return;
+    if (g_hud.text_first < 0 && !alloc_lines()) {
+        fprintf(stderr, "[HUD] no free text slots\n");
+        g_hud.ready = false;
+        return;
+    }
+    g_hud.visible = !g_hud.visible;
+    if (!g_hud.visible) return;
+    char buf[128];
+    for (int i = 0; i < HUD_LINES; ++i) {
+        format_line(i, buf, sizeof(buf));
+        update_text(g_hud.text_first + i, buf);
+    }
+}
+
+void hud_update(void) {
+    if (!g_hud.ready || !g_hud.visible) return;
+    double t0 = now_ms();
+    char buf[128];
+    int line = g_hud.next_line;
+    g_hud.next_line = (line + 1) % HUD_LINES;
+    format_line(line, buf, sizeof(buf));
+    update_text(g_hud.text_first + line, buf);
+    g_hud.update_ms = now_ms() - t0;
+}
+
+void hud_draw(void) {
+    if (!g_hud.ready || !g_hud.visible) return;
+    double t0 = now_ms();
+    draw_text_range(g_hud.text_first, HUD_LINES);
+    rollhist_push(&g_hud.cost, g_hud.update_ms + now_ms() - t0);
+    g_hud.update_ms = 0.0;
+}
+
+void hud_free(void) {
+    if (!g_hud.ready) return;
+    if (g_hud.cost.h.count > 0)
+        printf("[HUD] update+draw ms p50=%.4f p99=%.4f over the last %d frames shown\n",
+               loghist_percentile(&g_hud.cost.h, 50.0), loghist_percentile(&g_hud.cost.h, 99.0), g_hud.cost.count);
+    for (int r = 0; r < HUD_ROWS; ++r) rollhist_free(&g_hud.rows[r]);
+    rollhist_free(&g_hud.cost);
+    g_hud.ready = false;
+}
@@ -0,0 +1,199 @@
+#include "idpass.h"
+#include "plane.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IDPASS_ROWS (2 * MAX_PLANES)   /* rows 0..N-1: columns of ID k, N..2N-1: rows */
+
+static struct {
+    int      ready;
+    int      w, h, len;
+    GLuint   id_fbo, id_tex, id_depth;
+    GLuint   red_fbo, red_tex;
+    GLuint   prog;
+    GLuint   quad_vbo;
+    uint8_t* strip;                /* len x IDPASS_ROWS RGBA readback */
+} g_idp;
+
+/* Each fragment (i, r) walks one column (r < N) or row (r >= N) of the ID
+ * image and counts pixels of ID (r mod N) + 1. R: any, G/B: count hi/lo. */
+static const char* kReduceFS =
+    "#version 100\n"
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+    "precision highp float;\n"
+    "#else\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "uniform sampler2D u_ids;\n"
+    "uniform vec2 u_size;\n"
+    "void main() {\n"
+    "   float i = floor(gl_FragCoord.x);\n"
+    "   float r = floor(gl_FragCoord.y);\n"
+    "   bool rows = r >= float(NIDS);\n"
+    "   float k = mod(r, float(NIDS)) + 1.0;\n"
+    "   float cnt = 0.0;\n"
+    "   for (int j = 0; j < LEN; ++j) {\n"
+    "       vec2 px = rows ? vec2(float(j), i) : vec2(i, float(j));\n"
+    "       if (px.x < u_size.x && px.y < u_size.y) {\n"
+    "           float id = floor(texture2D(u_ids, (px + 0.5) / u_size).r * 255.0 + 0.5);\n"
+    "           if (id == k) cnt += 1.0;\n"
+    "       }\n"
+    "   }\n"
+    "   gl_FragColor = vec4(cnt > 0.0 ? 1.0 : 0.0, floor(cnt / 256.0) / 255.0, mod(cnt, 256.0) / 255.0, 1.0);\n"
+    "}\n";
+
+static const char* kReduceVS =
+    "#version 100\n"
+    "attribute vec2 a_pos;\n"
+    "void main() { gl_Position = vec4(a_pos, 0.0, 1.0); }\n";
+
+static GLuint make_target(int w, int h, GLuint* tex) {
+    glGenTextures(1, tex);
+    glBindTexture(GL_TEXTURE_2D, *tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *tex, 0);
+    return fbo;
+}
+
+bool idpass_init(int w, int h) {
+    if (g_idp.ready) return true;
+    memset(&g_idp, 0, sizeof(g_idp));
+    g_idp.w = w;
+    g_idp.h = h;
+    g_idp.len = w > h ? w : h;
+
+    char fs[2048];
+    snprintf(fs, sizeof(fs), "#version 100\n#define LEN %d\n#define NIDS %d\n%s",
+             g_idp.len, MAX_PLANES, kReduceFS + strlen("#version 100\n"));
+    g_idp.prog = createShaderProgram(kReduceVS, fs);
+    if (!g_idp.prog) { fprintf(stderr, "[IDPASS] reduction shader failed\n"); return false; }
+
+    GLint prev_fbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prev_fbo);
+
+    g_idp.id_fbo = make_target(w, h, &g_idp.id_tex);
+    glGenRenderbuffers(1, &g_idp.id_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, g_idp.id_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, w, h);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, g_idp.id_depth);
+    bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    g_idp.red_fbo = make_target(g_idp.len, IDPASS_ROWS, &g_idp.red_tex);
+    ok = ok && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)prev_fbo);
+
+    const GLfloat quad[8] = { -1.f, -1.f, 1.f, -1.f, -1.f, 1.f, 1.f, 1.f };
+    glGenBuffers(1, &g_idp.quad_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, g_idp.quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
+    g_idp.strip = malloc((size_t)g_idp.len * IDPASS_ROWS * 4);
+    g_idp.ready = 1;
+    if (!ok || !g_idp.strip) {
+        fprintf(stderr, "[IDPASS] framebuffer setup failed\n");
+        idpass_destroy();
+        return false;
+    }
+    printf("[IDPASS] %dx%d ID target, %dx%d readback strip\n", w, h, g_idp.len, IDPASS_ROWS);
+    return true;
+}
+
+bool idpass_ready(void) {
+    return g_idp.ready != 0;
+}
+
+bool idpass_run(mat4 view, mat4 proj, int vp_x, int vp_y, int vp_w, int vp_h,
+                IdPassBox out[MAX_PLANES]) {
+    memset(out, 0, sizeof(IdPassBox) * MAX_PLANES);
+    if (!g_idp.ready || plane_count > MAX_PLANES) return false;   /* IDs are 1..MAX_PLANES */
+
+    GLint prev_fbo = 0; glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prev_fbo);
+    GLint prev_vp[4];   glGetIntegerv(GL_VIEWPORT, prev_vp);
+    GLboolean depth_on = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blend_on = glIsEnabled(GL_BLEND);
+    GLfloat prev_clear[4]; glGetFloatv(GL_COLOR_CLEAR_VALUE, prev_clear);
+
+    /* 1) IDs with depth: other planes occlude exactly as in the color pass */
+    glBindFramebuffer(GL_FRAMEBUFFER, g_idp.id_fbo);
+    glViewport(0, 0, g_idp.w, g_idp.h);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glViewport(vp_x, vp_y, vp_w, vp_h);
+    for (int i = 0; i < plane_count; ++i)
+        draw_plane_id(&planes[i], view, proj, i + 1);
+
+    /* 2) Reduce to per-ID column/row histograms */
+    glBindFramebuffer(GL_FRAMEBUFFER, g_idp.red_fbo);
+    glViewport(0, 0, g_idp.len, IDPASS_ROWS);
+    glDisable(GL_DEPTH_TEST);
+    glUseProgram(g_idp.prog);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, g_idp.id_tex);
+    glUniform1i(glGetUniformLocation(g_idp.prog, "u_ids"), 0);
+    glUniform2f(glGetUniformLocation(g_idp.prog, "u_size"), (float)g_idp.w, (float)g_idp.h);
+    GLint a_pos = glGetAttribLocation(g_idp.prog, "a_pos");
+    glBindBuffer(GL_ARRAY_BUFFER, g_idp.quad_vbo);
+    glEnableVertexAttribArray(a_pos);
+    glVertexAttribPointer(a_pos, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(a_pos);
+
+    /* 3) Tiny readback */
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, g_idp.len, IDPASS_ROWS, GL_RGBA, GL_UNSIGNED_BYTE, g_idp.strip);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)prev_fbo);
+    glViewport(prev_vp[0], prev_vp[1], prev_vp[2], prev_vp[3]);
+    glClearColor(prev_clear[0], prev_clear[1], prev_clear[2], prev_clear[3]);
+    if (depth_on) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+    if (blend_on) glEnable(GL_BLEND);
+
+    for (int k = 0; k < MAX_PLANES; ++k) {
+        const uint8_t* cols = g_idp.strip + (size_t)k * g_idp.len * 4;
+        const uint8_t* rows = g_idp.strip + (size_t)(MAX_PLANES + k) * g_idp.len * 4;
+        int x0 = -1, x1 = -1, y0 = -1, y1 = -1, px = 0;
+        for (int i = 0; i < g_idp.w; ++i) {
+            if (!cols[4 * i]) continue;
+            if (x0 < 0) x0 = i;
+            x1 = i;
+            px += cols[4 * i + 1] * 256 + cols[4 * i + 2];
+        }
+        for (int j = 0; j < g_idp.h; ++j) {
+            if (!rows[4 * j]) continue;
+            if (y0 < 0) y0 = j;
+            y1 = j;
+        }
+        if (x0 < 0 || y0 < 0) continue;
+        out[k].visible_px = px;
+        out[k].x1 = (float)x0;
+        out[k].x2 = (float)(x1 + 1);
+        out[k].y1 = (float)(g_idp.h - 1 - y1);   /* GL rows are bottom-up */
+        out[k].y2 = (float)(g_idp.h - y0);
+    }
+    return true;
+}
+
+void idpass_destroy(void) {
+    if (!g_idp.ready) return;
+    if (g_idp.prog) glDeleteProgram(g_idp.prog);
+    if (g_idp.quad_vbo) glDeleteBuffers(1, &g_idp.quad_vbo);
+    if (g_idp.id_fbo) glDeleteFramebuffers(1, &g_idp.id_fbo);
+    if (g_idp.red_fbo) glDeleteFramebuffers(1, &g_idp.red_fbo);
+    if (g_idp.id_depth) glDeleteRenderbuffers(1, &g_idp.id_depth);
+    if (g_idp.id_tex) glDeleteTextures(1, &g_idp.id_tex);
+    if (g_idp.red_tex) glDeleteTextures(1, &g_idp.red_tex);
+    free(g_idp.strip);
+    memset(&g_idp, 0, sizeof(g_idp));
+}
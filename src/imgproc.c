@@ -0,0 +1,359 @@
+#include "imgproc.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define IMGPROC_SIMD 1
+#else
+#define IMGPROC_SIMD 0
+#endif
+
+/* ---------------- Scratch ---------------- */
+
+static int grow(void** p, size_t* cap, size_t need, size_t elem) {
+    if (*cap >= need) return 1;
+    void* q = realloc(*p, need * elem);
+    if (!q) return 0;
+    *p = q;
+    *cap = need;
+    return 1;
+}
+
+void imgproc_scratch_free(ImgScratch* s) {
+    if (!s) return;
+    free(s->gray);
+    free(s->resized);
+    free(s->row16);
+    free(s->rowf);
+    free(s->xtab);
+    free(s->wtab);
+    memset(s, 0, sizeof(*s));
+}
+
+/* ---------------- Geometry ---------------- */
+
+BoxTransform imgproc_letterbox_fit(int src_w, int src_h, int dst_w, int dst_h) {
+    BoxTransform tf;
+    float s = fminf((float)dst_w / (float)src_w, (float)dst_h / (float)src_h);
+    tf.content_w = (int)floorf(src_w * s + 0.5f);
+    tf.content_h = (int)floorf(src_h * s + 0.5f);
+    if (tf.content_w > dst_w) tf.content_w = dst_w;
+    if (tf.content_h > dst_h) tf.content_h = dst_h;
+    tf.content_x = (dst_w - tf.content_w) / 2;
+    tf.content_y = (dst_h - tf.content_h) / 2;
+    tf.scale_x = (float)tf.content_w / (float)src_w;
+    tf.scale_y = (float)tf.content_h / (float)src_h;
+    tf.off_x = (float)tf.content_x;
+    tf.off_y = (float)tf.content_y;
+    tf.src_w = src_w;
+    tf.src_h = src_h;
+    return tf;
+}
+
+void imgproc_unmap_box(const BoxTransform* tf, OnnxDet* d) {
+    d->x1 = fminf(fmaxf((d->x1 - tf->off_x) / tf->scale_x, 0.f), (float)tf->src_w);
+    d->x2 = fminf(fmaxf((d->x2 - tf->off_x) / tf->scale_x, 0.f), (float)tf->src_w);
+    d->y1 = fminf(fmaxf((d->y1 - tf->off_y) / tf->scale_y, 0.f), (float)tf->src_h);
+    d->y2 = fminf(fmaxf((d->y2 - tf->off_y) / tf->scale_y, 0.f), (float)tf->src_h);
+}
+
+/* ---------------- Color conversion ---------------- */
+
+/* Y = (77 R + 150 G + 29 B) >> 8 */
+void imgproc_rgba_to_gray(const uint8_t* src, uint8_t* dst, int n) {
+    int x = 0;
+#if IMGPROC_SIMD
+    const __m128i mask = _mm_set1_epi32(0x00FF00FF);
+    const __m128i w_rb = _mm_set1_epi32((29 << 16) | 77);
+    const __m128i w_ga = _mm_set1_epi32(150);
+    for (; x + 16 <= n; x += 16) {
+        __m128i y[4];
+        for (int k = 0; k < 4; ++k) {
+            __m128i v  = _mm_loadu_si128((const __m128i*)(src + (size_t)(x + 4 * k) * 4));
+            __m128i rb = _mm_and_si128(v, mask);
+            __m128i ga = _mm_and_si128(_mm_srli_epi16(v, 8), mask);
+            y[k] = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(rb, w_rb),
+                                                _mm_madd_epi16(ga, w_ga)), 8);
+        }
+        __m128i lo = _mm_packs_epi32(y[0], y[1]);
+        __m128i hi = _mm_packs_epi32(y[2], y[3]);
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; x < n; ++x) {
+        const uint8_t* p = src + (size_t)x * 4;
+        dst[x] = (uint8_t)((77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8);
+    }
+}
+
+/* Packed 24-bit input has no clean SSE2 deinterleave; the scalar loop
+ * is kept branch-free so the compiler can vectorize it. */
+void imgproc_rgb_to_gray(const uint8_t* src, uint8_t* dst, int n) {
+    for (int x = 0; x < n; ++x) {
+        const uint8_t* p = src + (size_t)x * 3;
+        dst[x] = (uint8_t)((77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8);
+    }
+}
+
+void imgproc_to_gray(const uint8_t* src, PixFormat fmt, int w, int h, int stride,
+                     int bottom_up, uint8_t* dst) {
+    if (stride <= 0) stride = w * (int)fmt;
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* row = src + (size_t)(bottom_up ? h - 1 - y : y) * stride;
+        uint8_t* out = dst + (size_t)y * w;
+        switch (fmt) {
+            case PIX_RGBA8: imgproc_rgba_to_gray(row, out, w); break;
+            case PIX_RGB8:  imgproc_rgb_to_gray(row, out, w);  break;
+            default:        memcpy(out, row, (size_t)w);       break;
+        }
+    }
+}
+
+void imgproc_gray_to_chw3(const uint8_t* gray, int n, float* c0, float* c1, float* c2) {
+    const float inv255 = 1.0f / 255.0f;
+    int x = 0;
+#if IMGPROC_SIMD
+    const __m128i z = _mm_setzero_si128();
+    const __m128 k = _mm_set1_ps(inv255);
+    for (; x + 16 <= n; x += 16) {
+        __m128i v  = _mm_loadu_si128((const __m128i*)(gray + x));
+        __m128i lo = _mm_unpacklo_epi8(v, z), hi = _mm_unpackhi_epi8(v, z);
+        __m128 f[4];
+        f[0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, z)), k);
+        f[1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, z)), k);
+        f[2] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, z)), k);
+        f[3] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, z)), k);
+        for (int i = 0; i < 4; ++i) {
+            _mm_storeu_ps(c0 + x + 4 * i, f[i]);
+            _mm_storeu_ps(c1 + x + 4 * i, f[i]);
+            _mm_storeu_ps(c2 + x + 4 * i, f[i]);
+        }
+    }
+#endif
+    for (; x < n; ++x) c0[x] = c1[x] = c2[x] = gray[x] * inv255;
+}
+
+void rgba_flip_gray3_chw_norm(const unsigned char* src, float* dst, int W, int H) {
+    const float inv255 = 1.0f / 255.0f;
+    const float wr = 0.299f * inv255, wg = 0.587f * inv255, wb = 0.114f * inv255;
+    size_t stride_ch = (size_t)W * (size_t)H;
+
+    for (int y = 0; y < H; ++y) {
+        const unsigned char* row = src + (size_t)(H - 1 - y) * (size_t)W * 4;
+        float* d0 = dst + (size_t)y * (size_t)W;
+        float* d1 = d0 + stride_ch;
+        float* d2 = d1 + stride_ch;
+        int x = 0;
+#if IMGPROC_SIMD
+        const __m128i m8 = _mm_set1_epi32(0xFF);
+        const __m128 vr = _mm_set1_ps(wr), vg = _mm_set1_ps(wg), vb = _mm_set1_ps(wb);
+        for (; x + 4 <= W; x += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(row + (size_t)x * 4));
+            __m128 r = _mm_cvtepi32_ps(_mm_and_si128(v, m8));
+            __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 8), m8));
+            __m128 b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 16), m8));
+            __m128 yv = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, vr), _mm_mul_ps(g, vg)), _mm_mul_ps(b, vb));
+            _mm_storeu_ps(d0 + x, yv);
+            _mm_storeu_ps(d1 + x, yv);
+            _mm_storeu_ps(d2 + x, yv);
+        }
+#endif
+        for (; x < W; ++x) {
+            const unsigned char* p = row + (size_t)x * 4;
+            float yval = p[0] * wr + p[1] * wg + p[2] * wb;
+            d0[x] = d1[x] = d2[x] = yval;
+        }
+    }
+}
+
+/* ---------------- Resize ---------------- */
+
+/* r0 * (256 - wy) + r1 * wy, 8.8 fixed point */
+static void blend_rows_u16(const uint8_t* r0, const uint8_t* r1, int wy, uint16_t* out, int n) {
+    int x = 0;
+#if IMGPROC_SIMD
+    const __m128i z = _mm_setzero_si128();
+    const __m128i w0 = _mm_set1_epi16((short)(256 - wy)), w1 = _mm_set1_epi16((short)wy);
+    for (; x + 16 <= n; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(r0 + x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(r1 + x));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, z), w0),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(b, z), w1));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, z), w0),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(b, z), w1));
+        _mm_storeu_si128((__m128i*)(out + x), lo);
+        _mm_storeu_si128((__m128i*)(out + x + 8), hi);
+    }
+#endif
+    for (; x < n; ++x) out[x] = (uint16_t)(r0[x] * (256 - wy) + r1[x] * wy);
+}
+
+static int resize_bilinear(ImgScratch* s, const uint8_t* src, int sw, int sh,
+                           uint8_t* dst, int dw, int dh, int dst_stride) {
+    if (!grow((void**)&s->row16, &s->row16_cap, (size_t)sw + 1, sizeof(uint16_t)) ||
+        !grow((void**)&s->xtab, &s->xtab_cap, (size_t)dw * 2, sizeof(int32_t)))
+        return -1;
+
+    /* x table: source index and 8-bit weight */
+    const float fx = (float)sw / (float)dw;
+    for (int x = 0; x < dw; ++x) {
+        float sx = (x + 0.5f) * fx - 0.5f;
+        if (sx < 0.f) sx = 0.f;
+        int x0 = (int)sx;
+        if (x0 > sw - 1) x0 = sw - 1;
+        s->xtab[2 * x]     = x0;
+        s->xtab[2 * x + 1] = (int32_t)((sx - (float)x0) * 256.f + 0.5f);
+    }
+
+    const float fy = (float)sh / (float)dh;
+    for (int y = 0; y < dh; ++y) {
+        float sy = (y + 0.5f) * fy - 0.5f;
+        if (sy < 0.f) sy = 0.f;
+        int y0 = (int)sy;
+        if (y0 > sh - 1) y0 = sh - 1;
+        int y1 = y0 + 1 < sh ? y0 + 1 : y0;
+        int wy = (int)((sy - (float)y0) * 256.f + 0.5f);
+
+        blend_rows_u16(src + (size_t)y0 * sw, src + (size_t)y1 * sw, wy, s->row16, sw);
+        s->row16[sw] = s->row16[sw - 1];
+
+        uint8_t* out = dst + (size_t)y * dst_stride;
+        const uint16_t* r = s->row16;
+        for (int x = 0; x < dw; ++x) {
+            int x0 = s->xtab[2 * x], wx = s->xtab[2 * x + 1];
+            uint32_t v = (uint32_t)r[x0] * (uint32_t)(256 - wx) + (uint32_t)r[x0 + 1] * (uint32_t)wx;
+            out[x] = (uint8_t)((v + 32768u) >> 16);
+        }
+    }
+    return 0;
+}
+
+/* acc += row * w */
+static void accumulate_row(const uint8_t* row, float w, float* acc, int n) {
+    int x = 0;
+#if IMGPROC_SIMD
+    const __m128i z = _mm_setzero_si128();
+    const __m128 vw = _mm_set1_ps(w);
+    for (; x + 16 <= n; x += 16) {
+        __m128i v  = _mm_loadu_si128((const __m128i*)(row + x));
+        __m128i lo = _mm_unpacklo_epi8(v, z), hi = _mm_unpackhi_epi8(v, z);
+        __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, z));
+        __m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, z));
+        __m128 f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, z));
+        __m128 f3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, z));
+        _mm_storeu_ps(acc + x,      _mm_add_ps(_mm_loadu_ps(acc + x),      _mm_mul_ps(f0, vw)));
+        _mm_storeu_ps(acc + x + 4,  _mm_add_ps(_mm_loadu_ps(acc + x + 4),  _mm_mul_ps(f1, vw)));
+        _mm_storeu_ps(acc + x + 8,  _mm_add_ps(_mm_loadu_ps(acc + x + 8),  _mm_mul_ps(f2, vw)));
+        _mm_storeu_ps(acc + x + 12, _mm_add_ps(_mm_loadu_ps(acc + x + 12), _mm_mul_ps(f3, vw)));
+    }
+#endif
+    for (; x < n; ++x) acc[x] += row[x] * w;
+}
+
+static int resize_area(ImgScratch* s, const uint8_t* src, int sw, int sh,
+                       uint8_t* dst, int dw, int dh, int dst_stride) {
+    const float fx = (float)sw / (float)dw;
+    const float fy = (float)sh / (float)dh;
+    /* per output column: [start, count] + count weights; spans cover <= ceil(fx)+1 px */
+    const int span = (int)ceilf(fx) + 1;
+
+    if (!grow((void**)&s->rowf, &s->rowf_cap, (size_t)sw, sizeof(float)) ||
+        !grow((void**)&s->xtab, &s->xtab_cap, (size_t)dw * 2, sizeof(int32_t)) ||
+        !grow((void**)&s->wtab, &s->wtab_cap, (size_t)dw * span, sizeof(float)))
+        return -1;
+
+    for (int x = 0; x < dw; ++x) {
+        float a = x * fx, b = (x + 1) * fx;
+        int i0 = (int)a, i1 = (int)ceilf(b);
+        if (i1 > sw) i1 = sw;
+        if (i1 - i0 > span) i1 = i0 + span;
+        s->xtab[2 * x] = i0;
+        s->xtab[2 * x + 1] = i1 - i0;
+        for (int i = i0; i < i1; ++i)
+            s->wtab[(size_t)x * span + (i - i0)] = (fminf(b, (float)(i + 1)) - fmaxf(a, (float)i)) / fx;
+    }
+
+    for (int y = 0; y < dh; ++y) {
+        float a = y * fy, b = (y + 1) * fy;
+        int j0 = (int)a, j1 = (int)ceilf(b);
+        if (j1 > sh) j1 = sh;
+
+        memset(s->rowf, 0, sizeof(float) * (size_t)sw);
+        for (int j = j0; j < j1; ++j)
+            accumulate_row(src + (size_t)j * sw, (fminf(b, (float)(j + 1)) - fmaxf(a, (float)j)) / fy, s->rowf, sw);
+
+        uint8_t* out = dst + (size_t)y * dst_stride;
+        for (int x = 0; x < dw; ++x) {
+            const float* wt = s->wtab + (size_t)x * span;
+            const float* r = s->rowf + s->xtab[2 * x];
+            float v = 0.f;
+            for (int i = 0; i < s->xtab[2 * x + 1]; ++i) v += r[i] * wt[i];
+            int iv = (int)(v + 0.5f);
+            out[x] = (uint8_t)(iv > 255 ? 255 : iv);
+        }
+    }
+    return 0;
+}
+
+int imgproc_resize_gray(ImgScratch* s, const uint8_t* src, int sw, int sh,
+                        uint8_t* dst, int dw, int dh, int dst_stride, ResizeMode mode) {
+    if (!s || !src || !dst || sw <= 0 || sh <= 0 || dw <= 0 || dh <= 0) return -1;
+    if (dst_stride <= 0) dst_stride = dw;
+
+    if (sw == dw && sh == dh) {
+        for (int y = 0; y < dh; ++y) memcpy(dst + (size_t)y * dst_stride, src + (size_t)y * sw, (size_t)sw);
+        return 0;
+    }
+    if (mode == RESIZE_AREA && dw <= sw && dh <= sh)
+        return resize_area(s, src, sw, sh, dst, dw, dh, dst_stride);
+    return resize_bilinear(s, src, sw, sh, dst, dw, dh, dst_stride);
+}
+
+/* ---------------- Frame -> tensor ---------------- */
+
+static void fill_f32(float* p, size_t n, float v) {
+    for (size_t i = 0; i < n; ++i) p[i] = v;
+}
+
+int imgproc_frame_to_tensor(ImgScratch* s,
+                            const uint8_t* src, PixFormat fmt, int w, int h, int stride, int bottom_up,
+                            float* dst_chw, int dst_w, int dst_h,
+                            ResizeMode mode, float pad_value, BoxTransform* out_tf) {
+    if (!s || !src || !dst_chw || w <= 0 || h <= 0 || dst_w <= 0 || dst_h <= 0) return ONNX_ERR_INVALID_ARG;
+
+    BoxTransform tf = imgproc_letterbox_fit(w, h, dst_w, dst_h);
+    if (out_tf) *out_tf = tf;
+
+    if (!grow((void**)&s->gray, &s->gray_cap, (size_t)w * h, 1) ||
+        !grow((void**)&s->resized, &s->resized_cap, (size_t)tf.content_w * tf.content_h, 1))
+        return ONNX_ERR_MEMORY;
+
+    imgproc_to_gray(src, fmt, w, h, stride, bottom_up, s->gray);
+    if (imgproc_resize_gray(s, s->gray, w, h, s->resized, tf.content_w, tf.content_h, 0, mode) != 0)
+        return ONNX_ERR_MEMORY;
+
+    const size_t plane = (size_t)dst_w * dst_h;
+    float* c0 = dst_chw;
+    float* c1 = dst_chw + plane;
+    float* c2 = dst_chw + 2 * plane;
+
+    /* pad bands only; content rows are written below */
+    for (int y = 0; y < dst_h; ++y) {
+        size_t row = (size_t)y * dst_w;
+        if (y < tf.content_y || y >= tf.content_y + tf.content_h) {
+            fill_f32(c0 + row, (size_t)dst_w, pad_value);
+            fill_f32(c1 + row, (size_t)dst_w, pad_value);
+            fill_f32(c2 + row, (size_t)dst_w, pad_value);
+            continue;
+        }
+        size_t l = (size_t)tf.content_x, r = (size_t)(dst_w - tf.content_x - tf.content_w);
+        fill_f32(c0 + row, l, pad_value); fill_f32(c0 + row + l + tf.content_w, r, pad_value);
+        fill_f32(c1 + row, l, pad_value); fill_f32(c1 + row + l + tf.content_w, r, pad_value);
+        fill_f32(c2 + row, l, pad_value); fill_f32(c2 + row + l + tf.content_w, r, pad_value);
+        imgproc_gray_to_chw3(s->resized + (size_t)(y - tf.content_y) * tf.content_w, tf.content_w,
+                             c0 + row + l, c1 + row + l, c2 + row + l);
+    }
+    return ONNX_OK;
+}
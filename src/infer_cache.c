@@ -0,0 +1,235 @@
+#define _POSIX_C_SOURCE 200809L
+#include "infer_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* ---------------- File layout ---------------- */
+
+#define CACHE_MAGIC   0x31484341434E4649ull  /* "IFNCACH1" */
+#define CACHE_VERSION 1u
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t slot_count;     /* power of two */
+    uint64_t model_tag;
+    uint64_t arena_floats;   /* capacity */
+    uint64_t arena_used;
+    uint64_t entries;
+} CacheHeader;
+
+typedef struct {
+    uint64_t key;            /* 0 = empty */
+    uint64_t offset;         /* in floats, into the arena */
+    uint32_t rows, cols;
+} CacheSlot;
+
+static size_t cache_file_size(uint32_t slots, uint64_t arena_floats) {
+    return sizeof(CacheHeader) + sizeof(CacheSlot) * (size_t)slots + sizeof(float) * (size_t)arena_floats;
+}
+
+/* ---------------- Hash ---------------- */
+
+#define P1 11400714785074694791ull
+#define P2 14029467366897019727ull
+#define P3  1609587929392839161ull
+#define P4  9650029242287828579ull
+#define P5  2870177450012600261ull
+
+static inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+static inline uint64_t read64(const uint8_t* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline uint64_t round64(uint64_t acc, uint64_t v) { return rotl64(acc + v * P2, 31) * P1; }
+static inline uint64_t merge64(uint64_t acc, uint64_t v) { return (acc ^ round64(0, v)) * P1 + P4; }
+
+uint64_t infer_cache_hash(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    const uint8_t* end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        uint64_t v1 = P1 + P2, v2 = P2, v3 = 0, v4 = 0 - P1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = merge64(h, v1); h = merge64(h, v2); h = merge64(h, v3); h = merge64(h, v4);
+    } else {
+        h = P5;
+    }
+    h += (uint64_t)len;
+
+    for (; p + 8 <= end; p += 8) h = rotl64(h ^ round64(0, read64(p)), 27) * P1 + P4;
+    for (; p < end; ++p)         h = rotl64(h ^ (*p * P5), 11) * P1;
+
+    h ^= h >> 33; h *= P2;
+    h ^= h >> 29; h *= P3;
+    h ^= h >> 32;
+    return h ? h : 1;   /* 0 marks an empty slot */
+}
+
+uint64_t infer_cache_file_tag(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    uint64_t tag = 0;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED) {
+            tag = infer_cache_hash(m, (size_t)st.st_size) ^ (uint64_t)st.st_size;
+            munmap(m, (size_t)st.st_size);
+        }
+    }
+    close(fd);
+    return tag;
+}
+
+/* ---------------- Open / close ---------------- */
+
+static void cache_reset(InferCache* c, uint32_t slots, uint64_t tag, uint64_t arena_floats) {
+    CacheHeader* hd = (CacheHeader*)c->header;
+    memset(c->slots, 0, sizeof(CacheSlot) * (size_t)slots);
+    hd->magic = CACHE_MAGIC;
+    hd->version = CACHE_VERSION;
+    hd->slot_count = slots;
+    hd->model_tag = tag;
+    hd->arena_floats = arena_floats;
+    hd->arena_used = 0;
+    hd->entries = 0;
+}
+
+int infer_cache_open(InferCache* c, const char* path, uint64_t model_tag,
+                     uint32_t slot_count, uint64_t arena_floats) {
+    if (!c || !path || slot_count == 0 || arena_floats == 0) return -1;
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+
+    uint32_t slots = 1;
+    while (slots < slot_count) slots <<= 1;
+
+    c->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (c->fd < 0) { perror("[CACHE] open"); return -1; }
+    /* One writer per file: the table is updated in place through the mapping.
+     * Released when fd is closed. */
+    if (flock(c->fd, LOCK_EX | LOCK_NB) != 0) {
+        fprintf(stderr, "[CACHE] %s is in use by another instance; running without cache\n", path);
+        close(c->fd);
+        c->fd = -1;
+        return -1;
+    }
+
+    /* Reuse an existing file's geometry so old entries stay valid */
+    CacheHeader existing;
+    int reuse = 0;
+    struct stat stt;
+    if (fstat(c->fd, &stt) == 0 && (size_t)stt.st_size >= sizeof(existing) &&
+        pread(c->fd, &existing, sizeof(existing), 0) == (ssize_t)sizeof(existing) &&
+        existing.magic == CACHE_MAGIC && existing.version == CACHE_VERSION &&
+        existing.model_tag == model_tag &&
+        (size_t)stt.st_size == cache_file_size(existing.slot_count, existing.arena_floats)) {
+        slots = existing.slot_count;
+        arena_floats = existing.arena_floats;
+        reuse = 1;
+    }
+
+    c->size = cache_file_size(slots, arena_floats);
+    if (!reuse && ftruncate(c->fd, (off_t)c->size) != 0) {
+        perror("[CACHE] ftruncate");
+        close(c->fd);
+        c->fd = -1;
+        return -1;
+    }
+
+    void* m = mmap(NULL, c->size, PROT_READ | PROT_WRITE, MAP_SHARED, c->fd, 0);
+    if (m == MAP_FAILED) {
+        perror("[CACHE] mmap");
+        close(c->fd);
+        c->fd = -1;
+        return -1;
+    }
+    c->base   = (uint8_t*)m;
+    c->header = c->base;
+    c->slots  = c->base + sizeof(CacheHeader);
+    c->arena  = (float*)(c->base + sizeof(CacheHeader) + sizeof(CacheSlot) * (size_t)slots);
+
+    if (!reuse) cache_reset(c, slots, model_tag, arena_floats);
+    fprintf(stderr, "[CACHE] %s: %llu entries, %.1f/%.1f MB used\n", path,
+            (unsigned long long)((CacheHeader*)c->header)->entries,
+            ((CacheHeader*)c->header)->arena_used * 4.0 / 1e6, arena_floats * 4.0 / 1e6);
+    return 0;
+}
+
+void infer_cache_close(InferCache* c) {
+    if (!c) return;
+    if (c->base) {
+        fprintf(stderr, "[CACHE] hits=%llu misses=%llu\n",
+                (unsigned long long)c->hits, (unsigned long long)c->misses);
+        msync(c->base, c->size, MS_ASYNC);
+        munmap(c->base, c->size);
+    }
+    if (c->fd >= 0) close(c->fd);
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+}
+
+/* ---------------- Lookup / store ---------------- */
+
+static CacheSlot* find_slot(InferCache* c, uint64_t key) {
+    CacheHeader* hd = (CacheHeader*)c->header;
+    CacheSlot* slots = (CacheSlot*)c->slots;
+    uint32_t mask = hd->slot_count - 1;
+    for (uint32_t i = 0, s = (uint32_t)key & mask; i <= mask; ++i, s = (s + 1) & mask) {
+        if (slots[s].key == key || slots[s].key == 0) return &slots[s];
+    }
+    return NULL;
+}
+
+int infer_cache_lookup(InferCache* c, uint64_t key,
+                       const float** out, int* rows, int* cols) {
+    if (!c || !c->base) return 0;
+    CacheSlot* s = find_slot(c, key);
+    if (!s || s->key != key) { c->misses++; return 0; }
+    *out  = c->arena + s->offset;
+    *rows = (int)s->rows;
+    *cols = (int)s->cols;
+    c->hits++;
+    return 1;
+}
+
+int infer_cache_store(InferCache* c, uint64_t key,
+                      const float* data, int rows, int cols) {
+    if (!c || !c->base || rows < 0 || cols < 0) return -1;
+    CacheHeader* hd = (CacheHeader*)c->header;
+    uint64_t n = (uint64_t)rows * (uint64_t)cols;
+    CacheSlot* s = find_slot(c, key);
+
+    /* keep the table at most 3/4 full so probes stay short */
+    if (!s || (s->key == 0 && (hd->entries + 1) * 4 > (uint64_t)hd->slot_count * 3) ||
+        hd->arena_used + n > hd->arena_floats) {
+        if (!c->full_warned) {
+            fprintf(stderr, "[CACHE] full; new outputs are no longer stored\n");
+            c->full_warned = 1;
+        }
+        return -1;
+    }
+    if (s->key == key) return 0;
+
+    memcpy(c->arena + hd->arena_used, data, sizeof(float) * (size_t)n);
+    s->offset = hd->arena_used;
+    s->rows = (uint32_t)rows;
+    s->cols = (uint32_t)cols;
+    s->key = key;              /* publish last */
+    hd->arena_used += n;
+    hd->entries++;
+    return 0;
+}
@@ -6,10 +6,33 @@
 #include "skybox.h"
 #include "textShowing.h"
 #include "onnx.h"
+#include "skyblob.h"
+#include "infer_cache.h"
+#include "shadow.h"
+#include "imgproc.h"
+#include "headless.h"
+#include "options.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "batch.h"
+#include "video.h"
+#include "dataset.h"
+#include "idpass.h"
+#include "blackbox.h"
+#include "detlog.h"
+#include "eval.h"
+#include "mot.h"
+#include "tracker.h"
+#include "scenario.h"
+#include "trace.h"
+#include "hud.h"
+#include "metrics.h"
 
 #include <time.h>
+#include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <math.h>
 
@@ -18,9 +41,8 @@
 
 /* ---- Runtime / build options ---- */
 #define KEYBOARD_ENABLED 1
-#define USE_VSYNC 1
-#define TARGET_FPS 0.0
 #define MAX_FRAME_DELTA 0.25
+#define MAX_STEPS_PER_FRAME 8      /* fixed-step catch-up limit, per unit of time warp */
 
 /* ---- Window ---- */
 GLFWwindow *window;
@@ -66,6 +88,15 @@ static double g_last_time  = 0.0;
 static double fps_accum    = 0.0;
 static int    fps_frames   = 0;
 
+/* ---- Simulation clock (--fixed-step / --time-warp) ---- */
+static double g_sim_time   = 0.0;              /* simüle edilen saniye (OSD süresi) */
+static double g_sim_accum  = 0.0;              /* fixed-step biriktirici */
+static long   g_sim_capped = 0;                /* adım sınırına takılan kareler */
+static Plane *g_prev_planes;                  /* son adımdan önceki durum */
+static Plane *g_render_backup;                /* interpolasyonlu çizim sırasında gerçek durum */
+static bool   g_use_keyboard   = false;        /* processInput mi, otopilot mu */
+static bool   g_quit_requested = false;        /* ESC (kayıttan da gelebilir) */
+
 vec3 cameraPos, cameraFront, cameraUp, cameraRight;
 bool  isAutopilotOn   = true;
 float offset_behind   = 400.0f;
@@ -83,20 +114,45 @@ static GLuint box_vbo = 0;
 static GLuint box_shader_program = 0;
 
 /* ---- ONNX detector ---- */
-#define DETECTION_MODEL_PATH "./models/yolov8n_448.onnx"
+#define DETECTION_MODEL_PATH      "./models/yolov8n_448.onnx"
+/* tools/fuse_preprocess.py çıktısı; varsa RGBA buffer doğrudan modele gider */
+#define DETECTION_MODEL_PATH_RGBA "./models/yolov8n_448_rgba.onnx"
 static OnnxDetector g_detector;
 static int          g_detector_ready = 0;
 static float        g_thresh = 0.6f;
 static float        g_nms    = 0.45f;
 static double       g_last_det_ms = 0.0;
 
+/* ---- Tracker for --detlog IDs and --mot scoring ---- */
+static Tracker      g_det_tracker;
+static int          g_det_tracker_ready = 0;
+static long         g_frame_index = 0;
+
+/* ---- Inference memoization (DET_INFER_CACHE=<file>) ---- */
+#define INFER_CACHE_SLOTS  (1u << 20)
+#define INFER_CACHE_FLOATS (64ull << 20)   /* 256 MB of raw outputs */
+static InferCache   g_infer_cache;
+static int          g_infer_cache_ready = 0;
+
+/* ---- Sky-blob fallback (no model) ---- */
+static SkyBlobDetector g_skyblob;
+static int             g_skyblob_ready = 0;
+
 /* ---- Detector readback buffers ---- */
 static unsigned char *g_rgba_buffer = NULL;
 static size_t         g_frame_buf_capacity = 0;
 
+/* ---- Ground truth per detection frame (sized to plane_count) ---- */
+static OnnxDet *g_gt       = NULL;
+static int     *g_gt_plane = NULL;
+static float   *g_gt_range = NULL;
+
 /* ---- 448x448 detector FBO (letterboxed) ---- */
 #define DET_W 448
 #define DET_H 448
+static int    g_det_w         = DET_W;         /* model input / --det-size */
+static int    g_det_h         = DET_H;
+static const char *g_model_path = NULL;        /* loaded model (eval report) */
 static GLuint g_det_fbo       = 0;
 static GLuint g_det_color_tex = 0;
 static GLuint g_det_depth_rbo = 0;
@@ -124,6 +180,11 @@ static double get_current_time_millis(void) {
     clock_gettime(CLOCK_MONOTONIC, &now);
     return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1e6;
 }
+static double get_thread_cpu_millis(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1e6;
+}
 static long get_current_time_millis2(void) {
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
@@ -131,7 +192,7 @@ static long get_current_time_millis2(void) {
 }
 
 static void update_system(double dt) {
-    double elapsedTime = g_last_time - g_start_time;
+    double elapsedTime = g_sim_time;
 
     if (!isCrashed && automaticCameraMovement) {
         vec3 move_vector;
@@ -140,8 +201,12 @@ static void update_system(double dt) {
         planes[0].position[1] -= gravitySpeed * (float)dt;
     }
 
-    for (int i = 1; i < MAX_PLANES; i++)
-        update_enemy_plane(&planes[i]);
+    if (scenario_active()) {
+        scenario_step(g_sim_time, (float)dt);
+    } else {
+        for (int i = 1; i < plane_count; i++)
+            update_enemy_plane(&planes[i]);
+    }
 
     if (!isCrashed) {
         if (dt > 0.0)
@@ -190,8 +255,11 @@ static void update_system(double dt) {
         }
         update_crash_text();
     }
+}
 
-    fps_accum  += dt;
+/* FPS metni duvar saatiyle ölçülür (simülasyon adımlarından bağımsız) */
+static void update_fps_counter(double frame_dt) {
+    fps_accum  += frame_dt;
     fps_frames += 1;
     if (fps_accum >= 0.25) {
         float fps = (float)(fps_frames / fps_accum);
@@ -201,6 +269,170 @@ static void update_system(double dt) {
     }
 }
 
+/* One simulation tick: input (or autopilot) + physics */
+static void sim_step(double dt) {
+    deltaTime = (float)dt;
+    trace_begin("sim_step");
+
+    if (g_use_keyboard) {
+        processInput();
+    } else {
+        if (startingAutoPilotMode) {
+            currentMovementSpeed = 650.0f;
+            startingAutoPilotMode = false;
+        }
+        autoPilotMode();
+    }
+
+    trace_begin("update_system");
+    update_system(dt);
+    trace_end();
+    g_sim_time += dt;
+    trace_end();
+}
+
+static void nlerp_vec3(const vec3 a, const vec3 b, float t, vec3 out) {
+    glm_vec3_lerp((float *)a, (float *)b, t, out);
+    glm_vec3_normalize(out);
+}
+
+/* Çizim için son iki adım arasını harmanla; gerçek durum yedeklenir */
+static void apply_interpolated_planes(float alpha) {
+    memcpy(g_render_backup, planes, sizeof(Plane) * (size_t)plane_count);
+    for (int i = 0; i < plane_count; i++) {
+        glm_vec3_lerp(g_prev_planes[i].position, planes[i].position, alpha, planes[i].position);
+        nlerp_vec3(g_prev_planes[i].front, g_render_backup[i].front, alpha, planes[i].front);
+        nlerp_vec3(g_prev_planes[i].up,    g_render_backup[i].up,    alpha, planes[i].up);
+        nlerp_vec3(g_prev_planes[i].right, g_render_backup[i].right, alpha, planes[i].right);
+        if (i > 0) update_enemy_model_matrix(&planes[i]);
+    }
+}
+
+static void restore_planes(void) {
+    memcpy(planes, g_render_backup, sizeof(Plane) * (size_t)plane_count);
+}
+
+/* ---- Snapshots ---- */
+static void capture_sim_state(SimState *st, long frame) {
+    memset(st, 0, sizeof(*st));
+    memcpy(st->planes, planes, sizeof(st->planes));
+
+    st->offset_behind = offset_behind;
+    st->offset_above  = offset_above;
+    st->offset_right  = offset_right;
+    glm_vec3_copy(cameraPos,   st->cameraPos);
+    glm_vec3_copy(cameraFront, st->cameraFront);
+    glm_vec3_copy(cameraUp,    st->cameraUp);
+    glm_vec3_copy(cameraRight, st->cameraRight);
+    st->fov = fov;
+
+    st->cmd_index = autopilot_command_index();
+    st->cmd_timer = autopilot_command_timer();
+    st->currentMovementSpeed = currentMovementSpeed;
+    st->fixedValue    = fixedValue;
+    st->gravitySpeed  = gravitySpeed;
+    st->verticalSpeed = verticalSpeed;
+    st->lastAltitude  = lastAltitude;
+    st->isAutopilotOn = isAutopilotOn;
+    st->startingAutoPilotMode   = startingAutoPilotMode;
+    st->isSpeedFixed            = isSpeedFixed;
+    st->automaticCameraMovement = automaticCameraMovement;
+
+    st->isCrashed       = isCrashed;
+    st->hasSetCrashView = hasSetCrashView;
+    glm_vec3_copy(crashPosition, st->crashPosition);
+
+    st->sim_time  = g_sim_time;
+    st->sim_accum = g_sim_accum;
+    st->frame     = frame;
+    get_chunk_residency(st->chunks);
+}
+
+static void apply_sim_state(const SimState *st) {
+    memcpy(planes, st->planes, sizeof(st->planes));
+    memcpy(g_prev_planes, planes, sizeof(Plane) * (size_t)plane_count);
+
+    offset_behind = st->offset_behind;
+    offset_above  = st->offset_above;
+    offset_right  = st->offset_right;
+    glm_vec3_copy((float *)st->cameraPos,   cameraPos);
+    glm_vec3_copy((float *)st->cameraFront, cameraFront);
+    glm_vec3_copy((float *)st->cameraUp,    cameraUp);
+    glm_vec3_copy((float *)st->cameraRight, cameraRight);
+    fov = st->fov;
+
+    autopilot_set_state(st->cmd_index, st->cmd_timer);
+    currentMovementSpeed = st->currentMovementSpeed;
+    fixedValue    = st->fixedValue;
+    gravitySpeed  = st->gravitySpeed;
+    verticalSpeed = st->verticalSpeed;
+    lastAltitude  = st->lastAltitude;
+    isAutopilotOn = st->isAutopilotOn;
+    startingAutoPilotMode   = st->startingAutoPilotMode;
+    isSpeedFixed            = st->isSpeedFixed;
+    automaticCameraMovement = st->automaticCameraMovement;
+
+    isCrashed       = st->isCrashed;
+    hasSetCrashView = st->hasSetCrashView;
+    glm_vec3_copy((float *)st->crashPosition, crashPosition);
+
+    g_sim_time  = st->sim_time;
+    g_sim_accum = st->sim_accum;
+    set_chunk_residency(st->chunks);
+}
+
+/* ---- Seeded start (--seed): dataset shards see different flights ---- */
+static uint64_t g_seed_state;
+
+static double seed_uniform(double lo, double hi) {
+    /* splitmix64: platform-independent, no global rand() state */
+    uint64_t z = (g_seed_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return lo + (hi - lo) * (double)(z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* relocate: also move/turn the player (skipped when a snapshot set the start) */
+static void apply_seed(uint64_t seed, bool relocate) {
+    g_seed_state = seed;
+    vec3 up = {0.0f, 1.0f, 0.0f};
+    float yaw = relocate ? (float)seed_uniform(-GLM_PI, GLM_PI) : 0.0f;
+
+    vec3 origin;
+    glm_vec3_copy(planes[0].position, origin);
+    if (relocate) {
+        planes[0].position[0] += (float)seed_uniform(-20000.0, 20000.0);
+        planes[0].position[2] += (float)seed_uniform(-20000.0, 20000.0);
+        planes[0].position[1] = get_terrain_height(planes[0].position[0], planes[0].position[2])
+                              + (float)seed_uniform(400.0, 1000.0);
+        glm_vec3_rotate(planes[0].front, yaw, up);
+        glm_vec3_rotate(planes[0].right, yaw, up);
+        lastAltitude = planes[0].position[1];
+    }
+
+    /* Enemies keep their formation around the player, jittered */
+    for (int i = 1; i < plane_count; ++i) {
+        vec3 rel;
+        glm_vec3_sub(planes[i].position, origin, rel);
+        rel[0] += (float)seed_uniform(-300.0, 300.0);
+        rel[1] += (float)seed_uniform(-150.0, 150.0);
+        rel[2] += (float)seed_uniform(-800.0, 400.0);
+        glm_vec3_rotate(rel, yaw, up);
+        glm_vec3_add(planes[0].position, rel, planes[i].position);
+        planes[i].speed *= (float)seed_uniform(0.8, 1.2);
+    }
+
+    autopilot_set_state((int)seed_uniform(0.0, (double)autopilot_command_count()), 0.0f);
+    memcpy(g_prev_planes, planes, sizeof(Plane) * (size_t)plane_count);
+}
+
+static void save_snapshot(long frame) {
+    SimState st;
+    capture_sim_state(&st, frame);
+    snapshot_save(g_opts.snapshot_save, &st);
+}
+
 /* 608x608 içine, ekranın aspect'ini koruyan letterbox viewport */
 static inline ViewRect det_letterbox_rect(int target, float aspect) {
     ViewRect r;
@@ -236,33 +468,6 @@ static inline void class_to_color(int cls, float *r, float *g, float *b) {
     }
 }
 
-static inline void rgba_flip_gray3_chw_norm(
-    const unsigned char* src,
-    float* dst,
-    int W, int H
-) {
-    const float inv255 = 1.0f / 255.0f;
-    size_t stride_ch = (size_t)W * (size_t)H;
-
-    for (int y = 0; y < H; ++y) {
-        int sy = H - 1 - y;
-        for (int x = 0; x < W; ++x) {
-            const unsigned char* p = src + ((size_t)sy * (size_t)W + (size_t)x) * 4;
-
-            float r = p[0] * inv255;
-            float g = p[1] * inv255;
-            float b = p[2] * inv255;
-
-            float yval = 0.299f * r + 0.587f * g + 0.114f * b;
-
-            size_t idx = (size_t)y * (size_t)W + (size_t)x;
-            dst[0 * stride_ch + idx] = yval;
-            dst[1 * stride_ch + idx] = yval;
-            dst[2 * stride_ch + idx] = yval;
-        }
-    }
-}
-
 /* Minimal shader util */
 GLuint compileShader(const char *source, GLenum type) {
     GLuint shader = glCreateShader(type);
@@ -307,7 +512,7 @@ GLuint createShaderProgram(const char *vs, const char *fs) {
 }
 
 /* 2D red box overlay (NDC) */
-static void init_box_drawing(void) {
+void init_box_drawing(void) {
     const char *vs =
         "attribute vec2 position;\n"
         "void main(){ gl_Position = vec4(position,0.0,1.0); }\n";
@@ -323,9 +528,9 @@ static void init_box_drawing(void) {
     glBufferData(GL_ARRAY_BUFFER, 48 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
-static void drawBoundingBoxColored(int L, int T, int R, int B,
-                                   float thickness_px,
-                                   float r, float g, float b, float a) {
+void drawBoundingBoxColored(int L, int T, int R, int B,
+                            float thickness_px,
+                            float r, float g, float b, float a) {
     // Ekran -> NDC
     float nl = 2.0f * L / SCR_WIDTH  - 1.0f;
     float nr = 2.0f * R / SCR_WIDTH  - 1.0f;
@@ -375,6 +580,11 @@ static void drawBoundingBoxColored(int L, int T, int R, int B,
 
 
 /* 608x608 RGB FBO for detector */
+/* "Ekran": pencerede 0, headless modda EGL tarafının FBO'su */
+static GLuint app_default_fbo(void) {
+    return g_opts.headless ? headless_default_fbo() : 0;
+}
+
 bool init_detection_fbo(void) {
     glGenFramebuffers(1, &g_det_fbo);
     glBindFramebuffer(GL_FRAMEBUFFER, g_det_fbo);
@@ -386,16 +596,16 @@ bool init_detection_fbo(void) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     /* store as RGBA8888; we’ll drop alpha after readback */
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, DET_W, DET_H, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, g_det_w, g_det_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_det_color_tex, 0);
 
     glGenRenderbuffers(1, &g_det_depth_rbo);
     glBindRenderbuffer(GL_RENDERBUFFER, g_det_depth_rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, DET_W, DET_H);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, g_det_w, g_det_h);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, g_det_depth_rbo);
 
     GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, app_default_fbo());
     return status == GL_FRAMEBUFFER_COMPLETE;
 }
 
@@ -403,20 +613,20 @@ bool init_detection_fbo(void) {
 static void render_for_detection(ViewRect vp, mat4 det_view, mat4 det_proj) {
     glDisable(GL_SCISSOR_TEST);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glViewport(0, 0, DET_W, DET_H);
+    glViewport(0, 0, g_det_w, g_det_h);
     glEnable(GL_DEPTH_TEST);
     glClearColor(0,0,0,1);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     glViewport(vp.x, vp.y, vp.w, vp.h);
     draw_skybox(det_view, det_proj);
-    for (int i = 0; i < MAX_PLANES; ++i)
+    for (int i = 0; i < plane_count; ++i)
         draw_plane(&planes[i], det_view, det_proj);
 }
 
 /* ---- App ---- */
-int main(void) {
-    if (!glfwInit()) { fprintf(stderr, "Failed to initialize GLFW\n"); return -1; }
+static bool init_window(void) {
+    if (!glfwInit()) { fprintf(stderr, "Failed to initialize GLFW\n"); return false; }
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
@@ -424,30 +634,180 @@ int main(void) {
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
 
     window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Height Map Terrain Flight", NULL, NULL);
-    if (!window) { fprintf(stderr, "Failed to create GLFW window\n"); glfwTerminate(); return -1; }
+    if (!window) { fprintf(stderr, "Failed to create GLFW window\n"); glfwTerminate(); return false; }
     glfwMakeContextCurrent(window);
-#if USE_VSYNC
-    glfwSwapInterval(1);
-#else
-    glfwSwapInterval(0);
-#endif
+    glfwSwapInterval(g_opts.vsync ? 1 : 0);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    return true;
+}
+
+/* GL uzantı giriş noktaları: pencere GLFW'den, headless EGL'den */
+static void *gl_get_proc(const char *name) {
+    return g_opts.headless ? headless_get_proc(name) : (void *)glfwGetProcAddress(name);
+}
+
+static bool app_should_close(long frames) {
+    if (g_quit_requested) return true;
+    if (g_opts.max_frames > 0 && frames >= g_opts.max_frames) return true;
+    return g_opts.headless ? false : glfwWindowShouldClose(window);
+}
+
+/* Per-plane buffers, once the scenario has fixed plane_count */
+static bool alloc_plane_buffers(void) {
+    size_t n = (size_t)plane_count;
+    g_prev_planes   = calloc(n, sizeof(Plane));
+    g_render_backup = calloc(n, sizeof(Plane));
+    g_gt            = calloc(n, sizeof(OnnxDet));
+    g_gt_plane      = calloc(n, sizeof(int));
+    g_gt_range      = calloc(n, sizeof(float));
+    if (g_prev_planes && g_render_backup && g_gt && g_gt_plane && g_gt_range) return true;
+    fprintf(stderr, "[SIM] out of memory for %d planes\n", plane_count);
+    return false;
+}
+
+static void free_plane_buffers(void) {
+    free(g_prev_planes);   g_prev_planes = NULL;
+    free(g_render_backup); g_render_backup = NULL;
+    free(g_gt);            g_gt = NULL;
+    free(g_gt_plane);      g_gt_plane = NULL;
+    free(g_gt_range);      g_gt_range = NULL;
+}
+
+int main(int argc, char **argv) {
+    default_options(&g_opts);
+    int exit_code = 0;
+    if (!parse_options(argc, argv, &g_opts, &exit_code)) return exit_code;
+
+    /* Katmanlar: varsayılanlar < makine profili < senaryo "args" < komut satırı */
+    const char *profile = g_opts.profile_path;
+    if (!profile && access(TUNE_PROFILE_DEFAULT, R_OK) == 0) profile = TUNE_PROFILE_DEFAULT;
+    if (profile && !strcmp(profile, "none")) profile = NULL;
+    const char *scenario = g_opts.scenario_path;
+    if (scenario && !scenario_load(scenario)) return 2;
+    if (profile || scenario) {
+        default_options(&g_opts);
+        if (profile && !load_profile(profile, &g_opts, &exit_code)) return exit_code;
+        if (scenario) {
+            char **sargv;
+            int sargc = scenario_args(&sargv);
+            if (!parse_options(sargc, sargv, &g_opts, &exit_code)) return exit_code ? exit_code : 2;
+        }
+        if (!parse_options(argc, argv, &g_opts, &exit_code)) return exit_code;
+        g_opts.scenario_path = scenario;
+    }
+    if ((g_opts.scenario_path || g_opts.aircraft > 0) && (g_opts.snapshot_load || g_opts.snapshot_save)) {
+        fprintf(stderr, "[SCENARIO] snapshots hold the stock %d planes; not available with a scenario\n",
+                MAX_PLANES);
+        return 2;
+    }
+
+    if (g_opts.batch_input) {
+        /* Çevrimdışı: GL/pencere açılmaz, float model tercih edilir */
+        BatchConfig bc = batch_default_config();
+        bc.input = g_opts.batch_input;
+        bc.out_path = g_opts.batch_out;
+        bc.threads = g_opts.threads;
+        bc.det_w = bc.det_h = g_opts.det_size;   /* 0: modelin giriş boyutu */
+        bc.score_thresh = g_thresh;
+        bc.nms_iou = g_nms;
+        bc.model_path = g_opts.model_path ? (strcmp(g_opts.model_path, "none") ? g_opts.model_path : NULL)
+                      : access(DETECTION_MODEL_PATH, R_OK) == 0 ? DETECTION_MODEL_PATH
+                                                                : DETECTION_MODEL_PATH_RGBA;
+        bc.detlog_path = g_opts.detlog_path;
+        return batch_run(&bc);
+    }
+
+    if (g_opts.headless) {
+        /* Pencere yok: EGL pbuffer / surfaceless, vsync ve FPS sınırı yok */
+        if (!headless_init(SCR_WIDTH, SCR_HEIGHT)) return -1;
+        printf("[HEADLESS] %dx%d, renderer: %s\n", SCR_WIDTH, SCR_HEIGHT, headless_renderer());
+    } else if (!init_window()) {
+        return -1;
+    }
+
+    /* İz, ONNX oturumundan önce açılır: ORT profili de aynı zaman ekseninde kalır */
+    if (g_opts.trace_path) {
+        if (!trace_open(g_opts.trace_path)) return -1;
+        trace_gpu_init(gl_get_proc);
+    }
+
+    if ((g_opts.scenario_path || g_opts.aircraft > 0) && !scenario_apply(g_opts.aircraft)) return -1;
+    if (!alloc_plane_buffers()) return -1;
 
     INIT_SYSTEM();
     init_box_drawing();
+    {
+        /* Kare bütçesi: vsync 60 Hz, yoksa hedef FPS; headless'ta yok */
+        double budget_ms = g_opts.headless ? 0.0 : g_opts.vsync ? 1000.0 / 60.0
+                         : g_opts.target_fps > 0.0 ? 1000.0 / g_opts.target_fps : 0.0;
+        if (!hud_init(g_opts.hud, budget_ms)) fprintf(stderr, "[HUD] not available\n");
+        if (g_opts.metrics_target && !metrics_open(g_opts.metrics_target, g_opts.metrics_interval, budget_ms))
+            return -1;
+    }
 
     /* ONNX */
     {
         OnnxConfig cfg = onnx_default_config();
         cfg.verbose = 1;
-        cfg.score_thresh = g_thresh;
+        /* --eval: AP tüm PR eğrisini ister; g_thresh çizim/izleme için sonra uygulanır */
+        cfg.score_thresh = g_opts.eval_path ? EVAL_SCORE_FLOOR : g_thresh;
         cfg.nms_iou_thresh = g_nms;
-        if (onnx_load_model(&g_detector, DETECTION_MODEL_PATH, &cfg) == ONNX_OK) {
+        if (g_opts.intra_threads > 0) cfg.intra_threads = g_opts.intra_threads;
+        if (g_opts.inter_threads > 0) cfg.inter_threads = g_opts.inter_threads;
+        static char ort_prefix[512];   /* g_detector.cfg keeps the pointer until onnx_destroy */
+        if (trace_active()) {
+            snprintf(ort_prefix, sizeof(ort_prefix), "%s.ort", g_opts.trace_path);
+            cfg.profile_prefix = ort_prefix;
+        }
+        const char *model_path = DETECTION_MODEL_PATH;
+        if (access(DETECTION_MODEL_PATH_RGBA, R_OK) == 0)
+            model_path = DETECTION_MODEL_PATH_RGBA;
+        if (g_opts.model_path) model_path = strcmp(g_opts.model_path, "none") ? g_opts.model_path : NULL;
+        if (g_opts.det_size) g_det_w = g_det_h = g_opts.det_size;
+        if (model_path && onnx_load_model(&g_detector, model_path, &cfg) == ONNX_OK) {
             g_detector_ready = 1;
-            printf("[ONNX] Model yüklendi: %s\n", DETECTION_MODEL_PATH);
-        } else {
-            fprintf(stderr, "[ONNX] Model yükleme başarısız (%s)\n", DETECTION_MODEL_PATH);
+            g_model_path = model_path;
+            printf("[ONNX] Model yüklendi: %s%s (%d/%d threads)\n", model_path,
+                   g_detector.in_u8 ? " (RGBA girişli)" : "", cfg.intra_threads, cfg.inter_threads);
+
+            /* Sabit girişli modelde dedektör boyutu modelden gelir */
+            if (g_detector.in_w > 0 && g_detector.in_h > 0) {
+                if (g_opts.det_size && (g_opts.det_size != g_detector.in_w || g_opts.det_size != g_detector.in_h)) {
+                    fprintf(stderr, "[ONNX] %s takes %lldx%lld input, --det-size %d does not fit\n", model_path,
+                            (long long)g_detector.in_w, (long long)g_detector.in_h, g_opts.det_size);
+                    return 2;
+                }
+                g_det_w = (int)g_detector.in_w;
+                g_det_h = (int)g_detector.in_h;
+            }
+
+            /* Tekrar oynatmalarda aynı girdiler için ham çıktıları sakla */
+            const char *cache_path = g_opts.infer_cache;
+            if (cache_path && *cache_path) {
+                uint64_t tag = infer_cache_file_tag(model_path) ^ (uint64_t)g_detector.in_u8;
+                if (infer_cache_open(&g_infer_cache, cache_path, tag,
+                                     INFER_CACHE_SLOTS, INFER_CACHE_FLOATS) == 0) {
+                    g_infer_cache_ready = 1;
+                    g_detector.cache = &g_infer_cache;
+                }
+            }
+        } else if (model_path) {
+            fprintf(stderr, "[ONNX] Model yükleme başarısız (%s)\n", model_path);
+            if (g_opts.model_path) return 2;   /* açıkça istenen model: sessizce düşme */
+        }
+    }
+
+    /* Shadow mode: aday modeli üretim sonuçlarıyla arka planda karşılaştır */
+    {
+        const char *shadow_path = g_opts.shadow_model;
+        if (shadow_path && *shadow_path) {
+            ShadowConfig scfg = shadow_default_config();
+            scfg.sample_every = g_opts.shadow_sample;
+            scfg.score_thresh = g_thresh;
+            scfg.frame_w = g_det_w;
+            scfg.frame_h = g_det_h;
+            shadow_start(shadow_path, &scfg);
         }
     }
 
@@ -455,37 +815,192 @@ int main(void) {
     if (!init_detection_fbo())
         fprintf(stderr, "[DET-FBO] init failed; default framebuffer fallback will be used.\n");
 
+    /* Sky-blob detector: fallback when the model is missing */
+    if (skyblob_init(&g_skyblob, g_det_w, g_det_h, NULL) == ONNX_OK) {
+        g_skyblob_ready = 1;
+        if (!g_detector_ready) printf("[BLOB] Model yok, sky-blob detector kullanılacak\n");
+    }
+
     g_last_time  = get_current_time_seconds();
     g_start_time = g_last_time;
+    long frames = 0;
+    memcpy(g_prev_planes, planes, sizeof(Plane) * (size_t)plane_count);
+
+    /* Snapshot: senaryoyu baştan uçmak yerine kaydedilmiş durumdan başla */
+    if (g_opts.snapshot_load) {
+        SimState st;
+        double t0 = get_current_time_millis();
+        if (!snapshot_load(g_opts.snapshot_load, &st)) return -1;
+        apply_sim_state(&st);
+        printf("[SNAPSHOT] loaded %s (frame %lld, t=%.2fs) in %.3f ms\n", g_opts.snapshot_load,
+               (long long)st.frame, st.sim_time, get_current_time_millis() - t0);
+    }
+    /* Kayıt / tekrar oynatma: kayıttaki saat, tohum ve tuşlar aynı simülasyonu sürer */
+    g_use_keyboard = KEYBOARD_ENABLED && !g_opts.headless;
+    if (g_opts.replay_path) {
+        ReplayInfo info;
+        if (!replay_open(g_opts.replay_path, &info)) return -1;
+        g_use_keyboard    = info.keyboard;
+        g_opts.fixed_hz   = info.fixed_hz;
+        g_opts.time_warp  = info.time_warp;
+        if (g_opts.seed && g_opts.seed != info.seed)
+            printf("[REPLAY] --seed %llu ignored, the recording used %llu\n", g_opts.seed,
+                   (unsigned long long)info.seed);
+        g_opts.seed = info.seed;
+        if ((uint64_t)g_opts.replay_from >= replay_frame_count()) {
+            fprintf(stderr, "[REPLAY] --replay-from %ld: the recording has %llu frames\n", g_opts.replay_from,
+                    (unsigned long long)replay_frame_count());
+            return -1;
+        }
+    } else if (g_opts.replay_from) {
+        fprintf(stderr, "--replay-from needs --replay\n");
+        return -1;
+    } else if (g_opts.record_path) {
+        ReplayInfo info = { g_use_keyboard, g_opts.fixed_hz, g_opts.time_warp, g_opts.seed };
+        if (!replay_record_start(g_opts.record_path, &info)) return -1;
+    }
+    if (g_opts.seed) {
+        apply_seed(g_opts.seed, !g_opts.snapshot_load);
+        printf("[SIM] seed %llu\n", (unsigned long long)g_opts.seed);
+    }
+    if (g_opts.fixed_hz > 0.0)
+        printf("[SIM] fixed step %.1f Hz, time warp x%.2f%s\n", g_opts.fixed_hz, g_opts.time_warp,
+               g_opts.headless ? " (virtual clock)" : "");
+
+    if (g_opts.dataset_dir &&
+        !dataset_open(g_opts.dataset_dir, g_opts.dataset_format, g_opts.threads))
+        return -1;
+    if (g_opts.eval_path) {
+        const char *det_name = g_detector_ready ? g_model_path : g_skyblob_ready ? "skyblob" : "none";
+        if (!eval_open(g_opts.eval_path, det_name, g_det_w, g_det_h, g_opts.detect_every,
+                       g_detector_ready ? g_thresh : 0.0f))
+            return -1;
+    }
+    if ((g_opts.dataset_dir || g_opts.eval_path || g_opts.mot_path) && !idpass_init(g_det_w, g_det_h))
+        printf("[DATASET] ID pass unavailable, labels from projected mesh bounds\n");
+    /* Video: sanal saatte kare aralığı warp/HZ sim-saniyedir; gerçek hızda oynasın.
+     * Pencere modunda halka dolarsa kare atlanır, çevrimdışı koşular bekler */
+    if (g_opts.video_path) {
+        double video_fps = 60.0;
+        if (g_opts.fixed_hz > 0.0 && g_opts.headless) video_fps = g_opts.fixed_hz / g_opts.time_warp;
+        else if (!g_opts.vsync && g_opts.target_fps > 0.0) video_fps = g_opts.target_fps;
+        if (!video_open(g_opts.video_path, SCR_WIDTH, SCR_HEIGHT, video_fps,
+                        g_opts.headless || replay_active(), g_opts.video_downscale))
+            return -1;
+    }
+    if (g_opts.detlog_path && !detlog_open(g_opts.detlog_path)) return -1;
+    if (g_opts.mot_path && !mot_open(g_opts.mot_path, g_opts.track_every)) return -1;
+    if (detlog_active() || mot_active()) {
+        tracker_init(&g_det_tracker, NULL);
+        g_det_tracker_ready = 1;
+    }
+    if (g_opts.blackbox_dir &&
+        !blackbox_open(g_opts.blackbox_dir, g_opts.blackbox_seconds, g_opts.blackbox_spike_ms))
+        return -1;
 
-    while (!glfwWindowShouldClose(window)) {
+    while (!app_should_close(frames)) {
+        g_frame_index = frames;
         double now = get_current_time_seconds();
         double dt  = now - g_last_time;
+        if (frames > g_opts.replay_from) {
+            hud_frame(dt * 1000.0);
+            metrics_frame(dt * 1000.0);
+        }
         if (dt > MAX_FRAME_DELTA) dt = MAX_FRAME_DELTA;
         g_last_time = now;
-        deltaTime = (float)dt;
-
-        if (KEYBOARD_ENABLED) {
-            processInput();
+        update_fps_counter(dt);
+
+        /* Bu karenin simülasyon saatine girdisi (warp öncesi).
+         * Headless + sabit adımda saat sanaldır: kare başına bir adım * warp,
+         * böylece iki koşu aynı kareleri üretir ve gerçek zamandan hızlı akar. */
+        double sim_dt = (g_opts.fixed_hz > 0.0 && g_opts.headless) ? 1.0 / g_opts.fixed_hz : dt;
+        ReplayFrame rf;
+        if (replay_active()) {
+            if (!replay_next(&rf)) break;
+            sim_dt = rf.dt;
+            input_set_keys(rf.keys);
         } else {
-            if (startingAutoPilotMode) {
-                currentMovementSpeed = 650.0f;
-                startingAutoPilotMode = false;
+            input_set_keys(input_poll_keys(window));
+        }
+
+        float alpha = 1.0f;
+        if (g_opts.fixed_hz > 0.0) {
+            /* Sabit adım: simülasyon sadece 1/HZ adımlarla ilerler */
+            const double step = 1.0 / g_opts.fixed_hz;
+            /* Yavaş karelerde adımlar birikip bir sonraki kareyi daha da yavaşlatmasın:
+             * sınıra gelince kalan süre atılır (sim gerçek zamanın gerisine düşer).
+             * Sanal saatte kare başına adım = warp, sınıra hiç ulaşmaz. */
+            const int max_steps = MAX_STEPS_PER_FRAME * (int)ceil(g_opts.time_warp);
+            int steps = 0;
+            g_sim_accum += sim_dt * g_opts.time_warp;
+            while (g_sim_accum >= step) {
+                if (steps == max_steps) {
+                    g_sim_accum = 0.0;
+                    g_sim_capped++;
+                    break;
+                }
+                memcpy(g_prev_planes, planes, sizeof(Plane) * (size_t)plane_count);
+                sim_step(step);
+                g_sim_accum -= step;
+                steps++;
             }
-            autoPilotMode();
+            alpha = (float)(g_sim_accum / step);
+        } else {
+            sim_step(sim_dt * g_opts.time_warp);
         }
 
-        update_system(dt);
+        if (replay_active()) {
+            replay_check(&rf, autopilot_command_index(), autopilot_command_timer());
+        } else if (replay_recording()) {
+            ReplayFrame out = { sim_dt, input_keys(), autopilot_command_index(), autopilot_command_timer() };
+            replay_record_frame(&out);
+        }
+        if (g_opts.snapshot_save && g_opts.snapshot_at > 0 && frames + 1 == g_opts.snapshot_at)
+            save_snapshot(frames + 1);
+        /* --replay-from: durum ancak adım adım kurulur; bu kareler çizilmez */
+        if (replay_active() && replay_position() <= (uint64_t)g_opts.replay_from) {
+            frames++;
+            continue;
+        }
+
+        /* Render interpolation: çizilen durum bir adım geriden gelir,
+         * ama kare hızı adım hızından bağımsız olarak akıcı kalır */
+        bool interpolate = g_opts.fixed_hz > 0.0 && !isCrashed;
+        if (interpolate) apply_interpolated_planes(alpha);
+        if (!g_opts.headless) {
+            /* HUD görünüm tuşu: simülasyon girdisi değil, kayda girmez */
+            static bool h_last = false;
+            bool h_now = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+            if (h_now && !h_last) hud_toggle();
+            h_last = h_now;
+        }
+        hud_update();
+        trace_begin("DRAW_SYSTEM");
         DRAW_SYSTEM();
+        trace_end();
+        trace_begin("detect_planes");
         detect_planes();
+        trace_end();
+        if (interpolate) restore_planes();
+        trace_begin("video_capture");
+        video_capture();
+        trace_end();
+
+        trace_begin("swap");
+        if (g_opts.headless) {
+            headless_swap();
+        } else {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        trace_end();
+        trace_frame_end(frames);
+        blackbox_frame_end(frames, g_sim_time, (get_current_time_seconds() - now) * 1000.0);
+        frames++;
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-
-#if !USE_VSYNC
-        if (TARGET_FPS > 0.0) {
+        if (!g_opts.headless && !replay_active() && !g_opts.vsync && g_opts.target_fps > 0.0) {
             double frame_end = get_current_time_seconds();
-            double remaining = (1.0 / TARGET_FPS) - (frame_end - now);
+            double remaining = (1.0 / g_opts.target_fps) - (frame_end - now);
             if (remaining > 0.0005) {
                 struct timespec ts;
                 ts.tv_sec  = (time_t)remaining;
@@ -494,19 +1009,51 @@ int main(void) {
                 nanosleep(&ts, NULL);
             }
         }
-#endif
     }
 
+    double wall = get_current_time_seconds() - g_start_time;
+    printf("[RUN] %ld frames in %.2f s (%.1f FPS)\n", frames, wall, wall > 0.0 ? frames / wall : 0.0);
+    if (g_sim_capped > 0)
+        printf("[SIM] %ld frames hit the %d-step limit; the sim fell behind real time there\n", g_sim_capped,
+               MAX_STEPS_PER_FRAME * (int)ceil(g_opts.time_warp));
+
+    replay_record_stop();
+    replay_close();
+    if (g_opts.snapshot_save && g_opts.snapshot_at <= 0) save_snapshot(frames);
+    video_close();
+    blackbox_close();
+    detlog_close();
+    mot_close();
+    if (g_det_tracker_ready) { tracker_free(&g_det_tracker); g_det_tracker_ready = 0; }
+    eval_close();
+    dataset_close();
+    idpass_destroy();
+    scenario_free();
+    free_plane_buffers();
+    hud_free();
+    metrics_close();
+    if (trace_active() && g_detector_ready) {
+        char *ort_path = NULL;
+        uint64_t ort_t0 = 0;
+        if (onnx_end_profiling(&g_detector, &ort_path, &ort_t0) == ONNX_OK) trace_ort_profile(ort_path, ort_t0);
+        free(ort_path);
+    }
+    trace_close();
+
     CLEANUP_SYSTEM();
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (g_opts.headless) {
+        headless_shutdown();
+    } else {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
     return 0;
 }
 
 /* ---- Engine ---- */
 void INIT_SYSTEM(void) {
     printf("Initializing system...\n");
-    for (int i = 0; i < MAX_PLANES; i++) init_flight_model(planes[i]);
+    for (int i = 0; i < plane_count; i++) init_flight_model(planes[i]);
 
     if (!init_skybox())       exit(-1);
     if (!init_ui())           exit(-1);
@@ -526,8 +1073,10 @@ void INIT_SYSTEM(void) {
 }
 
 void DRAW_SYSTEM(void) {
+    trace_gpu_begin("clear");
     glClearColor(0.53f, 0.81f, 0.92f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    trace_gpu_end();
 
     glm_perspective(glm_rad(fov), (float)SCR_WIDTH / (float)SCR_HEIGHT, 5.0f, 5000.0f, g_proj);
 
@@ -565,34 +1114,110 @@ void DRAW_SYSTEM(void) {
         glm_lookat(cameraPos, center, cameraUp, g_view);
     }
 
+    trace_gpu_begin("skybox");
     draw_skybox(g_view, g_proj);
+    trace_gpu_end();
+    trace_begin("update_chunks");
     update_chunks();
+    trace_end();
+    trace_gpu_begin("chunks");
     draw_chunks(g_view, g_proj);
+    trace_gpu_end();
     update_minimap_dot();
 
+    trace_gpu_begin("planes");
     if (!isCrashed) {
-        for (int i = 0; i < MAX_PLANES; i++)
+        for (int i = 0; i < plane_count; i++)
             draw_plane(&planes[i], g_view, g_proj);
     }
+    trace_gpu_end();
 
     glDisable(GL_DEPTH_TEST);
-    if (isCrashed) draw_crash_marker(g_view, g_proj);
+    if (isCrashed) {
+        trace_gpu_begin("crash_marker");
+        draw_crash_marker(g_view, g_proj);
+        trace_gpu_end();
+    }
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    trace_gpu_begin("texts");
     draw_texts();
+    hud_draw();
+    trace_gpu_end();
 
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    trace_gpu_begin("minimap");
     draw_minimap();
+    trace_gpu_end();
 
     glDisable(GL_BLEND);
     glEnable(GL_DEPTH_TEST);
 }
 
+/* --detect-every N: ara karelerde son tespitler (ve ID'leri) tekrar çizilir */
+static OnnxDet *g_held_dets  = NULL;
+static int     *g_held_ids   = NULL;
+static int      g_held_count = 0;              /* --eval için eşik altındakiler dahil */
+static int      g_held_kept  = 0;              /* g_thresh üstü önek: çizim ve izleme */
+static int      g_held_cap   = 0;
+
+static int cmp_det_score_desc(const void *a, const void *b) {
+    float x = ((const OnnxDet *)a)->score, y = ((const OnnxDet *)b)->score;
+    return (x < y) - (x > y);
+}
+
+/* ids: the first `kept` detections only */
+static void hold_detections(const OnnxDet *dets, const int *ids, int kept, int n) {
+    if (n > g_held_cap) {
+        g_held_cap  = n;
+        g_held_dets = realloc(g_held_dets, sizeof(OnnxDet) * (size_t)n);
+        g_held_ids  = realloc(g_held_ids, sizeof(int) * (size_t)n);
+    }
+    if (n > 0) memcpy(g_held_dets, dets, sizeof(OnnxDet) * (size_t)n);
+    for (int i = 0; i < n; ++i) g_held_ids[i] = ids && i < kept ? ids[i] : -1;
+    g_held_count = n;
+    g_held_kept  = kept;
+}
+
+static void draw_detections(const OnnxDet *dets, int det_count, ViewRect lb, float min_score) {
+    float sx = (float)SCR_WIDTH  / (float)lb.w;
+    float sy = (float)SCR_HEIGHT / (float)lb.h;
+
+    glDisable(GL_DEPTH_TEST);
+    for (int i = 0; i < det_count; ++i) {
+        if (dets[i].score < min_score)
+            continue;
+        if (dets[i].cls == 0 && dets[i].score < 0.9)
+            continue;
+
+        float x1 = (dets[i].x1 - (float)lb.x) * sx;
+        float y1 = (dets[i].y1 - (float)lb.y) * sy;
+        float x2 = (dets[i].x2 - (float)lb.x) * sx;
+        float y2 = (dets[i].y2 - (float)lb.y) * sy;
+
+        int L = (int)floorf(x1), T = (int)floorf(y1);
+        int R = (int)ceilf (x2), B = (int)ceilf (y2);
+        if (L < 0) L = 0; if (T < 0) T = 0;
+        if (R >= SCR_WIDTH)  R = SCR_WIDTH  - 1;
+        if (B >= SCR_HEIGHT) B = SCR_HEIGHT - 1;
+
+        if (R > L && B > T) {
+            int cls = dets[i].cls;
+            float rr, gg, bb;
+            class_to_color(cls, &rr, &gg, &bb);
+            drawBoundingBoxColored(L, T, R, B, 4.0f, rr, gg, bb, 1.0f);
+        }
+    }
+    glEnable(GL_DEPTH_TEST);
+}
+
 void detect_planes(void) {
-    if (!g_detector_ready) return;
+    if (!g_detector_ready && !g_skyblob_ready && !dataset_active() && !blackbox_active() && !eval_active() &&
+        !mot_active())
+        return;
 
-    const int W = DET_W, H = DET_H;
+    const int W = g_det_w, H = g_det_h;
     const size_t need_rgba = (size_t)W * H * 4;
     const size_t need_rgb  = (size_t)W * H * 3;
 
@@ -602,7 +1227,17 @@ void detect_planes(void) {
     }
 
     float screen_aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
-    ViewRect lb = det_letterbox_rect(DET_W, screen_aspect);
+    ViewRect lb = det_letterbox_rect(g_det_w, screen_aspect);
+    const float min_score = g_detector_ready ? g_thresh : 0.0f;
+
+    /* Ara kare: dedektör çalışmaz; değerlendirme açıksa yalnız etiketler için render edilir */
+    const bool held = (g_detector_ready || g_skyblob_ready) && g_frame_index % g_opts.detect_every != 0;
+    if (held && !eval_active() && !mot_active()) {
+        trace_gpu_begin("draw_held");
+        draw_detections(g_held_dets, g_held_kept, lb, min_score);
+        trace_gpu_end();
+        return;
+    }
 
     mat4 det_view, det_proj;
     glm_mat4_copy(g_view, det_view);
@@ -612,92 +1247,162 @@ void detect_planes(void) {
     GLint prev_vp[4];   glGetIntegerv(GL_VIEWPORT, prev_vp);
 
     double t_render0 = get_current_time_millis();
+    trace_gpu_begin("render");
     glBindFramebuffer(GL_FRAMEBUFFER, g_det_fbo);
     render_for_detection(lb, det_view, det_proj);
     glFinish();
+    trace_gpu_end();
     double t_render1 = get_current_time_millis();
 
     double t_read0 = get_current_time_millis();
+    trace_gpu_begin("read");
     glPixelStorei(GL_PACK_ALIGNMENT, 1);
     glReadPixels(0, 0, W, H, GL_RGBA, GL_UNSIGNED_BYTE, g_rgba_buffer);
+    trace_gpu_end();
     double t_read1 = get_current_time_millis();
 
-    double t_convert0 = get_current_time_millis();
-    float* chw = malloc(sizeof(float) * 3 * W * H);
-    rgba_flip_gray3_chw_norm(g_rgba_buffer, chw, W, H);
-    double t_convert1 = get_current_time_millis();
-
     glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)prev_fbo);
     glViewport(prev_vp[0], prev_vp[1], prev_vp[2], prev_vp[3]);
+    if (!held) blackbox_capture(g_rgba_buffer, W, H);
+
+    /* Eğitim verisi / değerlendirme: etiketler model matrislerinden, görüntü bu kareden */
+    OnnxDet *gt       = g_gt;
+    int     *gt_plane = g_gt_plane;
+    float   *gt_range = g_gt_range;
+    int      ngt = 0;
+    if (dataset_active() || eval_active() || mot_active()) {
+        trace_gpu_begin("ground_truth");
+        IdPassBox ids[MAX_PLANES];
+        ngt = idpass_run(det_view, det_proj, lb.x, lb.y, lb.w, lb.h, ids)
+            ? dataset_ground_truth_id(det_view, ids, gt, gt_plane, plane_count)
+            : dataset_ground_truth(det_view, det_proj, lb.x, lb.y, lb.w, lb.h, W, H, gt, gt_plane, plane_count);
+        for (int i = 0; i < ngt; ++i) {
+            vec3 p;
+            glm_mat4_mulv3(det_view, planes[gt_plane[i]].position, 1.0f, p);
+            gt_range[i] = glm_vec3_norm(p);
+        }
+        trace_gpu_end();
+        if (dataset_active() && !held) dataset_submit(g_rgba_buffer, W, H, gt, ngt);
+    }
+    if (held) {
+        /* stage_ms NULL: ara kare maliyeti sıfır sayılır */
+        eval_frame(gt, gt_range, ngt, g_held_dets, g_held_count, NULL);
+        if (g_det_tracker_ready) mot_frame(gt, gt_plane, ngt, g_held_dets, g_held_ids, g_held_kept, -1.0);
+        trace_gpu_begin("draw_held");
+        draw_detections(g_held_dets, g_held_kept, lb, min_score);
+        trace_gpu_end();
+        return;
+    }
+    if (!g_detector_ready && !g_skyblob_ready) {
+        eval_frame(gt, gt_range, ngt, NULL, 0, NULL);
+        mot_frame(gt, gt_plane, ngt, NULL, NULL, 0, 0.0);
+        return;
+    }
 
+    float* chw = NULL;
     OnnxDet* dets = NULL; int det_count = 0;
-    double t_infer0 = get_current_time_millis();
-    int rc = onnx_predict(&g_detector, chw, W, H, &dets, &det_count);
-    double t_infer1 = get_current_time_millis();
-    if (rc != ONNX_OK) { return; }
+    double t_convert0 = get_current_time_millis(), t_convert1 = t_convert0;
+    double t_infer0, t_infer1;
+    int rc;
+    if (g_detector_ready) {
+        const void *input = g_rgba_buffer;
+        if (!g_detector.in_u8) {
+            trace_begin("convert");
+            chw = malloc(sizeof(float) * 3 * W * H);
+            rgba_flip_gray3_chw_norm(g_rgba_buffer, chw, W, H);
+            input = chw;
+            trace_end();
+        }
+        t_convert1 = get_current_time_millis();
+
+        t_infer0 = get_current_time_millis();
+        trace_begin("infer");
+        rc = onnx_predict(&g_detector, input, W, H, &dets, &det_count);
+        trace_end();
+        t_infer1 = get_current_time_millis();
+    } else {
+        /* letterbox bantları siyah; sadece sahne alanında ara */
+        t_infer0 = get_current_time_millis();
+        trace_begin("infer");
+        rc = skyblob_detect_rgba(&g_skyblob, g_rgba_buffer, 1,
+                                 lb.x, H - lb.y - lb.h, lb.w, lb.h, &dets, &det_count);
+        trace_end();
+        t_infer1 = get_current_time_millis();
+    }
+    if (rc != ONNX_OK) {
+        /* Başarısız çıkarım = sıfır tespit; bu karenin GT'si kaçırılmış sayılır */
+        free(chw);
+        if (g_opts.detect_every > 1) hold_detections(NULL, NULL, 0, 0);
+        eval_frame(gt, gt_range, ngt, NULL, 0, NULL);
+        mot_frame(gt, gt_plane, ngt, NULL, NULL, 0, -1.0);
+        return;
+    }
     g_last_det_ms = (t_infer1 - t_infer0);
 
-    float sx = (float)SCR_WIDTH  / (float)lb.w;
-    float sy = (float)SCR_HEIGHT / (float)lb.h;
+    /* --eval: model EVAL_SCORE_FLOOR ile çalıştı. Skora göre sıralanır; g_thresh üstü
+     * önek çizim, izleme ve kayıtlara gider, değerlendirme listenin tamamını görür */
+    const int all_count = det_count;
+    if (g_detector_ready && eval_active()) {
+        qsort(dets, (size_t)det_count, sizeof(OnnxDet), cmp_det_score_desc);
+        det_count = 0;
+        while (det_count < all_count && dets[det_count].score >= g_thresh) det_count++;
+    }
+    blackbox_detections(dets, det_count);
+    shadow_offer(g_rgba_buffer, W, H, dets, det_count, g_last_det_ms);
 
     double t_draw0 = get_current_time_millis();
-    glDisable(GL_DEPTH_TEST);
-    for (int i = 0; i < det_count; ++i) {
-        if (dets[i].score < g_thresh)
-            continue;
-        if (dets[i].cls == 0 && dets[i].score < 0.9)
-            continue;
-
-        float x1 = (dets[i].x1 - (float)lb.x) * sx;
-        float y1 = (dets[i].y1 - (float)lb.y) * sy;
-        float x2 = (dets[i].x2 - (float)lb.x) * sx;
-        float y2 = (dets[i].y2 - (float)lb.y) * sy;
-
-        int L = (int)floorf(x1), T = (int)floorf(y1);
-        int R = (int)ceilf (x2), B = (int)ceilf (y2);
-        if (L < 0) L = 0; if (T < 0) T = 0;
-        if (R >= SCR_WIDTH)  R = SCR_WIDTH  - 1;
-        if (B >= SCR_HEIGHT) B = SCR_HEIGHT - 1;
+    trace_gpu_begin("draw");
+    draw_detections(dets, det_count, lb, min_score);
+    trace_gpu_end();
+    double t_draw1 = get_current_time_millis();
 
-        if (R > L && B > T) {
-            int cls = dets[i].cls;
-            float rr, gg, bb;
-            class_to_color(cls, &rr, &gg, &bb);
-            drawBoundingBoxColored(L, T, R, B, 4.0f, rr, gg, bb, 1.0f);
+    const float stage_ms[DETLOG_STAGES] = {
+        (float)(t_render1 - t_render0), (float)(t_read1 - t_read0), (float)(t_convert1 - t_convert0),
+        (float)(t_infer1 - t_infer0), (float)(t_draw1 - t_draw0), (float)(t_draw1 - t_render0) };
+    double track_ms = -1.0;
+    if (g_det_tracker_ready) {
+        /* --track-every N: ara karelerde izleyici çalışmaz, ID'ler -1 kalır */
+        int* ids = det_count > 0 ? malloc(sizeof(int) * (size_t)det_count) : NULL;
+        if (g_frame_index % g_opts.track_every == 0) {
+            double c0 = get_thread_cpu_millis();
+            trace_begin("track");
+            tracker_update(&g_det_tracker, dets, det_count, ids);
+            trace_end();
+            track_ms = get_thread_cpu_millis() - c0;
+        } else {
+            for (int i = 0; i < det_count; ++i) ids[i] = -1;
         }
+        detlog_frame(g_frame_index, g_sim_time, stage_ms, dets, ids, det_count);
+        mot_frame(gt, gt_plane, ngt, dets, ids, det_count, track_ms);
+        if (g_opts.detect_every > 1) hold_detections(dets, ids, det_count, all_count);
+        free(ids);
+    } else if (g_opts.detect_every > 1) {
+        hold_detections(dets, NULL, det_count, all_count);
     }
-    glEnable(GL_DEPTH_TEST);
-    double t_draw1 = get_current_time_millis();
+    eval_frame(gt, gt_range, ngt, dets, all_count, stage_ms);
+    hud_detection(stage_ms, track_ms);
+    metrics_detection(stage_ms, track_ms);
 
     free(chw);
     onnx_free_detections(dets);
-
-    // --- Log timings ---
-    printf("[DET] render=%.2fms read=%.2fms convert=%.2fms infer=%.2fms draw=%.2fms total=%.2fms\n",
-           (t_render1 - t_render0),
-           (t_read1   - t_read0),
-           (t_convert1- t_convert0),
-           (t_infer1  - t_infer0),
-           (t_draw1   - t_draw0),
-           (t_draw1   - t_render0));
 }
 
 
 /* ---- Input / camera ---- */
 void processInput(void) {
     if (!isCrashed) {
-        if (glfwGetKey(window, GLFW_KEY_1)) { offset_behind = 400.0f; offset_above = 170.0f; offset_right = 0.0f; }
-        else if (glfwGetKey(window, GLFW_KEY_2)) { offset_behind = -50.0f; offset_above = 30.0f; offset_right = 0.0f; }
-        else if (glfwGetKey(window, GLFW_KEY_3)) { offset_behind = 400.0f; offset_above = 500.0f; offset_right = 0.0f; }
-        else if (glfwGetKey(window, GLFW_KEY_4)) { offset_behind = -300.0f; offset_above = 100.0f; offset_right = 0.0f; }
-        else if (glfwGetKey(window, GLFW_KEY_5)) { offset_behind = -200.0f; offset_above = 150.0f; offset_right = 250.0f; }
-        else if (glfwGetKey(window, GLFW_KEY_6)) { offset_behind = -200.0f; offset_above = 150.0f; offset_right = -250.0f; }
-        else if (glfwGetKey(window, GLFW_KEY_7)) { offset_behind = -300.0f; offset_above = -100.0f; offset_right = 0.0f; }
-        else if (glfwGetKey(window, GLFW_KEY_8)) { offset_behind = -75.0f;  offset_above = 200.0f; offset_right = 550.0f; }
+        if (input_key_down(GLFW_KEY_1)) { offset_behind = 400.0f; offset_above = 170.0f; offset_right = 0.0f; }
+        else if (input_key_down(GLFW_KEY_2)) { offset_behind = -50.0f; offset_above = 30.0f; offset_right = 0.0f; }
+        else if (input_key_down(GLFW_KEY_3)) { offset_behind = 400.0f; offset_above = 500.0f; offset_right = 0.0f; }
+        else if (input_key_down(GLFW_KEY_4)) { offset_behind = -300.0f; offset_above = 100.0f; offset_right = 0.0f; }
+        else if (input_key_down(GLFW_KEY_5)) { offset_behind = -200.0f; offset_above = 150.0f; offset_right = 250.0f; }
+        else if (input_key_down(GLFW_KEY_6)) { offset_behind = -200.0f; offset_above = 150.0f; offset_right = -250.0f; }
+        else if (input_key_down(GLFW_KEY_7)) { offset_behind = -300.0f; offset_above = -100.0f; offset_right = 0.0f; }
+        else if (input_key_down(GLFW_KEY_8)) { offset_behind = -75.0f;  offset_above = 200.0f; offset_right = 550.0f; }
     }
 
     static bool a_last = false;
-    bool a_now = (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS);
+    bool a_now = (input_key_down(GLFW_KEY_A));
     if (a_now && !a_last) {
         isAutopilotOn = !isAutopilotOn;
         fixedValue = currentMovementSpeed;
@@ -714,15 +1419,16 @@ void processInput(void) {
     a_last = a_now;
 
     static bool t_last = false;
-    bool t_now = (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS);
+    bool t_now = (input_key_down(GLFW_KEY_T));
     if (t_now && !t_last) {
         isTriangleViewMode = !isTriangleViewMode;
         printf("GRID VIEW MODE: %s\n", isTriangleViewMode ? "ON" : "OFF");
     }
     t_last = t_now;
 
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, 1);
+    if (input_key_down(GLFW_KEY_ESCAPE)) {
+        if (window) glfwSetWindowShouldClose(window, 1);
+        g_quit_requested = true;
         return;
     }
 
@@ -731,14 +1437,14 @@ void processInput(void) {
         isAutopilotOn = false;
         currentMovementSpeed = initialMovementSpeed;
 
-        if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
+        if (input_key_down(GLFW_KEY_R)) {
             isCrashed = false;
             hasSetCrashView = true;
-            for (int i=0; i<MAX_PLANES; i++) init_flight_model(planes[i]);
+            for (int i=0; i<plane_count; i++) init_flight_model(planes[i]);
             reset_minimap_for_restart();
             lastAltitude = planes[0].position[1];
         }
-        if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
+        if (input_key_down(GLFW_KEY_C)) {
             glm_vec3_copy(crashPosition, planes[0].position);
             planes[0].position[1] += 250.0f;
             vec3 worldUp = {0.0f, 1.0f, 0.0f};
@@ -765,7 +1471,7 @@ void processInput(void) {
     }
 
     static bool s_last = false;
-    bool s_now = (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS);
+    bool s_now = (input_key_down(GLFW_KEY_S));
     if (s_now && !s_last) {
         isSpeedFixed = !isSpeedFixed;
         if (isSpeedFixed) fixedValue = currentMovementSpeed;
@@ -776,8 +1482,8 @@ void processInput(void) {
         currentMovementSpeed = fixedValue;
     } else {
         float maxSpeed = initialMovementSpeed * speedBoostMultiplier;
-        if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
-            glfwGetKey(window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS) {
+        if (input_key_down(GLFW_KEY_LEFT_SHIFT) ||
+            input_key_down(GLFW_KEY_RIGHT_SHIFT)) {
             currentMovementSpeed += accelerationSpeeding * deltaTime;
             if (currentMovementSpeed > maxSpeed) currentMovementSpeed = maxSpeed;
             else offset_behind += accelerationGoingFarPerSecond;
@@ -788,7 +1494,7 @@ void processInput(void) {
         }
     }
 
-    if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS) {
+    if (input_key_down(GLFW_KEY_Z)) {
         fov -= zoomingSpeed * deltaTime;
         if (fov < maximumZoomDistance) fov = maximumZoomDistance;
     } else {
@@ -800,10 +1506,10 @@ void processInput(void) {
     float roll_speed     = bow_rate * deltaTime;
     bool isTurning = false;
 
-    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)   applyUpPitch(rotation_speed * 2);
-    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) applyDownPitch(rotation_speed * 2);
-    if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) { isTurning = true;  applyLeftTurn(rotation_speed, roll_speed); }
-    if (glfwGetKey(window, GLFW_KEY_RIGHT)== GLFW_PRESS) { isTurning = true;  applyRightTurn(rotation_speed, roll_speed); }
+    if (input_key_down(GLFW_KEY_UP))   applyUpPitch(rotation_speed * 2);
+    if (input_key_down(GLFW_KEY_DOWN)) applyDownPitch(rotation_speed * 2);
+    if (input_key_down(GLFW_KEY_LEFT)) { isTurning = true;  applyLeftTurn(rotation_speed, roll_speed); }
+    if (input_key_down(GLFW_KEY_RIGHT)) { isTurning = true;  applyRightTurn(rotation_speed, roll_speed); }
     if (!isTurning) applyAutoLeveling();
 
     glm_normalize(planes[0].front);
@@ -843,10 +1549,16 @@ void CLEANUP_SYSTEM(void) {
     if (box_vbo)            glDeleteBuffers(1, &box_vbo);
     if (box_shader_program) glDeleteProgram(box_shader_program);
 
+    shadow_stop();
     if (g_detector_ready) { onnx_destroy(&g_detector); g_detector_ready = 0; }
+    if (g_skyblob_ready)  { skyblob_destroy(&g_skyblob); g_skyblob_ready = 0; }
+    if (g_infer_cache_ready) { infer_cache_close(&g_infer_cache); g_infer_cache_ready = 0; }
 
     if (g_rgba_buffer) { free(g_rgba_buffer); g_rgba_buffer = NULL; }
     g_frame_buf_capacity = 0;
+    free(g_held_dets); g_held_dets = NULL;
+    free(g_held_ids);  g_held_ids  = NULL;
+    g_held_count = g_held_kept = g_held_cap = 0;
 
     if (g_det_depth_rbo)  { glDeleteRenderbuffers(1, &g_det_depth_rbo);  g_det_depth_rbo  = 0; }
     if (g_det_color_tex)  { glDeleteTextures(1, &g_det_color_tex);       g_det_color_tex  = 0; }
@@ -0,0 +1,250 @@
+#define _GNU_SOURCE
+#include "metrics.h"
+#include "blackbox.h"
+#include "dataset.h"
+#include "detlog.h"
+#include "heightMap.h"
+#include "shadow.h"
+#include "stats.h"
+#include "video.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define METRICS_LINE_MAX (96 * 1024)
+
+enum { Q_VIDEO, Q_DATASET, Q_BLACKBOX, Q_SHADOW, METRICS_QUEUES };
+static const char* const queue_names[METRICS_QUEUES] = { "video", "dataset", "blackbox", "shadow" };
+
+static struct {
+    bool     active;
+    bool     is_socket;
+    int      fd;                   /* -1 = socket not connected */
+    char     path[108];            /* socket path (sun_path size) */
+    double   interval_s, budget_ms;
+    double   start_s, next_flush_s;
+    double   last_flush_ms;        /* exporter's own cost, reported on the next line */
+
+    LogHist  frame, stage[DETLOG_STAGES], track, queue[METRICS_QUEUES];
+    long     frames, late, detections;
+    long     seq, lines_written, lines_dropped;
+
+    char     line[METRICS_LINE_MAX];
+    size_t   len;
+    bool     overflow;
+} g_met = { .fd = -1 };
+
+static double now_s(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+/* ---------- line building ---------- */
+
+static void put(const char* fmt, ...) {
+    if (g_met.overflow) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(g_met.line + g_met.len, sizeof(g_met.line) - g_met.len, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= sizeof(g_met.line) - g_met.len) g_met.overflow = true;
+    else g_met.len += (size_t)n;
+}
+
+/* Bucket interpolation can overshoot the largest sample */
+static double percentile(const LogHist* h, double p) {
+    double v = loghist_percentile(h, p);
+    return v > h->max ? h->max : v;
+}
+
+static void put_hist(const char* name, const LogHist* h, bool first) {
+    put("%s\"%s\":{\"count\":%llu,\"sum\":%.6g,\"max\":%.6g", first ? "" : ",", name,
+        (unsigned long long)h->count, h->sum, h->max);
+    if (h->count > 0)
+        put(",\"p50\":%.6g,\"p95\":%.6g,\"p99\":%.6g", percentile(h, 50.0), percentile(h, 95.0),
+            percentile(h, 99.0));
+    put(",\"buckets\":[");
+    bool any = false;
+    for (int b = 0; b < LOGHIST_BUCKETS; ++b) {
+        if (!h->n[b]) continue;
+        put("%s[%.6g,%u]", any ? "," : "", loghist_bucket_lower(b), h->n[b]);
+        any = true;
+    }
+    put("]}");
+}
+
+static void build_line(double now) {
+    long drop[METRICS_QUEUES] = { 0 };
+    int  depth[METRICS_QUEUES];
+    depth[Q_VIDEO]    = video_queue_depth(&drop[Q_VIDEO]);
+    depth[Q_DATASET]  = dataset_queue_depth();
+    depth[Q_BLACKBOX] = blackbox_queue_depth(&drop[Q_BLACKBOX]);
+    depth[Q_SHADOW]   = shadow_queue_depth(&drop[Q_SHADOW]);
+
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+
+    g_met.len = 0;
+    g_met.overflow = false;
+    put("{\"seq\":%ld,\"ts\":%.3f,\"uptime_s\":%.3f,\"frames\":%ld,\"late_frames\":%ld,"
+        "\"detections\":%ld,\"chunk_generations\":%ld",
+        g_met.seq, (double)wall.tv_sec + (double)wall.tv_nsec / 1e9, now - g_met.start_s,
+        g_met.frames, g_met.late, g_met.detections, chunk_generations());
+
+    put(",\"queue\":{");
+    for (int q = 0; q < METRICS_QUEUES; ++q) put("%s\"%s\":%d", q ? "," : "", queue_names[q], depth[q]);
+    /* dataset writers block instead of dropping */
+    put("},\"dropped\":{\"video\":%ld,\"blackbox\":%ld,\"shadow\":%ld}", drop[Q_VIDEO], drop[Q_BLACKBOX],
+        drop[Q_SHADOW]);
+    put(",\"exporter\":{\"lines_dropped\":%ld,\"last_flush_ms\":%.4f}", g_met.lines_dropped, g_met.last_flush_ms);
+
+    put(",\"hist\":{");
+    put_hist("frame_ms", &g_met.frame, true);
+    char name[64];
+    for (int s = 0; s < DETLOG_STAGES; ++s) {
+        snprintf(name, sizeof(name), "%s_ms", detlog_stage_names[s]);
+        put_hist(name, &g_met.stage[s], false);
+    }
+    put_hist("track_ms", &g_met.track, false);
+    for (int q = 0; q < METRICS_QUEUES; ++q) {
+        snprintf(name, sizeof(name), "queue_%s", queue_names[q]);
+        put_hist(name, &g_met.queue[q], false);
+    }
+    put("}}\n");
+}
+
+/* ---------- output ---------- */
+
+static void socket_connect(void) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, g_met.path, strlen(g_met.path) + 1);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return;
+    }
+    g_met.fd = fd;
+}
+
+static void emit(void) {
+    if (g_met.overflow) {
+        g_met.lines_dropped++;
+        return;
+    }
+    if (g_met.is_socket) {
+        if (g_met.fd < 0) socket_connect();
+        if (g_met.fd < 0) {
+            g_met.lines_dropped++;
+            return;
+        }
+        ssize_t n = send(g_met.fd, g_met.line, g_met.len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n != (ssize_t)g_met.len) {
+            /* Yarım satır akışı bozar: bağlantı kapatılır, okuyucu yeniden bağlanınca temiz başlar */
+            close(g_met.fd);
+            g_met.fd = -1;
+            g_met.lines_dropped++;
+            return;
+        }
+    } else {
+        size_t off = 0;
+        while (off < g_met.len) {
+            ssize_t n = write(g_met.fd, g_met.line + off, g_met.len - off);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                g_met.lines_dropped++;
+                return;
+            }
+            off += (size_t)n;
+        }
+    }
+    g_met.lines_written++;
+}
+
+static void flush_now(double now) {
+    build_line(now);
+    emit();
+    g_met.seq++;
+    g_met.last_flush_ms = (now_s() - now) * 1000.0;
+}
+
+/* ---------- API ---------- */
+
+bool metrics_open(const char* target, double interval_s, double budget_ms) {
+    if (!target || !*target) return false;
+    memset(&g_met, 0, sizeof(g_met));
+    g_met.fd = -1;
+    g_met.interval_s = interval_s > 0.0 ? interval_s : METRICS_INTERVAL_S;
+    g_met.budget_ms = budget_ms;
+
+    if (!strncmp(target, "unix:", 5)) {
+        const char* p = target + 5;
+        if (!*p || strlen(p) >= sizeof(g_met.path)) {
+            fprintf(stderr, "[METRICS] bad socket path: %s\n", target);
+            return false;
+        }
+        memcpy(g_met.path, p, strlen(p) + 1);
+        g_met.is_socket = true;
+        socket_connect();
+        if (g_met.fd < 0) printf("[METRICS] %s not listening yet, retrying every flush\n", g_met.path);
+    } else {
+        g_met.fd = open(target, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (g_met.fd < 0) {
+            fprintf(stderr, "[METRICS] cannot open %s: %s\n", target, strerror(errno));
+            return false;
+        }
+    }
+    g_met.start_s = now_s();
+    g_met.next_flush_s = g_met.start_s + g_met.interval_s;
+    g_met.active = true;
+    printf("[METRICS] every %.2f s -> %s\n", g_met.interval_s, target);
+    return true;
+}
+
+bool metrics_active(void) { return g_met.active; }
+
+void metrics_frame(double frame_ms) {
+    if (!g_met.active) return;
+    loghist_add(&g_met.frame, frame_ms);
+    g_met.frames++;
+    if (g_met.budget_ms > 0.0 && frame_ms > 1.5 * g_met.budget_ms) g_met.late++;
+
+    loghist_add(&g_met.queue[Q_VIDEO], video_queue_depth(NULL));
+    loghist_add(&g_met.queue[Q_DATASET], dataset_queue_depth());
+    loghist_add(&g_met.queue[Q_BLACKBOX], blackbox_queue_depth(NULL));
+    loghist_add(&g_met.queue[Q_SHADOW], shadow_queue_depth(NULL));
+
+    double now = now_s();
+    if (now >= g_met.next_flush_s) {
+        flush_now(now);
+        /* Geride kalırsa biriktirmez: bir sonraki aralıktan devam eder */
+        g_met.next_flush_s += g_met.interval_s;
+        if (g_met.next_flush_s <= now) g_met.next_flush_s = now + g_met.interval_s;
+    }
+}
+
+void metrics_detection(const float* stage_ms, double track_ms) {
+    if (!g_met.active || !stage_ms) return;
+    for (int s = 0; s < DETLOG_STAGES; ++s) loghist_add(&g_met.stage[s], stage_ms[s]);
+    if (track_ms >= 0.0) loghist_add(&g_met.track, track_ms);
+    g_met.detections++;
+}
+
+void metrics_close(void) {
+    if (!g_met.active) return;
+    flush_now(now_s());
+    if (g_met.fd >= 0) close(g_met.fd);
+    g_met.fd = -1;
+    g_met.active = false;
+    printf("[METRICS] %ld lines written, %ld dropped\n", g_met.lines_written, g_met.lines_dropped);
+}
@@ -1,7 +1,6 @@
 #include "minimap.h"
 #include "globals.h"
 
-#define MINIMAP_TEXTURE_SIZE 256
 #define MAX_STARFIGHTERS MAX_PLANES
 
 static GLuint minimapShaderProgram, minimapVBO, minimapEBO;
@@ -181,7 +180,7 @@ static void get_continuous_normalized_position(vec2 out_pos, const vec3 world_po
     out_pos[1] = (world_pos[2] + total_height / 2.0f) / total_height;
 }
 
-static void draw_starfighter_icon(float angle_rad, StarfighterColors *colors, unsigned char *targetPixelData) {
+void draw_starfighter_icon(float angle_rad, StarfighterColors *colors, unsigned char *targetPixelData) {
     const float NOSE_POINT_SIZE = 3.5f;
     const float TAIL_POINT_SIZE = 4.0f;
 
@@ -381,9 +380,11 @@ void init_minimap() {
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(minimap_indices), minimap_indices, GL_STATIC_DRAW);
 
         for (int i=0; i<MAX_STARFIGHTERS; i++) {
-            starfighterColors[i] = &planes[i].colors;
-            starfighterPositions[i] = &planes[i].position;
-            starfighterFronts[i] = &planes[i].front;
+            /* icons for the first MAX_PLANES aircraft; smaller scenarios repeat the player */
+            Plane *p = &planes[i < plane_count ? i : 0];
+            starfighterColors[i] = &p->colors;
+            starfighterPositions[i] = &p->position;
+            starfighterFronts[i] = &p->front;
             init_starfighter_texture(i);
         }
     }
@@ -0,0 +1,395 @@
+#define _GNU_SOURCE
+#include "mot.h"
+#include "stats.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MOT_ALPHAS 19     /* HOTA localisation thresholds 0.05, 0.10 .. 0.95 */
+#define MOT_EPS    1e-10
+
+/* Frame record: ngt dense GT ids then nhyp dense track ids in ids[],
+ * the ngt x nhyp IoU matrix (row-major) in sim[] */
+typedef struct {
+    int  ngt, nhyp;
+    long id_off, sim_off;
+} MotFrame;
+
+/* Raw id -> dense index (dense[raw] = index + 1, 0 = unseen) */
+typedef struct {
+    int* dense;
+    long cap;
+    int  n;
+} IdMap;
+
+static struct {
+    int           running;
+    char*         path;
+    int           track_every;
+    MotFrame*     frames;
+    long          nframes, frames_cap;
+    int*          ids;
+    long          nids, ids_cap;
+    float*        sim;
+    long          nsim, sim_cap;
+    IdMap         gt_map, hyp_map;
+    int           oom;
+
+    /* last tracker output, held on frames the tracker skips */
+    OnnxDet       held[MOT_MAX_BOXES];
+    int           held_ids[MOT_MAX_BOXES];
+    int           nheld;
+
+    LatencyWindow cpu;
+    double        cpu_total;
+    long          cpu_runs;
+} g_mot;
+
+static int grow(void** p, long* cap, long need, size_t elem) {
+    if (need <= *cap) return 1;
+    long nc = *cap ? *cap * 2 : 4096;
+    while (nc < need) nc *= 2;
+    void* np = realloc(*p, (size_t)nc * elem);
+    if (!np) return 0;
+    *p = np;
+    *cap = nc;
+    return 1;
+}
+
+static int id_dense(IdMap* m, int raw) {
+    if (raw >= m->cap) {
+        long old = m->cap;
+        if (!grow((void**)&m->dense, &m->cap, (long)raw + 1, sizeof(int))) return -1;
+        memset(m->dense + old, 0, sizeof(int) * (size_t)(m->cap - old));
+    }
+    if (!m->dense[raw]) m->dense[raw] = ++m->n;
+    return m->dense[raw] - 1;
+}
+
+static float iou(const OnnxDet* a, const OnnxDet* b) {
+    float iw = fminf(a->x2, b->x2) - fmaxf(a->x1, b->x1);
+    float ih = fminf(a->y2, b->y2) - fmaxf(a->y1, b->y1);
+    if (iw <= 0.0f || ih <= 0.0f) return 0.0f;
+    float inter = iw * ih;
+    float uni = (a->x2 - a->x1) * (a->y2 - a->y1) + (b->x2 - b->x1) * (b->y2 - b->y1) - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+bool mot_open(const char* path, int track_every) {
+    if (g_mot.running) return true;
+    memset(&g_mot, 0, sizeof(g_mot));
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "[MOT] cannot write %s\n", path);
+        return false;
+    }
+    fclose(fp);
+    if (latwin_init(&g_mot.cpu, MOT_CPU_SAMPLES) != 0) return false;
+    g_mot.path = strdup(path);
+    g_mot.track_every = track_every > 0 ? track_every : 1;
+    g_mot.running = 1;
+    printf("[MOT] tracker vs plane identities, tracker every %d frame(s), report -> %s\n",
+           g_mot.track_every, path);
+    return true;
+}
+
+bool mot_active(void) { return g_mot.running != 0; }
+
+void mot_frame(const OnnxDet* gt, const int* gt_ids, int ngt,
+               const OnnxDet* hyp, const int* hyp_ids, int nhyp, double tracker_ms) {
+    if (!g_mot.running || g_mot.oom) return;
+    if (tracker_ms >= 0.0) {
+        latwin_push(&g_mot.cpu, tracker_ms);
+        g_mot.cpu_total += tracker_ms;
+        g_mot.cpu_runs++;
+        g_mot.nheld = 0;
+        for (int i = 0; i < nhyp && g_mot.nheld < MOT_MAX_BOXES; ++i) {
+            if (hyp_ids[i] < 0) continue;
+            g_mot.held[g_mot.nheld] = hyp[i];
+            g_mot.held_ids[g_mot.nheld++] = hyp_ids[i];
+        }
+    }
+    if (ngt > MOT_MAX_BOXES) ngt = MOT_MAX_BOXES;
+    const int nh = g_mot.nheld;
+
+    if (!grow((void**)&g_mot.frames, &g_mot.frames_cap, g_mot.nframes + 1, sizeof(MotFrame)) ||
+        !grow((void**)&g_mot.ids, &g_mot.ids_cap, g_mot.nids + ngt + nh, sizeof(int)) ||
+        !grow((void**)&g_mot.sim, &g_mot.sim_cap, g_mot.nsim + (long)ngt * nh, sizeof(float))) {
+        fprintf(stderr, "[MOT] out of memory after %ld frames; scoring those\n", g_mot.nframes);
+        g_mot.oom = 1;
+        return;
+    }
+    int* ids = g_mot.ids + g_mot.nids;
+    for (int i = 0; i < ngt + nh; ++i) {
+        ids[i] = i < ngt ? id_dense(&g_mot.gt_map, gt_ids[i]) : id_dense(&g_mot.hyp_map, g_mot.held_ids[i - ngt]);
+        if (ids[i] < 0) { g_mot.oom = 1; return; }
+    }
+    MotFrame* f = &g_mot.frames[g_mot.nframes];
+    f->ngt = ngt;
+    f->nhyp = nh;
+    f->id_off = g_mot.nids;
+    f->sim_off = g_mot.nsim;
+    g_mot.nids += ngt + nh;
+    for (int i = 0; i < ngt; ++i)
+        for (int j = 0; j < nh; ++j) g_mot.sim[g_mot.nsim++] = iou(&gt[i], &g_mot.held[j]);
+    g_mot.nframes++;
+}
+
+/* ---------------- Scoring ---------------- */
+
+/* Min-cost assignment (Hungarian, O(n^2 m)) for n <= m; cost is n x m
+ * row-major. row_col[r] receives the column of row r. */
+static int hungarian_min(const double* cost, int n, int m, int* row_col) {
+    double* u    = calloc((size_t)n + 1, sizeof(double));
+    double* v    = calloc((size_t)m + 1, sizeof(double));
+    double* minv = malloc(sizeof(double) * ((size_t)m + 1));
+    int*    p    = calloc((size_t)m + 1, sizeof(int));
+    int*    way  = calloc((size_t)m + 1, sizeof(int));
+    char*   used = malloc((size_t)m + 1);
+    int ok = u && v && minv && p && way && used;
+    for (int i = 1; ok && i <= n; ++i) {
+        p[0] = i;
+        int j0 = 0;
+        for (int j = 0; j <= m; ++j) { minv[j] = DBL_MAX; used[j] = 0; }
+        do {
+            used[j0] = 1;
+            int i0 = p[j0], j1 = 0;
+            double delta = DBL_MAX;
+            for (int j = 1; j <= m; ++j) {
+                if (used[j]) continue;
+                double cur = cost[(size_t)(i0 - 1) * m + (j - 1)] - u[i0] - v[j];
+                if (cur < minv[j]) { minv[j] = cur; way[j] = j0; }
+                if (minv[j] < delta) { delta = minv[j]; j1 = j; }
+            }
+            for (int j = 0; j <= m; ++j) {
+                if (used[j]) { u[p[j]] += delta; v[j] -= delta; }
+                else         minv[j] -= delta;
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do { int j1 = way[j0]; p[j0] = p[j1]; j0 = j1; } while (j0);
+    }
+    if (ok)
+        for (int j = 1; j <= m; ++j)
+            if (p[j]) row_col[p[j] - 1] = j - 1;
+    free(u); free(v); free(minv); free(p); free(way); free(used);
+    return ok;
+}
+
+/* Max-score assignment of any shape; pairs scoring <= 0 stay unmatched
+ * (row_col[r] = -1) */
+static void assign_max(const double* score, int n, int m, int* row_col) {
+    for (int r = 0; r < n; ++r) row_col[r] = -1;
+    if (n == 0 || m == 0) return;
+    const int tr = n > m;
+    const int rows = tr ? m : n, cols = tr ? n : m;
+    double* cost = malloc(sizeof(double) * (size_t)rows * cols);
+    int* rc = malloc(sizeof(int) * (size_t)rows);
+    if (cost && rc) {
+        for (int r = 0; r < rows; ++r)
+            for (int c = 0; c < cols; ++c)
+                cost[(size_t)r * cols + c] = -(tr ? score[(size_t)c * m + r] : score[(size_t)r * m + c]);
+        if (hungarian_min(cost, rows, cols, rc)) {
+            for (int r = 0; r < rows; ++r) {
+                int row = tr ? rc[r] : r, col = tr ? r : rc[r];
+                if (score[(size_t)row * m + col] > MOT_EPS) row_col[row] = col;
+            }
+        }
+    }
+    free(cost);
+    free(rc);
+}
+
+typedef struct {
+    long   gt_dets, hyp_dets;
+    long   tp, idsw;
+    double mota, motp;
+    double idtp, idf1, idp, idr;
+    double hota[MOT_ALPHAS], deta[MOT_ALPHAS], assa[MOT_ALPHAS], loca[MOT_ALPHAS];
+    double hota_mean, deta_mean, assa_mean, loca_mean;
+} MotScore;
+
+static int score_run(MotScore* s) {
+    memset(s, 0, sizeof(*s));
+    const int G = g_mot.gt_map.n, H = g_mot.hyp_map.n;
+    const size_t GH = (size_t)G * H;
+    double* gt_count  = calloc((size_t)G + 1, sizeof(double));
+    double* hyp_count = calloc((size_t)H + 1, sizeof(double));
+    double* id_pairs  = calloc(GH + 1, sizeof(double));   /* frames with IoU >= MOT_IOU */
+    double* potential = calloc(GH + 1, sizeof(double));   /* HOTA global alignment */
+    double* matches   = calloc(GH * MOT_ALPHAS + 1, sizeof(double));
+    int*    prev_ts   = malloc(sizeof(int) * ((size_t)G + 1));
+    int*    last      = malloc(sizeof(int) * ((size_t)G + 1));
+    int*    gt_col    = malloc(sizeof(int) * ((size_t)(G > MOT_MAX_BOXES ? G : MOT_MAX_BOXES) + 1));
+    double* sc        = malloc(sizeof(double) * MOT_MAX_BOXES * MOT_MAX_BOXES);
+    double  rsum[MOT_MAX_BOXES], csum[MOT_MAX_BOXES];
+    long    tp_a[MOT_ALPHAS] = {0};
+    double  loc_a[MOT_ALPHAS] = {0};
+    int ok = gt_count && hyp_count && id_pairs && potential && matches && prev_ts && last && gt_col && sc;
+    if (!ok) goto done;
+    for (int g = 0; g < G; ++g) { prev_ts[g] = -1; last[g] = -1; }
+
+    /* pass 1: CLEAR MOT, identity co-occurrence, HOTA alignment potential */
+    double motp_sum = 0.0;
+    for (long k = 0; k < g_mot.nframes; ++k) {
+        const MotFrame* f = &g_mot.frames[k];
+        const int* gi = g_mot.ids + f->id_off;
+        const int* hi = gi + f->ngt;
+        const float* S = g_mot.sim + f->sim_off;
+        const int ng = f->ngt, nh = f->nhyp;
+        s->gt_dets += ng;
+        s->hyp_dets += nh;
+        for (int i = 0; i < ng; ++i) gt_count[gi[i]] += 1.0;
+        for (int j = 0; j < nh; ++j) hyp_count[hi[j]] += 1.0;
+
+        for (int i = 0; i < ng; ++i) rsum[i] = 0.0;
+        for (int j = 0; j < nh; ++j) csum[j] = 0.0;
+        for (int i = 0; i < ng; ++i)
+            for (int j = 0; j < nh; ++j) { rsum[i] += S[i * nh + j]; csum[j] += S[i * nh + j]; }
+        for (int i = 0; i < ng; ++i) {
+            for (int j = 0; j < nh; ++j) {
+                double v = S[i * nh + j];
+                size_t gh = (size_t)gi[i] * H + hi[j];
+                if (v >= MOT_IOU) id_pairs[gh] += 1.0;
+                double den = rsum[i] + csum[j] - v;
+                if (den > MOT_EPS) potential[gh] += v / den;
+                /* keep last frame's correspondences while they still overlap */
+                sc[i * nh + j] = v >= MOT_IOU ? v + (prev_ts[gi[i]] == hi[j] ? 1000.0 : 0.0) : 0.0;
+            }
+        }
+        assign_max(sc, ng, nh, gt_col);
+        for (int g = 0; g < G; ++g) prev_ts[g] = -1;
+        for (int i = 0; i < ng; ++i) {
+            if (gt_col[i] < 0) continue;
+            int g = gi[i], h = hi[gt_col[i]];
+            s->tp++;
+            motp_sum += S[i * nh + gt_col[i]];
+            if (last[g] >= 0 && last[g] != h) s->idsw++;
+            last[g] = h;
+            prev_ts[g] = h;
+        }
+    }
+    const long fn = s->gt_dets - s->tp, fp = s->hyp_dets - s->tp;
+    s->mota = s->gt_dets ? 1.0 - (double)(fn + fp + s->idsw) / (double)s->gt_dets : 0.0;
+    s->motp = s->tp ? motp_sum / (double)s->tp : 0.0;
+
+    /* identity: one global GT id <-> track id assignment maximising IDTP */
+    if (G > 0 && H > 0) {
+        assign_max(id_pairs, G, H, gt_col);
+        for (int g = 0; g < G; ++g)
+            if (gt_col[g] >= 0) s->idtp += id_pairs[(size_t)g * H + gt_col[g]];
+    }
+    if (s->gt_dets + s->hyp_dets > 0) s->idf1 = 2.0 * s->idtp / (double)(s->gt_dets + s->hyp_dets);
+    s->idp = s->hyp_dets ? s->idtp / (double)s->hyp_dets : 0.0;
+    s->idr = s->gt_dets ? s->idtp / (double)s->gt_dets : 0.0;
+
+    /* pass 2: HOTA, frames matched on alignment-weighted IoU */
+    for (size_t gh = 0; gh < GH; ++gh) {
+        int g = (int)(gh / (size_t)H), h = (int)(gh % (size_t)H);
+        potential[gh] = potential[gh] / (gt_count[g] + hyp_count[h] - potential[gh]);
+    }
+    for (long k = 0; k < g_mot.nframes; ++k) {
+        const MotFrame* f = &g_mot.frames[k];
+        const int* gi = g_mot.ids + f->id_off;
+        const int* hi = gi + f->ngt;
+        const float* S = g_mot.sim + f->sim_off;
+        const int ng = f->ngt, nh = f->nhyp;
+        for (int i = 0; i < ng; ++i)
+            for (int j = 0; j < nh; ++j)
+                sc[i * nh + j] = potential[(size_t)gi[i] * H + hi[j]] * S[i * nh + j];
+        assign_max(sc, ng, nh, gt_col);
+        for (int i = 0; i < ng; ++i) {
+            if (gt_col[i] < 0) continue;
+            double v = S[i * nh + gt_col[i]];
+            size_t gh = (size_t)gi[i] * H + hi[gt_col[i]];
+            for (int a = 0; a < MOT_ALPHAS; ++a) {
+                if (v < 0.05 * (a + 1) - MOT_EPS) break;
+                tp_a[a]++;
+                loc_a[a] += v;
+                matches[(size_t)a * GH + gh] += 1.0;
+            }
+        }
+    }
+    for (int a = 0; a < MOT_ALPHAS; ++a) {
+        double ass = 0.0;
+        for (size_t gh = 0; gh < GH; ++gh) {
+            double m = matches[(size_t)a * GH + gh];
+            if (m <= 0.0) continue;
+            int g = (int)(gh / (size_t)H), h = (int)(gh % (size_t)H);
+            ass += m * m / (gt_count[g] + hyp_count[h] - m);
+        }
+        double det_den = (double)(s->gt_dets + s->hyp_dets - tp_a[a]);
+        s->assa[a] = tp_a[a] ? ass / (double)tp_a[a] : 0.0;
+        s->deta[a] = det_den > 0.0 ? (double)tp_a[a] / det_den : 0.0;
+        s->loca[a] = tp_a[a] ? loc_a[a] / (double)tp_a[a] : 0.0;
+        s->hota[a] = sqrt(s->deta[a] * s->assa[a]);
+        s->hota_mean += s->hota[a] / MOT_ALPHAS;
+        s->deta_mean += s->deta[a] / MOT_ALPHAS;
+        s->assa_mean += s->assa[a] / MOT_ALPHAS;
+        s->loca_mean += s->loca[a] / MOT_ALPHAS;
+    }
+
+done:
+    free(gt_count); free(hyp_count); free(id_pairs); free(potential); free(matches);
+    free(prev_ts); free(last); free(gt_col); free(sc);
+    return ok;
+}
+
+bool mot_close(void) {
+    if (!g_mot.running) return true;
+    g_mot.running = 0;
+
+    MotScore s;
+    bool ok = score_run(&s) != 0;
+    if (!ok) fprintf(stderr, "[MOT] out of memory while scoring\n");
+
+    static const double ps[4] = { 50.0, 95.0, 99.0, 100.0 };
+    double cpu[4];
+    latwin_percentiles(&g_mot.cpu, ps, cpu, 4);
+    const double per_frame = g_mot.nframes ? g_mot.cpu_total / (double)g_mot.nframes : 0.0;
+
+    FILE* fp = ok ? fopen(g_mot.path, "w") : NULL;
+    if (fp) {
+        const long fn = s.gt_dets - s.tp, fpos = s.hyp_dets - s.tp;
+        fprintf(fp, "{\n  \"frames\": %ld,\n  \"track_every\": %d,\n  \"iou\": %.2f,\n",
+                g_mot.nframes, g_mot.track_every, MOT_IOU);
+        fprintf(fp, "  \"gt_ids\": %d,\n  \"track_ids\": %d,\n  \"gt_dets\": %ld,\n  \"track_dets\": %ld,\n",
+                g_mot.gt_map.n, g_mot.hyp_map.n, s.gt_dets, s.hyp_dets);
+        fprintf(fp, "  \"summary\": { \"hota\": %.4f, \"mota\": %.4f, \"idf1\": %.4f, \"idsw\": %ld, "
+                    "\"tracker_cpu_ms_per_frame\": %.4f },\n",
+                s.hota_mean, s.mota, s.idf1, s.idsw, per_frame);
+        fprintf(fp, "  \"clear\": { \"mota\": %.4f, \"motp\": %.4f, \"tp\": %ld, \"fp\": %ld, \"fn\": %ld, "
+                    "\"idsw\": %ld },\n", s.mota, s.motp, s.tp, fpos, fn, s.idsw);
+        fprintf(fp, "  \"identity\": { \"idf1\": %.4f, \"idp\": %.4f, \"idr\": %.4f, \"idtp\": %.0f, "
+                    "\"idfp\": %.0f, \"idfn\": %.0f },\n",
+                s.idf1, s.idp, s.idr, s.idtp, (double)s.hyp_dets - s.idtp, (double)s.gt_dets - s.idtp);
+        fprintf(fp, "  \"hota\": { \"hota\": %.4f, \"deta\": %.4f, \"assa\": %.4f, \"loca\": %.4f, \"alphas\": [\n",
+                s.hota_mean, s.deta_mean, s.assa_mean, s.loca_mean);
+        for (int a = 0; a < MOT_ALPHAS; ++a)
+            fprintf(fp, "    { \"alpha\": %.2f, \"hota\": %.4f, \"deta\": %.4f, \"assa\": %.4f }%s\n",
+                    0.05 * (a + 1), s.hota[a], s.deta[a], s.assa[a], a + 1 < MOT_ALPHAS ? "," : "");
+        fprintf(fp, "  ] },\n");
+        fprintf(fp, "  \"tracker_cpu_ms\": { \"runs\": %ld, \"per_frame\": %.4f, \"mean\": %.4f, "
+                    "\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }\n}\n",
+                g_mot.cpu_runs, per_frame, g_mot.cpu_runs ? g_mot.cpu_total / (double)g_mot.cpu_runs : 0.0,
+                cpu[0], cpu[1], cpu[2], cpu[3]);
+        ok = fclose(fp) == 0;
+    } else {
+        ok = false;
+    }
+    if (ok)
+        printf("[MOT] %ld frames: HOTA %.4f MOTA %.4f IDF1 %.4f, %ld ID switches, tracker %.4f ms CPU/frame -> %s\n",
+               g_mot.nframes, s.hota_mean, s.mota, s.idf1, s.idsw, per_frame, g_mot.path);
+    else
+        fprintf(stderr, "[MOT] writing %s failed\n", g_mot.path);
+
+    latwin_free(&g_mot.cpu);
+    free(g_mot.frames); free(g_mot.ids); free(g_mot.sim);
+    free(g_mot.gt_map.dense); free(g_mot.hyp_map.dense);
+    free(g_mot.path);
+    memset(&g_mot, 0, sizeof(g_mot));
+    return ok;
+}
@@ -1,9 +1,11 @@
+#define _GNU_SOURCE
 #include "onnx.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include "onnxruntime_c_api.h"
+#include "infer_cache.h"
 
 /* ---------------- Dahili Yardımcılar ---------------- */
 
@@ -37,6 +39,30 @@ typedef struct {
     int cls;
 } RawDet;
 
+/* Ham çıktı satırlarını [x1,y1,x2,y2,score,cls] -> OnnxDet; eşiğin altı atılır */
+static int decode_raw_detections(const float* out_data, int num_det, int elem_per_det, float score_thresh,
+                                 OnnxDet** out_dets, int* out_count) {
+    OnnxDet* dets = (OnnxDet*)malloc(sizeof(OnnxDet) * (num_det > 0 ? num_det : 1));
+    if (!dets) return ONNX_ERR_MEMORY;
+
+    int n = 0;
+    for (int i = 0; i < num_det; ++i) {
+        const float* row = out_data + (size_t)i * elem_per_det;
+        if (row[4] < score_thresh) continue;
+        dets[n].x1 = row[0];
+        dets[n].y1 = row[1];
+        dets[n].x2 = row[2];
+        dets[n].y2 = row[3];
+        dets[n].score = row[4];
+        dets[n].cls = (int)row[5];
+        n++;
+    }
+
+    *out_dets = dets;
+    *out_count = n;
+    return ONNX_OK;
+}
+
 /* ---------------- Dış API Uygulamaları ---------------- */
 
 OnnxConfig onnx_default_config(void) {
@@ -46,6 +72,7 @@ OnnxConfig onnx_default_config(void) {
     c.score_thresh = 0.30f;
     c.nms_iou_thresh = 0.45f;
     c.verbose = 0;
+    c.profile_prefix = NULL;
     return c;
 }
 
@@ -64,6 +91,8 @@ int onnx_load_model(OnnxDetector* detector, const char* model_path, const OnnxCo
     ORT_CALL(detector, detector->api->SetIntraOpNumThreads(detector->session_opts, detector->cfg.intra_threads));
     ORT_CALL(detector, detector->api->SetInterOpNumThreads(detector->session_opts, detector->cfg.inter_threads));
     ORT_CALL(detector, detector->api->SetSessionGraphOptimizationLevel(detector->session_opts, ORT_ENABLE_ALL));
+    if (detector->cfg.profile_prefix)
+        ORT_CALL(detector, detector->api->EnableProfiling(detector->session_opts, detector->cfg.profile_prefix));
 
     ORT_CALL(detector, detector->api->CreateSession(detector->env, model_path, detector->session_opts, &detector->session));
     ORT_CALL(detector, detector->api->GetAllocatorWithDefaultOptions(&detector->allocator));
@@ -93,15 +122,27 @@ int onnx_load_model(OnnxDetector* detector, const char* model_path, const OnnxCo
     }
     int64_t dims[4];
     ORT_CALL(detector, detector->api->GetDimensions(tshape, dims, 4));
-    detector->in_n = dims[0];
-    detector->in_c = dims[1];
-    detector->in_h = dims[2];
-    detector->in_w = dims[3];
+    ONNXTensorElementDataType in_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    ORT_CALL(detector, detector->api->GetTensorElementType(tshape, &in_type));
+
+    if (in_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8) {
+        /* Ön işleme grafiğe gömülü: [1,H,W,4] RGBA */
+        detector->in_u8 = 1;
+        detector->in_n = dims[0];
+        detector->in_h = dims[1];
+        detector->in_w = dims[2];
+        detector->in_c = dims[3];
+    } else {
+        detector->in_n = dims[0];
+        detector->in_c = dims[1];
+        detector->in_h = dims[2];
+        detector->in_w = dims[3];
+    }
 
     detector->api->ReleaseTypeInfo(ti);
 
-    if (detector->in_n != 1 || detector->in_c != 3) {
-        LOG_IF(detector, "Şu an sadece N=1, C=3 destekleniyor\n");
+    if (detector->in_n != 1 || detector->in_c != (detector->in_u8 ? 4 : 3)) {
+        LOG_IF(detector, "Şu an sadece N=1, C=3 (float) veya C=4 (uint8 RGBA) destekleniyor\n");
         return ONNX_ERR_MODEL;
     }
 
@@ -115,8 +156,12 @@ int onnx_load_model(OnnxDetector* detector, const char* model_path, const OnnxCo
     ORT_CALL(detector, detector->api->SessionGetOutputName(detector->session, 0, detector->allocator, &detector->output_name));
 
     LOG_IF(detector, "Model yüklendi: %s\n", model_path);
-    LOG_IF(detector, "Input name: %s  Shape: [1,3,%lld,%lld]\n",
-          detector->input_name, (long long)detector->in_h, (long long)detector->in_w);
+    if (detector->in_u8)
+        LOG_IF(detector, "Input name: %s  Shape: [1,%lld,%lld,4] uint8 RGBA\n",
+              detector->input_name, (long long)detector->in_h, (long long)detector->in_w);
+    else
+        LOG_IF(detector, "Input name: %s  Shape: [1,3,%lld,%lld]\n",
+              detector->input_name, (long long)detector->in_h, (long long)detector->in_w);
     LOG_IF(detector, "Output name: %s\n", detector->output_name);
 
     return ONNX_OK;
@@ -131,19 +176,42 @@ int onnx_predict(const OnnxDetector* detector,
     *out_dets = NULL;
     *out_count = 0;
 
-    int target_w = (int)detector->in_w;
-    int target_h = (int)detector->in_h;
+    /* Dinamik boyutlu modeller (-1) girdinin boyutunu alır */
+    int target_w = detector->in_w > 0 ? (int)detector->in_w : w;
+    int target_h = detector->in_h > 0 ? (int)detector->in_h : h;
+    if (w != target_w || h != target_h) return ONNX_ERR_INVALID_ARG;
+
+    size_t tensor_elems = (size_t)detector->in_c * target_h * target_w;
+    int64_t shape[4] = {1, 3, target_h, target_w};
+    size_t tensor_bytes = sizeof(float) * tensor_elems;
+    ONNXTensorElementDataType tensor_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+
+    if (detector->in_u8) {
+        /* Ham RGBA readback; çevirme/gri/normalizasyon grafikte */
+        shape[1] = target_h;
+        shape[2] = target_w;
+        shape[3] = 4;
+        tensor_bytes = tensor_elems;
+        tensor_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8;
+    }
 
-    size_t tensor_elems = (size_t)detector->in_c * detector->in_h * detector->in_w;
-    int64_t shape[4] = {1, 3, detector->in_h, detector->in_w};
+    /* Aynı girdi daha önce görüldüyse ORT'yi hiç çağırma */
+    uint64_t cache_key = 0;
+    if (detector->cache) {
+        const float* cached = NULL;
+        int rows = 0, cols = 0;
+        cache_key = infer_cache_hash(img_rgb, tensor_bytes);
+        if (infer_cache_lookup(detector->cache, cache_key, &cached, &rows, &cols))
+            return decode_raw_detections(cached, rows, cols, detector->cfg.score_thresh, out_dets, out_count);
+    }
 
     OrtValue* input_tensor = NULL;
     OrtStatus* st = detector->api->CreateTensorWithDataAsOrtValue(
         detector->mem_info,
         (void*)img_rgb,
-        sizeof(float) * tensor_elems,
+        tensor_bytes,
         shape, 4,
-        ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT,
+        tensor_type,
         &input_tensor
     );
     if (st) {
@@ -191,38 +259,28 @@ int onnx_predict(const OnnxDetector* detector,
     float* out_data = NULL;
     detector->api->GetTensorMutableData(output_tensor, (void**)&out_data);
 
-    OnnxDet* dets = (OnnxDet*)malloc(sizeof(OnnxDet) * num_det);
-    if (!dets) {
-        detector->api->ReleaseTensorTypeAndShapeInfo(oinfo);
-        detector->api->ReleaseValue(output_tensor);
-        detector->api->ReleaseValue(input_tensor);
-        return ONNX_ERR_MEMORY;
-    }
-
-    for (int i = 0; i < num_det; ++i) {
-        float x1 = out_data[i * elem_per_det + 0];
-        float y1 = out_data[i * elem_per_det + 1];
-        float x2 = out_data[i * elem_per_det + 2];
-        float y2 = out_data[i * elem_per_det + 3];
-        float score = out_data[i * elem_per_det + 4];
-        int cls = (int)out_data[i * elem_per_det + 5];
-
-        dets[i].x1 = x1;
-        dets[i].y1 = y1;
-        dets[i].x2 = x2;
-        dets[i].y2 = y2;
-        dets[i].score = score;
-        dets[i].cls = cls;
-    }
-
-    *out_dets = dets;
-    *out_count = num_det;
+    int rc = decode_raw_detections(out_data, num_det, elem_per_det, detector->cfg.score_thresh, out_dets,
+                                   out_count);
+    if (rc == ONNX_OK && detector->cache)
+        infer_cache_store(detector->cache, cache_key, out_data, num_det, elem_per_det);
 
     detector->api->ReleaseTensorTypeAndShapeInfo(oinfo);
     detector->api->ReleaseValue(output_tensor);
     detector->api->ReleaseValue(input_tensor);
 
-    return ONNX_OK;
+    return rc;
+}
+
+int onnx_end_profiling(OnnxDetector* detector, char** out_path, uint64_t* start_ns) {
+    if (!detector || !detector->session || !detector->cfg.profile_prefix || !out_path || !start_ns)
+        return ONNX_ERR_INVALID_ARG;
+    char* path = NULL;
+    ORT_CALL(detector, detector->api->SessionGetProfilingStartTimeNs(detector->session, start_ns));
+    ORT_CALL(detector, detector->api->SessionEndProfiling(detector->session, detector->allocator, &path));
+    *out_path = path ? strdup(path) : NULL;
+    if (path) detector->allocator->Free(detector->allocator, path);
+    detector->cfg.profile_prefix = NULL;   /* ended once */
+    return *out_path ? ONNX_OK : ONNX_ERR_MEMORY;
 }
 
 void onnx_destroy(OnnxDetector* detector) {
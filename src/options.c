@@ -0,0 +1,303 @@
+#define _GNU_SOURCE
+#include "options.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+AppOptions g_opts;
+
+void default_options(AppOptions *o) {
+    memset(o, 0, sizeof(*o));
+    o->headless      = false;
+    o->max_frames    = 0;
+    o->vsync         = USE_VSYNC != 0;
+    o->target_fps    = TARGET_FPS;
+    o->fixed_hz      = 0.0;
+    o->time_warp     = 1.0;
+    o->shadow_sample = 10;
+    o->track_every   = 1;
+    o->video_downscale = 1;
+    o->detect_every  = 1;
+    o->blackbox_seconds  = 10.0;
+    o->blackbox_spike_ms = 100.0;
+
+    // Environment variables predate the flags; keep them working
+    const char *env;
+    if ((env = getenv("DET_INFER_CACHE")) && *env) o->infer_cache = env;
+    if ((env = getenv("SHADOW_MODEL")) && *env)    o->shadow_model = env;
+    if ((env = getenv("SHADOW_SAMPLE")) && atoi(env) > 0) o->shadow_sample = atoi(env);
+}
+
+void print_usage(const char *argv0) {
+    printf("Usage: %s [options]\n"
+           "  --headless             render offscreen through EGL (no window, uncapped)\n"
+           "  --frames N             exit after N frames\n"
+           "  --no-vsync             disable vsync (windowed)\n"
+           "  --fps F                frame cap when vsync is off (windowed)\n"
+           "  --fixed-step HZ        deterministic fixed-step simulation at HZ steps/s\n"
+           "  --time-warp X          simulate X seconds per real second (headless\n"
+           "                         fixed-step: X steps per rendered frame)\n"
+           "  --seed N               randomize start position, heading, enemy formation\n"
+           "                         and autopilot phase (0 = stock start)\n"
+           "  --scenario FILE        aircraft count, spawn patterns, trajectories, camera\n"
+           "                         script and default flags (see scenario.h)\n"
+           "  --aircraft N           total aircraft incl. the player (scenario or stock\n"
+           "                         formation plus a grid)\n"
+           "  --record FILE          record per-frame inputs for exact replay\n"
+           "  --replay FILE          replay a recording (runs uncapped, ends with it)\n"
+           "  --replay-from N        step the first N recorded frames without drawing\n"
+           "                         (frame numbers still count from the start)\n"
+           "  --snapshot-load FILE   start from a saved simulation state\n"
+           "  --snapshot-save FILE   save the simulation state (at exit, or see below)\n"
+           "  --snapshot-at N        save the snapshot after frame N\n"
+           "  --video FILE           write the annotated frames to FILE (.y4m, lossless .fcv,\n"
+           "                         else raw rgb24)\n"
+           "  --video-downscale N    record at 1/N size per side (1..4, default 1)\n"
+           "  --blackbox DIR         keep the last seconds in memory, dump to DIR on\n"
+           "                         crash or frame-time spike\n"
+           "  --blackbox-seconds S   history length (default 10)\n"
+           "  --blackbox-spike-ms MS frame time that triggers a dump (default 100, 0 = off)\n"
+           "  --hud                  show the performance HUD (H toggles it)\n"
+           "  --metrics PATH         counters and latency histograms as JSONL; a file, or\n"
+           "                         unix:/path for a listening Unix socket\n"
+           "  --metrics-interval S   seconds between metric lines (default 1)\n"
+           "  --trace FILE           Chrome/Perfetto trace: CPU spans, GPU timer queries\n"
+           "                         and ONNX Runtime operators on one timeline\n"
+           "  --profile FILE         machine profile from autotune (default: ./tune.profile\n"
+           "                         if present, \"none\" to skip)\n"
+           "  --model PATH           detector model (\"none\" = sky-blob fallback)\n"
+           "  --det-size N           detector input side; must match fixed-shape models\n"
+           "  --intra-threads N      ONNX Runtime intra-op threads\n"
+           "  --inter-threads N      ONNX Runtime inter-op threads\n"
+           "  --detect-every N       run the detector every Nth frame, hold boxes between\n"
+           "  --infer-cache FILE     memoize detector outputs in FILE\n"
+           "  --detlog FILE          append detections, tracks and stage timings to a\n"
+           "                         columnar log (query with detlog_query)\n"
+           "  --eval FILE            score detections against simulator ground truth\n"
+           "                         (precision/recall/mAP, stage latencies) as JSON\n"
+           "  --mot FILE             score the tracker against plane identities (MOTA,\n"
+           "                         IDF1, HOTA, tracker CPU time) as JSON\n"
+           "  --track-every N        run the tracker every Nth frame (default 1)\n"
+           "  --shadow-model FILE    run FILE as a shadow candidate model\n"
+           "  --shadow-sample N      offer every Nth detection frame to the candidate\n"
+           "  --batch PATH           detect + track offline over an image directory\n"
+           "                         or .y4m/.fcv file, then exit (no GL)\n"
+           "  --batch-out FILE       batch CSV output (default: stdout)\n"
+           "  --threads N            batch workers / dataset writer threads\n"
+           "  --dataset DIR          export detection frames + YOLO ground-truth labels\n"
+           "  --dataset-format F     jpg (default), png or qoi (lossless, fast)\n"
+           "  -h, --help             show this help\n",
+           argv0);
+}
+
+// "--flag value" helper; reports a missing value
+static const char *next_value(int argc, char **argv, int *i) {
+    if (*i + 1 >= argc) {
+        fprintf(stderr, "Missing value for %s\n", argv[*i]);
+        return NULL;
+    }
+    return argv[++*i];
+}
+
+bool parse_options(int argc, char **argv, AppOptions *o, int *exit_code) {
+    *exit_code = 0;
+    int i;
+    for (i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        const char *v = NULL;
+
+        if (!strcmp(a, "-h") || !strcmp(a, "--help")) {
+            print_usage(argv[0]);
+            return false;
+        } else if (!strcmp(a, "--headless")) {
+            o->headless = true;
+        } else if (!strcmp(a, "--no-vsync")) {
+            o->vsync = false;
+        } else if (!strcmp(a, "--frames")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->max_frames = atol(v);
+        } else if (!strcmp(a, "--fps")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->target_fps = atof(v);
+        } else if (!strcmp(a, "--fixed-step")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->fixed_hz = atof(v) > 0.0 ? atof(v) : 0.0;
+        } else if (!strcmp(a, "--time-warp")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->time_warp = atof(v);
+            if (o->time_warp <= 0.0) {
+                fprintf(stderr, "--time-warp must be > 0\n");
+                *exit_code = 2;
+                return false;
+            }
+        } else if (!strcmp(a, "--seed")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->seed = strtoull(v, NULL, 10);
+        } else if (!strcmp(a, "--scenario")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->scenario_path = v;
+        } else if (!strcmp(a, "--aircraft")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->aircraft = atoi(v) > 0 ? atoi(v) : 0;
+        } else if (!strcmp(a, "--record")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->record_path = v;
+        } else if (!strcmp(a, "--replay")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->replay_path = v;
+        } else if (!strcmp(a, "--replay-from")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->replay_from = atol(v) > 0 ? atol(v) : 0;
+        } else if (!strcmp(a, "--snapshot-load")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->snapshot_load = v;
+        } else if (!strcmp(a, "--snapshot-save")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->snapshot_save = v;
+        } else if (!strcmp(a, "--snapshot-at")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->snapshot_at = atol(v);
+        } else if (!strcmp(a, "--video")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->video_path = v;
+        } else if (!strcmp(a, "--video-downscale")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->video_downscale = atoi(v);
+        } else if (!strcmp(a, "--blackbox")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->blackbox_dir = v;
+        } else if (!strcmp(a, "--blackbox-seconds")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->blackbox_seconds = atof(v) > 0.0 ? atof(v) : 10.0;
+        } else if (!strcmp(a, "--blackbox-spike-ms")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->blackbox_spike_ms = atof(v) > 0.0 ? atof(v) : 0.0;
+        } else if (!strcmp(a, "--detlog")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->detlog_path = v;
+        } else if (!strcmp(a, "--eval")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->eval_path = v;
+        } else if (!strcmp(a, "--mot")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->mot_path = v;
+        } else if (!strcmp(a, "--track-every")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->track_every = atoi(v) > 0 ? atoi(v) : 1;
+        } else if (!strcmp(a, "--hud")) {
+            o->hud = true;
+        } else if (!strcmp(a, "--metrics")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->metrics_target = v;
+        } else if (!strcmp(a, "--metrics-interval")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->metrics_interval = atof(v) > 0.0 ? atof(v) : 0.0;
+        } else if (!strcmp(a, "--trace")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->trace_path = v;
+        } else if (!strcmp(a, "--profile")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->profile_path = v;
+        } else if (!strcmp(a, "--model")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->model_path = v;
+        } else if (!strcmp(a, "--det-size")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->det_size = atoi(v);
+            if (o->det_size < 64 || o->det_size > 2048 || o->det_size % 32) {
+                fprintf(stderr, "--det-size must be a multiple of 32 in 64..2048\n");
+                *exit_code = 2;
+                return false;
+            }
+        } else if (!strcmp(a, "--intra-threads")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->intra_threads = atoi(v) > 0 ? atoi(v) : 0;
+        } else if (!strcmp(a, "--inter-threads")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->inter_threads = atoi(v) > 0 ? atoi(v) : 0;
+        } else if (!strcmp(a, "--detect-every")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->detect_every = atoi(v) > 0 ? atoi(v) : 1;
+        } else if (!strcmp(a, "--infer-cache")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->infer_cache = v;
+        } else if (!strcmp(a, "--shadow-model")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->shadow_model = v;
+        } else if (!strcmp(a, "--shadow-sample")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->shadow_sample = atoi(v) > 0 ? atoi(v) : 1;
+        } else if (!strcmp(a, "--batch")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->batch_input = v;
+        } else if (!strcmp(a, "--batch-out")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->batch_out = v;
+        } else if (!strcmp(a, "--dataset")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->dataset_dir = v;
+        } else if (!strcmp(a, "--dataset-format")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->dataset_format = v;
+        } else if (!strcmp(a, "--threads")) {
+            if (!(v = next_value(argc, argv, &i))) break;
+            o->threads = atoi(v) > 0 ? atoi(v) : 0;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", a);
+            print_usage(argv[0]);
+            *exit_code = 2;
+            return false;
+        }
+    }
+    if (i < argc) {         // loop left early: a flag was missing its value
+        *exit_code = 2;
+        return false;
+    }
+    return true;
+}
+
+bool load_profile(const char *path, AppOptions *o, int *exit_code) {
+    *exit_code = 0;
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "[PROFILE] cannot open %s\n", path);
+        *exit_code = 2;
+        return false;
+    }
+    // The tokens stay referenced by *o (paths), so they live until exit
+    enum { MAX_TOKENS = 64 };
+    static char *argv[MAX_TOKENS + 1];
+    int argc = 0;
+    argv[argc++] = (char *)path;
+
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        char host[256], me[256];
+        if (sscanf(line, "# host %255s", host) == 1 && gethostname(me, sizeof(me)) == 0) {
+            me[sizeof(me) - 1] = '\0';
+            if (strcmp(host, me))
+                fprintf(stderr, "[PROFILE] %s was tuned on %s, this is %s; rerun autotune\n", path, host, me);
+        }
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        for (char *t = strtok(line, " \t\r\n"); t; t = strtok(NULL, " \t\r\n")) {
+            if (argc == MAX_TOKENS) {
+                fprintf(stderr, "[PROFILE] %s: too many flags\n", path);
+                fclose(f);
+                *exit_code = 2;
+                return false;
+            }
+            argv[argc++] = strdup(t);
+        }
+    }
+    fclose(f);
+    argv[argc] = NULL;
+    if (!parse_options(argc, argv, o, exit_code)) {
+        if (!*exit_code) *exit_code = 2;
+        return false;
+    }
+    printf("[PROFILE] %s: %d flag tokens\n", path, argc - 1);
+    return true;
+}
@@ -11,32 +11,16 @@
 #include <string.h>
 
 
-typedef enum {
-    FLY_STRAIGHT,
-    TURN_LEFT,
-    TURN_RIGHT,
-    AUTO_PITCH_UP,
-    AUTO_PITCH_DOWN,
-    SET_SPEED,
-    TOGGLE_SPEED_LOCK,
-    SET_CAMERA,
-    HOLD_ZOOM,
-    TOGGLE_GRID_VIEW
-} AutopilotAction;
-
-typedef struct {
-    AutopilotAction action;
-    float duration;
-    float value;
-} AutopilotCommand;
-
 static const float MAX_PITCH_ANGLE_DEGREES = 135.0f;
 static const float PITCH_SMOOTHING_RANGE   = 30.0f;
 
 static GLuint shaderProgram = 0;
+static GLuint idShaderProgram = 0;     /* flat ID color, instance-ID pass */
 static GLuint VBO = 0, NBO = 0, TBO = 0;
 static GLuint planeTextureID = 0;
 static GLsizei planeDrawCount = 0;
+static vec3    planeBoundsMin = {0.0f, 0.0f, 0.0f};   /* model-space AABB */
+static vec3    planeBoundsMax = {0.0f, 0.0f, 0.0f};
 
 static tinyobj_attrib_t    planeAttrib;
 static tinyobj_shape_t    *planeShapes = NULL;
@@ -90,7 +74,7 @@ static char* preprocess_obj_strip_vertex_colors(const char* input, size_t in_len
 }
 
 
-Plane planes[MAX_PLANES] = {
+static Plane stock_planes[MAX_PLANES] = {
                    {.position = {0.0f, 500.0f, 50.0f},
                     .front = {0.0f, 0.0f, -1.0f},
                     .up = {0.0f, 1.0f, 0.0f},
@@ -177,7 +161,10 @@ Plane planes[MAX_PLANES] = {
                     .shadeStrength = 0.6f}
 };
 
-static AutopilotCommand flight_plan[] = {
+Plane *planes      = stock_planes;
+int    plane_count = MAX_PLANES;
+
+static const AutopilotCommand stock_flight_plan[] = {
     {FLY_STRAIGHT, 2.0f, 0.0f},     {TURN_LEFT, 3.0f, 0.0f},        {SET_CAMERA, 0.0f, 5.0f},
     {FLY_STRAIGHT, 3.0f, 0.0f},     {SET_CAMERA, 1.0f, 1.0f},       {SET_SPEED, 2.0f, 300.0f},
     {FLY_STRAIGHT, 2.0f, 0.0f},     {TURN_LEFT, 8.0f, 0.0f},        {FLY_STRAIGHT, 2.0f, 0.0f},
@@ -192,7 +179,8 @@ static AutopilotCommand flight_plan[] = {
     {FLY_STRAIGHT, 3.0f, 0.0f},     {SET_CAMERA, 0.0f, 7.0f},
     {FLY_STRAIGHT, 1.0f, 0.0f},     {TOGGLE_SPEED_LOCK, 0.0f, 0.0f}
 };
-static const int numCommands = (int)(sizeof(flight_plan) / sizeof(AutopilotCommand));
+static const AutopilotCommand *flight_plan = stock_flight_plan;
+static int numCommands = (int)(sizeof(stock_flight_plan) / sizeof(AutopilotCommand));
 
 static const GLchar *planeVertexSource =
     "#version 100\n"
@@ -235,6 +223,23 @@ static const GLchar *planeFragmentSource =
     "   gl_FragColor = vec4(finalColor * diffuse, 1.0);\n"
     "}\n";
 
+/* Instance-ID pass: position only, constant R = id / 255 */
+static const GLchar *planeIdVertexSource =
+    "#version 100\n"
+    "attribute vec3 position;\n"
+    "uniform mat4 mvp;\n"
+    "void main() {\n"
+    "   gl_Position = mvp * vec4(position, 1.0);\n"
+    "}\n";
+
+static const GLchar *planeIdFragmentSource =
+    "#version 100\n"
+    "precision mediump float;\n"
+    "uniform float u_id;\n"
+    "void main() {\n"
+    "   gl_FragColor = vec4(u_id / 255.0, 0.0, 0.0, 1.0);\n"
+    "}\n";
+
 void file_reader_callback_impl(void *ctx, const char *filename, int is_mtl,
                                const char *obj_filename, char **buf, size_t *len) {
     (void)ctx; (void)is_mtl;
@@ -281,6 +286,7 @@ bool init_plane(void) {
     shaderProgram = createShaderProgram(planeVertexSource, planeFragmentSource);
     if (shaderProgram == 0)
         return false;
+    idShaderProgram = createShaderProgram(planeIdVertexSource, planeIdFragmentSource);
 
     const char *plane_obj_path = "./images/plane.obj";
     int ret = tinyobj_parse_obj(&planeAttrib, &planeShapes, &numPlaneShapes,
@@ -311,6 +317,14 @@ bool init_plane(void) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     stbi_image_free(data);
 
+    // Model-space bounds (ground-truth boxes project these)
+    glm_vec3_copy(planeAttrib.vertices, planeBoundsMin);
+    glm_vec3_copy(planeAttrib.vertices, planeBoundsMax);
+    for (unsigned int i = 1; i < planeAttrib.num_vertices; ++i) {
+        glm_vec3_minv(planeBoundsMin, planeAttrib.vertices + i * 3, planeBoundsMin);
+        glm_vec3_maxv(planeBoundsMax, planeAttrib.vertices + i * 3, planeBoundsMax);
+    }
+
     // Build interleaved buffers from tinyobj attrib
     planeDrawCount = (GLsizei)planeAttrib.num_faces;
 
@@ -376,6 +390,10 @@ void update_enemy_plane(Plane *enemy) {
     glm_vec3_scale(enemy->front, enemy->speed * deltaTime, movement);
     glm_vec3_add(enemy->position, movement, enemy->position);
 
+    update_enemy_model_matrix(enemy);
+}
+
+void update_enemy_model_matrix(Plane *enemy) {
     glm_mat4_identity(enemy->modelMatrix);
     glm_translate(enemy->modelMatrix, enemy->position);
 
@@ -383,6 +401,29 @@ void update_enemy_plane(Plane *enemy) {
     glm_rotate(enemy->modelMatrix, yawAngle, (vec3) {0.0f, 1.0f, 0.0f});
 }
 
+void plane_mesh_bounds(vec3 out_min, vec3 out_max) {
+    glm_vec3_copy(planeBoundsMin, out_min);
+    glm_vec3_copy(planeBoundsMax, out_max);
+}
+
+void draw_plane_id(Plane *plane, mat4 view, mat4 proj, int id) {
+    if (!idShaderProgram) return;
+    mat4 mvp;
+    glm_mat4_mul(proj, view, mvp);
+    glm_mat4_mul(mvp, plane->modelMatrix, mvp);
+
+    glUseProgram(idShaderProgram);
+    glUniformMatrix4fv(glGetUniformLocation(idShaderProgram, "mvp"), 1, GL_FALSE, (GLfloat *) mvp);
+    glUniform1f(glGetUniformLocation(idShaderProgram, "u_id"), (float)id);
+
+    GLint posAttrib = glGetAttribLocation(idShaderProgram, "position");
+    glEnableVertexAttribArray(posAttrib);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+    glDrawArrays(GL_TRIANGLES, 0, planeDrawCount);
+    glDisableVertexAttribArray(posAttrib);
+}
+
 void draw_plane(Plane *plane, mat4 view, mat4 proj) {
     glUseProgram(shaderProgram);
     glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, (GLfloat *) plane->modelMatrix);
@@ -496,6 +537,41 @@ void reset_autopilot_state(void) {
     commandTimer = 0.0f;
 }
 
+int autopilot_command_index(void) { return currentCommandIndex; }
+float autopilot_command_timer(void) { return commandTimer; }
+
+int autopilot_command_count(void) { return numCommands; }
+
+void autopilot_set_plan(const AutopilotCommand *commands, int count) {
+    if (commands && count > 0) {
+        flight_plan = commands;
+        numCommands = count;
+    } else {
+        flight_plan = stock_flight_plan;
+        numCommands = (int)(sizeof(stock_flight_plan) / sizeof(AutopilotCommand));
+    }
+    reset_autopilot_state();
+}
+
+bool autopilot_camera_preset(int preset) {
+    switch (preset) {
+        case 1: offset_behind = 400.0f;  offset_above = 170.0f;  offset_right = 0.0f;    return true;
+        case 2: offset_behind = -50.0f;  offset_above = 30.0f;   offset_right = 0.0f;    return true;
+        case 3: offset_behind = 400.0f;  offset_above = 500.0f;  offset_right = 0.0f;    return true;
+        case 4: offset_behind = -300.0f; offset_above = 100.0f;  offset_right = 0.0f;    return true;
+        case 5: offset_behind = -200.0f; offset_above = 150.0f;  offset_right = 250.0f;  return true;
+        case 6: offset_behind = -200.0f; offset_above = 150.0f;  offset_right = -250.0f; return true;
+        case 7: offset_behind = -300.0f; offset_above = -100.0f; offset_right = 0.0f;    return true;
+        case 8: offset_behind = -75.0f;  offset_above = 200.0f;  offset_right = 550.0f;  return true;
+        default: return false;
+    }
+}
+
+void autopilot_set_state(int command_index, float command_timer) {
+    currentCommandIndex = (command_index >= 0 && command_index < numCommands) ? command_index : 0;
+    commandTimer = command_timer;
+}
+
 void autoPilotMode(void) {
     commandTimer += deltaTime;
     AutopilotCommand currentCommand = flight_plan[currentCommandIndex];
@@ -563,23 +639,7 @@ void autoPilotMode(void) {
             if (fov < maximumZoomDistance) fov = maximumZoomDistance;
             break;
         case SET_CAMERA:
-            if (currentCommand.value == 1.0f) {
-                offset_behind = 400.0f; offset_above = 170.0f; offset_right = 0.0f;
-            } else if (currentCommand.value == 2.0f) {
-                offset_behind = -50.0f; offset_above = 30.0f; offset_right = 0.0f;
-            } else if (currentCommand.value == 3.0f) {
-                offset_behind = 400.0f; offset_above = 500.0f; offset_right = 0.0f;
-            } else if (currentCommand.value == 4.0f) {
-                offset_behind = -300.0f; offset_above = 100.0f; offset_right = 0.0f;
-            } else if (currentCommand.value == 5.0f) {
-                offset_behind = -200.0f; offset_above = 150.0f; offset_right = 250.0f;
-            } else if (currentCommand.value == 6.0f) {
-                offset_behind = -200.0f; offset_above = 150.0f; offset_right = -250.0f;
-            } else if (currentCommand.value == 7.0f) {
-                offset_behind = -300.0f; offset_above = -100.0f; offset_right = 0.0f;
-            } else if (currentCommand.value == 8.0f) {
-                offset_behind = -75.0f; offset_above = 200.0f; offset_right = 550.0f;
-            }
+            autopilot_camera_preset((int)currentCommand.value);
             break;
         case TOGGLE_SPEED_LOCK:
             if (commandTimer < deltaTime * 1.5f) {
@@ -611,6 +671,7 @@ void autoPilotMode(void) {
 
 void cleanup_plane(void) {
     if (shaderProgram) glDeleteProgram(shaderProgram);
+    if (idShaderProgram) glDeleteProgram(idShaderProgram);
     if (VBO) glDeleteBuffers(1, &VBO);
     if (NBO) glDeleteBuffers(1, &NBO);
     if (TBO) glDeleteBuffers(1, &TBO);
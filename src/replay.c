@@ -0,0 +1,309 @@
+#define _POSIX_C_SOURCE 200809L
+#include "replay.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* ---------------- Tracked keys ---------------- */
+
+/* Bit i of the key mask <-> s_keys[i]. Append only: the order is part of the file format. */
+static const int s_keys[] = {
+    GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_4,
+    GLFW_KEY_5, GLFW_KEY_6, GLFW_KEY_7, GLFW_KEY_8,
+    GLFW_KEY_A, GLFW_KEY_C, GLFW_KEY_R, GLFW_KEY_S,
+    GLFW_KEY_T, GLFW_KEY_Z, GLFW_KEY_UP, GLFW_KEY_DOWN,
+    GLFW_KEY_LEFT, GLFW_KEY_RIGHT, GLFW_KEY_LEFT_SHIFT, GLFW_KEY_RIGHT_SHIFT,
+    GLFW_KEY_ESCAPE
+};
+#define KEY_COUNT ((int)(sizeof(s_keys) / sizeof(s_keys[0])))
+
+static uint32_t s_key_mask = 0;
+
+static int key_bit(int glfw_key) {
+    for (int i = 0; i < KEY_COUNT; ++i)
+        if (s_keys[i] == glfw_key) return i;
+    return -1;
+}
+
+uint32_t input_poll_keys(GLFWwindow* win) {
+    uint32_t m = 0;
+    if (!win) return 0;
+    for (int i = 0; i < KEY_COUNT; ++i)
+        if (glfwGetKey(win, s_keys[i]) == GLFW_PRESS) m |= 1u << i;
+    return m;
+}
+
+void     input_set_keys(uint32_t mask) { s_key_mask = mask; }
+uint32_t input_keys(void)              { return s_key_mask; }
+
+bool input_key_down(int glfw_key) {
+    int b = key_bit(glfw_key);
+    return b >= 0 && (s_key_mask >> b) & 1u;
+}
+
+/* ---------------- File format ---------------- */
+
+#define REC_MAGIC     0x3130434552544C46ull  /* "FLTREC01" */
+#define REC_END_MAGIC 0x31444E4552544C46ull  /* "FLTREND1" */
+#define REC_VERSION   3u      /* 2: seed, 3: no keyframes / seek index */
+
+#define F_KEYS     0x01u
+#define F_DT       0x02u
+#define F_CMD      0x04u
+#define F_TIMER    0x08u
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t flags;          /* bit0: keyboard */
+    double   fixed_hz;
+    double   time_warp;
+    uint32_t key_count;
+    uint32_t reserved;
+    uint64_t seed;           /* --seed of the recorded run (0 = none) */
+} RecHeader;
+
+typedef struct {
+    uint64_t frame_count;
+    uint64_t magic;
+} RecFooter;
+
+/* Delta reference: zero before the first record, then the previous frame */
+typedef struct {
+    uint32_t keys;
+    uint64_t dt_bits;
+    int32_t  cmd_index;
+    uint32_t timer_bits;
+} RecState;
+
+static uint64_t dbits(double d)  { uint64_t u; memcpy(&u, &d, 8); return u; }
+static double   bitsd(uint64_t u){ double d; memcpy(&d, &u, 8); return d; }
+static uint32_t fbits(float f)   { uint32_t u; memcpy(&u, &f, 4); return u; }
+static float    bitsf(uint32_t u){ float f; memcpy(&f, &u, 4); return f; }
+
+static int put_varint(uint8_t* p, uint64_t v) {
+    int n = 0;
+    while (v >= 0x80) { p[n++] = (uint8_t)(v | 0x80); v >>= 7; }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/* 0 on truncated input */
+static int get_varint(const uint8_t* p, const uint8_t* end, uint64_t* v) {
+    uint64_t r = 0;
+    for (int n = 0, shift = 0; p + n < end && shift < 64; ++n, shift += 7) {
+        r |= (uint64_t)(p[n] & 0x7F) << shift;
+        if (!(p[n] & 0x80)) { *v = r; return n + 1; }
+    }
+    return 0;
+}
+
+/* Decode one record at p; 0 on truncated/corrupt input */
+static int decode_record(const uint8_t* p, const uint8_t* end, RecState* st, ReplayFrame* out) {
+    const uint8_t* q = p;
+    if (q >= end) return 0;
+    uint8_t tag = *q++;
+    uint64_t v;
+    int n;
+
+    if (tag & F_KEYS)  { if (!(n = get_varint(q, end, &v))) return 0; q += n; st->keys ^= (uint32_t)v; }
+    if (tag & F_DT)    { if (!(n = get_varint(q, end, &v))) return 0; q += n; st->dt_bits ^= v; }
+    if (tag & F_CMD)   { if (!(n = get_varint(q, end, &v))) return 0; q += n;
+                         st->cmd_index = (int32_t)((v >> 1) ^ (0 - (v & 1))); }
+    if (tag & F_TIMER) { if (!(n = get_varint(q, end, &v))) return 0; q += n; st->timer_bits ^= (uint32_t)v; }
+
+    out->keys      = st->keys;
+    out->dt        = bitsd(st->dt_bits);
+    out->cmd_index = st->cmd_index;
+    out->cmd_timer = bitsf(st->timer_bits);
+    return (int)(q - p);
+}
+
+/* ---------------- Recording ---------------- */
+
+static struct {
+    FILE*     f;
+    RecState  st;
+    uint64_t  frames;
+    uint64_t  offset;        /* bytes written so far */
+} g_rec;
+
+bool replay_record_start(const char* path, const ReplayInfo* info) {
+    memset(&g_rec, 0, sizeof(g_rec));
+    g_rec.f = fopen(path, "wb");
+    if (!g_rec.f) { perror("[RECORD] fopen"); return false; }
+
+    RecHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = REC_MAGIC;
+    h.version = REC_VERSION;
+    h.flags = info->keyboard ? 1u : 0u;
+    h.fixed_hz = info->fixed_hz;
+    h.time_warp = info->time_warp;
+    h.seed = info->seed;
+    h.key_count = KEY_COUNT;
+    fwrite(&h, sizeof(h), 1, g_rec.f);
+    g_rec.offset = sizeof(h);
+    printf("[RECORD] %s\n", path);
+    return true;
+}
+
+bool replay_recording(void) { return g_rec.f != NULL; }
+
+void replay_record_frame(const ReplayFrame* f) {
+    if (!g_rec.f) return;
+
+    uint8_t buf[64];
+    int n = 1;
+    uint8_t tag = 0;
+
+    RecState* st = &g_rec.st;
+    uint32_t tb = fbits(f->cmd_timer);
+    uint64_t db = dbits(f->dt);
+    if (f->keys != st->keys)           { tag |= F_KEYS;  n += put_varint(buf + n, f->keys ^ st->keys); }
+    if (db != st->dt_bits)             { tag |= F_DT;    n += put_varint(buf + n, db ^ st->dt_bits); }
+    if (f->cmd_index != st->cmd_index) { tag |= F_CMD;
+        int64_t ci = f->cmd_index;   /* zigzag */
+        n += put_varint(buf + n, ((uint64_t)ci << 1) ^ (uint64_t)(ci >> 63)); }
+    if (tb != st->timer_bits)          { tag |= F_TIMER; n += put_varint(buf + n, tb ^ st->timer_bits); }
+    buf[0] = tag;
+
+    st->keys = f->keys; st->dt_bits = db; st->cmd_index = f->cmd_index; st->timer_bits = tb;
+
+    fwrite(buf, 1, (size_t)n, g_rec.f);
+    g_rec.offset += (uint64_t)n;
+    g_rec.frames++;
+}
+
+void replay_record_stop(void) {
+    if (!g_rec.f) return;
+    RecFooter ft;
+    ft.frame_count = g_rec.frames;
+    ft.magic       = REC_END_MAGIC;
+    fwrite(&ft, sizeof(ft), 1, g_rec.f);
+    printf("[RECORD] %llu frames, %.1f bytes/frame\n", (unsigned long long)g_rec.frames,
+           g_rec.frames ? (double)(g_rec.offset - sizeof(RecHeader)) / (double)g_rec.frames : 0.0);
+    fclose(g_rec.f);
+    memset(&g_rec, 0, sizeof(g_rec));
+}
+
+/* ---------------- Replay ---------------- */
+
+static struct {
+    int             fd;
+    const uint8_t*  base;
+    size_t          size;
+    const uint8_t*  data_end;    /* end of the record stream */
+    uint64_t        frames;
+    const uint8_t*  cur;
+    uint64_t        pos;         /* frame number of the next record */
+    RecState        st;
+    int             diverged;
+} g_rep = { .fd = -1 };
+
+/* Unfinished recording (no footer): walk the stream, keep whole records */
+static void count_frames(void) {
+    const uint8_t* p = g_rep.base + sizeof(RecHeader);
+    const uint8_t* end = g_rep.base + g_rep.size;
+    RecState st; memset(&st, 0, sizeof(st));
+    ReplayFrame f;
+    uint64_t frames = 0;
+    int n;
+    while ((n = decode_record(p, end, &st, &f)) > 0) {
+        p += n;
+        frames++;
+    }
+    g_rep.frames = frames;
+    g_rep.data_end = p;
+    fprintf(stderr, "[REPLAY] no footer (unfinished recording); recovered %llu frames\n",
+            (unsigned long long)frames);
+}
+
+bool replay_open(const char* path, ReplayInfo* out_info) {
+    replay_close();
+    g_rep.fd = open(path, O_RDONLY);
+    if (g_rep.fd < 0) { perror("[REPLAY] open"); return false; }
+
+    struct stat stt;
+    if (fstat(g_rep.fd, &stt) != 0 || (size_t)stt.st_size < sizeof(RecHeader)) {
+        fprintf(stderr, "[REPLAY] %s: too small\n", path);
+        replay_close();
+        return false;
+    }
+    g_rep.size = (size_t)stt.st_size;
+    void* m = mmap(NULL, g_rep.size, PROT_READ, MAP_PRIVATE, g_rep.fd, 0);
+    if (m == MAP_FAILED) { perror("[REPLAY] mmap"); replay_close(); return false; }
+    g_rep.base = (const uint8_t*)m;
+
+    RecHeader h;
+    memcpy(&h, g_rep.base, sizeof(h));
+    if (h.magic != REC_MAGIC || h.version != REC_VERSION || h.key_count > 32) {
+        fprintf(stderr, "[REPLAY] %s: not a flight recording (or another version)\n", path);
+        replay_close();
+        return false;
+    }
+
+    RecFooter ft;
+    int have_footer = 0;
+    if (g_rep.size >= sizeof(RecHeader) + sizeof(RecFooter)) {
+        memcpy(&ft, g_rep.base + g_rep.size - sizeof(ft), sizeof(ft));
+        have_footer = ft.magic == REC_END_MAGIC;
+    }
+    if (have_footer) {
+        g_rep.frames = ft.frame_count;
+        g_rep.data_end = g_rep.base + g_rep.size - sizeof(ft);
+    } else {
+        count_frames();
+    }
+
+    out_info->keyboard  = (h.flags & 1u) != 0;
+    out_info->fixed_hz  = h.fixed_hz;
+    out_info->time_warp = h.time_warp;
+    out_info->seed      = h.seed;
+
+    g_rep.cur = g_rep.base + sizeof(RecHeader);
+    g_rep.pos = 0;
+    memset(&g_rep.st, 0, sizeof(g_rep.st));
+    printf("[REPLAY] %s: %llu frames (%s, fixed %.1f Hz, warp x%.2f, seed %llu)\n", path,
+           (unsigned long long)g_rep.frames, out_info->keyboard ? "keyboard" : "autopilot",
+           out_info->fixed_hz, out_info->time_warp, (unsigned long long)out_info->seed);
+    return true;
+}
+
+bool replay_active(void) { return g_rep.base != NULL; }
+
+bool replay_next(ReplayFrame* out) {
+    if (!g_rep.base || g_rep.pos >= g_rep.frames) return false;
+    int n = decode_record(g_rep.cur, g_rep.data_end, &g_rep.st, out);
+    if (n <= 0) return false;
+    g_rep.cur += n;
+    g_rep.pos++;
+    return true;
+}
+
+uint64_t replay_frame_count(void) { return g_rep.frames; }
+uint64_t replay_position(void)    { return g_rep.pos; }
+
+bool replay_check(const ReplayFrame* expected, int cmd_index, float cmd_timer) {
+    if (expected->cmd_index == cmd_index && fbits(expected->cmd_timer) == fbits(cmd_timer))
+        return true;
+    if (!g_rep.diverged) {
+        fprintf(stderr, "[REPLAY] diverged at frame %llu: autopilot %d/%.6f, recorded %d/%.6f\n",
+                (unsigned long long)(g_rep.pos - 1), cmd_index, cmd_timer,
+                expected->cmd_index, expected->cmd_timer);
+        g_rep.diverged = 1;
+    }
+    return false;
+}
+
+void replay_close(void) {
+    if (g_rep.base) {
+        if (!g_rep.diverged && g_rep.pos > 0)
+            printf("[REPLAY] %llu frames replayed without divergence\n", (unsigned long long)g_rep.pos);
+        munmap((void*)g_rep.base, g_rep.size);
+    }
+    if (g_rep.fd >= 0) close(g_rep.fd);
+    memset(&g_rep, 0, sizeof(g_rep));
+    g_rep.fd = -1;
+}
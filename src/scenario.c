@@ -0,0 +1,494 @@
+#define _GNU_SOURCE
+#include "scenario.h"
+#include "globals.h"
+#include "plane.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { PATH_FOLLOW, PATH_STRAIGHT, PATH_ORBIT, PATH_WAYPOINTS };
+enum { PAT_POINT, PAT_LINE, PAT_GRID, PAT_RING, PAT_RANDOM };
+
+typedef struct {
+    int      count, pattern, path, cols, look, loop;
+    vec3     origin, spacing, vmin, vmax;
+    float    radius, speed_lo, speed_hi;
+    float    heading;                               /* degrees, 0 = -Z, + = left */
+    int      random_heading;
+    float    dir;                                   /* orbit: +1 ccw, -1 cw (seen from above) */
+    uint64_t seed;
+    int      nwp;
+    vec3     wp[SCENARIO_MAX_WAYPOINTS];
+} ScnSpawn;
+
+typedef struct {
+    double t;
+    int    preset;          /* 0 = explicit offsets */
+    float  behind, above, right, fov;   /* fov <= 0: unchanged */
+} ScnCamera;
+
+/* Per enemy: its spawn group and trajectory progress */
+typedef struct {
+    int group;
+    int wp_index;
+} ScnPlane;
+
+static struct {
+    int              loaded, active;
+    char*            path;
+    int              aircraft;           /* "aircraft N" (0 = sum of spawns) */
+    int              has_player;
+    vec3             player_pos;
+    float            player_heading;
+    ScnSpawn*        spawns;
+    int              nspawns;
+    AutopilotCommand plan[SCENARIO_MAX_PLAN];
+    int              nplan;
+    ScnCamera        camera[SCENARIO_MAX_CAMERA];
+    int              ncamera, next_camera;
+    char*            argv[SCENARIO_MAX_ARGS + 2];
+    int              argc;
+
+    Plane*           stock;              /* built-in planes[], restored on free */
+    Plane*           fleet;
+    ScnPlane*        state;
+} g_scn;
+
+static double scn_uniform(uint64_t* s, double lo, double hi) {
+    /* splitmix64, same generator as --seed */
+    uint64_t z = (*s += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return lo + (hi - lo) * (double)(z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* ---------------- Parsing ---------------- */
+
+static int parse_vec3(const char* v, vec3 out) {
+    return sscanf(v, "%f,%f,%f", &out[0], &out[1], &out[2]) == 3;
+}
+
+static int parse_path(const char* v) {
+    if (!strcmp(v, "follow"))    return PATH_FOLLOW;
+    if (!strcmp(v, "straight"))  return PATH_STRAIGHT;
+    if (!strcmp(v, "orbit"))     return PATH_ORBIT;
+    if (!strcmp(v, "waypoints")) return PATH_WAYPOINTS;
+    return -1;
+}
+
+static int parse_pattern(const char* v) {
+    if (!strcmp(v, "point"))  return PAT_POINT;
+    if (!strcmp(v, "line"))   return PAT_LINE;
+    if (!strcmp(v, "grid"))   return PAT_GRID;
+    if (!strcmp(v, "ring"))   return PAT_RING;
+    if (!strcmp(v, "random")) return PAT_RANDOM;
+    return -1;
+}
+
+static int parse_action(const char* v, AutopilotAction* out) {
+    static const struct { const char* name; AutopilotAction a; } k[] = {
+        { "straight", FLY_STRAIGHT },   { "left", TURN_LEFT },        { "right", TURN_RIGHT },
+        { "pitch_up", AUTO_PITCH_UP },  { "pitch_down", AUTO_PITCH_DOWN },
+        { "speed", SET_SPEED },         { "speed_lock", TOGGLE_SPEED_LOCK },
+        { "camera", SET_CAMERA },       { "zoom", HOLD_ZOOM },        { "grid", TOGGLE_GRID_VIEW },
+    };
+    for (size_t i = 0; i < sizeof(k) / sizeof(k[0]); ++i)
+        if (!strcmp(v, k[i].name)) { *out = k[i].a; return 1; }
+    return 0;
+}
+
+/* Splits "key=value" in place; value is "" without '=' */
+static void split_kv(char* tok, char** key, char** val) {
+    char* eq = strchr(tok, '=');
+    *key = tok;
+    *val = eq ? (*eq = '\0', eq + 1) : tok + strlen(tok);
+}
+
+static int parse_spawn(char** tok, int ntok, ScnSpawn* s, int index, const char** err) {
+    memset(s, 0, sizeof(*s));
+    s->count = 1;
+    s->pattern = PAT_POINT;
+    s->path = PATH_FOLLOW;
+    s->cols = 10;
+    s->speed_lo = s->speed_hi = 600.0f;
+    s->spacing[0] = 300.0f; s->spacing[2] = -300.0f;
+    s->origin[1] = 500.0f;
+    s->radius = 1000.0f;
+    s->dir = 1.0f;
+    s->seed = (uint64_t)index + 1;
+    s->loop = 1;
+    for (int i = 0; i < ntok; ++i) {
+        char *k, *v;
+        split_kv(tok[i], &k, &v);
+        if (!strcmp(k, "count")) {
+            s->count = atoi(v);
+            if (s->count < 1) { *err = "count must be >= 1"; return 0; }
+        } else if (!strcmp(k, "pattern")) {
+            if ((s->pattern = parse_pattern(v)) < 0) { *err = "unknown pattern"; return 0; }
+        } else if (!strcmp(k, "path")) {
+            if ((s->path = parse_path(v)) < 0) { *err = "unknown path"; return 0; }
+        } else if (!strcmp(k, "origin") || !strcmp(k, "center")) {
+            if (!parse_vec3(v, s->origin)) { *err = "expected X,Y,Z"; return 0; }
+        } else if (!strcmp(k, "spacing")) {
+            if (!parse_vec3(v, s->spacing)) { *err = "expected X,Y,Z"; return 0; }
+        } else if (!strcmp(k, "min")) {
+            if (!parse_vec3(v, s->vmin)) { *err = "expected X,Y,Z"; return 0; }
+        } else if (!strcmp(k, "max")) {
+            if (!parse_vec3(v, s->vmax)) { *err = "expected X,Y,Z"; return 0; }
+        } else if (!strcmp(k, "cols")) {
+            s->cols = atoi(v) > 0 ? atoi(v) : 1;
+        } else if (!strcmp(k, "radius")) {
+            s->radius = (float)atof(v);
+            if (s->radius <= 0.0f) { *err = "radius must be > 0"; return 0; }
+        } else if (!strcmp(k, "speed")) {
+            if (sscanf(v, "%f:%f", &s->speed_lo, &s->speed_hi) != 2) s->speed_hi = s->speed_lo = (float)atof(v);
+        } else if (!strcmp(k, "heading")) {
+            if (!strcmp(v, "random")) s->random_heading = 1;
+            else s->heading = (float)atof(v);
+        } else if (!strcmp(k, "dir")) {
+            s->dir = !strcmp(v, "cw") ? -1.0f : 1.0f;
+        } else if (!strcmp(k, "seed")) {
+            s->seed = strtoull(v, NULL, 10);
+        } else if (!strcmp(k, "look")) {
+            s->look = atoi(v);
+            if (s->look < 1 || s->look >= MAX_PLANES) {
+                static char msg[32];
+                snprintf(msg, sizeof(msg), "look must be 1..%d", MAX_PLANES - 1);
+                *err = msg;
+                return 0;
+            }
+        } else if (!strcmp(k, "loop")) {
+            s->loop = atoi(v) != 0;
+        } else if (!strcmp(k, "wp")) {
+            for (char* p = v; *p && s->nwp < SCENARIO_MAX_WAYPOINTS; ) {
+                if (!parse_vec3(p, s->wp[s->nwp])) { *err = "expected wp=X,Y,Z;X,Y,Z..."; return 0; }
+                s->nwp++;
+                char* semi = strchr(p, ';');
+                if (!semi) break;
+                p = semi + 1;
+            }
+        } else {
+            *err = "unknown spawn field";
+            return 0;
+        }
+    }
+    if (s->path == PATH_WAYPOINTS && s->nwp == 0) { *err = "path=waypoints needs wp="; return 0; }
+    if (s->path == PATH_WAYPOINTS && s->loop) {
+        /* Tek noktalı (ya da hep aynı noktalı) döngü hiçbir yere gitmez */
+        int distinct = 0;
+        for (int w = 1; w < s->nwp && !distinct; ++w)
+            distinct = glm_vec3_distance(s->wp[w], s->wp[0]) > 1e-3f;
+        if (!distinct) { *err = "loop=1 needs at least two distinct wp= points"; return 0; }
+    }
+    return 1;
+}
+
+bool scenario_load(const char* path) {
+    scenario_free();
+    FILE* f = fopen(path, "r");
+    if (!f) { fprintf(stderr, "[SCENARIO] cannot open %s\n", path); return false; }
+    g_scn.path = strdup(path);
+    g_scn.argv[g_scn.argc++] = g_scn.path;
+
+    char line[4096];
+    int lineno = 0;
+    const char* err = NULL;
+    while (!err && fgets(line, sizeof(line), f)) {
+        lineno++;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char* tok[128];
+        int ntok = 0;
+        for (char* p = strtok(line, " \t\r\n"); p && ntok < 128; p = strtok(NULL, " \t\r\n")) tok[ntok++] = p;
+        if (ntok == 0) continue;
+        const char* d = tok[0];
+
+        if (!strcmp(d, "aircraft")) {
+            g_scn.aircraft = ntok > 1 ? atoi(tok[1]) : 0;
+            if (g_scn.aircraft < 1 || g_scn.aircraft > SCENARIO_MAX_PLANES) err = "aircraft out of range";
+        } else if (!strcmp(d, "player")) {
+            g_scn.has_player = 1;
+            g_scn.player_pos[1] = 500.0f; g_scn.player_pos[2] = 50.0f;
+            for (int i = 1; i < ntok && !err; ++i) {
+                char *k, *v;
+                split_kv(tok[i], &k, &v);
+                if (!strcmp(k, "pos")) { if (!parse_vec3(v, g_scn.player_pos)) err = "expected pos=X,Y,Z"; }
+                else if (!strcmp(k, "heading")) g_scn.player_heading = (float)atof(v);
+                else err = "unknown player field";
+            }
+        } else if (!strcmp(d, "spawn")) {
+            if (g_scn.nspawns >= SCENARIO_MAX_SPAWNS) { err = "too many spawn lines"; break; }
+            ScnSpawn* ns = realloc(g_scn.spawns, sizeof(ScnSpawn) * (size_t)(g_scn.nspawns + 1));
+            if (!ns) { err = "out of memory"; break; }
+            g_scn.spawns = ns;
+            if (parse_spawn(tok + 1, ntok - 1, &g_scn.spawns[g_scn.nspawns], g_scn.nspawns, &err))
+                g_scn.nspawns++;
+        } else if (!strcmp(d, "plan")) {
+            AutopilotCommand* c = &g_scn.plan[g_scn.nplan];
+            if (g_scn.nplan >= SCENARIO_MAX_PLAN) err = "too many plan lines";
+            else if (ntok < 3 || !parse_action(tok[1], &c->action)) err = "expected plan ACTION DURATION [VALUE]";
+            else {
+                c->duration = (float)atof(tok[2]);
+                c->value = ntok > 3 ? (float)atof(tok[3]) : 0.0f;
+                g_scn.nplan++;
+            }
+        } else if (!strcmp(d, "camera")) {
+            if (g_scn.ncamera >= SCENARIO_MAX_CAMERA) { err = "too many camera lines"; break; }
+            ScnCamera* c = &g_scn.camera[g_scn.ncamera];
+            memset(c, 0, sizeof(*c));
+            c->t = -1.0;
+            for (int i = 1; i < ntok && !err; ++i) {
+                char *k, *v;
+                split_kv(tok[i], &k, &v);
+                if (!strcmp(k, "t")) c->t = atof(v);
+                else if (!strcmp(k, "preset")) c->preset = atoi(v);
+                else if (!strcmp(k, "offset")) {
+                    if (sscanf(v, "%f,%f,%f", &c->behind, &c->above, &c->right) != 3) err = "expected offset=B,A,R";
+                } else if (!strcmp(k, "fov")) c->fov = (float)atof(v);
+                else err = "unknown camera field";
+            }
+            if (!err && c->t < 0.0) err = "camera needs t=SECONDS";
+            if (!err && c->preset && (c->preset < 1 || c->preset > 8)) err = "preset must be 1..8";
+            if (!err) {
+                /* keep the script sorted by time (stable) */
+                int j = g_scn.ncamera++;
+                ScnCamera tmp = *c;
+                while (j > 0 && g_scn.camera[j - 1].t > tmp.t) { g_scn.camera[j] = g_scn.camera[j - 1]; j--; }
+                g_scn.camera[j] = tmp;
+            }
+        } else if (!strcmp(d, "args")) {
+            for (int i = 1; i < ntok; ++i) {
+                if (g_scn.argc >= SCENARIO_MAX_ARGS) { err = "too many args"; break; }
+                g_scn.argv[g_scn.argc++] = strdup(tok[i]);
+            }
+        } else {
+            err = "unknown directive";
+        }
+    }
+    fclose(f);
+    if (err) {
+        fprintf(stderr, "[SCENARIO] %s:%d: %s\n", path, lineno, err);
+        scenario_free();
+        return false;
+    }
+    g_scn.argv[g_scn.argc] = NULL;
+    g_scn.loaded = 1;
+    return true;
+}
+
+bool scenario_active(void) { return g_scn.active != 0; }
+
+int scenario_args(char*** argv) {
+    *argv = g_scn.argv;
+    return g_scn.loaded ? g_scn.argc : 0;
+}
+
+/* ---------------- Building planes[] ---------------- */
+
+static void set_heading(Plane* p, float yaw_rad) {
+    vec3 up = {0.0f, 1.0f, 0.0f};
+    glm_vec3_copy((vec3){0.0f, 0.0f, -1.0f}, p->front);
+    glm_vec3_rotate(p->front, yaw_rad, up);
+    glm_vec3_copy(up, p->up);
+    glm_vec3_cross(p->front, p->up, p->right);
+    glm_normalize(p->right);
+}
+
+static void place(const ScnSpawn* s, int k, uint64_t* rng, Plane* p) {
+    vec3 pos;
+    float yaw = s->random_heading ? (float)scn_uniform(rng, -GLM_PI, GLM_PI) : glm_rad(s->heading);
+    switch (s->pattern) {
+        case PAT_LINE:
+            glm_vec3_copy((float*)s->origin, pos);
+            glm_vec3_muladds((float*)s->spacing, (float)k, pos);
+            break;
+        case PAT_GRID: {
+            int c = k % s->cols, r = k / s->cols;
+            pos[0] = s->origin[0] + s->spacing[0] * (float)c;
+            pos[1] = s->origin[1] + s->spacing[1] * (float)r;
+            pos[2] = s->origin[2] + s->spacing[2] * (float)r;
+            break;
+        }
+        case PAT_RING: {
+            float a = 2.0f * GLM_PIf * (float)k / (float)s->count;
+            pos[0] = s->origin[0] + s->radius * cosf(a);
+            pos[1] = s->origin[1];
+            pos[2] = s->origin[2] + s->radius * sinf(a);
+            if (s->path == PATH_ORBIT) yaw = 0.0f;   /* set by the first step */
+            break;
+        }
+        case PAT_RANDOM:
+            for (int i = 0; i < 3; ++i) pos[i] = (float)scn_uniform(rng, s->vmin[i], s->vmax[i]);
+            break;
+        case PAT_POINT:
+        default:
+            glm_vec3_copy((float*)s->origin, pos);
+            break;
+    }
+    glm_vec3_copy(pos, p->position);
+    set_heading(p, yaw);
+    p->speed = s->speed_lo == s->speed_hi ? s->speed_lo : (float)scn_uniform(rng, s->speed_lo, s->speed_hi);
+}
+
+bool scenario_apply(int aircraft) {
+    if (aircraft <= 0) aircraft = g_scn.aircraft;
+    if (!g_scn.loaded && aircraft <= 0) return true;         /* stock scenario */
+    if (aircraft > SCENARIO_MAX_PLANES) {
+        fprintf(stderr, "[SCENARIO] at most %d aircraft\n", SCENARIO_MAX_PLANES);
+        return false;
+    }
+
+    /* spawn groups, or the stock five enemies when the file has none */
+    int spawned = 0;
+    for (int g = 0; g < g_scn.nspawns; ++g) spawned += g_scn.spawns[g].count;
+    int base = 1 + (g_scn.nspawns ? spawned : MAX_PLANES - 1);
+    int total = aircraft > 0 ? aircraft : base;
+    if (total > SCENARIO_MAX_PLANES) total = SCENARIO_MAX_PLANES;
+
+    Plane* stock = g_scn.stock ? g_scn.stock : planes;      /* still the built-in array */
+    Plane* fleet = calloc((size_t)total, sizeof(Plane));
+    ScnPlane* state = calloc((size_t)total, sizeof(ScnPlane));
+    if (!fleet || !state) {
+        free(fleet); free(state);
+        fprintf(stderr, "[SCENARIO] out of memory for %d aircraft\n", total);
+        return false;
+    }
+
+    fleet[0] = stock[0];
+    if (g_scn.has_player) {
+        glm_vec3_copy(g_scn.player_pos, fleet[0].position);
+        set_heading(&fleet[0], glm_rad(g_scn.player_heading));
+    }
+
+    int n = 1;
+    if (g_scn.nspawns) {
+        for (int g = 0; g < g_scn.nspawns && n < total; ++g) {
+            const ScnSpawn* s = &g_scn.spawns[g];
+            uint64_t rng = s->seed;
+            for (int k = 0; k < s->count && n < total; ++k, ++n) {
+                fleet[n] = stock[s->look ? s->look : 1 + (n - 1) % (MAX_PLANES - 1)];
+                place(s, k, &rng, &fleet[n]);
+                state[n].group = g;
+            }
+        }
+    } else {
+        for (; n < MAX_PLANES && n < total; ++n) { fleet[n] = stock[n]; state[n].group = -1; }
+    }
+
+    /* fill: a follow grid behind the stock formation */
+    const int fill = total - n;
+    const int cols = fill > 0 ? (int)ceilf(sqrtf((float)fill)) : 1;
+    for (int k = 0; n < total; ++k, ++n) {
+        fleet[n] = stock[1 + (n - 1) % (MAX_PLANES - 1)];
+        fleet[n].position[0] = fleet[0].position[0] + 400.0f * (float)(k % cols - cols / 2);
+        fleet[n].position[1] = 500.0f + 60.0f * (float)(k % 5);
+        fleet[n].position[2] = fleet[0].position[2] - 4500.0f - 400.0f * (float)(k / cols);
+        set_heading(&fleet[n], 0.0f);
+        fleet[n].speed = 600.0f + 25.0f * (float)(k % 5);
+        state[n].group = -1;
+    }
+    for (int i = 1; i < total; ++i) update_enemy_model_matrix(&fleet[i]);
+
+    free(g_scn.fleet);
+    free(g_scn.state);
+    planes = fleet;
+    plane_count = total;
+    g_scn.stock = stock;
+    g_scn.fleet = fleet;
+    g_scn.state = state;
+    g_scn.next_camera = 0;
+    g_scn.active = 1;
+    if (g_scn.nplan) autopilot_set_plan(g_scn.plan, g_scn.nplan);
+
+    printf("[SCENARIO] %s: %d aircraft (%d spawn groups), %d plan commands, %d camera cues\n",
+           g_scn.path ? g_scn.path : "--aircraft", total, g_scn.nspawns, g_scn.nplan, g_scn.ncamera);
+    return true;
+}
+
+/* ---------------- Per step ---------------- */
+
+static void step_orbit(Plane* p, const ScnSpawn* s, float dt) {
+    float dx = p->position[0] - s->origin[0], dz = p->position[2] - s->origin[2];
+    float a = atan2f(dz, dx) + s->dir * p->speed * dt / s->radius;
+    p->position[0] = s->origin[0] + s->radius * cosf(a);
+    p->position[2] = s->origin[2] + s->radius * sinf(a);
+    /* tangent; atan2 grows towards +Z */
+    p->front[0] = -sinf(a) * s->dir;
+    p->front[1] = 0.0f;
+    p->front[2] = cosf(a) * s->dir;
+}
+
+static void step_waypoints(Plane* p, ScnPlane* st, const ScnSpawn* s, float dt) {
+    float travel = p->speed * dt;
+    float lap = 0.0f;   /* distance covered since the last full lap */
+    int   visited = 0;
+    while (travel > 0.0f && st->wp_index < s->nwp) {
+        vec3 d;
+        glm_vec3_sub((float*)s->wp[st->wp_index], p->position, d);
+        float dist = glm_vec3_norm(d);
+        if (dist > 1e-3f) glm_vec3_scale(d, 1.0f / dist, p->front);
+        if (dist > travel) {
+            glm_vec3_muladds(p->front, travel, p->position);
+            return;
+        }
+        glm_vec3_copy((float*)s->wp[st->wp_index], p->position);
+        travel -= dist;
+        lap += dist;
+        st->wp_index++;
+        if (st->wp_index >= s->nwp && s->loop) st->wp_index = 0;
+        if (++visited == s->nwp) {
+            if (lap <= 1e-3f) return;  /* a lap that goes nowhere would spin forever: hold */
+            lap = 0.0f;
+            visited = 0;
+        }
+    }
+    /* end of a non-looping route: carry on straight */
+    glm_vec3_muladds(p->front, travel, p->position);
+}
+
+void scenario_step(double sim_time, float dt) {
+    if (!g_scn.active) return;
+    vec3 up = {0.0f, 1.0f, 0.0f};
+
+    for (int i = 1; i < plane_count; ++i) {
+        Plane* p = &planes[i];
+        ScnPlane* st = &g_scn.state[i];
+        const ScnSpawn* s = st->group >= 0 ? &g_scn.spawns[st->group] : NULL;
+        int path = s ? s->path : PATH_FOLLOW;
+        if (path == PATH_FOLLOW) { update_enemy_plane(p); continue; }
+
+        if (path == PATH_ORBIT)          step_orbit(p, s, dt);
+        else if (path == PATH_WAYPOINTS) step_waypoints(p, st, s, dt);
+        else                             glm_vec3_muladds(p->front, p->speed * dt, p->position);
+        glm_vec3_copy(up, p->up);
+        glm_vec3_cross(p->front, p->up, p->right);
+        glm_normalize(p->right);
+        update_enemy_model_matrix(p);
+    }
+
+    while (g_scn.next_camera < g_scn.ncamera && g_scn.camera[g_scn.next_camera].t <= sim_time) {
+        const ScnCamera* c = &g_scn.camera[g_scn.next_camera++];
+        if (c->preset) autopilot_camera_preset(c->preset);
+        else { offset_behind = c->behind; offset_above = c->above; offset_right = c->right; }
+        if (c->fov > 0.0f) fov = c->fov;
+    }
+}
+
+void scenario_free(void) {
+    for (int i = 1; i < g_scn.argc; ++i) free(g_scn.argv[i]);
+    free(g_scn.path);
+    free(g_scn.spawns);
+    if (g_scn.fleet) {
+        /* back to the built-in array and flight plan (both point into g_scn) */
+        planes = g_scn.stock;
+        plane_count = MAX_PLANES;
+        autopilot_set_plan(NULL, 0);
+    }
+    free(g_scn.fleet);
+    free(g_scn.state);
+    memset(&g_scn, 0, sizeof(g_scn));
+}
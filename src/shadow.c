@@ -0,0 +1,358 @@
+#define _GNU_SOURCE
+#include "shadow.h"
+#include "stats.h"
+#include "imgproc.h"
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#define SHADOW_MAX_BOXES 256
+#define SHADOW_LAT_WINDOW 4096
+
+/* ---------------- State ---------------- */
+
+typedef struct {
+    uint8_t* rgba;
+    size_t   cap;           /* bytes allocated for rgba */
+    int      w, h;
+    OnnxDet  prod[SHADOW_MAX_BOXES];
+    int      prod_count;
+    double   prod_ms;
+} ShadowFrame;
+
+static struct {
+    int             running;
+    ShadowConfig    cfg;
+    OnnxDetector    det;
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+
+    const char*     model_path;    /* until the worker has loaded it */
+    int             load_state;    /* 0 loading, 1 ready, -1 failed (guarded by lock) */
+
+    ShadowFrame     slot;          /* mailbox, guarded by lock */
+    int             slot_full;
+    int             stop;
+    long            offered;       /* render thread only */
+
+    /* worker-side accumulators (guarded by lock for report) */
+    long   frames, skipped, failed;
+    long   matched, prod_only, cand_only;
+    double iou_sum;
+    LatencyWindow prod_lat, cand_lat;
+} g_shadow;
+
+static double now_ms(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec * 1000.0 + (double)t.tv_nsec / 1e6;
+}
+
+/* ---------------- Comparison ---------------- */
+
+static float box_iou(const OnnxDet* a, const OnnxDet* b) {
+    float ix = fminf(a->x2, b->x2) - fmaxf(a->x1, b->x1);
+    float iy = fminf(a->y2, b->y2) - fmaxf(a->y1, b->y1);
+    if (ix <= 0.f || iy <= 0.f) return 0.f;
+    float inter = ix * iy;
+    float ua = (a->x2 - a->x1) * (a->y2 - a->y1) + (b->x2 - b->x1) * (b->y2 - b->y1) - inter;
+    return ua > 0.f ? inter / ua : 0.f;
+}
+
+/* Greedy same-class matching by best IoU */
+static void compare_frame(const OnnxDet* prod, int np, const OnnxDet* cand, int nc,
+                          long* matched, long* prod_only, long* cand_only, double* iou_sum) {
+    unsigned char used[SHADOW_MAX_BOXES] = {0};
+    float th = g_shadow.cfg.score_thresh;
+    int np_kept = 0, nc_kept = 0, m = 0;
+
+    for (int j = 0; j < nc && j < SHADOW_MAX_BOXES; ++j)
+        if (cand[j].score >= th) nc_kept++;
+
+    for (int i = 0; i < np; ++i) {
+        if (prod[i].score < th) continue;
+        np_kept++;
+        int best = -1;
+        float best_iou = g_shadow.cfg.iou_match;
+        for (int j = 0; j < nc && j < SHADOW_MAX_BOXES; ++j) {
+            if (used[j] || cand[j].score < th || cand[j].cls != prod[i].cls) continue;
+            float iou = box_iou(&prod[i], &cand[j]);
+            if (iou >= best_iou) { best_iou = iou; best = j; }
+        }
+        if (best >= 0) {
+            used[best] = 1;
+            m++;
+            *iou_sum += best_iou;
+        }
+    }
+    *matched   += m;
+    *prod_only += np_kept - m;
+    *cand_only += nc_kept - m;
+}
+
+/* ---------------- Worker ---------------- */
+
+static void lower_thread_priority(void) {
+#ifdef SCHED_IDLE
+    struct sched_param sp;
+    memset(&sp, 0, sizeof(sp));
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &sp) == 0) return;
+#endif
+    /* Linux: nice applies per thread when addressed by tid */
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
+}
+
+/* Runs on the worker after lower_thread_priority(): ORT's intra-op pool
+ * threads are created here and inherit the idle policy / nice level */
+static int load_candidate(void) {
+    OnnxConfig oc = onnx_default_config();
+    oc.intra_threads = g_shadow.cfg.intra_threads;
+    oc.inter_threads = 1;
+    oc.score_thresh = g_shadow.cfg.score_thresh;
+    if (onnx_load_model(&g_shadow.det, g_shadow.model_path, &oc) != ONNX_OK) {
+        onnx_destroy(&g_shadow.det);
+        return -1;
+    }
+    /* kareler ölçeklenmeden verilir; sabit girişli aday aynı boyutu almalı */
+    const OnnxDetector* d = &g_shadow.det;
+    if (d->in_w > 0 && d->in_h > 0 &&
+        (d->in_w != g_shadow.cfg.frame_w || d->in_h != g_shadow.cfg.frame_h)) {
+        fprintf(stderr, "[SHADOW] candidate takes %lldx%lld input, frames are %dx%d\n",
+                (long long)d->in_w, (long long)d->in_h, g_shadow.cfg.frame_w, g_shadow.cfg.frame_h);
+        onnx_destroy(&g_shadow.det);
+        return -1;
+    }
+    return 1;
+}
+
+static void* shadow_worker(void* arg) {
+    (void)arg;
+    lower_thread_priority();
+
+    int state = load_candidate();
+    pthread_mutex_lock(&g_shadow.lock);
+    g_shadow.load_state = state;
+    pthread_cond_broadcast(&g_shadow.cond);
+    pthread_mutex_unlock(&g_shadow.lock);
+    if (state < 0) return NULL;
+
+    ShadowFrame local;
+    memset(&local, 0, sizeof(local));
+    float* chw = NULL;
+    size_t chw_cap = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&g_shadow.lock);
+        while (!g_shadow.slot_full && !g_shadow.stop)
+            pthread_cond_wait(&g_shadow.cond, &g_shadow.lock);
+        if (g_shadow.stop) { pthread_mutex_unlock(&g_shadow.lock); break; }
+
+        /* swap buffers so the render thread can refill the slot */
+        uint8_t* spare = local.rgba;
+        size_t spare_cap = local.cap;
+        local = g_shadow.slot;
+        g_shadow.slot.rgba = spare;
+        g_shadow.slot.cap = spare_cap;
+        g_shadow.slot_full = 0;
+        pthread_mutex_unlock(&g_shadow.lock);
+
+        const void* input = local.rgba;
+        if (!g_shadow.det.in_u8) {
+            size_t need = (size_t)3 * local.w * local.h;
+            if (chw_cap < need) {
+                free(chw);
+                chw = (float*)malloc(sizeof(float) * need);
+                chw_cap = chw ? need : 0;
+            }
+            if (!chw) continue;
+            rgba_flip_gray3_chw_norm(local.rgba, chw, local.w, local.h);
+            input = chw;
+        }
+
+        OnnxDet* cand = NULL;
+        int nc = 0;
+        double t0 = now_ms();
+        int rc = onnx_predict(&g_shadow.det, input, local.w, local.h, &cand, &nc);
+        double t1 = now_ms();
+
+        long matched = 0, prod_only = 0, cand_only = 0;
+        double iou_sum = 0.0;
+        if (rc == ONNX_OK)
+            compare_frame(local.prod, local.prod_count, cand, nc,
+                          &matched, &prod_only, &cand_only, &iou_sum);
+        onnx_free_detections(cand);
+
+        int print_now = 0;
+        pthread_mutex_lock(&g_shadow.lock);
+        if (rc == ONNX_OK) {
+            g_shadow.frames++;
+            g_shadow.matched += matched;
+            g_shadow.prod_only += prod_only;
+            g_shadow.cand_only += cand_only;
+            g_shadow.iou_sum += iou_sum;
+            latwin_push(&g_shadow.prod_lat, local.prod_ms);
+            latwin_push(&g_shadow.cand_lat, t1 - t0);
+            print_now = g_shadow.cfg.report_every > 0 &&
+                        g_shadow.frames % g_shadow.cfg.report_every == 0;
+        } else {
+            g_shadow.failed++;
+        }
+        pthread_mutex_unlock(&g_shadow.lock);
+        if (print_now) shadow_report(stdout);
+    }
+
+    free(chw);
+    free(local.rgba);
+    return NULL;
+}
+
+/* ---------------- Public API ---------------- */
+
+ShadowConfig shadow_default_config(void) {
+    ShadowConfig c;
+    c.sample_every  = 10;
+    c.iou_match     = 0.5f;
+    c.score_thresh  = 0.6f;
+    c.intra_threads = 2;
+    c.report_every  = 300;
+    c.frame_w       = 0;
+    c.frame_h       = 0;
+    return c;
+}
+
+int shadow_start(const char* model_path, const ShadowConfig* cfg) {
+    if (g_shadow.running) return 0;
+    memset(&g_shadow, 0, sizeof(g_shadow));
+    g_shadow.cfg = cfg ? *cfg : shadow_default_config();
+    if (g_shadow.cfg.sample_every < 1) g_shadow.cfg.sample_every = 1;
+
+    g_shadow.model_path = model_path;
+
+    if (latwin_init(&g_shadow.prod_lat, SHADOW_LAT_WINDOW) != 0 ||
+        latwin_init(&g_shadow.cand_lat, SHADOW_LAT_WINDOW) != 0) {
+        latwin_free(&g_shadow.prod_lat);
+        return -1;
+    }
+
+    pthread_mutex_init(&g_shadow.lock, NULL);
+    pthread_cond_init(&g_shadow.cond, NULL);
+    if (pthread_create(&g_shadow.thread, NULL, shadow_worker, NULL) != 0) {
+        fprintf(stderr, "[SHADOW] worker thread could not be started\n");
+        latwin_free(&g_shadow.prod_lat);
+        latwin_free(&g_shadow.cand_lat);
+        return -1;
+    }
+
+    /* Model işçi iş parçacığında yüklenir; sonucu beklenir */
+    pthread_mutex_lock(&g_shadow.lock);
+    while (g_shadow.load_state == 0) pthread_cond_wait(&g_shadow.cond, &g_shadow.lock);
+    int state = g_shadow.load_state;
+    pthread_mutex_unlock(&g_shadow.lock);
+    g_shadow.model_path = NULL;
+    if (state < 0) {
+        fprintf(stderr, "[SHADOW] Aday model yüklenemedi (%s)\n", model_path);
+        pthread_join(g_shadow.thread, NULL);
+        latwin_free(&g_shadow.prod_lat);
+        latwin_free(&g_shadow.cand_lat);
+        pthread_mutex_destroy(&g_shadow.lock);
+        pthread_cond_destroy(&g_shadow.cond);
+        return -1;
+    }
+    g_shadow.running = 1;
+    printf("[SHADOW] Aday model: %s (her %d karede bir)\n", model_path, g_shadow.cfg.sample_every);
+    return 0;
+}
+
+int shadow_active(void) {
+    return g_shadow.running;
+}
+
+void shadow_offer(const uint8_t* rgba, int w, int h,
+                  const OnnxDet* prod, int prod_count, double prod_ms) {
+    if (!g_shadow.running || !rgba) return;
+    if (g_shadow.offered++ % g_shadow.cfg.sample_every != 0) return;
+
+    /* never block the render thread */
+    if (pthread_mutex_trylock(&g_shadow.lock) != 0) { g_shadow.skipped++; return; }
+    if (g_shadow.slot_full) {
+        g_shadow.skipped++;
+        pthread_mutex_unlock(&g_shadow.lock);
+        return;
+    }
+
+    size_t bytes = (size_t)w * h * 4;
+    if (g_shadow.slot.cap < bytes) {
+        free(g_shadow.slot.rgba);
+        g_shadow.slot.rgba = (uint8_t*)malloc(bytes);
+        g_shadow.slot.cap = g_shadow.slot.rgba ? bytes : 0;
+    }
+    if (g_shadow.slot.rgba) {
+        memcpy(g_shadow.slot.rgba, rgba, bytes);
+        g_shadow.slot.w = w;
+        g_shadow.slot.h = h;
+        g_shadow.slot.prod_count = prod_count < SHADOW_MAX_BOXES ? prod_count : SHADOW_MAX_BOXES;
+        if (g_shadow.slot.prod_count > 0)
+            memcpy(g_shadow.slot.prod, prod, sizeof(OnnxDet) * (size_t)g_shadow.slot.prod_count);
+        g_shadow.slot.prod_ms = prod_ms;
+        g_shadow.slot_full = 1;
+        pthread_cond_signal(&g_shadow.cond);
+    }
+    pthread_mutex_unlock(&g_shadow.lock);
+}
+
+int shadow_queue_depth(long* dropped) {
+    if (dropped) *dropped = g_shadow.running ? __atomic_load_n(&g_shadow.skipped, __ATOMIC_RELAXED) : 0;
+    return g_shadow.running ? __atomic_load_n(&g_shadow.slot_full, __ATOMIC_RELAXED) : 0;
+}
+
+void shadow_report(FILE* out) {
+    if (!g_shadow.running) return;
+    static const double ps[3] = {50.0, 95.0, 99.0};
+    double pl[3], cl[3];
+
+    pthread_mutex_lock(&g_shadow.lock);
+    long frames = g_shadow.frames, skipped = g_shadow.skipped, failed = g_shadow.failed;
+    long m = g_shadow.matched, po = g_shadow.prod_only, co = g_shadow.cand_only;
+    double iou = m ? g_shadow.iou_sum / (double)m : 0.0;
+    latwin_percentiles(&g_shadow.prod_lat, ps, pl, 3);
+    latwin_percentiles(&g_shadow.cand_lat, ps, cl, 3);
+    pthread_mutex_unlock(&g_shadow.lock);
+
+    double agree  = (m + po + co) ? (double)m / (double)(m + po + co) : 1.0;
+    double recall = (m + po) ? (double)m / (double)(m + po) : 1.0;
+    double prec   = (m + co) ? (double)m / (double)(m + co) : 1.0;
+
+    fprintf(out, "[SHADOW] frames=%ld skipped=%ld failed=%ld agree=%.3f recall=%.3f precision=%.3f meanIoU=%.3f "
+                 "prod p50/p95/p99=%.2f/%.2f/%.2fms cand p50/p95/p99=%.2f/%.2f/%.2fms\n",
+            frames, skipped, failed, agree, recall, prec, iou,
+            pl[0], pl[1], pl[2], cl[0], cl[1], cl[2]);
+    fflush(out);
+}
+
+void shadow_stop(void) {
+    if (!g_shadow.running) return;
+
+    pthread_mutex_lock(&g_shadow.lock);
+    g_shadow.stop = 1;
+    pthread_cond_signal(&g_shadow.cond);
+    pthread_mutex_unlock(&g_shadow.lock);
+    pthread_join(g_shadow.thread, NULL);
+
+    shadow_report(stdout);
+
+    onnx_destroy(&g_shadow.det);
+    latwin_free(&g_shadow.prod_lat);
+    latwin_free(&g_shadow.cand_lat);
+    free(g_shadow.slot.rgba);
+    g_shadow.slot.rgba = NULL;
+    pthread_mutex_destroy(&g_shadow.lock);
+    pthread_cond_destroy(&g_shadow.cond);
+    g_shadow.running = 0;
+}
@@ -0,0 +1,388 @@
+#include "skyblob.h"
+#include "imgproc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SKYBLOB_SIMD 1
+#else
+#define SKYBLOB_SIMD 0
+#endif
+
+/* ---------------- Internal types ---------------- */
+
+typedef struct {
+    uint16_t x0, x1, y;   /* inclusive run [x0, x1] on row y */
+    uint8_t  peak;        /* max |gray - bg| inside the run */
+    int      parent;      /* union-find */
+} Run;
+
+typedef struct {
+    int x0, y0, x1, y1;
+    int area;
+    int peak;
+} Blob;
+
+static int uf_find(Run* r, int i) {
+    while (r[i].parent != i) {
+        r[i].parent = r[r[i].parent].parent;
+        i = r[i].parent;
+    }
+    return i;
+}
+
+static void uf_union(Run* r, int a, int b) {
+    a = uf_find(r, a);
+    b = uf_find(r, b);
+    if (a == b) return;
+    if (a < b) r[b].parent = a; else r[a].parent = b;
+}
+
+/* ---------------- Background ---------------- */
+
+/* Sum of n gray pixels */
+static uint32_t sum_u8(const uint8_t* p, int n) {
+    uint32_t s = 0;
+    int x = 0;
+#if SKYBLOB_SIMD
+    __m128i acc = _mm_setzero_si128();
+    for (; x + 16 <= n; x += 16)
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(p + x)), _mm_setzero_si128()));
+    s = (uint32_t)_mm_cvtsi128_si32(acc) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#endif
+    for (; x < n; ++x) s += p[x];
+    return s;
+}
+
+/* Interpolate one background row from two rows of cell means.
+ * Cell centres sit at SKYBLOB_CELL/2 + k*SKYBLOB_CELL, so every span
+ * between two centres is exactly SKYBLOB_CELL pixels long (the SIMD
+ * path divides by shifting, so SKYBLOB_CELL must stay 16). */
+static void build_bg_row(const uint8_t* c0, const uint8_t* c1, int wy, /* 0..256 */
+                         int cells_x, int w, uint8_t* out) {
+    enum { H = SKYBLOB_CELL / 2 };
+    int col[512];
+    int n = cells_x < 512 ? cells_x : 512;
+    for (int k = 0; k < n; ++k)
+        col[k] = (c0[k] * (256 - wy) + c1[k] * wy + 128) >> 8;
+
+    int first = H < w ? H : w;
+    memset(out, col[0], (size_t)first);
+
+    int x = H;
+    for (int k = 0; k + 1 < n && x < w; ++k, x += SKYBLOB_CELL) {
+        int a = col[k], d = col[k + 1] - col[k];
+#if SKYBLOB_SIMD
+        if (x + SKYBLOB_CELL <= w) {
+            const __m128i t0 = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+            const __m128i t1 = _mm_setr_epi16(8, 9, 10, 11, 12, 13, 14, 15);
+            __m128i base = _mm_set1_epi16((short)(a * SKYBLOB_CELL + H));
+            __m128i dd   = _mm_set1_epi16((short)d);
+            __m128i v0 = _mm_srai_epi16(_mm_add_epi16(base, _mm_mullo_epi16(dd, t0)), 4);
+            __m128i v1 = _mm_srai_epi16(_mm_add_epi16(base, _mm_mullo_epi16(dd, t1)), 4);
+            _mm_storeu_si128((__m128i*)(out + x), _mm_packus_epi16(v0, v1));
+            continue;
+        }
+#endif
+        for (int t = 0; t < SKYBLOB_CELL && x + t < w; ++t)
+            out[x + t] = (uint8_t)((a * SKYBLOB_CELL + d * t + H) / SKYBLOB_CELL);
+    }
+    for (; x < w; ++x) out[x] = (uint8_t)col[n - 1];
+}
+
+/* 3x3 median over the cell grid so cells covered by an aircraft take
+ * the surrounding sky value instead of dragging the background along. */
+static void median3x3_cells(const uint32_t* in, uint8_t* out, int cx, int cy) {
+    for (int y = 0; y < cy; ++y) {
+        for (int x = 0; x < cx; ++x) {
+            uint32_t v[9];
+            int n = 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+                int yy = y + dy;
+                if (yy < 0 || yy >= cy) continue;
+                for (int dx = -1; dx <= 1; ++dx) {
+                    int xx = x + dx;
+                    if (xx < 0 || xx >= cx) continue;
+                    uint32_t t = in[yy * cx + xx];
+                    int k = n++;
+                    while (k > 0 && v[k - 1] > t) { v[k] = v[k - 1]; --k; }
+                    v[k] = t;
+                }
+            }
+            out[y * cx + x] = (uint8_t)v[n / 2];
+        }
+    }
+}
+
+/* out = |g - bg| */
+static void abs_diff_row(const uint8_t* g, const uint8_t* bg, uint8_t* out, int n) {
+    int x = 0;
+#if SKYBLOB_SIMD
+    for (; x + 16 <= n; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(g + x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(bg + x));
+        _mm_storeu_si128((__m128i*)(out + x), _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a)));
+    }
+#endif
+    for (; x < n; ++x) out[x] = (uint8_t)(g[x] > bg[x] ? g[x] - bg[x] : bg[x] - g[x]);
+}
+
+/* ---------------- Public API ---------------- */
+
+SkyBlobConfig skyblob_default_config(void) {
+    SkyBlobConfig c;
+    c.thresh    = 24;
+    c.min_area  = 6;
+    c.merge_gap = 4;
+    c.max_blobs = 64;
+    return c;
+}
+
+int skyblob_init(SkyBlobDetector* d, int w, int h, const SkyBlobConfig* cfg) {
+    if (!d || w <= 0 || h <= 0) return ONNX_ERR_INVALID_ARG;
+    memset(d, 0, sizeof(*d));
+    d->w = w;
+    d->h = h;
+    d->cfg = cfg ? *cfg : skyblob_default_config();
+
+    int cx = (w + SKYBLOB_CELL - 1) / SKYBLOB_CELL;
+    int cy = (h + SKYBLOB_CELL - 1) / SKYBLOB_CELL;
+    d->run_capacity = (w * h) / 8 + 1024;
+
+    d->gray      = (uint8_t*)malloc((size_t)w * h);
+    d->bg_row    = (uint8_t*)malloc((size_t)w + 16);
+    d->diff_row  = (uint8_t*)malloc((size_t)w + 16);
+    d->cell_sum  = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)cx * cy);
+    d->cell_cnt  = (uint16_t*)malloc(sizeof(uint16_t) * (size_t)cx * cy);
+    d->cell_mean = (uint8_t*)malloc((size_t)cx * cy);
+    d->runs      = malloc(sizeof(Run) * (size_t)d->run_capacity);
+    d->blobs     = malloc(sizeof(Blob) * (size_t)d->run_capacity);
+
+    if (!d->gray || !d->bg_row || !d->diff_row || !d->cell_sum ||
+        !d->cell_cnt || !d->cell_mean || !d->runs || !d->blobs) {
+        skyblob_destroy(d);
+        return ONNX_ERR_MEMORY;
+    }
+    return ONNX_OK;
+}
+
+static int boxes_touch(const Blob* a, const Blob* b, int gap) {
+    return a->x0 <= b->x1 + gap && b->x0 <= a->x1 + gap &&
+           a->y0 <= b->y1 + gap && b->y0 <= a->y1 + gap;
+}
+
+/* bpp 4: RGBA8, 1: GRAY8; frame is frame_w x frame_h with `stride` bytes per row */
+static int detect_impl(SkyBlobDetector* d,
+                       const uint8_t* src, int bpp, int frame_w, int frame_h, size_t stride,
+                       int bottom_up, int roi_x, int roi_y, int roi_w, int roi_h,
+                       OnnxDet** out_dets, int* out_count) {
+    if (!d || !d->gray || !src || !out_dets || !out_count) return ONNX_ERR_INVALID_ARG;
+    *out_dets = NULL;
+    *out_count = 0;
+
+    if (roi_x < 0) { roi_w += roi_x; roi_x = 0; }
+    if (roi_y < 0) { roi_h += roi_y; roi_y = 0; }
+    if (roi_x + roi_w > frame_w) roi_w = frame_w - roi_x;
+    if (roi_y + roi_h > frame_h) roi_h = frame_h - roi_y;
+    if (roi_w <= 0 || roi_h <= 0) return ONNX_OK;
+    if (roi_w > d->w || roi_h > d->h) return ONNX_ERR_INVALID_ARG;   /* buffers sized at init */
+
+    const int W = roi_w, H = roi_h;
+    const int cells_x = (W + SKYBLOB_CELL - 1) / SKYBLOB_CELL;
+    const int cells_y = (H + SKYBLOB_CELL - 1) / SKYBLOB_CELL;
+
+    /* 1) gray + background cell sums */
+    memset(d->cell_sum, 0, sizeof(uint32_t) * (size_t)cells_x * cells_y);
+    memset(d->cell_cnt, 0, sizeof(uint16_t) * (size_t)cells_x * cells_y);
+    for (int y = 0; y < H; ++y) {
+        int fy = roi_y + y;
+        int sy = bottom_up ? (frame_h - 1 - fy) : fy;
+        const uint8_t* row = src + (size_t)sy * stride + (size_t)roi_x * bpp;
+        uint8_t* g = d->gray + (size_t)y * W;
+        if (bpp == 4) imgproc_rgba_to_gray(row, g, W);
+        else          memcpy(g, row, (size_t)W);
+
+        uint32_t* cs = d->cell_sum + (size_t)(y / SKYBLOB_CELL) * cells_x;
+        uint16_t* cc = d->cell_cnt + (size_t)(y / SKYBLOB_CELL) * cells_x;
+        for (int c = 0; c < cells_x; ++c) {
+            int x0 = c * SKYBLOB_CELL;
+            int n  = (x0 + SKYBLOB_CELL <= W) ? SKYBLOB_CELL : (W - x0);
+            cs[c] += sum_u8(g + x0, n);
+            cc[c] += (uint16_t)n;
+        }
+    }
+    for (int i = 0; i < cells_x * cells_y; ++i)
+        d->cell_sum[i] = d->cell_cnt[i] ? (d->cell_sum[i] + d->cell_cnt[i] / 2) / d->cell_cnt[i] : 0;
+    median3x3_cells(d->cell_sum, d->cell_mean, cells_x, cells_y);
+
+    /* 2) threshold + run extraction + union with previous row */
+    Run* runs = (Run*)d->runs;
+    int nruns = 0;
+    int prev_begin = 0, prev_end = 0;
+    const int th = d->cfg.thresh;
+    int overflow = 0;
+
+    for (int y = 0; y < H && !overflow; ++y) {
+        /* background row: blend the two nearest cell rows */
+        int fy256 = ((2 * y + 1 - SKYBLOB_CELL) * 256) / (2 * SKYBLOB_CELL);
+        int r0 = fy256 < 0 ? 0 : fy256 >> 8;
+        int wy = fy256 < 0 ? 0 : fy256 & 255;
+        if (r0 >= cells_y - 1) { r0 = cells_y - 1; wy = 0; }
+        int r1 = r0 + 1 < cells_y ? r0 + 1 : r0;
+        build_bg_row(d->cell_mean + (size_t)r0 * cells_x, d->cell_mean + (size_t)r1 * cells_x,
+                     wy, cells_x, W, d->bg_row);
+
+        const uint8_t* g = d->gray + (size_t)y * W;
+        abs_diff_row(g, d->bg_row, d->diff_row, W);
+
+        int cur_begin = nruns;
+        int x = 0;
+        int in_run = 0, run_x0 = 0, peak = 0;
+        while (x < W) {
+#if SKYBLOB_SIMD
+            if (x + 16 <= W) {
+                __m128i v = _mm_subs_epu8(_mm_loadu_si128((const __m128i*)(d->diff_row + x)), _mm_set1_epi8((char)th));
+                int m = ~_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) & 0xFFFF;
+                if (m == 0 && !in_run) { x += 16; continue; }
+                if (m == 0xFFFF && in_run) {
+                    for (int k = 0; k < 16; ++k) if (d->diff_row[x + k] > peak) peak = d->diff_row[x + k];
+                    x += 16;
+                    continue;
+                }
+            }
+#endif
+            int on = d->diff_row[x] > th;
+            if (on) {
+                if (!in_run) { in_run = 1; run_x0 = x; peak = 0; }
+                if (d->diff_row[x] > peak) peak = d->diff_row[x];
+            } else if (in_run) {
+                in_run = 0;
+                if (nruns >= d->run_capacity) { overflow = 1; break; }
+                runs[nruns].x0 = (uint16_t)run_x0; runs[nruns].x1 = (uint16_t)(x - 1);
+                runs[nruns].y = (uint16_t)y; runs[nruns].peak = (uint8_t)peak;
+                runs[nruns].parent = nruns;
+                nruns++;
+            }
+            ++x;
+        }
+        if (in_run && !overflow) {
+            if (nruns >= d->run_capacity) { overflow = 1; break; }
+            runs[nruns].x0 = (uint16_t)run_x0; runs[nruns].x1 = (uint16_t)(W - 1);
+            runs[nruns].y = (uint16_t)y; runs[nruns].peak = (uint8_t)peak;
+            runs[nruns].parent = nruns;
+            nruns++;
+        }
+
+        /* 8-connectivity: runs overlap when the previous row extended by 1 touches */
+        int p = prev_begin;
+        for (int c = cur_begin; c < nruns; ++c) {
+            while (p < prev_end && runs[p].x1 + 1 < runs[c].x0) ++p;
+            for (int q = p; q < prev_end && runs[q].x0 <= runs[c].x1 + 1; ++q)
+                uf_union(runs, c, q);
+        }
+        prev_begin = cur_begin;
+        prev_end = nruns;
+    }
+    if (overflow)
+        fprintf(stderr, "[BLOB] run buffer full (%d); frame too noisy, raise thresh\n", d->run_capacity);
+
+    /* 3) per-component stats, accumulated at the root run */
+    Blob* blobs = (Blob*)d->blobs;
+    for (int i = 0; i < nruns; ++i) {
+        runs[i].parent = uf_find(runs, i);
+        if (runs[i].parent == i) {
+            blobs[i].x0 = runs[i].x0; blobs[i].x1 = runs[i].x1;
+            blobs[i].y0 = blobs[i].y1 = runs[i].y;
+            blobs[i].area = 0;
+            blobs[i].peak = 0;
+        }
+    }
+    for (int i = 0; i < nruns; ++i) {
+        int r = runs[i].parent;
+        Blob* b = &blobs[r];
+        if (runs[i].x0 < b->x0) b->x0 = runs[i].x0;
+        if (runs[i].x1 > b->x1) b->x1 = runs[i].x1;
+        if (runs[i].y  < b->y0) b->y0 = runs[i].y;
+        if (runs[i].y  > b->y1) b->y1 = runs[i].y;
+        if (runs[i].peak > b->peak) b->peak = runs[i].peak;
+        b->area += runs[i].x1 - runs[i].x0 + 1;
+    }
+
+    /* compact roots that pass the area filter */
+    int nb = 0;
+    for (int i = 0; i < nruns; ++i) {
+        if (runs[i].parent != i) continue;
+        if (blobs[i].area < d->cfg.min_area) continue;
+        blobs[nb++] = blobs[i];
+    }
+
+    /* 4) merge fragments (wings/fuselage split by the threshold) */
+    for (int merged = 1; merged && nb > 1; ) {
+        merged = 0;
+        for (int i = 0; i < nb; ++i) {
+            for (int j = i + 1; j < nb; ++j) {
+                if (!boxes_touch(&blobs[i], &blobs[j], d->cfg.merge_gap)) continue;
+                Blob* a = &blobs[i];
+                const Blob* b = &blobs[j];
+                if (b->x0 < a->x0) a->x0 = b->x0;
+                if (b->y0 < a->y0) a->y0 = b->y0;
+                if (b->x1 > a->x1) a->x1 = b->x1;
+                if (b->y1 > a->y1) a->y1 = b->y1;
+                if (b->peak > a->peak) a->peak = b->peak;
+                a->area += b->area;
+                blobs[j] = blobs[--nb];
+                merged = 1;
+                --j;
+            }
+        }
+    }
+
+    if (nb == 0) return ONNX_OK;
+    if (nb > d->cfg.max_blobs) nb = d->cfg.max_blobs;
+
+    OnnxDet* dets = (OnnxDet*)malloc(sizeof(OnnxDet) * (size_t)nb);
+    if (!dets) return ONNX_ERR_MEMORY;
+    for (int i = 0; i < nb; ++i) {
+        float s = (float)blobs[i].peak / 64.0f;
+        dets[i].x1 = (float)(roi_x + blobs[i].x0);
+        dets[i].y1 = (float)(roi_y + blobs[i].y0);
+        dets[i].x2 = (float)(roi_x + blobs[i].x1 + 1);
+        dets[i].y2 = (float)(roi_y + blobs[i].y1 + 1);
+        dets[i].score = s > 1.0f ? 1.0f : s;
+        dets[i].cls = SKYBLOB_CLASS;
+    }
+    *out_dets = dets;
+    *out_count = nb;
+    return ONNX_OK;
+}
+
+int skyblob_detect_rgba(SkyBlobDetector* d,
+                        const uint8_t* rgba, int bottom_up,
+                        int roi_x, int roi_y, int roi_w, int roi_h,
+                        OnnxDet** out_dets, int* out_count) {
+    return detect_impl(d, rgba, 4, d ? d->w : 0, d ? d->h : 0, d ? (size_t)d->w * 4 : 0,
+                       bottom_up, roi_x, roi_y, roi_w, roi_h, out_dets, out_count);
+}
+
+int skyblob_detect_gray(SkyBlobDetector* d,
+                        const uint8_t* gray, int w, int h, int stride,
+                        int roi_x, int roi_y, int roi_w, int roi_h,
+                        OnnxDet** out_dets, int* out_count) {
+    return detect_impl(d, gray, 1, w, h, stride > 0 ? (size_t)stride : (size_t)w,
+                       0, roi_x, roi_y, roi_w, roi_h, out_dets, out_count);
+}
+
+void skyblob_destroy(SkyBlobDetector* d) {
+    if (!d) return;
+    free(d->gray);
+    free(d->bg_row);
+    free(d->diff_row);
+    free(d->cell_sum);
+    free(d->cell_cnt);
+    free(d->cell_mean);
+    free(d->runs);
+    free(d->blobs);
+    memset(d, 0, sizeof(*d));
+}
@@ -0,0 +1,48 @@
+#include "snapshot.h"
+#include "infer_cache.h"   /* infer_cache_hash */
+
+#define SNAP_MAGIC   0x31504E5354414C46ull  /* "FLATSNP1" */
+#define SNAP_VERSION 1u
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t state_size;     /* sizeof(SimState) of the writer */
+    uint64_t checksum;       /* hash of the state bytes */
+} SnapHeader;
+
+bool snapshot_save(const char* path, const SimState* st) {
+    FILE* f = fopen(path, "wb");
+    if (!f) { perror("[SNAPSHOT] fopen"); return false; }
+
+    SnapHeader h;
+    h.magic = SNAP_MAGIC;
+    h.version = SNAP_VERSION;
+    h.state_size = (uint32_t)sizeof(SimState);
+    h.checksum = infer_cache_hash(st, sizeof(*st));
+
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(st, sizeof(*st), 1, f) == 1;
+    ok = (fclose(f) == 0) && ok;
+    if (ok) printf("[SNAPSHOT] saved %s (frame %lld, t=%.2fs)\n", path, (long long)st->frame, st->sim_time);
+    else    fprintf(stderr, "[SNAPSHOT] write failed: %s\n", path);
+    return ok;
+}
+
+bool snapshot_load(const char* path, SimState* out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) { perror("[SNAPSHOT] fopen"); return false; }
+
+    SnapHeader h;
+    bool ok = fread(&h, sizeof(h), 1, f) == 1;
+    if (ok && (h.magic != SNAP_MAGIC || h.version != SNAP_VERSION || h.state_size != sizeof(SimState))) {
+        fprintf(stderr, "[SNAPSHOT] %s: written by another build or not a snapshot\n", path);
+        ok = false;
+    }
+    ok = ok && fread(out, sizeof(*out), 1, f) == 1;
+    fclose(f);
+    if (ok && infer_cache_hash(out, sizeof(*out)) != h.checksum) {
+        fprintf(stderr, "[SNAPSHOT] %s: checksum mismatch\n", path);
+        ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,134 @@
+#include "stats.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+int latwin_init(LatencyWindow* w, int capacity) {
+    memset(w, 0, sizeof(*w));
+    if (capacity <= 0) return -1;
+    w->v = (double*)malloc(sizeof(double) * (size_t)capacity);
+    w->scratch = (double*)malloc(sizeof(double) * (size_t)capacity);
+    if (!w->v || !w->scratch) { latwin_free(w); return -1; }
+    w->cap = capacity;
+    return 0;
+}
+
+void latwin_push(LatencyWindow* w, double ms) {
+    if (!w->v) return;
+    w->v[w->head] = ms;
+    w->head = (w->head + 1) % w->cap;
+    if (w->count < w->cap) w->count++;
+    w->total++;
+}
+
+void latwin_reset(LatencyWindow* w) {
+    w->count = 0;
+    w->head = 0;
+    w->total = 0;
+}
+
+void latwin_free(LatencyWindow* w) {
+    free(w->v);
+    free(w->scratch);
+    memset(w, 0, sizeof(*w));
+}
+
+double stats_percentile_sorted(const double* sorted, int n, double p) {
+    if (n <= 0) return 0.0;
+    if (p <= 0.0) return sorted[0];
+    if (p >= 100.0) return sorted[n - 1];
+    double pos = p / 100.0 * (double)(n - 1);
+    int i = (int)pos;
+    double f = pos - (double)i;
+    return (i + 1 < n) ? sorted[i] + (sorted[i + 1] - sorted[i]) * f : sorted[i];
+}
+
+int latwin_percentiles(LatencyWindow* w, const double* ps, double* out, int n) {
+    if (!w->v || w->count == 0) {
+        for (int i = 0; i < n; ++i) out[i] = 0.0;
+        return 0;
+    }
+    memcpy(w->scratch, w->v, sizeof(double) * (size_t)w->count);
+    qsort(w->scratch, (size_t)w->count, sizeof(double), cmp_double);
+    for (int i = 0; i < n; ++i)
+        out[i] = stats_percentile_sorted(w->scratch, w->count, ps[i]);
+    return w->count;
+}
+
+/* ---------------- Log-bucketed histogram ---------------- */
+
+int loghist_bucket(double ms) {
+    if (!(ms >= LOGHIST_MIN_MS)) return 0;
+    int e;
+    double m = frexp(ms / LOGHIST_MIN_MS, &e);          /* [0.5, 1) * 2^e */
+    int b = 1 + (e - 1) * LOGHIST_SUB + (int)((m * 2.0 - 1.0) * LOGHIST_SUB);
+    return b < LOGHIST_BUCKETS ? b : LOGHIST_BUCKETS - 1;
+}
+
+double loghist_bucket_lower(int b) {
+    if (b <= 0) return 0.0;
+    int octave = (b - 1) / LOGHIST_SUB, sub = (b - 1) % LOGHIST_SUB;
+    return LOGHIST_MIN_MS * ldexp(1.0 + (double)sub / LOGHIST_SUB, octave);
+}
+
+void loghist_add(LogHist* h, double ms) {
+    h->n[loghist_bucket(ms)]++;
+    h->count++;
+    h->sum += ms;
+    if (ms > h->max) h->max = ms;
+}
+
+void loghist_reset(LogHist* h) {
+    memset(h, 0, sizeof(*h));
+}
+
+double loghist_percentile(const LogHist* h, double p) {
+    if (h->count == 0) return 0.0;
+    double target = p / 100.0 * (double)h->count;
+    double cum = 0.0;
+    for (int b = 0; b < LOGHIST_BUCKETS; ++b) {
+        if (!h->n[b]) continue;
+        if (cum + h->n[b] >= target) {
+            /* linear inside the bucket */
+            double lo = loghist_bucket_lower(b), hi = loghist_bucket_lower(b + 1);
+            if (b == LOGHIST_BUCKETS - 1) hi = lo * 2.0;
+            return lo + (hi - lo) * ((target - cum) / h->n[b]);
+        }
+        cum += h->n[b];
+    }
+    return loghist_bucket_lower(LOGHIST_BUCKETS - 1);
+}
+
+int rollhist_init(RollingHist* r, int capacity) {
+    memset(r, 0, sizeof(*r));
+    if (capacity <= 0) return -1;
+    r->ring = (uint8_t*)malloc((size_t)capacity);
+    if (!r->ring) return -1;
+    r->cap = capacity;
+    return 0;
+}
+
+void rollhist_push(RollingHist* r, double ms) {
+    if (!r->ring) return;
+    if (r->count == r->cap) {
+        r->h.n[r->ring[r->head]]--;
+        r->h.count--;
+    } else {
+        r->count++;
+    }
+    int b = loghist_bucket(ms);
+    r->ring[r->head] = (uint8_t)b;
+    r->head = (r->head + 1) % r->cap;
+    r->h.n[b]++;
+    r->h.count++;
+}
+
+void rollhist_free(RollingHist* r) {
+    free(r->ring);
+    memset(r, 0, sizeof(*r));
+}
@@ -431,6 +431,11 @@ bool update_text(int id, const char *str)
     return true;
 }
 
+void set_text_visible(int id, bool visible)
+{
+    renderable_texts[id].visible = visible;
+}
+
 bool change_text_colour(int id, float r, float g, float b, float a)
 {
     renderable_texts[id].r = r;
@@ -440,7 +445,7 @@ bool change_text_colour(int id, float r, float g, float b, float a)
     return true;
 }
 
-void draw_texts()
+static void draw_text_span(int first, int end, bool only_visible)
 {
     // always draw on-top of scene
     glDisable(GL_DEPTH_TEST);
@@ -450,8 +455,10 @@ void draw_texts()
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, font_texture);
     glUseProgram(font_sp);
-    for (int i = 0; i < num_render_strings; i++)
+    for (int i = first; i < end; i++)
     {
+        if (only_visible && !renderable_texts[i].visible)
+            continue;
         // Set up vertex attributes directly (no VAO support in OpenGL ES 2.0)
         glBindBuffer(GL_ARRAY_BUFFER, renderable_texts[i].points_vbo);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
@@ -478,3 +485,15 @@ void draw_texts()
     glDisable(GL_BLEND);
     glEnable(GL_DEPTH_TEST);
 }
+
+void draw_texts()
+{
+    draw_text_span(0, num_render_strings, true);
+}
+
+void draw_text_range(int first, int count)
+{
+    if (first < 0 || count <= 0 || first + count > num_render_strings)
+        return;
+    draw_text_span(first, first + count, false);
+}
@@ -0,0 +1,345 @@
+#define _GNU_SOURCE
+#include "trace.h"
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#define TRACE_BUFFER_EVENTS 16384
+#define TRACE_GPU_TID       1000000000L     /* outside the kernel's pid range */
+#define TRACE_ORT_TIDS      64
+
+enum { TRACK_CPU, TRACK_GPU };
+
+typedef struct {
+    const char* name;
+    int64_t     ts_ns;        /* since trace_open */
+    int64_t     dur_ns;
+    long        frame;        /* "args": {"frame": N}; -1 = none */
+    int         track;
+} TraceEvent;
+
+typedef struct {
+    GLuint      query;
+    const char* name;
+    int64_t     submit_ns;
+} GpuSpan;
+
+static struct {
+    bool    on;
+    FILE*   fp;
+    long    pid, tid;
+    int64_t mono0_ns, real0_ns;
+    long    written;
+
+    TraceEvent* ev;
+    int         nev;
+
+    struct { const char* name; int64_t t0; bool gpu; } stack[TRACE_MAX_DEPTH];
+    int     depth;
+    int64_t frame_t0;         /* first span of the current frame, -1 = none yet */
+
+    /* EXT_disjoint_timer_query */
+    bool    gpu;
+    bool    gpu_open;
+    PFNGLGENQUERIESEXTPROC          gen_queries;
+    PFNGLDELETEQUERIESEXTPROC       delete_queries;
+    PFNGLBEGINQUERYEXTPROC          begin_query;
+    PFNGLENDQUERYEXTPROC            end_query;
+    PFNGLGETQUERYOBJECTUIVEXTPROC   get_query_uiv;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_ui64v;
+    GLuint  pool[TRACE_GPU_QUERIES];
+    int     nfree;
+    GpuSpan pending[TRACE_GPU_QUERIES];   /* FIFO in submit order */
+    int     pend_head, pend_count;
+    int64_t gpu_cursor_ns;    /* end of the last GPU span on the track */
+    long    gpu_spans, gpu_dropped, gpu_disjoint, gpu_invalid;
+
+    char*    ort_path;
+    uint64_t ort_start_ns;
+} g_tr = { .frame_t0 = -1 };
+
+static int64_t clock_ns(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int64_t now_ns(void) { return clock_ns(CLOCK_MONOTONIC) - g_tr.mono0_ns; }
+
+static void write_raw(const char* json) {
+    fprintf(g_tr.fp, "%s%s", g_tr.written++ ? ",\n" : "", json);
+}
+
+static void write_meta(long tid, const char* what, const char* name) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+             what, g_tr.pid, tid, name);
+    write_raw(buf);
+}
+
+static void flush_events(void) {
+    char buf[256];
+    for (int i = 0; i < g_tr.nev; ++i) {
+        const TraceEvent* e = &g_tr.ev[i];
+        int n = snprintf(buf, sizeof(buf), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%ld,\"tid\":%ld,\"ts\":%.3f,\"dur\":%.3f",
+                         e->name, g_tr.pid, e->track == TRACK_GPU ? TRACE_GPU_TID : g_tr.tid,
+                         e->ts_ns / 1000.0, e->dur_ns / 1000.0);
+        if (e->frame >= 0) snprintf(buf + n, sizeof(buf) - n, ",\"args\":{\"frame\":%ld}}", e->frame);
+        else               snprintf(buf + n, sizeof(buf) - n, "}");
+        write_raw(buf);
+    }
+    g_tr.nev = 0;
+}
+
+static void push_event(const char* name, int64_t ts, int64_t dur, long frame, int track) {
+    if (g_tr.nev == TRACE_BUFFER_EVENTS) flush_events();
+    g_tr.ev[g_tr.nev++] = (TraceEvent){ name, ts, dur, frame, track };
+}
+
+bool trace_open(const char* path) {
+    g_tr.fp = fopen(path, "w");
+    if (!g_tr.fp) {
+        fprintf(stderr, "[TRACE] cannot write %s\n", path);
+        return false;
+    }
+    g_tr.ev = malloc(sizeof(TraceEvent) * TRACE_BUFFER_EVENTS);
+    if (!g_tr.ev) { fclose(g_tr.fp); g_tr.fp = NULL; return false; }
+
+    g_tr.pid      = (long)getpid();
+    g_tr.tid      = (long)syscall(SYS_gettid);
+    g_tr.mono0_ns = clock_ns(CLOCK_MONOTONIC);
+    g_tr.real0_ns = clock_ns(CLOCK_REALTIME);
+    g_tr.frame_t0 = -1;
+    g_tr.on       = true;
+
+    fprintf(g_tr.fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    write_meta(g_tr.tid, "process_name", "simulator");
+    write_meta(g_tr.tid, "thread_name", "render");
+    write_meta(TRACE_GPU_TID, "thread_name", "GPU");
+    printf("[TRACE] writing %s\n", path);
+    return true;
+}
+
+bool trace_active(void) { return g_tr.on; }
+
+static bool has_gl_ext(const char* name) {
+    const char* list = (const char*)glGetString(GL_EXTENSIONS);
+    if (!list) return false;
+    size_t n = strlen(name);
+    for (const char* p = list; (p = strstr(p, name)) != NULL; p += n)
+        if ((p == list || p[-1] == ' ') && (p[n] == ' ' || p[n] == '\0')) return true;
+    return false;
+}
+
+void trace_gpu_init(TraceGetProc get_proc) {
+    if (!g_tr.on || g_tr.gpu) return;
+    if (!has_gl_ext("GL_EXT_disjoint_timer_query")) {
+        printf("[TRACE] GL_EXT_disjoint_timer_query not available, CPU spans only\n");
+        return;
+    }
+    g_tr.gen_queries     = (PFNGLGENQUERIESEXTPROC)get_proc("glGenQueriesEXT");
+    g_tr.delete_queries  = (PFNGLDELETEQUERIESEXTPROC)get_proc("glDeleteQueriesEXT");
+    g_tr.begin_query     = (PFNGLBEGINQUERYEXTPROC)get_proc("glBeginQueryEXT");
+    g_tr.end_query       = (PFNGLENDQUERYEXTPROC)get_proc("glEndQueryEXT");
+    g_tr.get_query_uiv   = (PFNGLGETQUERYOBJECTUIVEXTPROC)get_proc("glGetQueryObjectuivEXT");
+    g_tr.get_query_ui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC)get_proc("glGetQueryObjectui64vEXT");
+    if (!g_tr.gen_queries || !g_tr.delete_queries || !g_tr.begin_query || !g_tr.end_query ||
+        !g_tr.get_query_uiv || !g_tr.get_query_ui64v) {
+        printf("[TRACE] timer query entry points missing, CPU spans only\n");
+        return;
+    }
+    g_tr.gen_queries(TRACE_GPU_QUERIES, g_tr.pool);
+    g_tr.nfree = TRACE_GPU_QUERIES;
+    GLint disjoint;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);   /* clears the flag */
+    g_tr.gpu = true;
+    printf("[TRACE] GPU timer queries enabled\n");
+}
+
+void trace_begin(const char* name) {
+    if (!g_tr.on || g_tr.depth == TRACE_MAX_DEPTH) return;
+    int64_t t = now_ns();
+    if (g_tr.frame_t0 < 0) g_tr.frame_t0 = t;
+    g_tr.stack[g_tr.depth].name = name;
+    g_tr.stack[g_tr.depth].t0   = t;
+    g_tr.stack[g_tr.depth].gpu  = false;
+    g_tr.depth++;
+}
+
+void trace_end(void) {
+    if (!g_tr.on || g_tr.depth == 0) return;
+    g_tr.depth--;
+    const int d = g_tr.depth;
+    int64_t t0 = g_tr.stack[d].t0;
+    if (g_tr.stack[d].gpu) {
+        g_tr.end_query(GL_TIME_ELAPSED_EXT);
+        g_tr.gpu_open = false;
+        int slot = (g_tr.pend_head + g_tr.pend_count) % TRACE_GPU_QUERIES;
+        g_tr.pending[slot].name      = g_tr.stack[d].name;
+        g_tr.pending[slot].submit_ns = t0;
+        g_tr.pend_count++;
+    }
+    push_event(g_tr.stack[d].name, t0, now_ns() - t0, -1, TRACK_CPU);
+}
+
+void trace_gpu_begin(const char* name) {
+    if (!g_tr.on) return;
+    const int depth = g_tr.depth;
+    trace_begin(name);
+    if (!g_tr.gpu || g_tr.gpu_open || g_tr.depth == depth) return;
+    if (g_tr.nfree == 0) { g_tr.gpu_dropped++; return; }
+
+    GLuint q = g_tr.pool[--g_tr.nfree];
+    int slot = (g_tr.pend_head + g_tr.pend_count) % TRACE_GPU_QUERIES;
+    g_tr.pending[slot].query = q;
+    g_tr.begin_query(GL_TIME_ELAPSED_EXT, q);
+    g_tr.stack[g_tr.depth - 1].gpu = true;
+    g_tr.gpu_open = true;
+}
+
+void trace_gpu_end(void) { trace_end(); }
+
+/* Finished queries in submit order; stops at the first one still running */
+static void collect_gpu(bool wait) {
+    if (!g_tr.gpu || g_tr.pend_count == 0) return;
+    GpuSpan done[TRACE_GPU_QUERIES];
+    GLuint64 elapsed[TRACE_GPU_QUERIES];
+    int ndone = 0;
+    while (g_tr.pend_count > 0) {
+        GpuSpan* s = &g_tr.pending[g_tr.pend_head];
+        GLuint avail = 0;
+        if (!wait) g_tr.get_query_uiv(s->query, GL_QUERY_RESULT_AVAILABLE_EXT, &avail);
+        if (!wait && !avail) break;
+        g_tr.get_query_ui64v(s->query, GL_QUERY_RESULT_EXT, &elapsed[ndone]);
+        done[ndone++] = *s;
+        g_tr.pool[g_tr.nfree++] = s->query;
+        g_tr.pend_head = (g_tr.pend_head + 1) % TRACE_GPU_QUERIES;
+        g_tr.pend_count--;
+    }
+    if (ndone == 0) return;
+
+    /* A disjoint event (clock change, reset) makes these results meaningless */
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint) { g_tr.gpu_disjoint += ndone; return; }
+
+    const int64_t now = now_ns();
+    for (int i = 0; i < ndone; ++i) {
+        /* Cannot exceed the wall time since submit (some drivers botch the first query) */
+        if ((int64_t)elapsed[i] > now - done[i].submit_ns) { g_tr.gpu_invalid++; continue; }
+        int64_t ts = done[i].submit_ns > g_tr.gpu_cursor_ns ? done[i].submit_ns : g_tr.gpu_cursor_ns;
+        push_event(done[i].name, ts, (int64_t)elapsed[i], -1, TRACK_GPU);
+        g_tr.gpu_cursor_ns = ts + (int64_t)elapsed[i];
+        g_tr.gpu_spans++;
+    }
+}
+
+void trace_frame_end(long frame) {
+    if (!g_tr.on) return;
+    if (g_tr.frame_t0 >= 0) {
+        push_event("frame", g_tr.frame_t0, now_ns() - g_tr.frame_t0, frame, TRACK_CPU);
+        g_tr.frame_t0 = -1;
+    }
+    collect_gpu(false);
+    if (g_tr.nev > TRACE_BUFFER_EVENTS / 2) flush_events();
+}
+
+void trace_ort_profile(const char* path, uint64_t start_ns) {
+    if (!g_tr.on || !path) return;
+    free(g_tr.ort_path);
+    g_tr.ort_path     = strdup(path);
+    g_tr.ort_start_ns = start_ns;
+}
+
+/* Copies one ORT event object with "ts" shifted and "pid" replaced */
+static void write_ort_event(char* line, int64_t shift_us, long* tids, int* ntids) {
+    size_t len = strlen(line);
+    while (len && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ',' || line[len - 1] == ' '))
+        line[--len] = '\0';
+    if (len < 2 || line[0] != '{') return;
+
+    char* ts_key  = strstr(line, "\"ts\"");
+    char* pid_key = strstr(line, "\"pid\"");
+    char* tid_key = strstr(line, "\"tid\"");
+    if (!ts_key) return;
+
+    /* Splice "pid" and "ts" values in place order; everything else is kept */
+    char* keys[2] = { ts_key, pid_key };
+    if (pid_key && pid_key < ts_key) { keys[0] = pid_key; keys[1] = ts_key; }
+
+    fprintf(g_tr.fp, ",\n");
+    g_tr.written++;
+    const char* p = line;
+    for (int k = 0; k < 2; ++k) {
+        char* key = keys[k];
+        if (!key) continue;
+        char* v = strchr(key + 3, ':');
+        if (!v) continue;
+        ++v;
+        while (*v == ' ') ++v;
+        char* end;
+        long long value = strtoll(v, &end, 10);
+        fwrite(p, 1, (size_t)(v - p), g_tr.fp);
+        if (key == ts_key) fprintf(g_tr.fp, "%lld", value + (long long)shift_us);
+        else               fprintf(g_tr.fp, "%ld", g_tr.pid);
+        p = end;
+    }
+    fputs(p, g_tr.fp);
+
+    if (tid_key) {
+        char* v = strchr(tid_key + 4, ':');
+        long tid = v ? strtol(v + 1, NULL, 10) : 0;
+        int seen = 0;
+        for (int i = 0; i < *ntids && !seen; ++i) seen = tids[i] == tid;
+        if (!seen && *ntids < TRACE_ORT_TIDS) tids[(*ntids)++] = tid;
+    }
+}
+
+static void merge_ort(void) {
+    FILE* in = fopen(g_tr.ort_path, "r");
+    if (!in) {
+        fprintf(stderr, "[TRACE] cannot read ORT profile %s\n", g_tr.ort_path);
+        return;
+    }
+    /* ORT "ts" is microseconds since its profiling start (system clock) */
+    int64_t shift_us = ((int64_t)g_tr.ort_start_ns - g_tr.real0_ns) / 1000;
+    long tids[TRACE_ORT_TIDS];
+    int ntids = 0;
+    long before = g_tr.written;
+    char* line = NULL;
+    size_t cap = 0;
+    while (getline(&line, &cap, in) > 0) write_ort_event(line, shift_us, tids, &ntids);
+    free(line);
+    fclose(in);
+    printf("[TRACE] merged %ld ORT events from %s\n", g_tr.written - before, g_tr.ort_path);
+    for (int i = 0; i < ntids; ++i)
+        if (tids[i] != g_tr.tid) write_meta(tids[i], "thread_name", "onnxruntime");
+}
+
+void trace_close(void) {
+    if (!g_tr.on) return;
+    while (g_tr.depth > 0) trace_end();
+    collect_gpu(true);
+    flush_events();
+    if (g_tr.ort_path) merge_ort();
+    fprintf(g_tr.fp, "\n]}\n");
+    bool ok = fclose(g_tr.fp) == 0;
+    if (g_tr.gpu) g_tr.delete_queries(TRACE_GPU_QUERIES, g_tr.pool);
+
+    printf("[TRACE] %ld events", g_tr.written);
+    if (g_tr.gpu)
+        printf(", %ld GPU spans (%ld skipped, %ld disjoint, %ld invalid)", g_tr.gpu_spans, g_tr.gpu_dropped,
+               g_tr.gpu_disjoint, g_tr.gpu_invalid);
+    printf("%s\n", ok ? "" : " -- write failed");
+
+    free(g_tr.ev);
+    free(g_tr.ort_path);
+    memset(&g_tr, 0, sizeof(g_tr));
+    g_tr.frame_t0 = -1;
+}
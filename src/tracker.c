@@ -0,0 +1,151 @@
+#include "tracker.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    float iou;
+    int   det, track;
+} Pair;
+
+TrackerConfig tracker_default_config(void) {
+    TrackerConfig c;
+    c.iou_match  = 0.3f;
+    c.max_misses = 5;
+    c.min_hits   = 2;
+    return c;
+}
+
+void tracker_init(Tracker* t, const TrackerConfig* cfg) {
+    memset(t, 0, sizeof(*t));
+    t->cfg = cfg ? *cfg : tracker_default_config();
+    t->next_id = 1;
+}
+
+static float iou_xyxy(float ax1, float ay1, float ax2, float ay2,
+                      float bx1, float by1, float bx2, float by2) {
+    float ix = (ax2 < bx2 ? ax2 : bx2) - (ax1 > bx1 ? ax1 : bx1);
+    float iy = (ay2 < by2 ? ay2 : by2) - (ay1 > by1 ? ay1 : by1);
+    if (ix <= 0.f || iy <= 0.f) return 0.f;
+    float inter = ix * iy;
+    float uni = (ax2 - ax1) * (ay2 - ay1) + (bx2 - bx1) * (by2 - by1) - inter;
+    return uni > 0.f ? inter / uni : 0.f;
+}
+
+static int cmp_pair_desc(const void* a, const void* b) {
+    float x = ((const Pair*)a)->iou, y = ((const Pair*)b)->iou;
+    return (x < y) - (x > y);
+}
+
+static int grow(void** p, int* cap, int need, size_t elem) {
+    if (need <= *cap) return 1;
+    int c = *cap ? *cap : 16;
+    while (c < need) c *= 2;
+    void* q = realloc(*p, (size_t)c * elem);
+    if (!q) return 0;
+    *p = q;
+    *cap = c;
+    return 1;
+}
+
+int tracker_update(Tracker* t, const OnnxDet* dets, int n, int* out_ids) {
+    if (n < 0 || (n > 0 && !dets)) return ONNX_ERR_INVALID_ARG;
+
+    /* 1) predict: shift every box by its velocity */
+    for (int i = 0; i < t->count; ++i) {
+        Track* tr = &t->tracks[i];
+        tr->x1 += tr->vx; tr->x2 += tr->vx;
+        tr->y1 += tr->vy; tr->y2 += tr->vy;
+        tr->age++;
+    }
+
+    /* 2) candidate pairs above the IoU gate, best first */
+    if (!grow(&t->pairs, &t->pair_cap, n * t->count + 1, sizeof(Pair)) ||
+        !grow((void**)&t->det_track, &t->det_cap, n + 1, sizeof(int)))
+        return ONNX_ERR_MEMORY;
+    Pair* pairs = (Pair*)t->pairs;
+    int np = 0;
+    for (int d = 0; d < n; ++d) {
+        for (int k = 0; k < t->count; ++k) {
+            const Track* tr = &t->tracks[k];
+            float iou = iou_xyxy(dets[d].x1, dets[d].y1, dets[d].x2, dets[d].y2,
+                                 tr->x1, tr->y1, tr->x2, tr->y2);
+            if (iou >= t->cfg.iou_match) { pairs[np].iou = iou; pairs[np].det = d; pairs[np].track = k; np++; }
+        }
+    }
+    qsort(pairs, (size_t)np, sizeof(Pair), cmp_pair_desc);
+
+    int* det_track = t->det_track;
+    for (int d = 0; d < n; ++d) det_track[d] = -1;
+    for (int k = 0; k < t->count; ++k) t->tracks[k].misses++;   /* cleared on match */
+
+    for (int i = 0; i < np; ++i) {
+        Track* tr = &t->tracks[pairs[i].track];
+        int d = pairs[i].det;
+        if (det_track[d] >= 0 || tr->misses == 0) continue;   /* either side taken */
+        det_track[d] = pairs[i].track;
+
+        float pcx = 0.5f * (tr->x1 + tr->x2) - tr->vx, pcy = 0.5f * (tr->y1 + tr->y2) - tr->vy;
+        float cx = 0.5f * (dets[d].x1 + dets[d].x2), cy = 0.5f * (dets[d].y1 + dets[d].y2);
+        tr->vx = 0.5f * tr->vx + 0.5f * (cx - pcx);
+        tr->vy = 0.5f * tr->vy + 0.5f * (cy - pcy);
+        tr->x1 = dets[d].x1; tr->y1 = dets[d].y1;
+        tr->x2 = dets[d].x2; tr->y2 = dets[d].y2;
+        tr->cls = dets[d].cls;
+        tr->score = dets[d].score;
+        tr->hits++;
+        tr->misses = 0;
+    }
+
+    /* 3) drop stale tracks (order kept so det_track indices stay valid until step 4) */
+    int* remap = (int*)malloc(sizeof(int) * (size_t)(t->count + 1));
+    if (!remap) return ONNX_ERR_MEMORY;
+    int kept = 0;
+    for (int k = 0; k < t->count; ++k) {
+        if (t->tracks[k].misses > t->cfg.max_misses) { remap[k] = -1; continue; }
+        remap[k] = kept;
+        t->tracks[kept++] = t->tracks[k];
+    }
+    t->count = kept;
+    for (int d = 0; d < n; ++d)
+        if (det_track[d] >= 0) det_track[d] = remap[det_track[d]];
+    free(remap);
+
+    /* 4) new tracks for unmatched detections */
+    if (!grow((void**)&t->tracks, &t->cap, t->count + n, sizeof(Track))) return ONNX_ERR_MEMORY;
+    for (int d = 0; d < n; ++d) {
+        if (det_track[d] >= 0) continue;
+        Track* tr = &t->tracks[t->count];
+        memset(tr, 0, sizeof(*tr));
+        tr->id = t->next_id++;
+        tr->cls = dets[d].cls;
+        tr->score = dets[d].score;
+        tr->x1 = dets[d].x1; tr->y1 = dets[d].y1;
+        tr->x2 = dets[d].x2; tr->y2 = dets[d].y2;
+        tr->hits = 1;
+        det_track[d] = t->count++;
+    }
+
+    if (out_ids) {
+        for (int d = 0; d < n; ++d) {
+            const Track* tr = &t->tracks[det_track[d]];
+            out_ids[d] = tr->hits >= t->cfg.min_hits ? tr->id : -1;
+        }
+    }
+    return ONNX_OK;
+}
+
+int tracker_is_reported(const Tracker* t, const Track* tr) {
+    return tr->misses == 0 && tr->hits >= t->cfg.min_hits;
+}
+
+void tracker_reset(Tracker* t) {
+    t->count = 0;
+    t->next_id = 1;
+}
+
+void tracker_free(Tracker* t) {
+    free(t->tracks);
+    free(t->pairs);
+    free(t->det_track);
+    memset(t, 0, sizeof(*t));
+}
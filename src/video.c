@@ -0,0 +1,331 @@
+#define _GNU_SOURCE
+#include "video.h"
+#include "fcodec.h"
+#include "stats.h"
+#include <GLES2/gl2.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#define VIDEO_LAT_WINDOW 4096
+#define VIDEO_FCV_STRIPES 8
+
+
+enum { VIDEO_RAW, VIDEO_Y4M, VIDEO_FCV };
+
+/* ---------------- State ---------------- */
+
+static struct {
+    int             running;
+    FILE*           fp;
+    int             format;        /* VIDEO_RAW / VIDEO_Y4M / VIDEO_FCV */
+    int             stripes;       /* fcv: parallel encode stripes */
+    int             w, h;          /* output size */
+    int             div, src_w, src_h; /* --video-downscale; src: readback size */
+    bool            block;
+
+    uint8_t*        slots[VIDEO_RING_SLOTS];   /* bottom-up RGBA readbacks */
+    int             head, tail, count;         /* guarded by lock */
+    int             stop;
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  have_frame;
+    pthread_cond_t  have_space;
+
+    long            captured, dropped, written;   /* written: writer thread */
+    int             write_error;
+    LatencyWindow   read_lat;      /* render thread: glReadPixels */
+    LatencyWindow   write_lat;     /* writer thread: convert + fwrite */
+} g_video;
+
+static double now_ms(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec * 1000.0 + (double)t.tv_nsec / 1e6;
+}
+
+/* ---------------- Conversion ---------------- */
+
+static inline uint8_t clamp_u8(int v) {
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static void rgba_row_to_luma(const uint8_t* s, uint8_t* y, int w) {
+    for (int x = 0; x < w; ++x, s += 4)
+        y[x] = (uint8_t)((77 * s[0] + 150 * s[1] + 29 * s[2] + 128) >> 8);
+}
+
+/* Bottom-up RGBA -> top-down I420, BT.601 full range ("C420jpeg").
+ * Luma row by row, then chroma over 2x2 blocks; an odd last column or
+ * row repeats its edge pixel. */
+static void rgba_to_i420(const uint8_t* src, int w, int h, uint8_t* yp, uint8_t* up, uint8_t* vp) {
+    const int cw = (w + 1) / 2, pairs = w / 2;
+    for (int y = 0; y < h; y += 2) {
+        const uint8_t* r0 = src + (size_t)(h - 1 - y) * w * 4;
+        const uint8_t* r1 = (y + 1 < h) ? r0 - (size_t)w * 4 : r0;
+        rgba_row_to_luma(r0, yp + (size_t)y * w, w);
+        if (y + 1 < h) rgba_row_to_luma(r1, yp + (size_t)(y + 1) * w, w);
+        uint8_t* u = up + (size_t)(y / 2) * cw;
+        uint8_t* v = vp + (size_t)(y / 2) * cw;
+
+        for (int c = 0; c < cw; ++c) {
+            const uint8_t* a = r0 + 8 * c;
+            const uint8_t* b = r1 + 8 * c;
+            const int k = c < pairs ? 4 : 0;     /* odd width: last block repeats its column */
+            int rs = a[0] + a[k] + b[0] + b[k];
+            int gs = a[1] + a[k + 1] + b[1] + b[k + 1];
+            int bs = a[2] + a[k + 2] + b[2] + b[k + 2];
+            /* sums of 4 pixels: scale 1/1024 instead of 1/256 */
+            u[c] = clamp_u8(((-43 * rs - 85 * gs + 128 * bs + 512) >> 10) + 128);
+            v[c] = clamp_u8(((128 * rs - 107 * gs - 21 * bs + 512) >> 10) + 128);
+        }
+    }
+}
+
+/* Bottom-up RGBA box-filtered by div into (w/div) x (h/div), still bottom-up.
+ * Rows are taken from the top so the cut remainder is at the bottom edge. */
+static void rgba_downscale(const uint8_t* src, int sw, int sh, int div, uint8_t* dst, int w, int h) {
+    const int n = div * div, half = n / 2;
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* row0 = src + (size_t)(sh - (h - y) * div) * sw * 4;
+        uint8_t* d = dst + (size_t)y * w * 4;
+        if (div == 2) {
+            const uint8_t* a = row0;
+            const uint8_t* c = row0 + (size_t)sw * 4;
+            for (int x = 0; x < w; ++x, a += 8, c += 8, d += 4) {
+                d[0] = (uint8_t)((a[0] + a[4] + c[0] + c[4] + 2) >> 2);
+                d[1] = (uint8_t)((a[1] + a[5] + c[1] + c[5] + 2) >> 2);
+                d[2] = (uint8_t)((a[2] + a[6] + c[2] + c[6] + 2) >> 2);
+                d[3] = 255;
+            }
+            continue;
+        }
+        for (int x = 0; x < w; ++x) {
+            int r = 0, g = 0, b = 0;
+            for (int j = 0; j < div; ++j) {
+                const uint8_t* s = row0 + (size_t)j * sw * 4 + (size_t)x * div * 4;
+                for (int i = 0; i < div; ++i, s += 4) { r += s[0]; g += s[1]; b += s[2]; }
+            }
+            d[4 * x + 0] = (uint8_t)((r + half) / n);
+            d[4 * x + 1] = (uint8_t)((g + half) / n);
+            d[4 * x + 2] = (uint8_t)((b + half) / n);
+            d[4 * x + 3] = 255;
+        }
+    }
+}
+
+/* ---------------- Writer ---------------- */
+
+static void* video_writer(void* arg) {
+    (void)arg;
+    const int w = g_video.w, h = g_video.h;
+    const size_t luma = (size_t)w * h;
+    const size_t chroma = (size_t)((w + 1) / 2) * ((h + 1) / 2);
+    const size_t fcv_cap = fcodec_bound(w, h, 4, g_video.stripes);
+    uint8_t* out = malloc(g_video.format == VIDEO_Y4M ? luma + 2 * chroma :
+                          g_video.format == VIDEO_FCV ? fcv_cap : (size_t)w * 3);
+    uint8_t* small = g_video.div > 1 ? malloc((size_t)w * h * 4) : NULL;
+
+    for (;;) {
+        pthread_mutex_lock(&g_video.lock);
+        while (g_video.count == 0 && !g_video.stop)
+            pthread_cond_wait(&g_video.have_frame, &g_video.lock);
+        if (g_video.count == 0) { pthread_mutex_unlock(&g_video.lock); break; }
+        const uint8_t* rgba = g_video.slots[g_video.tail];
+        const int failed = g_video.write_error;
+        pthread_mutex_unlock(&g_video.lock);
+
+        double t0 = now_ms();
+        int ok = out != NULL && !failed;
+        if (g_video.div > 1) {
+            ok = ok && small != NULL;
+            if (ok) rgba_downscale(rgba, g_video.src_w, g_video.src_h, g_video.div, small, w, h);
+            rgba = small;
+        }
+        if (ok && g_video.format == VIDEO_Y4M) {
+            rgba_to_i420(rgba, w, h, out, out + luma, out + luma + chroma);
+            ok = fwrite("FRAME\n", 1, 6, g_video.fp) == 6 &&
+                 fwrite(out, 1, luma + 2 * chroma, g_video.fp) == luma + 2 * chroma;
+        } else if (ok && g_video.format == VIDEO_FCV) {
+            size_t n = fcodec_encode(rgba, w, h, 4, 0, true, g_video.stripes, out, fcv_cap);
+            ok = n > 0 && fcodec_stream_write_frame(g_video.fp, out, n);
+        } else if (ok) {
+            for (int y = 0; y < h && ok; ++y) {
+                const uint8_t* s = rgba + (size_t)(h - 1 - y) * w * 4;
+                for (int x = 0; x < w; ++x) {
+                    out[3 * x + 0] = s[4 * x + 0];
+                    out[3 * x + 1] = s[4 * x + 1];
+                    out[3 * x + 2] = s[4 * x + 2];
+                }
+                ok = fwrite(out, 1, (size_t)w * 3, g_video.fp) == (size_t)w * 3;
+            }
+        }
+        double t1 = now_ms();
+
+        pthread_mutex_lock(&g_video.lock);
+        if (ok) {
+            g_video.written++;
+        } else if (failed) {
+            g_video.dropped++;     /* queued before the error was seen */
+        } else {
+            g_video.write_error = 1;
+            g_video.dropped++;
+            fprintf(stderr, "[VIDEO] write failed, further frames are discarded\n");
+        }
+        if (!failed) latwin_push(&g_video.write_lat, t1 - t0);
+        g_video.tail = (g_video.tail + 1) % VIDEO_RING_SLOTS;
+        g_video.count--;
+        pthread_cond_signal(&g_video.have_space);
+        pthread_mutex_unlock(&g_video.lock);
+    }
+    free(out);
+    free(small);
+    return NULL;
+}
+
+/* ---------------- API ---------------- */
+
+static int has_suffix(const char* s, const char* suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcasecmp(s + n - m, suffix) == 0;
+}
+
+bool video_open(const char* path, int width, int height, double fps, bool block_when_full, int downscale) {
+    if (g_video.running || !path || width <= 0 || height <= 0) return false;
+    if (downscale < 1 || downscale > VIDEO_MAX_DOWNSCALE || width / downscale < 2 || height / downscale < 2) {
+        fprintf(stderr, "[VIDEO] downscale must be 1..%d\n", VIDEO_MAX_DOWNSCALE);
+        return false;
+    }
+    memset(&g_video, 0, sizeof(g_video));
+    g_video.div = downscale;
+    g_video.src_w = width;
+    g_video.src_h = height;
+    width /= downscale;
+    height /= downscale;
+    g_video.w = width;
+    g_video.h = height;
+
+    g_video.fp = fopen(path, "wb");
+    if (!g_video.fp) { perror("[VIDEO] open"); return false; }
+    g_video.format = has_suffix(path, ".y4m") ? VIDEO_Y4M :
+                     has_suffix(path, ".fcv") ? VIDEO_FCV : VIDEO_RAW;
+    g_video.block = block_when_full;
+
+    for (int i = 0; i < VIDEO_RING_SLOTS; ++i) {
+        g_video.slots[i] = malloc((size_t)g_video.src_w * g_video.src_h * 4);
+        if (!g_video.slots[i]) {
+            for (int k = 0; k < i; ++k) free(g_video.slots[k]);
+            fclose(g_video.fp);
+            fprintf(stderr, "[VIDEO] out of memory\n");
+            return false;
+        }
+    }
+
+    if (fps <= 0.0) fps = 60.0;
+    if (g_video.format == VIDEO_Y4M) {
+        long num = (long)(fps * 1000.0 + 0.5), den = 1000;
+        if (num % 1000 == 0) { num /= 1000; den = 1; }
+        fprintf(g_video.fp, "YUV4MPEG2 W%d H%d F%ld:%ld Ip A1:1 C420jpeg XYSCSS=420JPEG\n",
+                width, height, num, den);
+    } else if (g_video.format == VIDEO_FCV) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        g_video.stripes = cpus < 1 ? 1 : (cpus > VIDEO_FCV_STRIPES ? VIDEO_FCV_STRIPES : (int)cpus);
+        fcodec_stream_write_header(g_video.fp, width, height, 4, fps);
+    }
+
+    latwin_init(&g_video.read_lat, VIDEO_LAT_WINDOW);
+    latwin_init(&g_video.write_lat, VIDEO_LAT_WINDOW);
+    pthread_mutex_init(&g_video.lock, NULL);
+    pthread_cond_init(&g_video.have_frame, NULL);
+    pthread_cond_init(&g_video.have_space, NULL);
+    if (pthread_create(&g_video.thread, NULL, video_writer, NULL) != 0) {
+        fprintf(stderr, "[VIDEO] writer thread failed\n");
+        for (int i = 0; i < VIDEO_RING_SLOTS; ++i) free(g_video.slots[i]);
+        latwin_free(&g_video.read_lat);
+        latwin_free(&g_video.write_lat);
+        fclose(g_video.fp);
+        return false;
+    }
+    g_video.running = 1;
+
+    if (downscale > 1) printf("[VIDEO] %dx%d readback box-filtered 1/%d by the writer\n", g_video.src_w,
+                              g_video.src_h, downscale);
+    printf("[VIDEO] %s: %dx%d %s, %d-frame ring, %s when full\n", path, width, height,
+           g_video.format == VIDEO_Y4M ? "y4m 4:2:0" :
+           g_video.format == VIDEO_FCV ? "fcv lossless RGBA" : "raw rgb24", VIDEO_RING_SLOTS,
+           block_when_full ? "waits" : "drops");
+    return true;
+}
+
+bool video_active(void) {
+    return g_video.running != 0;
+}
+
+void video_capture(void) {
+    if (!g_video.running) return;
+
+    pthread_mutex_lock(&g_video.lock);
+    if (g_video.write_error) {     /* writer gave up; skip the readback too */
+        g_video.dropped++;
+        pthread_mutex_unlock(&g_video.lock);
+        return;
+    }
+    if (g_video.count == VIDEO_RING_SLOTS && !g_video.block) {
+        g_video.dropped++;
+        pthread_mutex_unlock(&g_video.lock);
+        return;
+    }
+    while (g_video.count == VIDEO_RING_SLOTS)
+        pthread_cond_wait(&g_video.have_space, &g_video.lock);
+    uint8_t* dst = g_video.slots[g_video.head];
+    pthread_mutex_unlock(&g_video.lock);
+
+    /* The head slot belongs to the render thread until it is published */
+    double t0 = now_ms();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, g_video.src_w, g_video.src_h, GL_RGBA, GL_UNSIGNED_BYTE, dst);
+    latwin_push(&g_video.read_lat, now_ms() - t0);
+
+    pthread_mutex_lock(&g_video.lock);
+    g_video.head = (g_video.head + 1) % VIDEO_RING_SLOTS;
+    g_video.count++;
+    g_video.captured++;
+    pthread_cond_signal(&g_video.have_frame);
+    pthread_mutex_unlock(&g_video.lock);
+}
+
+int video_queue_depth(long* dropped) {
+    if (dropped) *dropped = g_video.running ? __atomic_load_n(&g_video.dropped, __ATOMIC_RELAXED) : 0;
+    return g_video.running ? __atomic_load_n(&g_video.count, __ATOMIC_RELAXED) : 0;
+}
+
+void video_close(void) {
+    if (!g_video.running) return;
+
+    pthread_mutex_lock(&g_video.lock);
+    g_video.stop = 1;
+    pthread_cond_signal(&g_video.have_frame);
+    pthread_mutex_unlock(&g_video.lock);
+    pthread_join(g_video.thread, NULL);
+
+    const double ps[2] = { 50.0, 95.0 };
+    double rd[2] = {0}, wr[2] = {0};
+    latwin_percentiles(&g_video.read_lat, ps, rd, 2);
+    latwin_percentiles(&g_video.write_lat, ps, wr, 2);
+    printf("[VIDEO] %ld frames written, %ld dropped | readback ms p50=%.2f p95=%.2f | encode+write ms p50=%.2f p95=%.2f\n",
+           g_video.written, g_video.dropped, rd[0], rd[1], wr[0], wr[1]);
+
+    if (fclose(g_video.fp) != 0) perror("[VIDEO] close");
+    for (int i = 0; i < VIDEO_RING_SLOTS; ++i) free(g_video.slots[i]);
+    latwin_free(&g_video.read_lat);
+    latwin_free(&g_video.write_lat);
+    pthread_cond_destroy(&g_video.have_space);
+    pthread_cond_destroy(&g_video.have_frame);
+    pthread_mutex_destroy(&g_video.lock);
+    g_video.running = 0;
+}
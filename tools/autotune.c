@@ -0,0 +1,414 @@
+/*
+ * Machine-specific detector auto-tuner
+ *
+ * Runs the simulator headlessly with --eval over a grid of detector
+ * settings (model, input size, ONNX Runtime intra/inter-op threads,
+ * detection cadence) and writes the cheapest configuration whose accuracy
+ * stays above a floor to a profile file. The simulator reads ./tune.profile
+ * at startup (or --profile FILE); the command line still wins.
+ *
+ *   make tools
+ *   ./autotune                                   coordinate descent, defaults
+ *   ./autotune --floor-rel 0.95 --every 1,2,4    allow 5% accuracy loss
+ *   ./autotune --model a.onnx --model b.onnx --det-size 320,448,640
+ *   ./autotune --exhaustive --frames 600 -- --scenario crowd.scn
+ *
+ * Cost is the mean detector time per frame (held frames count as zero),
+ * ties go to the lower p95 latency. Every run is logged to <dir>/runs.csv;
+ * arguments after "--" are passed to every run unchanged.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define MAX_VALUES  16
+#define MAX_MODELS  8
+#define MAX_RUNS    1024
+#define MAX_EXTRA   64
+
+enum { DIM_MODEL, DIM_SIZE, DIM_INTRA, DIM_INTER, DIM_EVERY, DIMS };
+
+static const char* k_dim_names[DIMS] = { "model", "det-size", "intra-threads", "inter-threads", "detect-every" };
+
+/* Index into each dimension's value list; 0 is the reference value */
+typedef struct { int v[DIMS]; } Config;
+
+typedef struct {
+    Config cfg;
+    int    ok;                /* run exited 0 and wrote the report */
+    double accuracy;
+    double cost_ms;           /* cost_ms_per_frame */
+    double p95_ms;
+    int    in_w, in_h;        /* size the simulator actually used */
+} Run;
+
+static const char* g_models[MAX_MODELS + 1] = { NULL };   /* [0] = built-in choice */
+static int  g_values[DIMS][MAX_VALUES];                    /* DIM_MODEL unused */
+static int  g_count[DIMS];
+
+static Run  g_runs[MAX_RUNS];
+static int  g_nruns = 0;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char* argv0) {
+    printf("Usage: %s [options] [-- simulator args]\n"
+           "  --bin PATH          simulator binary (default ./main)\n"
+           "  --dir DIR           run reports and runs.csv (default autotune_runs)\n"
+           "  --out FILE          profile to write (default tune.profile)\n"
+           "  --frames N          frames per run (default 400)\n"
+           "  --reps N            runs per configuration, median cost (default 1)\n"
+           "  --model PATH        candidate model (repeatable; \"none\" = sky-blob)\n"
+           "  --det-size LIST     candidate input sizes (default 0,320,384,448,512,640)\n"
+           "  --intra LIST        intra-op thread counts (default 0,1,2,4,<cores>)\n"
+           "  --inter LIST        inter-op thread counts (default 0,1,2)\n"
+           "  --every LIST        detection cadences (default 1,2,3,4)\n"
+           "  --floor A           absolute accuracy floor\n"
+           "  --floor-rel R       floor = R x reference accuracy (default 0.98)\n"
+           "  --exhaustive        run the full grid instead of coordinate descent\n"
+           "  --dry-run           print the reference command and exit\n"
+           "LIST is comma separated; 0 means \"leave the simulator default\".\n",
+           argv0);
+}
+
+static int parse_list(const char* s, int dim) {
+    g_count[dim] = 0;
+    while (*s && g_count[dim] < MAX_VALUES) {
+        char* end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v < 0) return 0;
+        g_values[dim][g_count[dim]++] = (int)v;
+        s = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return 0;
+    }
+    return g_count[dim] > 0;
+}
+
+static void set_default_list(int dim, const int* v, int n) {
+    if (g_count[dim]) return;
+    for (int i = 0; i < n; ++i) g_values[dim][i] = v[i];
+    g_count[dim] = n;
+}
+
+/* Flags for a configuration; returns the number of argv entries added */
+static int config_args(const Config* c, char bufs[DIMS][32], char** args) {
+    int n = 0;
+    const char* model = g_models[c->v[DIM_MODEL]];
+    if (model) { args[n++] = "--model"; args[n++] = (char*)model; }
+    static const char* flags[DIMS] = { NULL, "--det-size", "--intra-threads", "--inter-threads", "--detect-every" };
+    for (int d = DIM_SIZE; d < DIMS; ++d) {
+        int v = g_values[d][c->v[d]];
+        if (v <= 0) continue;
+        snprintf(bufs[d], 32, "%d", v);
+        args[n++] = (char*)flags[d];
+        args[n++] = bufs[d];
+    }
+    return n;
+}
+
+static void describe(const Config* c, char* out, size_t cap) {
+    const char* model = g_models[c->v[DIM_MODEL]];
+    int len = snprintf(out, cap, "model=%s", model ? model : "default");
+    for (int d = DIM_SIZE; d < DIMS && len < (int)cap; ++d) {
+        int v = g_values[d][c->v[d]];
+        if (v > 0) len += snprintf(out + len, cap - len, " %s=%d", k_dim_names[d], v);
+        else       len += snprintf(out + len, cap - len, " %s=default", k_dim_names[d]);
+    }
+}
+
+static int read_number(const char* json, const char* key, double* out) {
+    const char* p = strstr(json, key);
+    if (!p) return 0;
+    p += strlen(key);
+    while (*p == ' ' || *p == ':' || *p == '"') ++p;
+    char* end;
+    *out = strtod(p, &end);
+    return end != p;
+}
+
+/* Reads the fields the tuner needs from an --eval report */
+static int parse_report(const char* path, Run* r) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return 0;
+    char buf[4096];
+    size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = '\0';
+
+    double w = 0, h = 0;
+    const char* in = strstr(buf, "\"input\": [");
+    if (in && sscanf(in, "\"input\": [%lf, %lf]", &w, &h) == 2) { r->in_w = (int)w; r->in_h = (int)h; }
+    return read_number(buf, "\"accuracy\"", &r->accuracy) &&
+           read_number(buf, "\"cost_ms_per_frame\"", &r->cost_ms) &&
+           read_number(buf, "\"latency_ms_p95\"", &r->p95_ms);
+}
+
+typedef struct {
+    const char* bin;
+    const char* dir;
+    int         frames;
+    int         reps;
+    char**      extra;
+    int         nextra;
+} RunEnv;
+
+static int build_argv(const RunEnv* env, const Config* c, const char* report, char* frames_s,
+                      char bufs[DIMS][32], char** args) {
+    int n = 0;
+    snprintf(frames_s, 16, "%d", env->frames);
+    args[n++] = (char*)env->bin;
+    args[n++] = "--headless";
+    args[n++] = "--fixed-step"; args[n++] = "60";
+    args[n++] = "--time-warp";  args[n++] = "10";
+    args[n++] = "--frames";     args[n++] = frames_s;
+    args[n++] = "--profile";    args[n++] = "none";
+    args[n++] = "--eval";       args[n++] = (char*)report;
+    n += config_args(c, bufs, args + n);
+    for (int e = 0; e < env->nextra; ++e) args[n++] = env->extra[e];
+    args[n] = NULL;
+    return n;
+}
+
+static int exec_once(const RunEnv* env, const Config* c, int id, Run* r) {
+    char report[600], log_path[600], frames_s[16], bufs[DIMS][32];
+    char* args[32 + MAX_EXTRA];
+    snprintf(report, sizeof(report), "%s/run_%03d.json", env->dir, id);
+    snprintf(log_path, sizeof(log_path), "%s/run_%03d.log", env->dir, id);
+    build_argv(env, c, report, frames_s, bufs, args);
+    unlink(report);
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        int fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) { dup2(fd, STDOUT_FILENO); dup2(fd, STDERR_FILENO); close(fd); }
+        execv(env->bin, args);
+        perror("[TUNE] exec");
+        _exit(127);
+    }
+    if (pid < 0) { perror("[TUNE] fork"); return 0; }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0)
+        if (errno != EINTR) return 0;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 && parse_report(report, r);
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Runs a configuration (cached); returns its slot or NULL when out of room */
+static const Run* evaluate(const RunEnv* env, const Config* c, FILE* csv) {
+    for (int i = 0; i < g_nruns; ++i)
+        if (!memcmp(&g_runs[i].cfg, c, sizeof(*c))) return &g_runs[i];
+    if (g_nruns == MAX_RUNS) return NULL;
+
+    Run* r = &g_runs[g_nruns];
+    memset(r, 0, sizeof(*r));
+    r->cfg = *c;
+    double cost[64], p95[64];
+    int reps = env->reps < 64 ? env->reps : 64;
+    double t0 = now_s();
+    r->ok = 1;
+    for (int k = 0; k < reps && r->ok; ++k) {
+        r->ok = exec_once(env, c, g_nruns, r);
+        cost[k] = r->cost_ms;
+        p95[k] = r->p95_ms;
+    }
+    if (r->ok && reps > 1) {
+        qsort(cost, reps, sizeof(double), cmp_double);
+        qsort(p95, reps, sizeof(double), cmp_double);
+        r->cost_ms = cost[reps / 2];
+        r->p95_ms = p95[reps / 2];
+    }
+
+    char desc[256];
+    describe(c, desc, sizeof(desc));
+    if (r->ok)
+        printf("[TUNE] run %03d %-70s acc=%.4f cost=%.3fms p95=%.3fms input=%dx%d (%.1f s)\n", g_nruns, desc,
+               r->accuracy, r->cost_ms, r->p95_ms, r->in_w, r->in_h, now_s() - t0);
+    else
+        printf("[TUNE] run %03d %-70s FAILED (see %s/run_%03d.log)\n", g_nruns, desc, env->dir, g_nruns);
+    if (csv) {
+        const char* model = g_models[c->v[DIM_MODEL]];
+        fprintf(csv, "%d,%s,%d,%d,%d,%d,%d,%d,%.4f,%.4f,%.4f\n", g_nruns, model ? model : "", r->in_w, r->in_h,
+                g_values[DIM_INTRA][c->v[DIM_INTRA]], g_values[DIM_INTER][c->v[DIM_INTER]],
+                g_values[DIM_EVERY][c->v[DIM_EVERY]], r->ok, r->accuracy, r->cost_ms, r->p95_ms);
+        fflush(csv);
+    }
+    g_nruns++;
+    return r;
+}
+
+static int feasible(const Run* r, double floor) { return r && r->ok && r->accuracy >= floor; }
+
+static int better(const Run* a, const Run* b) {
+    if (!b) return 1;
+    if (a->cost_ms != b->cost_ms) return a->cost_ms < b->cost_ms;
+    return a->p95_ms < b->p95_ms;
+}
+
+static int write_profile(const char* path, const Run* best, const Run* ref, double floor) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) { perror("[TUNE] profile"); return 0; }
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    char desc[256];
+    describe(&best->cfg, desc, sizeof(desc));
+    time_t now = time(NULL);
+    char when[64];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M", localtime(&now));
+
+    fprintf(fp, "# Detector profile written by autotune (%s)\n", when);
+    fprintf(fp, "# host %s\n", host);
+    fprintf(fp, "# %s\n", desc);
+    fprintf(fp, "# accuracy %.4f (floor %.4f, reference %.4f)\n", best->accuracy, floor, ref->accuracy);
+    fprintf(fp, "# cost %.3f ms/frame (reference %.3f), p95 %.3f ms, input %dx%d\n", best->cost_ms,
+            ref->cost_ms, best->p95_ms, best->in_w, best->in_h);
+
+    char bufs[DIMS][32];
+    char* args[2 * DIMS];
+    int n = config_args(&best->cfg, bufs, args);
+    for (int i = 0; i < n; i += 2) fprintf(fp, "%s %s\n", args[i], args[i + 1]);
+    fclose(fp);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    RunEnv env = { "./main", "autotune_runs", 400, 1, NULL, 0 };
+    const char* out = "tune.profile";
+    double floor_abs = -1.0, floor_rel = 0.98;
+    int exhaustive = 0, dry_run = 0, nmodels = 0;
+    char* extra[MAX_EXTRA];
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(a, "--")) {
+            for (int k = i + 1; k < argc && env.nextra < MAX_EXTRA; ++k) extra[env.nextra++] = argv[k];
+            break;
+        }
+        if (!strcmp(a, "--help") || !strcmp(a, "-h")) { usage(argv[0]); return 0; }
+        if (!strcmp(a, "--exhaustive")) { exhaustive = 1; continue; }
+        if (!strcmp(a, "--dry-run"))    { dry_run = 1; continue; }
+        if (!v) { fprintf(stderr, "%s: missing value\n", a); return 2; }
+        ++i;
+        int ok = 1;
+        if      (!strcmp(a, "--bin"))       env.bin = v;
+        else if (!strcmp(a, "--dir"))       env.dir = v;
+        else if (!strcmp(a, "--out"))       out = v;
+        else if (!strcmp(a, "--frames"))    ok = (env.frames = atoi(v)) > 0;
+        else if (!strcmp(a, "--reps"))      ok = (env.reps = atoi(v)) > 0;
+        else if (!strcmp(a, "--floor"))     floor_abs = atof(v);
+        else if (!strcmp(a, "--floor-rel")) ok = (floor_rel = atof(v)) > 0.0;
+        else if (!strcmp(a, "--model"))     ok = nmodels < MAX_MODELS && (g_models[++nmodels] = v) != NULL;
+        else if (!strcmp(a, "--det-size"))  ok = parse_list(v, DIM_SIZE);
+        else if (!strcmp(a, "--intra"))     ok = parse_list(v, DIM_INTRA);
+        else if (!strcmp(a, "--inter"))     ok = parse_list(v, DIM_INTER);
+        else if (!strcmp(a, "--every"))     ok = parse_list(v, DIM_EVERY);
+        else { fprintf(stderr, "unknown option: %s\n", a); usage(argv[0]); return 2; }
+        if (!ok) { fprintf(stderr, "bad value for %s: %s\n", a, v); return 2; }
+    }
+    env.extra = extra;
+
+    /* Reference = index 0 of every list: the simulator's own defaults */
+    g_count[DIM_MODEL] = nmodels + 1;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int intra_def[] = { 0, 1, 2, 4, (int)(ncpu > 0 ? ncpu : 1) };
+    int size_def[]  = { 0, 320, 384, 448, 512, 640 };
+    int inter_def[] = { 0, 1, 2 };
+    int every_def[] = { 1, 2, 3, 4 };
+    set_default_list(DIM_SIZE, size_def, 6);
+    set_default_list(DIM_INTRA, intra_def, intra_def[4] > 4 ? 5 : 4);
+    set_default_list(DIM_INTER, inter_def, 3);
+    set_default_list(DIM_EVERY, every_def, 4);
+
+    Config ref;
+    memset(&ref, 0, sizeof(ref));
+    if (dry_run) {
+        char report[600], frames_s[16], bufs[DIMS][32];
+        char* args[32 + MAX_EXTRA];
+        snprintf(report, sizeof(report), "%s/run_000.json", env.dir);
+        int n = build_argv(&env, &ref, report, frames_s, bufs, args);
+        printf("[TUNE] reference:");
+        for (int a = 0; a < n; ++a) printf(" %s", args[a]);
+        printf("\n");
+        return 0;
+    }
+    if (access(env.bin, X_OK) != 0) { fprintf(stderr, "[TUNE] %s is not executable\n", env.bin); return 1; }
+    if (mkdir(env.dir, 0755) != 0 && errno != EEXIST) { perror("[TUNE] mkdir"); return 1; }
+
+    char csv_path[600];
+    snprintf(csv_path, sizeof(csv_path), "%s/runs.csv", env.dir);
+    FILE* csv = fopen(csv_path, "w");
+    if (csv) fprintf(csv, "run,model,input_w,input_h,intra_threads,inter_threads,detect_every,ok,accuracy,cost_ms,p95_ms\n");
+
+    double t0 = now_s();
+    const Run* r0 = evaluate(&env, &ref, csv);
+    if (!r0 || !r0->ok) {
+        fprintf(stderr, "[TUNE] reference run failed; nothing to compare against\n");
+        if (csv) fclose(csv);
+        return 1;
+    }
+    Run reference = *r0;
+    double floor = floor_abs >= 0.0 ? floor_abs : reference.accuracy * floor_rel;
+    printf("[TUNE] reference acc=%.4f cost=%.3fms, floor %.4f\n", reference.accuracy, reference.cost_ms, floor);
+
+    int best_i = feasible(&reference, floor) ? 0 : -1;
+    if (exhaustive) {
+        Config c;
+        memset(&c, 0, sizeof(c));
+        for (;;) {
+            const Run* r = evaluate(&env, &c, csv);
+            if (!r) break;
+            if (feasible(r, floor) && better(r, best_i >= 0 ? &g_runs[best_i] : NULL)) best_i = (int)(r - g_runs);
+            int d = 0;
+            while (d < DIMS && ++c.v[d] == g_count[d]) c.v[d++] = 0;
+            if (d == DIMS) break;
+        }
+    } else {
+        /* Coordinate descent from the reference until a full pass changes nothing */
+        Config cur = ref;
+        for (int pass = 0, changed = 1; changed && pass < 4; ++pass) {
+            changed = 0;
+            for (int d = 0; d < DIMS; ++d) {
+                for (int k = 0; k < g_count[d]; ++k) {
+                    Config c = cur;
+                    c.v[d] = k;
+                    const Run* r = evaluate(&env, &c, csv);
+                    if (!r) break;
+                    if (feasible(r, floor) && better(r, best_i >= 0 ? &g_runs[best_i] : NULL)) {
+                        best_i = (int)(r - g_runs);
+                        if (memcmp(&cur, &c, sizeof(c))) { cur = c; changed = 1; }
+                    }
+                }
+            }
+        }
+    }
+    if (csv) fclose(csv);
+
+    if (best_i < 0) {
+        fprintf(stderr, "[TUNE] no configuration reached accuracy %.4f; %s not written\n", floor, out);
+        return 1;
+    }
+    const Run* best = &g_runs[best_i];
+    char desc[256];
+    describe(&best->cfg, desc, sizeof(desc));
+    printf("[TUNE] %d runs in %.1f s; best: %s\n", g_nruns, now_s() - t0, desc);
+    printf("[TUNE] acc=%.4f cost=%.3fms (%.2fx reference) p95=%.3fms -> %s\n", best->accuracy, best->cost_ms,
+           best->cost_ms > 0 ? reference.cost_ms / best->cost_ms : 0.0, best->p95_ms, out);
+    return write_profile(out, best, &reference, floor) ? 0 : 1;
+}
@@ -0,0 +1,462 @@
+/*
+ * Microbenchmarks of the hot paths (make bench)
+ *
+ * Sets up the engine headlessly (EGL, INIT_SYSTEM) and times each function
+ * in isolation: a sample is a batch of calls sized to --sample-ms, GL cases
+ * end their batch with glFinish so queued GPU work is included. Results
+ * are robust statistics per call (median, MAD, p5/p95, outliers beyond
+ * 3 scaled MADs) written as JSON, one case per line.
+ *
+ *   make bench                                   # -> bench.json
+ *   make bench BENCH_ARGS="--baseline base.json" # compare, exit 1 on regression
+ *   ./microbench --filter terrain --reps 50 --cpu 2
+ *
+ * A case is "slower"/"faster" than the baseline when its median moved by
+ * more than --threshold percent and by more than 3x the combined MAD.
+ */
+#define _GNU_SOURCE
+#include "globals.h"
+#include "heightMap.h"
+#include "headless.h"
+#include "imgproc.h"
+#include "minimap.h"
+#include "onnx.h"
+#include "options.h"
+#include "stats.h"
+#include "text.h"
+
+#include <math.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAX_CASES   16
+#define BENCH_MAX_REPS    1000
+#define BENCH_DET_W       448
+#define BENCH_DET_H       448
+#define BENCH_TERRAIN_PTS 4096
+
+static const char* const kModelPaths[] = {
+    "./models/yolov8n_448_rgba.onnx", "./models/yolov8n_448.onnx",
+};
+
+typedef struct {
+    const char* name;
+    const char* what;                /* one call = ... */
+    int         gl;                  /* glFinish at the end of every batch */
+    void      (*run)(long iters);
+    const char* skip;                /* reason, set by setup */
+} BenchCase;
+
+typedef struct {
+    long   batch, samples;
+    double median, mad, p05, p95, min, max, mean;
+    int    outliers;
+} BenchResult;
+
+static volatile float g_sink;        /* keeps results alive */
+
+/* ---------------- Case state ---------------- */
+
+static float*         g_pts;         /* terrain sample points, x,z pairs */
+static unsigned char* g_rgba;        /* detector-sized RGBA frame */
+static float*         g_chw;
+static OnnxDetector   g_det;
+static int            g_det_ready;
+static int            g_det_w, g_det_h;      /* model input (448x448 if dynamic) */
+static unsigned char* g_det_rgba;            /* model-sized copies of the frame */
+static float*         g_det_chw;
+static int            g_det_rc;              /* last failing onnx_predict code */
+static char           g_det_what[64];
+static unsigned char* g_icon;
+static GLuint         g_text_vbo[2];
+static const char*    g_osd_text =
+    "ALT 1234.5 m  SPD 612.0 km/h  VS -3.2 m/s\n"
+    "HDG 271  PITCH  4.5  ROLL -12.0  FOV 45.0\n"
+    "AUTOPILOT  CMD 17/42  T 2.35 s  FPS 59.9\n"
+    "DET 6  TRK 5  INFER 11.82 ms  TOTAL 18.40 ms";
+
+static uint64_t g_rng = 0x243F6A8885A308D3ull;
+static double bench_uniform(double lo, double hi) {
+    uint64_t z = (g_rng += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return lo + (hi - lo) * (double)(z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void run_terrain(long iters) {
+    float acc = 0.0f;
+    for (long i = 0; i < iters; ++i) {
+        const float* p = &g_pts[2 * (i & (BENCH_TERRAIN_PTS - 1))];
+        acc += get_terrain_height(p[0], p[1]);
+    }
+    g_sink = acc;
+}
+
+static void run_flip_chw(long iters) {
+    for (long i = 0; i < iters; ++i)
+        rgba_flip_gray3_chw_norm(g_rgba, g_chw, BENCH_DET_W, BENCH_DET_H);
+    g_sink = g_chw[0];
+}
+
+static void run_onnx(long iters) {
+    const void* input = g_det.in_u8 ? (const void*)g_det_rgba : (const void*)g_det_chw;
+    for (long i = 0; i < iters; ++i) {
+        OnnxDet* dets = NULL;
+        int n = 0;
+        int rc = onnx_predict(&g_det, input, g_det_w, g_det_h, &dets, &n);
+        if (rc == ONNX_OK) onnx_free_detections(dets);
+        else g_det_rc = rc;
+        g_sink = (float)n;
+    }
+}
+
+static void run_text(long iters) {
+    for (long i = 0; i < iters; ++i) {
+        int count;
+        float bx, by;
+        text_to_vbo(g_osd_text, 18.0f, &g_text_vbo[0], &g_text_vbo[1], &count, &bx, &by);
+        g_sink = bx;
+    }
+}
+
+static void run_icon(long iters) {
+    for (long i = 0; i < iters; ++i)
+        draw_starfighter_icon((float)(i & 63) * (GLM_PIf / 32.0f), &planes[1].colors, g_icon);
+    g_sink = g_icon[MINIMAP_TEXTURE_SIZE * MINIMAP_TEXTURE_SIZE * 2];
+}
+
+static void run_chunks_steady(long iters) {
+    for (long i = 0; i < iters; ++i) update_chunks();
+}
+
+/* Player hops one chunk back and forth, so rows of tiles keep being regenerated */
+static void run_chunks_cross(long iters) {
+    for (long i = 0; i < iters; ++i) {
+        planes[0].position[0] += (i & 1) ? -(float)EDGE_SIZE_OF_EACH_CHUNK : (float)EDGE_SIZE_OF_EACH_CHUNK;
+        update_chunks();
+    }
+    if (iters & 1) planes[0].position[0] -= (float)EDGE_SIZE_OF_EACH_CHUNK;
+}
+
+static void run_boxes(long iters) {
+    for (long i = 0; i < iters; ++i) {
+        int x = (int)(i * 97 % (SCR_WIDTH - 200)), y = (int)(i * 61 % (SCR_HEIGHT - 200));
+        drawBoundingBoxColored(x, y, x + 120, y + 80, 2.0f, 1.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+static BenchCase g_cases[] = {
+    { "get_terrain_height",       "one height lookup",                0, run_terrain,       NULL },
+    { "rgba_flip_gray3_chw_norm", "one 448x448 frame",                0, run_flip_chw,      NULL },
+    { "onnx_predict",             "one inference, 448x448",           0, run_onnx,          NULL },
+    { "text_to_vbo",              "one 4-line OSD string incl. upload", 1, run_text,        NULL },
+    { "draw_starfighter_icon",    "one 256x256 icon",                 0, run_icon,          NULL },
+    { "update_chunks/steady",     "one call, no tile change",         0, run_chunks_steady, NULL },
+    { "update_chunks/cross",      "one call, player hops a chunk",    1, run_chunks_cross,  NULL },
+    { "box_drawing",              "one 4-edge box overlay",           1, run_boxes,         NULL },
+};
+#define NCASES ((int)(sizeof(g_cases) / sizeof(g_cases[0])))
+
+static BenchCase* find_case(const char* name) {
+    for (int i = 0; i < NCASES; ++i)
+        if (!strcmp(g_cases[i].name, name)) return &g_cases[i];
+    return NULL;
+}
+
+/* Frame at the model's input size (nearest-neighbour from the bench frame) */
+static bool setup_onnx_input(void) {
+    g_det_w = g_det.in_w > 0 ? (int)g_det.in_w : BENCH_DET_W;
+    g_det_h = g_det.in_h > 0 ? (int)g_det.in_h : BENCH_DET_H;
+    g_det_rgba = malloc((size_t)g_det_w * g_det_h * 4);
+    g_det_chw  = malloc(sizeof(float) * 3 * (size_t)g_det_w * g_det_h);
+    if (!g_det_rgba || !g_det_chw) return false;
+    for (int y = 0; y < g_det_h; ++y)
+        for (int x = 0; x < g_det_w; ++x)
+            memcpy(g_det_rgba + ((size_t)y * g_det_w + x) * 4,
+                   g_rgba + ((size_t)(y * BENCH_DET_H / g_det_h) * BENCH_DET_W + x * BENCH_DET_W / g_det_w) * 4, 4);
+    rgba_flip_gray3_chw_norm(g_det_rgba, g_det_chw, g_det_w, g_det_h);
+    snprintf(g_det_what, sizeof(g_det_what), "one inference, %dx%d", g_det_w, g_det_h);
+    find_case("onnx_predict")->what = g_det_what;
+    return true;
+}
+
+static bool setup_cases(const char* model_path) {
+    g_pts  = malloc(sizeof(float) * 2 * BENCH_TERRAIN_PTS);
+    g_rgba = malloc((size_t)BENCH_DET_W * BENCH_DET_H * 4);
+    g_chw  = malloc(sizeof(float) * 3 * BENCH_DET_W * BENCH_DET_H);
+    g_icon = malloc(MINIMAP_TEXTURE_SIZE * MINIMAP_TEXTURE_SIZE * 4);
+    if (!g_pts || !g_rgba || !g_chw || !g_icon) return false;
+
+    for (int i = 0; i < 2 * BENCH_TERRAIN_PTS; ++i) g_pts[i] = (float)bench_uniform(-20000.0, 20000.0);
+    /* sky gradient over a darker ground band, with noise: a frame-like input */
+    for (int y = 0; y < BENCH_DET_H; ++y)
+        for (int x = 0; x < BENCH_DET_W; ++x) {
+            unsigned char* p = g_rgba + ((size_t)y * BENCH_DET_W + x) * 4;
+            int base = y < BENCH_DET_H / 3 ? 60 : 120 + y / 4;
+            for (int c = 0; c < 3; ++c) p[c] = (unsigned char)(base + (int)bench_uniform(0.0, 24.0));
+            p[3] = 255;
+        }
+    rgba_flip_gray3_chw_norm(g_rgba, g_chw, BENCH_DET_W, BENCH_DET_H);
+
+    OnnxConfig cfg = onnx_default_config();
+    const char* path = model_path;
+    for (int i = 0; !path && i < (int)(sizeof(kModelPaths) / sizeof(kModelPaths[0])); ++i)
+        if (access(kModelPaths[i], R_OK) == 0) path = kModelPaths[i];
+    if (path && onnx_load_model(&g_det, path, &cfg) == ONNX_OK) {
+        g_det_ready = 1;
+        if (!setup_onnx_input()) return false;
+        printf("[BENCH] model %s%s, %dx%d\n", path, g_det.in_u8 ? " (RGBA input)" : "", g_det_w, g_det_h);
+        /* An early error return would be timed as if it were inference */
+        run_onnx(1);
+        if (g_det_rc != ONNX_OK) {
+            static char why[64];
+            snprintf(why, sizeof(why), "onnx_predict returned %d", g_det_rc);
+            find_case("onnx_predict")->skip = why;
+        }
+    } else {
+        find_case("onnx_predict")->skip = path ? "model failed to load" : "no model in ./models";
+    }
+
+    glGenBuffers(2, g_text_vbo);
+    return true;
+}
+
+static void teardown_cases(void) {
+    if (g_det_ready) onnx_destroy(&g_det);
+    glDeleteBuffers(2, g_text_vbo);
+    free(g_pts); free(g_rgba); free(g_chw); free(g_icon);
+    free(g_det_rgba); free(g_det_chw);
+}
+
+/* ---------------- Measurement ---------------- */
+
+static double now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+static double time_batch(const BenchCase* c, long iters) {
+    double t0 = now_ns();
+    c->run(iters);
+    if (c->gl) glFinish();
+    return now_ns() - t0;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void measure(const BenchCase* c, int reps, double sample_ms, BenchResult* r) {
+    memset(r, 0, sizeof(*r));
+    /* warm up (first calls compile shaders, fault pages in), then grow the
+     * batch until one takes sample_ms */
+    double warm = 0.0;
+    for (int k = 0; k < 3 || warm < 2.0 * sample_ms * 1e6; ++k) warm += time_batch(c, 1);
+    long iters = 1;
+    for (;;) {
+        double ns = time_batch(c, iters);
+        if (ns >= sample_ms * 1e6 || iters >= (1L << 30)) break;
+        long grow = ns > 0.0 ? (long)(iters * (sample_ms * 1e6 / ns) * 1.1) : iters * 10;
+        iters = grow > iters * 10 ? iters * 10 : (grow > iters ? grow : iters + 1);
+    }
+    time_batch(c, iters);
+
+    double v[BENCH_MAX_REPS], dev[BENCH_MAX_REPS], sum = 0.0;
+    for (int i = 0; i < reps; ++i) {
+        v[i] = time_batch(c, iters) / (double)iters;
+        sum += v[i];
+    }
+    qsort(v, (size_t)reps, sizeof(double), cmp_double);
+    r->batch = iters;
+    r->samples = reps;
+    r->median = stats_percentile_sorted(v, reps, 50.0);
+    r->p05 = stats_percentile_sorted(v, reps, 5.0);
+    r->p95 = stats_percentile_sorted(v, reps, 95.0);
+    r->min = v[0];
+    r->max = v[reps - 1];
+    r->mean = sum / reps;
+    for (int i = 0; i < reps; ++i) dev[i] = fabs(v[i] - r->median);
+    qsort(dev, (size_t)reps, sizeof(double), cmp_double);
+    r->mad = 1.4826 * stats_percentile_sorted(dev, reps, 50.0);   /* ~sigma for normal noise */
+    for (int i = 0; i < reps; ++i)
+        if (dev[i] > 3.0 * r->mad && r->mad > 0.0) r->outliers++;
+}
+
+/* ---------------- Baseline ---------------- */
+
+typedef struct {
+    char   name[64];
+    double median, mad;
+} BaseEntry;
+
+/* Reads the per-case lines of a previous bench.json */
+static int load_baseline(const char* path, BaseEntry* out, int max) {
+    FILE* f = fopen(path, "r");
+    if (!f) { fprintf(stderr, "[BENCH] cannot open baseline %s\n", path); return -1; }
+    char line[1024];
+    int n = 0;
+    while (n < max && fgets(line, sizeof(line), f)) {
+        const char* p = strstr(line, "\"name\": \"");
+        const char* m = strstr(line, "\"median_ns\": ");
+        const char* d = strstr(line, "\"mad_ns\": ");
+        if (!p || !m || !d) continue;
+        p += strlen("\"name\": \"");
+        const char* e = strchr(p, '"');
+        if (!e || e - p >= (long)sizeof(out[n].name)) continue;
+        memcpy(out[n].name, p, (size_t)(e - p));
+        out[n].name[e - p] = '\0';
+        out[n].median = atof(m + strlen("\"median_ns\": "));
+        out[n].mad = atof(d + strlen("\"mad_ns\": "));
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+/* ---------------- Main ---------------- */
+
+static void usage(const char* argv0) {
+    printf("Usage: %s [options]  (run from the repository root)\n"
+           "  --out FILE         JSON report (default: stdout)\n"
+           "  --baseline FILE    compare with an earlier report; exit 1 on regression\n"
+           "  --threshold PCT    smallest change that counts (default 5)\n"
+           "  --reps N           samples per case (default 25)\n"
+           "  --sample-ms MS     duration of one sample batch (default 5)\n"
+           "  --filter TEXT      only cases whose name contains TEXT\n"
+           "  --model PATH       ONNX model for onnx_predict (default: ./models/...)\n"
+           "  --cpu N            pin to CPU N\n",
+           argv0);
+}
+
+static void cpu_model(char* out, size_t cap) {
+    snprintf(out, cap, "unknown");
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (!f) return;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "model name", 10)) continue;
+        char* v = strchr(line, ':');
+        if (!v) break;
+        v += strspn(v, ": \t");
+        v[strcspn(v, "\n\"\\")] = '\0';
+        snprintf(out, cap, "%s", v);
+        break;
+    }
+    fclose(f);
+}
+
+int main(int argc, char** argv) {
+    const char *out_path = NULL, *base_path = NULL, *filter = NULL, *model = NULL;
+    double threshold = 5.0, sample_ms = 5.0;
+    int reps = 25, cpu = -1;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(a, "-h") || !strcmp(a, "--help")) { usage(argv[0]); return 0; }
+        if (!v) { fprintf(stderr, "Missing value for %s\n", a); return 2; }
+        if (!strcmp(a, "--out")) out_path = v;
+        else if (!strcmp(a, "--baseline")) base_path = v;
+        else if (!strcmp(a, "--threshold")) threshold = atof(v);
+        else if (!strcmp(a, "--reps")) reps = atoi(v);
+        else if (!strcmp(a, "--sample-ms")) sample_ms = atof(v) > 0.0 ? atof(v) : 5.0;
+        else if (!strcmp(a, "--filter")) filter = v;
+        else if (!strcmp(a, "--model")) model = v;
+        else if (!strcmp(a, "--cpu")) cpu = atoi(v);
+        else { fprintf(stderr, "Unknown option: %s\n", a); usage(argv[0]); return 2; }
+        i++;
+    }
+    if (reps < 5) reps = 5;
+    if (reps > BENCH_MAX_REPS) reps = BENCH_MAX_REPS;
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) perror("[BENCH] sched_setaffinity");
+    }
+
+    BaseEntry base[BENCH_MAX_CASES];
+    int nbase = 0;
+    if (base_path && (nbase = load_baseline(base_path, base, BENCH_MAX_CASES)) < 0) return 2;
+
+    default_options(&g_opts);
+    g_opts.headless = true;
+    if (!headless_init(SCR_WIDTH, SCR_HEIGHT)) return 2;
+    INIT_SYSTEM();
+    init_box_drawing();
+    glBindFramebuffer(GL_FRAMEBUFFER, headless_default_fbo());
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    if (!setup_cases(model)) { fprintf(stderr, "[BENCH] out of memory\n"); return 2; }
+
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) { perror("[BENCH] open output"); return 2; }
+    char cpu_name[256];
+    cpu_model(cpu_name, sizeof(cpu_name));
+    fprintf(out, "{\n  \"cpu\": \"%s\",\n  \"renderer\": \"%s\",\n  \"reps\": %d,\n  \"sample_ms\": %.2f,\n",
+            cpu_name, headless_renderer(), reps, sample_ms);
+    if (base_path) fprintf(out, "  \"baseline\": \"%s\",\n  \"threshold_pct\": %.2f,\n", base_path, threshold);
+    fprintf(out, "  \"cases\": [\n");
+
+    int regressions = 0, written = 0;
+    for (int i = 0; i < NCASES; ++i) {
+        const BenchCase* c = &g_cases[i];
+        if (filter && !strstr(c->name, filter)) continue;
+        fprintf(out, "%s", written++ ? ",\n" : "");
+        if (c->skip) {
+            fprintf(out, "    { \"name\": \"%s\", \"skipped\": \"%s\" }", c->name, c->skip);
+            printf("[BENCH] %-26s skipped (%s)\n", c->name, c->skip);
+            continue;
+        }
+        BenchResult r;
+        g_det_rc = ONNX_OK;
+        measure(c, reps, sample_ms, &r);
+        if (g_det_rc != ONNX_OK) {
+            /* timings of failed calls mean nothing; counts as a regression */
+            fprintf(out, "    { \"name\": \"%s\", \"failed\": \"onnx_predict returned %d\" }", c->name, g_det_rc);
+            printf("[BENCH] %-26s FAILED (onnx_predict returned %d)\n", c->name, g_det_rc);
+            regressions++;
+            continue;
+        }
+        fprintf(out, "    { \"name\": \"%s\", \"op\": \"%s\", \"batch\": %ld, \"median_ns\": %.1f, "
+                     "\"mad_ns\": %.1f, \"p05_ns\": %.1f, \"p95_ns\": %.1f, \"min_ns\": %.1f, "
+                     "\"max_ns\": %.1f, \"mean_ns\": %.1f, \"outliers\": %d",
+                c->name, c->what, r.batch, r.median, r.mad, r.p05, r.p95, r.min, r.max, r.mean, r.outliers);
+
+        const char* verdict = NULL;
+        double delta = 0.0;
+        for (int b = 0; b < nbase; ++b) {
+            if (strcmp(base[b].name, c->name) || base[b].median <= 0.0) continue;
+            delta = 100.0 * (r.median - base[b].median) / base[b].median;
+            double noise = 100.0 * 3.0 * sqrt(r.mad * r.mad + base[b].mad * base[b].mad) / base[b].median;
+            double limit = noise > threshold ? noise : threshold;
+            verdict = delta > limit ? "slower" : delta < -limit ? "faster" : "same";
+            if (delta > limit) regressions++;
+            fprintf(out, ", \"baseline_median_ns\": %.1f, \"delta_pct\": %.2f, \"noise_pct\": %.2f, \"verdict\": \"%s\"",
+                    base[b].median, delta, noise, verdict);
+            break;
+        }
+        fprintf(out, " }");
+
+        if (verdict)
+            printf("[BENCH] %-26s median %12.1f ns  MAD %9.1f ns  %+7.2f%% %s\n",
+                   c->name, r.median, r.mad, delta, verdict);
+        else
+            printf("[BENCH] %-26s median %12.1f ns  MAD %9.1f ns  p95 %12.1f ns\n",
+                   c->name, r.median, r.mad, r.p95);
+    }
+    fprintf(out, "\n  ],\n  \"regressions\": %d\n}\n", regressions);
+    if (out != stdout) fclose(out);
+
+    teardown_cases();
+    CLEANUP_SYSTEM();
+    headless_shutdown();
+    if (regressions) printf("[BENCH] %d case(s) slower than %s\n", regressions, base_path);
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,204 @@
+/*
+ * Query tool for --detlog files
+ *
+ * Memory-maps the log and scans only the columns a filter needs; blocks
+ * whose zone maps (frame / track / score range, class mask) cannot match
+ * are skipped without touching their data.
+ *
+ *   make tools
+ *   ./detlog_query run.dlog --frames 1000:2000 --cls 1,2 --min-score 0.5
+ *   ./detlog_query run.dlog --track 17
+ *   ./detlog_query run.dlog --summary
+ *   ./detlog_query run.dlog --timings --frames 5000:5100
+ *
+ * Default output: CSV "frame,track,cls,score,x1,y1,x2,y2".
+ */
+#include "detlog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int64_t  frame_min, frame_max;
+    uint32_t cls_mask;           /* bit (cls + 1); all bits = any */
+    int      has_track;
+    int32_t  track;
+    float    score_min, score_max;
+} Filter;
+
+static void usage(const char* argv0) {
+    printf("Usage: %s LOG [filters] [--count | --summary | --timings]\n"
+           "  --frames A:B       frame range, inclusive (A: or :B open-ended)\n"
+           "  --cls C[,C...]     classes (-1 = blob detector)\n"
+           "  --track T          track id (-1 = unconfirmed)\n"
+           "  --min-score S      score >= S\n"
+           "  --max-score S      score <= S\n"
+           "  --count            print the number of matching detections only\n"
+           "  --summary          per-class counts, track count, stage time percentiles\n"
+           "  --timings          per-frame stage timings (CSV) in the frame range\n",
+           argv0);
+}
+
+static int block_may_match(const DetlogBlock* b, const Filter* f) {
+    if (b->frame_max < f->frame_min || b->frame_min > f->frame_max) return 0;
+    if (b->nrows == 0) return 0;
+    if (!(b->cls_mask & f->cls_mask)) return 0;
+    if (f->has_track && (f->track < b->track_min || f->track > b->track_max)) return 0;
+    if (b->score_max < f->score_min || b->score_min > f->score_max) return 0;
+    return 1;
+}
+
+static int row_matches(const DetlogBlock* b, uint32_t r, const Filter* f) {
+    if (b->det_frame[r] < f->frame_min || b->det_frame[r] > f->frame_max) return 0;
+    int bit = b->cls[r] + 1;
+    if (bit < 0 || bit >= 32 || !(f->cls_mask & (1u << bit))) return 0;
+    if (f->has_track && b->track[r] != f->track) return 0;
+    return b->score[r] >= f->score_min && b->score[r] <= f->score_max;
+}
+
+static int cmp_float(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static float pct(const float* v, long n, double p) {
+    if (n == 0) return 0.0f;
+    long i = (long)(p / 100.0 * (double)(n - 1) + 0.5);
+    return v[i < n ? i : n - 1];
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || !strcmp(argv[1], "-h") || !strcmp(argv[1], "--help")) {
+        usage(argv[0]);
+        return argc < 2 ? 2 : 0;
+    }
+    const char* path = argv[1];
+    Filter f = { INT64_MIN, INT64_MAX, 0xffffffffu, 0, 0, -1e30f, 1e30f };
+    int mode_count = 0, mode_summary = 0, mode_timings = 0;
+
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!strcmp(a, "--count"))   { mode_count = 1; continue; }
+        if (!strcmp(a, "--summary")) { mode_summary = 1; continue; }
+        if (!strcmp(a, "--timings")) { mode_timings = 1; continue; }
+        if (!v) { fprintf(stderr, "Missing value for %s\n", a); return 2; }
+        ++i;
+        if (!strcmp(a, "--frames")) {
+            const char* colon = strchr(v, ':');
+            if (!colon) { f.frame_min = f.frame_max = strtoll(v, NULL, 10); continue; }
+            if (colon != v) f.frame_min = strtoll(v, NULL, 10);
+            if (colon[1]) f.frame_max = strtoll(colon + 1, NULL, 10);
+        } else if (!strcmp(a, "--cls")) {
+            f.cls_mask = 0;
+            for (const char* p = v; *p; ) {
+                char* end;
+                long c = strtol(p, &end, 10);
+                if (end == p) break;
+                if (c + 1 >= 0 && c + 1 < 32) f.cls_mask |= 1u << (c + 1);
+                p = *end == ',' ? end + 1 : end;
+            }
+        } else if (!strcmp(a, "--track")) {
+            f.has_track = 1;
+            f.track = (int32_t)atoi(v);
+        } else if (!strcmp(a, "--min-score")) {
+            f.score_min = (float)atof(v);
+        } else if (!strcmp(a, "--max-score")) {
+            f.score_max = (float)atof(v);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", a);
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    DetlogReader r;
+    if (!detlog_reader_open(&r, path)) { fprintf(stderr, "%s: not a readable detection log\n", path); return 1; }
+
+    if (mode_timings) {
+        printf("frame,sim_time");
+        for (int s = 0; s < DETLOG_STAGES; ++s) printf(",%s_ms", detlog_stage_names[s]);
+        printf(",detections\n");
+        for (long k = 0; k < r.nblocks; ++k) {
+            const DetlogBlock* b = &r.blocks[k];
+            if (b->frame_max < f.frame_min || b->frame_min > f.frame_max) continue;
+            for (uint32_t i = 0; i < b->nframes; ++i) {
+                if (b->frame[i] < f.frame_min || b->frame[i] > f.frame_max) continue;
+                printf("%lld,%.4f", (long long)b->frame[i], b->sim_time[i]);
+                for (int s = 0; s < DETLOG_STAGES; ++s) printf(",%.3f", b->stage_ms[s][i]);
+                printf(",%u\n", b->first_row[i + 1] - b->first_row[i]);
+            }
+        }
+        detlog_reader_close(&r);
+        return 0;
+    }
+
+    long matched = 0, skipped = 0;
+    long per_cls[32] = {0};
+    int32_t track_max = -1;
+    char* seen = NULL;
+    size_t seen_cap = 0;
+    long tracks = 0;
+    if (!mode_count && !mode_summary) printf("frame,track,cls,score,x1,y1,x2,y2\n");
+
+    for (long k = 0; k < r.nblocks; ++k) {
+        const DetlogBlock* b = &r.blocks[k];
+        if (!block_may_match(b, &f)) { skipped++; continue; }
+        for (uint32_t i = 0; i < b->nrows; ++i) {
+            if (!row_matches(b, i, &f)) continue;
+            matched++;
+            if (mode_summary) {
+                per_cls[b->cls[i] + 1 < 32 ? b->cls[i] + 1 : 31]++;
+                int32_t t = b->track[i];
+                if (t >= 0) {
+                    if ((size_t)t >= seen_cap) {
+                        size_t nc = (size_t)t * 2 + 64;
+                        char* ns = realloc(seen, nc);
+                        if (!ns) continue;
+                        memset(ns + seen_cap, 0, nc - seen_cap);
+                        seen = ns;
+                        seen_cap = nc;
+                    }
+                    if (!seen[t]) { seen[t] = 1; tracks++; }
+                    if (t > track_max) track_max = t;
+                }
+            } else if (!mode_count) {
+                printf("%lld,%d,%d,%.4f,%.1f,%.1f,%.1f,%.1f\n", (long long)b->det_frame[i], b->track[i],
+                       b->cls[i], b->score[i], b->x1[i], b->y1[i], b->x2[i], b->y2[i]);
+            }
+        }
+    }
+
+    if (mode_count) printf("%ld\n", matched);
+    if (mode_summary) {
+        long frames = 0;
+        float* v[DETLOG_STAGES];
+        for (int s = 0; s < DETLOG_STAGES; ++s) v[s] = malloc(sizeof(float) * (size_t)(r.frames ? r.frames : 1));
+        for (long k = 0; k < r.nblocks; ++k) {
+            const DetlogBlock* b = &r.blocks[k];
+            if (b->frame_max < f.frame_min || b->frame_min > f.frame_max) continue;
+            for (uint32_t i = 0; i < b->nframes; ++i) {
+                if (b->frame[i] < f.frame_min || b->frame[i] > f.frame_max) continue;
+                for (int s = 0; s < DETLOG_STAGES; ++s) if (v[s]) v[s][frames] = b->stage_ms[s][i];
+                frames++;
+            }
+        }
+        printf("log: %ld blocks, %ld frames, %ld detections (%ld blocks skipped by zone maps)\n",
+               r.nblocks, r.frames, r.rows, skipped);
+        printf("matched: %ld detections, %ld distinct tracks, %ld frames in range\n", matched, tracks, frames);
+        for (int c = 0; c < 32; ++c)
+            if (per_cls[c]) printf("  cls %d: %ld\n", c - 1, per_cls[c]);
+        for (int s = 0; s < DETLOG_STAGES; ++s) {
+            if (!v[s]) continue;
+            qsort(v[s], (size_t)frames, sizeof(float), cmp_float);
+            printf("  %-8s ms p50=%.2f p95=%.2f p99=%.2f max=%.2f\n", detlog_stage_names[s],
+                   pct(v[s], frames, 50), pct(v[s], frames, 95), pct(v[s], frames, 99),
+                   frames ? v[s][frames - 1] : 0.0f);
+            free(v[s]);
+        }
+    }
+    free(seen);
+    detlog_reader_close(&r);
+    return 0;
+}
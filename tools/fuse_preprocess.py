@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""
+Prepend the detector preprocessing to an ONNX model so it accepts the raw
+glReadPixels buffer (uint8 RGBA, bottom-up rows, NHWC) directly.
+
+The inserted nodes reproduce rgba_flip_gray3_chw_norm() in src/main.c:
+
+    rgba [1,H,W,4] uint8
+      -> Slice   (flip rows, steps=-1 on H)
+      -> Cast    (float)
+      -> MatMul  ([4,1] = luminance weights / 255, alpha weight 0)
+      -> Transpose (NHWC -> NCHW, [1,1,H,W])
+      -> Expand  ([1,3,H,W], gray replicated to 3 channels)
+      -> original model input
+
+Usage:
+    python3 tools/fuse_preprocess.py models/yolov8n_448.onnx models/yolov8n_448_rgba.onnx
+
+Requires the `onnx` Python package.
+"""
+import sys
+
+import numpy as np
+import onnx
+from onnx import TensorProto, helper, numpy_helper
+
+LUMA = (0.299, 0.587, 0.114)
+NEW_INPUT = "rgba"
+
+
+def static_hw(value_info):
+    dims = value_info.type.tensor_type.shape.dim
+    if len(dims) != 4:
+        raise SystemExit("expected a 4-D NCHW input, got rank %d" % len(dims))
+    c, h, w = (d.dim_value for d in dims[1:])
+    if c != 3 or h <= 0 or w <= 0:
+        raise SystemExit("expected static [1,3,H,W] input (got C=%d H=%d W=%d)" % (c, h, w))
+    return h, w
+
+
+def fuse(model):
+    graph = model.graph
+    initializers = {i.name for i in graph.initializer}
+    inputs = [i for i in graph.input if i.name not in initializers]
+    if len(inputs) != 1:
+        raise SystemExit("expected exactly one non-initializer input, got %d" % len(inputs))
+    old = inputs[0]
+    if old.type.tensor_type.elem_type != TensorProto.FLOAT:
+        raise SystemExit("input '%s' is not float; already fused?" % old.name)
+    h, w = static_hw(old)
+
+    p = "pre_"  # name prefix for everything we add
+    weights = np.array([[LUMA[0] / 255.0], [LUMA[1] / 255.0], [LUMA[2] / 255.0], [0.0]], dtype=np.float32)
+    inits = [
+        numpy_helper.from_array(np.array([-1], dtype=np.int64), p + "flip_starts"),
+        numpy_helper.from_array(np.array([np.iinfo(np.int64).min], dtype=np.int64), p + "flip_ends"),
+        numpy_helper.from_array(np.array([1], dtype=np.int64), p + "flip_axes"),
+        numpy_helper.from_array(np.array([-1], dtype=np.int64), p + "flip_steps"),
+        numpy_helper.from_array(weights, p + "luma_w"),
+        numpy_helper.from_array(np.array([1, 3, h, w], dtype=np.int64), p + "chw_shape"),
+    ]
+    nodes = [
+        helper.make_node("Slice", [NEW_INPUT, p + "flip_starts", p + "flip_ends", p + "flip_axes", p + "flip_steps"],
+                         [p + "flipped"], name=p + "flip"),
+        helper.make_node("Cast", [p + "flipped"], [p + "f32"], to=TensorProto.FLOAT, name=p + "cast"),
+        helper.make_node("MatMul", [p + "f32", p + "luma_w"], [p + "gray_nhwc"], name=p + "luma"),
+        helper.make_node("Transpose", [p + "gray_nhwc"], [p + "gray_nchw"], perm=[0, 3, 1, 2], name=p + "to_nchw"),
+        helper.make_node("Expand", [p + "gray_nchw", p + "chw_shape"], [old.name], name=p + "gray3"),
+    ]
+
+    new_input = helper.make_tensor_value_info(NEW_INPUT, TensorProto.UINT8, [1, h, w, 4])
+    graph.input.remove(old)
+    graph.input.insert(0, new_input)
+    graph.initializer.extend(inits)
+    existing = list(graph.node)
+    del graph.node[:]
+    graph.node.extend(nodes + existing)
+
+    # Slice with steps needs opset >= 10
+    for opset in model.opset_import:
+        if opset.domain in ("", "ai.onnx") and opset.version < 10:
+            opset.version = 10
+    return model
+
+
+def main(argv):
+    if len(argv) != 3:
+        print(__doc__.strip().split("Usage:")[1].strip().splitlines()[0])
+        return 2
+    model = onnx.load(argv[1])
+    model = fuse(model)
+    onnx.checker.check_model(model)
+    onnx.save(model, argv[2])
+    print("fused preprocessing -> %s (input '%s' uint8 [1,H,W,4])" % (argv[2], NEW_INPUT))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,276 @@
+/*
+ * Sharded dataset generation launcher
+ *
+ * Starts K headless simulator instances, each pinned to its own core set,
+ * with its own --seed (and optionally a snapshot or .scn scenario file), writing a
+ * dataset shard to <out>/shard_NN. When all of them exit, the shard
+ * manifests are merged into <out>/train.txt + <out>/data.yaml.
+ *
+ *   make tools
+ *   ./launcher --instances 16 --frames 50000 --out data/run01
+ *   ./launcher --cores-per 2 --scenario a.snap --scenario b.snap -- --no-vsync
+ *   ./launcher --scenario crowd.scn -- --aircraft 500
+ *
+ * Instances run with --model none unless --child-model says otherwise: the
+ * labels come from the model matrices, so inference would only cost time.
+ * Arguments after "--" are passed to every instance unchanged.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define MAX_SCENARIOS 64
+#define MAX_EXTRA     64
+
+typedef struct {
+    pid_t  pid;
+    int    cpu0, ncpu;
+    double t_start, t_end;
+    int    status;
+    long   images;
+    char   dir[512];
+} Shard;
+
+static double now_s(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+static void usage(const char* argv0) {
+    printf("Usage: %s [options] [-- extra simulator args]\n"
+           "  --instances K      simulator processes (default: CPUs / cores-per)\n"
+           "  --cores-per N      cores pinned per instance (default: CPUs / K, min 1)\n"
+           "  --frames N         frames per instance (default 10000)\n"
+           "  --out DIR          output root (default ./dataset)\n"
+           "  --bin PATH         simulator binary (default ./main)\n"
+           "  --seed-base S      instance i runs with --seed S+i (default 1)\n"
+           "  --scenario FILE    snapshot to start from, or a .scn scenario file;\n"
+           "                     repeat to round-robin\n"
+           "  --fixed-step HZ    simulation rate (default 60)\n"
+           "  --time-warp X      sim seconds per real second; with the fixed step,\n"
+           "                     X steps per rendered frame (default 20)\n"
+           "  --format F         jpg, png or qoi (default jpg)\n"
+           "  --child-model PATH detection model for the instances (default none:\n"
+           "                     labels do not need inference)\n"
+           "  --dry-run          print the commands only\n",
+           argv0);
+}
+
+static int make_dir(const char* path) {
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+/* Appends <shard>/manifest.txt to train.txt with paths made root-relative */
+static long merge_manifest(FILE* out, const Shard* s, const char* root) {
+    char path[600];
+    snprintf(path, sizeof(path), "%s/manifest.txt", s->dir);
+    FILE* in = fopen(path, "r");
+    if (!in) return 0;
+    const char* rel = s->dir + strlen(root);
+    while (*rel == '/') rel++;
+    long n = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        size_t len = strlen(line);
+        while (len && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+        if (!len) continue;
+        fprintf(out, "%s/%s\n", rel, line);
+        n++;
+    }
+    fclose(in);
+    return n;
+}
+
+int main(int argc, char** argv) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) ncpu = 1;
+
+    int instances = 0, cores_per = 0, dry_run = 0;
+    long frames = 10000;
+    unsigned long long seed_base = 1;
+    const char* out = "./dataset";
+    const char* bin = "./main";
+    const char* hz = "60";
+    const char* warp = "20";
+    const char* format = "jpg";
+    const char* model = "none";
+    const char* scenarios[MAX_SCENARIOS];
+    int nscen = 0;
+    char* extra[MAX_EXTRA];
+    int nextra = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!strcmp(a, "--")) {
+            if (argc - i - 1 > MAX_EXTRA) {
+                fprintf(stderr, "Too many simulator args after -- (max %d)\n", MAX_EXTRA);
+                return 2;
+            }
+            for (++i; i < argc; ++i) extra[nextra++] = argv[i];
+            break;
+        } else if (!strcmp(a, "-h") || !strcmp(a, "--help")) {
+            usage(argv[0]);
+            return 0;
+        } else if (!strcmp(a, "--dry-run")) {
+            dry_run = 1;
+            continue;
+        }
+        if (!v) { fprintf(stderr, "Missing value for %s\n", a); return 2; }
+        ++i;
+        if      (!strcmp(a, "--instances"))  instances = atoi(v);
+        else if (!strcmp(a, "--cores-per"))  cores_per = atoi(v);
+        else if (!strcmp(a, "--frames"))     frames = atol(v);
+        else if (!strcmp(a, "--out"))        out = v;
+        else if (!strcmp(a, "--bin"))        bin = v;
+        else if (!strcmp(a, "--seed-base"))  seed_base = strtoull(v, NULL, 10);
+        else if (!strcmp(a, "--fixed-step")) hz = v;
+        else if (!strcmp(a, "--time-warp"))  warp = v;
+        else if (!strcmp(a, "--format"))     format = v;
+        else if (!strcmp(a, "--child-model")) model = v;
+        else if (!strcmp(a, "--scenario")) {
+            if (nscen == MAX_SCENARIOS) { fprintf(stderr, "Too many scenarios\n"); return 2; }
+            scenarios[nscen++] = v;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", a);
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (cores_per <= 0) cores_per = instances > 0 ? (int)(ncpu / instances) : 1;
+    if (cores_per <= 0) cores_per = 1;
+    if (instances <= 0) instances = (int)(ncpu / cores_per);
+    if (instances <= 0) instances = 1;
+    if ((long)instances * cores_per > ncpu)
+        fprintf(stderr, "[LAUNCH] warning: %d x %d cores oversubscribes %ld CPUs\n", instances, cores_per, ncpu);
+
+    if (!make_dir(out)) { perror("[LAUNCH] mkdir"); return 1; }
+
+    Shard* shards = calloc((size_t)instances, sizeof(Shard));
+    if (!shards) return 1;
+
+    /* llvmpipe sizes its rasterizer pool from this; match the pinned set */
+    char lp_threads[16];
+    snprintf(lp_threads, sizeof(lp_threads), "%d", cores_per);
+    if (!getenv("LP_NUM_THREADS")) setenv("LP_NUM_THREADS", lp_threads, 1);
+
+    printf("[LAUNCH] %d instances x %d cores, %ld frames each -> %s\n", instances, cores_per, frames, out);
+    double t0 = now_s();
+
+    for (int k = 0; k < instances; ++k) {
+        Shard* s = &shards[k];
+        s->cpu0 = (int)(((long)k * cores_per) % ncpu);
+        s->ncpu = cores_per;
+        snprintf(s->dir, sizeof(s->dir), "%s/shard_%02d", out, k);
+
+        char frames_s[32], seed_s[32], writers_s[16];
+        snprintf(frames_s, sizeof(frames_s), "%ld", frames);
+        snprintf(seed_s, sizeof(seed_s), "%llu", seed_base + (unsigned long long)k);
+        snprintf(writers_s, sizeof(writers_s), "%d", cores_per > 1 ? cores_per - 1 : 1);
+
+        char* args[32 + MAX_EXTRA];
+        int n = 0;
+        args[n++] = (char*)bin;
+        args[n++] = "--headless";
+        args[n++] = "--fixed-step";    args[n++] = (char*)hz;
+        args[n++] = "--time-warp";     args[n++] = (char*)warp;
+        args[n++] = "--frames";        args[n++] = frames_s;
+        args[n++] = "--seed";          args[n++] = seed_s;
+        args[n++] = "--dataset";       args[n++] = s->dir;
+        args[n++] = "--dataset-format"; args[n++] = (char*)format;
+        args[n++] = "--threads";       args[n++] = writers_s;
+        args[n++] = "--model";         args[n++] = (char*)model;
+        if (nscen) {
+            const char* sc = scenarios[k % nscen];
+            size_t len = strlen(sc);
+            args[n++] = len > 4 && !strcmp(sc + len - 4, ".scn") ? "--scenario" : "--snapshot-load";
+            args[n++] = (char*)sc;
+        }
+        for (int e = 0; e < nextra; ++e) args[n++] = extra[e];
+        args[n] = NULL;
+
+        printf("[LAUNCH] shard %02d cpus %d-%d:", k, s->cpu0, s->cpu0 + cores_per - 1);
+        for (int a = 0; a < n; ++a) printf(" %s", args[a]);
+        printf("\n");
+        if (dry_run) continue;
+
+        if (!make_dir(s->dir)) { perror("[LAUNCH] mkdir"); s->pid = -1; continue; }
+        char log_path[600];
+        snprintf(log_path, sizeof(log_path), "%s/run.log", s->dir);
+
+        fflush(stdout);
+        s->t_start = now_s();
+        s->pid = fork();
+        if (s->pid == 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int c = 0; c < cores_per; ++c) CPU_SET((s->cpu0 + c) % ncpu, &set);
+            if (sched_setaffinity(0, sizeof(set), &set) != 0) perror("[LAUNCH] sched_setaffinity");
+            int fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd >= 0) { dup2(fd, STDOUT_FILENO); dup2(fd, STDERR_FILENO); close(fd); }
+            execv(bin, args);
+            perror("[LAUNCH] exec");
+            _exit(127);
+        }
+        if (s->pid < 0) perror("[LAUNCH] fork");
+    }
+    if (dry_run) { free(shards); return 0; }
+
+    int running = 0;
+    for (int k = 0; k < instances; ++k) running += shards[k].pid > 0;
+    int failed = instances - running;
+    while (running > 0) {
+        int status = 0;
+        pid_t pid = wait(&status);
+        if (pid < 0) { if (errno == EINTR) continue; break; }
+        for (int k = 0; k < instances; ++k) {
+            Shard* s = &shards[k];
+            if (s->pid != pid) continue;
+            s->t_end = now_s();
+            s->status = status;
+            running--;
+            int ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            if (!ok) failed++;
+            printf("[LAUNCH] shard %02d %s in %.1f s\n", k,
+                   ok ? "done" : "FAILED (see run.log)", s->t_end - s->t_start);
+        }
+    }
+    double wall = now_s() - t0;
+
+    /* Merge: one train list over all shards, paths relative to <out> */
+    char path[600];
+    snprintf(path, sizeof(path), "%s/train.txt", out);
+    FILE* train = fopen(path, "w");
+    long total = 0;
+    if (train) {
+        for (int k = 0; k < instances; ++k) {
+            shards[k].images = merge_manifest(train, &shards[k], out);
+            total += shards[k].images;
+        }
+        fclose(train);
+    }
+    snprintf(path, sizeof(path), "%s/data.yaml", out);
+    FILE* y = fopen(path, "w");
+    if (y) {
+        fprintf(y, "path: .\ntrain: train.txt\nval: train.txt\nnames:\n  0: own\n  1: enemy_near\n  2: enemy_far\n");
+        fclose(y);
+    }
+
+    printf("[LAUNCH] %ld images from %d shards in %.1f s: %.1f images/s total, %.1f per instance, %d failed\n",
+           total, instances, wall, wall > 0 ? total / wall : 0.0,
+           wall > 0 && instances ? total / wall / instances : 0.0, failed);
+    free(shards);
+    return failed ? 1 : 0;
+}